@@ -100,6 +100,9 @@ int main()
 
 		driver->endScene();
 
+        //! Colliders follow the nodes they are attached to when the collision engine refits its BVH
+        gCollEng->refit();
+
         cube->getMaterial(0u).Wireframe = false;
         sphere->getMaterial(0u).Wireframe = false;
         core::vectorSIMDf origin,dir;
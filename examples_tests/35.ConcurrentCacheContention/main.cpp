@@ -0,0 +1,107 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <string>
+
+#include "CConcurrentObjectCache.h"
+#include "CShardedConcurrentObjectCache.h"
+
+using namespace irr;
+
+// asset-cache-like workload: path keys, lookups by many threads while one thread keeps inserting and removing now and then
+#define KEY_COUNT (1u<<12)
+#define MAX_THREADS 64u
+#define MEASURE_MS 500u
+#define WRITER_PERIOD_US 200u
+
+static std::string makeKey(uint32_t _i)
+{
+    return "../../media/assets/textures/some_material_" + std::to_string(_i) + ".png";
+}
+
+template<class CacheT>
+static double measureLookupsPerSecond(CacheT& _cache, const core::vector<std::string>& _keys, uint32_t _threadCount)
+{
+    std::atomic<bool> start(false), stop(false);
+    std::atomic<uint64_t> totalLookups(0u);
+
+    core::vector<std::thread> readers;
+    for (uint32_t t=0u; t<_threadCount; t++)
+    readers.emplace_back([&,t]()
+    {
+        std::mt19937 generator(t);
+        std::uniform_int_distribution<uint32_t> dist(0u,KEY_COUNT-1u);
+        while (!start.load()) {}
+
+        uint64_t lookups = 0u;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            uint32_t value;
+            size_t count = 1u;
+            _cache.findAndStoreRange(_keys[dist(generator)],count,&value);
+            lookups++;
+        }
+        totalLookups += lookups;
+    });
+
+    // read-mostly, but not read-only
+    std::thread writer([&]()
+    {
+        uint32_t i = KEY_COUNT;
+        while (!start.load()) {}
+        while (!stop.load())
+        {
+            const std::string key = makeKey(i);
+            _cache.insert(key,i);
+            _cache.removeObject(i,key);
+            i++;
+            std::this_thread::sleep_for(std::chrono::microseconds(WRITER_PERIOD_US));
+        }
+    });
+
+    const auto begin = std::chrono::high_resolution_clock::now();
+    start = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(MEASURE_MS));
+    stop = true;
+    for (auto& thread : readers)
+        thread.join();
+    const auto end = std::chrono::high_resolution_clock::now();
+    writer.join();
+
+    return double(totalLookups.load())/std::chrono::duration<double>(end-begin).count();
+}
+
+template<class CacheT>
+static void fill(CacheT& _cache, const core::vector<std::string>& _keys)
+{
+    for (uint32_t i=0u; i<KEY_COUNT; i++)
+        _cache.insert(_keys[i],i);
+}
+
+int main()
+{
+    core::vector<std::string> keys(KEY_COUNT);
+    for (uint32_t i=0u; i<KEY_COUNT; i++)
+        keys[i] = makeKey(i);
+
+    core::CConcurrentMultiObjectCache<std::string,uint32_t,std::multimap> lockedCache;
+    core::CShardedConcurrentMultiObjectCache<std::string,uint32_t> shardedCache;
+    fill(lockedCache,keys);
+    fill(shardedCache,keys);
+
+    printf("Hardware threads: %u\n",std::thread::hardware_concurrency());
+    printf("%8s %24s %24s %8s\n","threads","RW-locked lookups/s","sharded lookups/s","speedup");
+    for (uint32_t threads=1u; threads<=MAX_THREADS; threads*=2u)
+    {
+        const double locked = measureLookupsPerSecond(lockedCache,keys,threads);
+        const double sharded = measureLookupsPerSecond(shardedCache,keys,threads);
+        printf("%8u %24.0f %24.0f %7.2fx\n",threads,locked,sharded,sharded/locked);
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "irr/core/string/fast_atof.h"
+
+using namespace irr;
+
+// scanned-geometry-like OBJs: a jittered grid with full-precision positions, uvs and normals
+#define MIN_SIZE_MB 16u
+#define MAX_SIZE_MB 256u
+#define REPETITIONS 3u
+
+static std::string generateOBJ(size_t _targetBytes)
+{
+    std::mt19937 generator(0x45u);
+    std::uniform_real_distribution<float> jitter(-0.5f,0.5f);
+
+    // one grid vertex with its face comes out at roughly 150 bytes
+    const uint32_t side = core::max_<uint32_t>(uint32_t(sqrt(double(_targetBytes)/150.0)),2u);
+    std::string retval;
+    retval.reserve(_targetBytes+(_targetBytes>>3u));
+    retval += "# synthetic scan\n";
+
+    char line[256];
+    for (uint32_t y=0u; y<side; y++)
+    for (uint32_t x=0u; x<side; x++)
+    {
+        sprintf(line,"v %.7f %.7f %.7f\n",float(x)+jitter(generator),jitter(generator)*10.f,float(y)+jitter(generator));
+        retval += line;
+        sprintf(line,"vt %.7f %.7f\n",float(x)/float(side),float(y)/float(side));
+        retval += line;
+        sprintf(line,"vn %.7f %.7f %.7f\n",jitter(generator),1.f,jitter(generator));
+        retval += line;
+    }
+    for (uint32_t y=1u; y<side; y++)
+    for (uint32_t x=1u; x<side; x++)
+    {
+        const uint32_t a = (y-1u)*side+x, b = a+1u, c = b+side, d = a+side;
+        sprintf(line,"f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n",a,a,a,b,b,b,c,c,c,d,d,d);
+        retval += line;
+    }
+    return retval;
+}
+
+// number parsing in isolation, every whitespace separated token which starts like a number
+template<typename F>
+static double measureNumberParsing(const std::string& _obj, F&& _parse)
+{
+    const char* it = _obj.data();
+    const char* const end = it+_obj.size();
+    float sum = 0.f;
+
+    const auto begin = std::chrono::high_resolution_clock::now();
+    while (it!=end)
+    {
+        if (core::isdigit(*it) || *it=='-')
+        {
+            float value;
+            it = _parse(it,end,value);
+            sum += value;
+        }
+        else
+            it++;
+    }
+    const auto finish = std::chrono::high_resolution_clock::now();
+
+    // keep the optimizer honest
+    if (sum==0.12345f)
+        printf(" ");
+    return double(_obj.size())/double(1u<<20u)/std::chrono::duration<double>(finish-begin).count();
+}
+
+int main()
+{
+    irr::SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return 1;
+
+    io::IFileSystem* fs = device->getFileSystem();
+    auto am = device->getAssetManager();
+
+    printf("Task scheduler concurrency: %u\n",core::CTaskScheduler::getDefault()->getConcurrency());
+    printf("%8s %16s %16s %16s\n","MB","strtof MB/s","fast_atof MB/s","load MB/s");
+    for (uint32_t sizeMB=MIN_SIZE_MB; sizeMB<=MAX_SIZE_MB; sizeMB*=4u)
+    {
+        const std::string obj = generateOBJ(size_t(sizeMB)<<20u);
+        const double objMB = double(obj.size())/double(1u<<20u);
+
+        const double strtofThroughput = measureNumberParsing(obj,[](const char* _it, const char* _end, float& _out) -> const char*
+            {
+                char* next;
+                _out = strtof(_it,&next);
+                return next!=_it ? next:(_it+1);
+            }
+        );
+        const double fastAtofThroughput = measureNumberParsing(obj,[](const char* _it, const char* _end, float& _out) -> const char*
+            {
+                const char* next = core::fast_atof_move(_it,_end,_out);
+                return next!=_it ? next:(_it+1);
+            }
+        );
+
+        double bestLoad = 0.0;
+        for (uint32_t r=0u; r<REPETITIONS; r++)
+        {
+            // unique name, so that neither the mesh nor its submeshes come from the cache
+            const std::string name = "synthetic_"+std::to_string(sizeMB)+"MB_"+std::to_string(r)+".obj";
+            io::IReadFile* file = fs->createMemoryReadFile(obj.data(),obj.size(),name.c_str());
+
+            asset::IAssetLoader::SAssetLoadParams lparams;
+            const auto begin = std::chrono::high_resolution_clock::now();
+            auto bundle = am->getAsset(file,name,lparams);
+            const auto finish = std::chrono::high_resolution_clock::now();
+            file->drop();
+
+            if (bundle.isEmpty())
+            {
+                printf("Failed to load %s\n",name.c_str());
+                device->drop();
+                return 2;
+            }
+            am->removeAssetFromCache(bundle);
+            bestLoad = core::max_(bestLoad,objMB/std::chrono::duration<double>(finish-begin).count());
+        }
+
+        printf("%8.1f %16.1f %16.1f %16.1f\n",objMB,strtofThroughput,fastAtofThroughput,bestLoad);
+    }
+
+    device->drop();
+    return 0;
+}
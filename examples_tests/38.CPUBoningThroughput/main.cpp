@@ -0,0 +1,243 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+#include "../source/Irrlicht/CSoABoneSolver.h"
+
+using namespace irr;
+using namespace core;
+
+#define INSTANCE_COUNT 2000u
+#define KEYFRAME_COUNT 64u
+#define REPETITIONS 5u
+
+typedef scene::CSoABoneSolver::SBoneOutput SBoneOutput;
+
+//! Random hierarchy with `_levelSizes[i]` bones on level i, parents are picked at random from the level above
+static asset::CFinalBoneHierarchy* createHierarchy(const core::vector<size_t>& _levelSizes, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> unit(-1.f,1.f);
+    std::uniform_real_distribution<float> scale(0.8f,1.2f);
+
+    core::vector<size_t> levelEnds;
+    for (size_t size : _levelSizes)
+        levelEnds.push_back((levelEnds.size() ? levelEnds.back():0u)+size);
+    const size_t boneCount = levelEnds.back();
+
+    core::vector<asset::CFinalBoneHierarchy::BoneReferenceData> bones(boneCount);
+    core::vector<core::stringc> names(boneCount);
+    for (size_t level=0u, i=0u; level<levelEnds.size(); level++)
+    for (; i<levelEnds[level]; i++)
+    {
+        auto& bone = bones[i];
+        core::quaternion rot(unit(_generator),unit(_generator),unit(_generator),unit(_generator));
+        rot = core::quaternion::normalize(rot);
+        core::matrix3x4SIMD poseBind;
+        poseBind.setScaleRotationAndTranslation(core::vectorSIMDf(1.f),rot,core::vectorSIMDf(unit(_generator),unit(_generator),unit(_generator)));
+        bone.PoseBindMatrix = poseBind.getAsRetardedIrrlichtMatrix();
+        for (uint32_t j=0u; j<3u; j++)
+        {
+            bone.MinBBoxEdge[j] = -0.5f+0.25f*unit(_generator);
+            bone.MaxBBoxEdge[j] = 0.5f+0.25f*unit(_generator);
+        }
+        if (level)
+        {
+            const size_t levelBegin = level>1u ? levelEnds[level-2u]:0u;
+            bone.parentOffsetFromTop = levelBegin+_generator()%(levelEnds[level-1u]-levelBegin);
+            bone.parentOffsetRelative = i-bone.parentOffsetFromTop;
+        }
+        else
+        {
+            bone.parentOffsetFromTop = i;
+            bone.parentOffsetRelative = 0u;
+        }
+        char name[16];
+        sprintf(name,"bone%u",uint32_t(i));
+        names[i] = name;
+    }
+
+    core::vector<float> keys(KEYFRAME_COUNT);
+    for (uint32_t i=0u; i<KEYFRAME_COUNT; i++)
+        keys[i] = float(i);
+
+    core::vector<asset::CFinalBoneHierarchy::AnimationKeyData> animations(boneCount*KEYFRAME_COUNT);
+    for (auto& key : animations)
+    {
+        core::quaternion rot(unit(_generator),unit(_generator),unit(_generator),unit(_generator));
+        rot = core::quaternion::normalize(rot);
+        memcpy(key.Rotation,&rot,sizeof(key.Rotation));
+        for (uint32_t j=0u; j<3u; j++)
+        {
+            key.Position[j] = unit(_generator);
+            key.Scale[j] = scale(_generator);
+        }
+        key.Padding[0] = key.Padding[1] = 0.f;
+    }
+
+    return new asset::CFinalBoneHierarchy(bones.data(),bones.data()+boneCount,names.data(),names.data()+boneCount,levelEnds.data(),levelEnds.data()+levelEnds.size(),
+                                            keys.data(),keys.data()+keys.size(),animations.data(),animations.data()+animations.size(),animations.data(),animations.data()+animations.size());
+}
+
+//! What CSkinningStateManager::performBoning used to do for every bone, matrix4x3 in and out of every step
+static void solveScalar(const asset::CFinalBoneHierarchy* _hierarchy, float _frame, core::matrix4x3* _globalMatrices, SBoneOutput* _outBones)
+{
+    float interpolationFactor;
+    size_t foundKeyIx = _hierarchy->getLowerBoundBoneKeyframes(interpolationFactor,_frame);
+    float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
+    core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
+
+    for (size_t j=0; j<_hierarchy->getBoneCount(); j++)
+    {
+        const asset::CFinalBoneHierarchy::AnimationKeyData* animation = _hierarchy->getInterpolatedAnimationData(j);
+        core::matrix3x4SIMD interpolatedLocalTform;
+        if (interpolationFactor<1.f)
+            interpolatedLocalTform = _hierarchy->getMatrixFromKeys(animation[foundKeyIx-1],animation[foundKeyIx],interpolationFactor,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+        else
+            interpolatedLocalTform = _hierarchy->getMatrixFromKey(animation[foundKeyIx]);
+
+        if (j<_hierarchy->getBoneLevelRangeEnd(0))
+            _globalMatrices[j] = interpolatedLocalTform.getAsRetardedIrrlichtMatrix();
+        else
+            _globalMatrices[j] = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(_globalMatrices[_hierarchy->getBoneData()[j].parentOffsetFromTop]),interpolatedLocalTform).getAsRetardedIrrlichtMatrix();
+
+        core::matrix4x3& skinning = reinterpret_cast<core::matrix4x3&>(_outBones[j].SkinningTransform);
+        skinning = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(_globalMatrices[j]),core::matrix3x4SIMD().set(_hierarchy->getBoneData()[j].PoseBindMatrix)).getAsRetardedIrrlichtMatrix();
+
+        const float* inMin = _hierarchy->getBoneData()[j].MinBBoxEdge;
+        const float* inMax = _hierarchy->getBoneData()[j].MaxBBoxEdge;
+        core::aabbox3df bbox(inMin[0],inMin[1],inMin[2],inMax[0],inMax[1],inMax[2]);
+        bbox = core::transformBoxEx(bbox,core::matrix3x4SIMD().set(skinning));
+        memcpy(_outBones[j].MinBBoxEdge,&bbox.MinEdge.X,sizeof(float)*3u);
+        memcpy(_outBones[j].MaxBBoxEdge,&bbox.MaxEdge.X,sizeof(float)*3u);
+        skinning.getSub3x3InverseTranspose(_outBones[j].SkinningNormalMatrix);
+        _outBones[j].lastAnimatedFrame = _frame;
+    }
+}
+
+template<typename F>
+static double measureInstancesPerMs(F&& _solve)
+{
+    double best = 0.0;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _solve(r);
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::max_(best,double(INSTANCE_COUNT)/std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+static void benchmark(const char* _name, const core::vector<size_t>& _levelSizes)
+{
+    std::mt19937 generator(0x45u);
+    asset::CFinalBoneHierarchy* hierarchy = createHierarchy(_levelSizes,generator);
+    const size_t boneCount = hierarchy->getBoneCount();
+    scene::CSoABoneSolver boneSolver(hierarchy,scene::CSoABoneSolver::EB_BONES);
+    scene::CSoABoneSolver instanceSolver(hierarchy,scene::CSoABoneSolver::EB_INSTANCES);
+    scene::CSoABoneSolver autoSolver(hierarchy);
+
+    core::vector<float> frames(INSTANCE_COUNT);
+    std::uniform_real_distribution<float> frame(0.f,float(KEYFRAME_COUNT-1u));
+    for (auto& f : frames)
+        f = frame(generator);
+
+    core::vector<core::matrix4x3> scalarGlobals(boneCount*INSTANCE_COUNT), globals(boneCount*INSTANCE_COUNT);
+    core::vector<SBoneOutput> scalarBones(boneCount*INSTANCE_COUNT), bones(boneCount*INSTANCE_COUNT);
+    core::vector<core::aabbox3df> bboxes(INSTANCE_COUNT);
+    core::vector<scene::CSoABoneSolver::SInstance> instances(INSTANCE_COUNT);
+    for (size_t i=0u; i<INSTANCE_COUNT; i++)
+        instances[i] = {0.f,true,globals.data()+i*boneCount,bones.data()+i*boneCount,bboxes.data()+i,nullptr,0u};
+
+    // every repetition moves the instances along a bit so nothing is cached between runs
+    const double scalar = measureInstancesPerMs([&](uint32_t _rep)
+        {
+            for (size_t i=0u; i<INSTANCE_COUNT; i++)
+                solveScalar(hierarchy,frames[i]+0.125f*_rep,scalarGlobals.data()+i*boneCount,scalarBones.data()+i*boneCount);
+        }
+    );
+    auto measureSolver = [&](const scene::CSoABoneSolver& _solver, bool _parallel)
+    {
+        return measureInstancesPerMs([&](uint32_t _rep)
+            {
+                for (size_t i=0u; i<INSTANCE_COUNT; i++)
+                    instances[i].frame = frames[i]+0.125f*_rep;
+                if (_parallel)
+                {
+                    const size_t grain = core::roundUp<size_t>(core::max_<size_t>(2048u/boneCount,1u),scene::CSoABoneSolver::BatchSize);
+                    core::parallel_for_range<size_t>(0u,INSTANCE_COUNT,[&](size_t _begin, size_t _end) {_solver.solve(instances.data()+_begin,_end-_begin);},grain);
+                }
+                else
+                    _solver.solve(instances.data(),INSTANCE_COUNT);
+            }
+        );
+    };
+
+    // every solver ran the same last repetition as the scalar code
+    float maxError = 0.f;
+    auto compare = [&]()
+    {
+        for (size_t i=0u; i<bones.size(); i++)
+        {
+            const float* a = reinterpret_cast<const float*>(scalarBones.data()+i);
+            const float* b = reinterpret_cast<const float*>(bones.data()+i);
+            for (size_t j=0u; j<sizeof(SBoneOutput)/sizeof(float); j++)
+                maxError = core::max_(maxError,fabsf(a[j]-b[j])/core::max_(fabsf(a[j]),1.f));
+        }
+    };
+    const double soaBones = measureSolver(boneSolver,false);
+    compare();
+    const double soaInstances = measureSolver(instanceSolver,false);
+    compare();
+    const double parallel = measureSolver(autoSolver,true);
+    compare();
+
+    // a crowd-like stack: base clip, an override on every other bone and an additive layer
+    core::vector<float> boneWeights(boneCount);
+    for (size_t i=0u; i<boneCount; i++)
+        boneWeights[i] = float(i&1u);
+    core::vector<scene::CSoABoneSolver::SLayer> layers(INSTANCE_COUNT*3u);
+    for (size_t i=0u; i<INSTANCE_COUNT; i++)
+    {
+        scene::CSoABoneSolver::SLayer* instanceLayers = layers.data()+i*3u;
+        instanceLayers[0] = {frames[i],0.f,1.f,nullptr,true,false};
+        instanceLayers[1] = {frames[INSTANCE_COUNT-1u-i],0.f,0.5f,boneWeights.data(),true,false};
+        instanceLayers[2] = {frame(generator),0.f,0.75f,nullptr,true,true};
+        instances[i].layers = instanceLayers;
+        instances[i].layerCount = 3u;
+    }
+    const double layered = measureSolver(autoSolver,true);
+    for (size_t i=0u; i<INSTANCE_COUNT; i++)
+        instances[i].layerCount = 0u;
+
+    // same hierarchy with the tracks compressed, the random keys leave little to drop so this mostly measures the decoding
+    const size_t rawBytes = hierarchy->getAnimationCount()*sizeof(asset::CFinalBoneHierarchy::AnimationKeyData)*2u;
+    hierarchy->compressAnimations();
+    const size_t compressedBytes = hierarchy->getCompressedAnimations()->getSerializedSize();
+    scene::CSoABoneSolver compressedSolver(hierarchy);
+    const double compressed = measureSolver(compressedSolver,true);
+
+    printf("%-12s %6u %6u %12.1f %12.1f %12.1f %12.1f %9s %8.2fx %12.2e %12.1f %12.1f %8.2fx\n",_name,uint32_t(boneCount),uint32_t(hierarchy->getHierarchyLevels()),
+        scalar,soaBones,soaInstances,parallel,autoSolver.getBatching()==scene::CSoABoneSolver::EB_BONES ? "bones":"instances",parallel/scalar,maxError,
+        layered,compressed,double(rawBytes)/double(compressedBytes));
+    hierarchy->drop();
+}
+
+int main()
+{
+    printf("Task scheduler concurrency: %u, %u instances\n",core::CTaskScheduler::getDefault()->getConcurrency(),INSTANCE_COUNT);
+    printf("Instances boned per millisecond, max error is the largest difference to the scalar results relative to max(|x|,1)\n");
+    printf("3 layers is the threaded solver blending a base clip, a masked override and an additive layer per instance\n");
+    printf("The last two columns are the threaded solver on compressed animations and how much smaller they got\n");
+    printf("%-12s %6s %6s %12s %12s %12s %12s %9s %9s %12s %12s %12s %9s\n","Hierarchy","bones","levels","scalar","SoA bones","SoA inst.","threaded","auto","speedup","max error","3 layers","compressed","ratio");
+
+    benchmark("humanoid",{1u,3u,6u,10u,12u,12u,10u,6u,4u});
+    benchmark("wide",{4u,28u,96u,128u});
+    benchmark("chain",core::vector<size_t>(32u,1u));
+    benchmark("crowd LoD",{1u,3u,4u,4u,4u});
+
+    return 0;
+}
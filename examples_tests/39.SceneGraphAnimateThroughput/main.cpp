@@ -0,0 +1,100 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+using namespace irr;
+using namespace core;
+
+#define NODE_COUNT 500000u
+#define REPETITIONS 5u
+
+//! What the scene manager used to do every frame, minus the animators
+static void updateDepthFirst(scene::IDummyTransformationSceneNode* _node)
+{
+    _node->updateAbsolutePosition();
+    for (auto child : _node->getChildren())
+        updateDepthFirst(child);
+}
+
+template<typename F, typename G>
+static double measureMs(F&& _move, G&& _update)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        _move();
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _update();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+int main()
+{
+    irr::SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return 1;
+
+    scene::ISceneManager* smgr = device->getSceneManager();
+    scene::ISceneNode* root = smgr->getRootSceneNode();
+
+    // a few big subtrees with a fanout of 4 to 8, roughly what a level or a city block looks like
+    std::mt19937 generator(0x45u);
+    std::uniform_real_distribution<float> unit(-1.f,1.f);
+    core::vector<scene::IDummyTransformationSceneNode*> nodes;
+    nodes.reserve(NODE_COUNT);
+    for (uint32_t i=0u; i<16u; i++)
+        nodes.push_back(smgr->addDummyTransformationSceneNode(root));
+    uint32_t levels = 1u;
+    for (size_t levelBegin=0u, levelEnd=nodes.size(); nodes.size()<NODE_COUNT; levelBegin=levelEnd, levelEnd=nodes.size(), levels++)
+    for (size_t i=levelBegin; i<levelEnd && nodes.size()<NODE_COUNT; i++)
+    for (uint32_t j=4u+generator()%5u; j && nodes.size()<NODE_COUNT; j--)
+        nodes.push_back(smgr->addDummyTransformationSceneNode(nodes[i]));
+    for (auto node : nodes)
+    {
+        node->setPosition(core::vector3df(unit(generator),unit(generator),unit(generator)));
+        node->setRotation(core::vector3df(unit(generator),unit(generator),unit(generator))*30.f);
+    }
+    root->OnAnimate(0u);
+
+    auto depthFirst = [&]()
+    {
+        for (auto child : root->getChildren())
+            updateDepthFirst(child);
+    };
+    auto levelOrdered = [&]()
+    {
+        root->OnAnimate(0u);
+    };
+
+    printf("Task scheduler concurrency: %u, %u nodes in %u levels\n",core::CTaskScheduler::getDefault()->getConcurrency(),uint32_t(nodes.size()),levels);
+    printf("Best of %u updates in milliseconds, depth first is the old single threaded recursion\n",REPETITIONS);
+    printf("%-16s %12s %14s %9s\n","Changed","depth first","level ordered","speedup");
+    struct
+    {
+        const char* name;
+        size_t count;
+        size_t stride;
+    } scenarios[] = {{"nothing",0u,1u},{"1% of nodes",nodes.size(),100u},{"top level nodes",16u,1u},{"every node",nodes.size(),1u}};
+    for (const auto& scenario : scenarios)
+    {
+        auto move = [&]()
+        {
+            for (size_t i=0u; i<scenario.count; i+=scenario.stride)
+                nodes[i]->setPosition(core::vector3df(unit(generator),unit(generator),unit(generator)));
+        };
+        const double df = measureMs(move,depthFirst);
+        const double lo = measureMs(move,levelOrdered);
+        printf("%-16s %12.2f %14.2f %8.2fx\n",scenario.name,df,lo,df/lo);
+    }
+
+    device->drop();
+    return 0;
+}
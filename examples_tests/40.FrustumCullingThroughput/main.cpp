@@ -0,0 +1,133 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+#include "../source/Irrlicht/CFrustumCuller.h"
+
+using namespace irr;
+using namespace core;
+
+#define WORLD_SIZE 4000.f
+#define REPETITIONS 5u
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+//! What CSceneManager::isCulled does for every node, minus the virtual calls
+static bool isCulledOneByOne(const aabbox3df& _localBox, const matrix4x3& _world, const scene::SViewFrustum& _frustum)
+{
+    aabbox3df box = _localBox;
+    if (box.MinEdge==box.MaxEdge)
+        return true;
+    _world.transformBoxEx(box);
+    return !box.intersectsWithBox(_frustum.getBoundingBox()) || !_frustum.intersectsAABB(box);
+}
+
+static void benchmark(size_t _count, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> position(-0.5f*WORLD_SIZE,0.5f*WORLD_SIZE);
+    std::uniform_real_distribution<float> angle(0.f,360.f);
+    std::uniform_real_distribution<float> extent(0.5f,10.f);
+
+    core::vector<aabbox3df> boxes(_count);
+    core::vector<matrix4x3> transforms(_count);
+    for (size_t i=0u; i<_count; i++)
+    {
+        boxes[i] = aabbox3df(-extent(_generator),-extent(_generator),-extent(_generator),extent(_generator),extent(_generator),extent(_generator));
+        transforms[i].setRotationDegrees(vector3df(angle(_generator),angle(_generator),angle(_generator)));
+        transforms[i].setTranslation(vector3df(position(_generator),position(_generator),position(_generator)));
+    }
+
+    // a camera in the middle of the world looking along +Z, like CCameraSceneNode sets it up
+    const matrix4SIMD projection = matrix4SIMD::buildProjectionMatrixPerspectiveFovRH(0.5f*core::PI,16.f/9.f,1.f,0.5f*WORLD_SIZE);
+    const matrix3x4SIMD view = matrix3x4SIMD::buildCameraLookAtMatrixLH(vectorSIMDf(0.f),vectorSIMDf(0.f,0.f,1.f),vectorSIMDf(0.f,1.f,0.f));
+    const scene::SViewFrustum frustum(concatenateBFollowedByA(projection,view));
+
+    core::vector<uint8_t> oneByOne(_count);
+    const double oneByOneMs = measureMs([&]()
+        {
+            for (size_t i=0u; i<_count; i++)
+                oneByOne[i] = !isCulledOneByOne(boxes[i],transforms[i],frustum);
+        }
+    );
+
+    scene::CFrustumCuller culler;
+    const uint32_t cullingType = scene::EAC_BOX|scene::EAC_FRUSTUM_BOX;
+    const double batchedMs = measureMs([&]()
+        {
+            culler.clear();
+            for (size_t i=0u; i<_count; i++)
+                culler.addBox(boxes[i],transforms.data()+i,cullingType);
+            culler.cull(&frustum);
+        }
+    );
+
+    size_t visible = 0u, mismatches = 0u;
+    for (size_t i=0u; i<_count; i++)
+    {
+        visible += oneByOne[i];
+        mismatches += oneByOne[i]!=uint8_t(culler.isVisible(i));
+        // single box path the scene manager uses while nodes register, against the frustum cull() set up
+        mismatches += oneByOne[i]!=uint8_t(culler.cullBox(boxes[i],transforms[i],cullingType));
+    }
+
+    // the survivors as solid pass entries (few render priorities and materials) and as transparent ones (distances)
+    std::uniform_int_distribution<uint32_t> priority(0u,7u), material(0u,15u);
+    core::vector<uint64_t> solidKeys, sortedSolidKeys(visible), solidScratch(visible);
+    core::vector<uint32_t> transparentKeys, sortedTransparentKeys(visible), transparentScratch(visible);
+    for (size_t i=0u; i<_count; i++)
+    {
+        if (!oneByOne[i])
+            continue;
+        solidKeys.push_back((uint64_t(priority(_generator)<<28u)<<32ull)|material(_generator));
+        transparentKeys.push_back(~float_to_sortable_uint(transforms[i].getTranslation().getLengthSQ()));
+    }
+    const double stdSortMs = measureMs([&]()
+        {
+            sortedSolidKeys = solidKeys;
+            std::sort(sortedSolidKeys.begin(),sortedSolidKeys.end());
+            sortedTransparentKeys = transparentKeys;
+            std::sort(sortedTransparentKeys.begin(),sortedTransparentKeys.end());
+        }
+    );
+    const double radixSortMs = measureMs([&]()
+        {
+            sortedSolidKeys = solidKeys;
+            radix_sort(sortedSolidKeys.data(),sortedSolidKeys.data()+visible,solidScratch.data(),[](uint64_t key) {return key;});
+            sortedTransparentKeys = transparentKeys;
+            radix_sort(sortedTransparentKeys.data(),sortedTransparentKeys.data()+visible,transparentScratch.data(),[](uint32_t key) {return key;});
+        }
+    );
+    const bool sorted = std::is_sorted(sortedSolidKeys.begin(),sortedSolidKeys.end())&&std::is_sorted(sortedTransparentKeys.begin(),sortedTransparentKeys.end());
+
+    printf("%9u %9u %12.2f %12.2f %8.2fx %10u %12.2f %12.2f %8.2fx %s\n",uint32_t(_count),uint32_t(visible),oneByOneMs,batchedMs,oneByOneMs/batchedMs,
+        uint32_t(mismatches),stdSortMs,radixSortMs,stdSortMs/radixSortMs,sorted ? "yes":"NO");
+}
+
+int main()
+{
+    printf("Task scheduler concurrency: %u\n",core::CTaskScheduler::getDefault()->getConcurrency());
+    printf("Best of %u runs in milliseconds, one by one is CSceneManager::isCulled's math for every box,\n",REPETITIONS);
+    printf("batched is CFrustumCuller (queueing included), mismatches count disagreements of cull() and cullBox() with it\n");
+    printf("%9s %9s %12s %12s %9s %10s %12s %12s %9s %s\n","boxes","visible","one by one","batched","speedup","mismatches","std::sort","radix sort","speedup","sorted");
+
+    std::mt19937 generator(0x45u);
+    for (size_t count=1024u; count<=(1u<<20u); count*=8u)
+        benchmark(count,generator);
+
+    return 0;
+}
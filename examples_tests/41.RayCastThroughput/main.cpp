@@ -0,0 +1,485 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+using namespace irr;
+using namespace core;
+
+#define WORLD_SIZE 1000.f
+#define RAY_COUNT 100000u
+#define REPETITIONS 5u
+//! brute force gets fewer rays so it finishes in reasonable time, that many ray-collider tests
+#define BRUTE_FORCE_BUDGET (1u<<27u)
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+//! Just enough of a scene node to attach colliders to, without a scene manager or a driver
+class CColliderNode : public scene::ISceneNode
+{
+        aabbox3df Box;
+    public:
+        CColliderNode() : scene::ISceneNode(nullptr,nullptr) {}
+
+        void render() override {}
+        const aabbox3df& getBoundingBox() override {return Box;}
+};
+
+struct SRay
+{
+    vectorSIMDf origin;
+    vectorSIMDf direction;
+};
+
+struct SHit
+{
+    bool hit;
+    float distance;
+};
+
+static bool sameHit(const SHit& a, const SHit& b)
+{
+    return a.hit==b.hit && (!a.hit || fabsf(a.distance-b.distance)<=0.001f*core::max_(1.f,a.distance));
+}
+
+static core::vector<SRay> randomRays(size_t _count, float _extent, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> position(-0.5f*_extent,0.5f*_extent);
+    std::normal_distribution<float> gaussian;
+    core::vector<SRay> rays(_count);
+    for (auto& ray : rays)
+    {
+        ray.origin.set(position(_generator),position(_generator),position(_generator),0.f);
+        // normalized gaussian vectors are uniform on the sphere
+        ray.direction.set(gaussian(_generator),gaussian(_generator),gaussian(_generator),0.f);
+        ray.direction = normalize(ray.direction);
+    }
+    return rays;
+}
+
+//! What SCollisionEngine::FastCollide did before it had a BVH
+static SHit bruteForce(const core::vector<SCompoundCollider*>& _colliders, const SRay& _ray, float _maxRayLen)
+{
+    SHit retval = {false,_maxRayLen};
+    for (auto collider : _colliders)
+    {
+        float distance;
+        if (collider->CollideWithRay(distance,_ray.origin,_ray.direction,retval.distance)&&distance<retval.distance)
+        {
+            retval.distance = distance;
+            retval.hit = true;
+        }
+    }
+    return retval;
+}
+
+//! Primary rays of a 90 degree camera in the corner of the world, in 2x2 pixel tiles so every packet is a tile
+static core::vector<SRay> cameraRays(size_t _count)
+{
+    const uint32_t resolution = uint32_t(sqrtf(float(_count)))&~0x1u;
+    const vectorSIMDf origin(-0.5f*WORLD_SIZE,-0.5f*WORLD_SIZE,-0.5f*WORLD_SIZE,0.f);
+    core::vector<SRay> rays;
+    rays.reserve(resolution*resolution);
+    for (uint32_t y=0u; y<resolution; y+=2u)
+    for (uint32_t x=0u; x<resolution; x+=2u)
+    for (uint32_t i=0u; i<4u; i++)
+    {
+        const float u = (float(x+(i&0x1u))+0.5f)/float(resolution)*2.f-1.f;
+        const float v = (float(y+(i>>1u))+0.5f)/float(resolution)*2.f-1.f;
+        SRay ray;
+        ray.origin = origin;
+        // looking at the middle of the world
+        ray.direction = normalize(vectorSIMDf(1.f+u,1.f+v,1.f-0.5f*(u+v),0.f));
+        rays.push_back(ray);
+    }
+    return rays;
+}
+
+struct SBatchResult
+{
+    size_t count;
+    double singleRandom, batchedRandom;
+    double singleCoherent, batchedCoherent;
+    size_t mismatches;
+};
+
+struct SOverlapResult
+{
+    size_t count;
+    //! queries/sec of the BVH and how much faster than brute force
+    double box, boxSpeedup;
+    double sphere, sphereSpeedup;
+    double frustum, frustumSpeedup;
+    //! milliseconds, brute force gets skipped (and is 0) for many colliders
+    double pairs, pairsSpeedup;
+    size_t mismatches;
+};
+
+#define OVERLAP_QUERY_COUNT 10000u
+#define FRUSTUM_QUERY_COUNT 200u
+#define MAX_BRUTE_FORCE_PAIRS_COLLIDERS 8192u
+
+//! Box, sphere and frustum queries and all overlapping pairs, brute force loops over the bounds of every collider like application code had to
+static SOverlapResult benchmarkOverlaps(const SCollisionEngine& _engine, const core::vector<SCompoundCollider*>& _colliders, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> position(-0.5f*WORLD_SIZE,0.5f*WORLD_SIZE);
+    std::uniform_real_distribution<float> extent(10.f,50.f);
+    std::normal_distribution<float> gaussian;
+
+    core::vector<aabbox3df> bounds(_colliders.size());
+    for (size_t i=0u; i<_colliders.size(); i++)
+        bounds[i] = _colliders[i]->getWorldBoundingBox();
+
+    core::vector<aabbox3df> boxes(OVERLAP_QUERY_COUNT);
+    core::vector<vectorSIMDf> centers(OVERLAP_QUERY_COUNT);
+    core::vector<float> radii(OVERLAP_QUERY_COUNT);
+    for (uint32_t i=0u; i<OVERLAP_QUERY_COUNT; i++)
+    {
+        const vector3df center(position(_generator),position(_generator),position(_generator));
+        const vector3df halfExtent(extent(_generator),extent(_generator),extent(_generator));
+        boxes[i] = aabbox3df(center-halfExtent,center+halfExtent);
+        centers[i].set(center);
+        radii[i] = extent(_generator);
+    }
+    core::vector<scene::SViewFrustum> frustums;
+    const matrix4SIMD projection = matrix4SIMD::buildProjectionMatrixPerspectiveFovRH(0.25f*core::PI,16.f/9.f,1.f,0.25f*WORLD_SIZE);
+    for (uint32_t i=0u; i<FRUSTUM_QUERY_COUNT; i++)
+    {
+        const vectorSIMDf eye(position(_generator),position(_generator),position(_generator));
+        const vectorSIMDf forward = normalize(vectorSIMDf(gaussian(_generator),gaussian(_generator),gaussian(_generator)));
+        const matrix3x4SIMD view = matrix3x4SIMD::buildCameraLookAtMatrixLH(eye,eye+forward,vectorSIMDf(0.f,1.f,0.f));
+        frustums.emplace_back(concatenateBFollowedByA(projection,view));
+    }
+
+    // counts of both, per query
+    core::vector<size_t> bruteForceCounts(OVERLAP_QUERY_COUNT), bvhCounts(OVERLAP_QUERY_COUNT);
+    core::vector<SCompoundCollider*> found(_colliders.size());
+    SOverlapResult result = {_colliders.size(),0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0,0u};
+    auto compare = [&](uint32_t queryCount)
+    {
+        for (uint32_t i=0u; i<queryCount; i++)
+            result.mismatches += bruteForceCounts[i]!=bvhCounts[i];
+    };
+    auto sphereOverlapsBox = [](const vectorSIMDf& center, float radius, const aabbox3df& box)
+    {
+        float distance2 = 0.f;
+        for (uint32_t j=0u; j<3u; j++)
+        {
+            const float d = core::max_((&box.MinEdge.X)[j]-center.pointer[j],0.f)+core::max_(center.pointer[j]-(&box.MaxEdge.X)[j],0.f);
+            distance2 += d*d;
+        }
+        return distance2<=radius*radius;
+    };
+
+    auto measureQueries = [&](uint32_t queryCount, auto bruteForce, auto bvh, double& queriesPerSec, double& speedup)
+    {
+        const double bruteForceMs = measureMs([&]()
+            {
+                for (uint32_t i=0u; i<queryCount; i++)
+                {
+                    bruteForceCounts[i] = 0u;
+                    for (const auto& box : bounds)
+                        bruteForceCounts[i] += bruteForce(i,box);
+                }
+            }
+        );
+        const double bvhMs = measureMs([&]()
+            {
+                for (uint32_t i=0u; i<queryCount; i++)
+                    bvhCounts[i] = bvh(i);
+            }
+        );
+        compare(queryCount);
+        queriesPerSec = double(queryCount)*1000.0/bvhMs;
+        speedup = bruteForceMs/bvhMs;
+    };
+    measureQueries(OVERLAP_QUERY_COUNT,[&](uint32_t i, const aabbox3df& box) {return boxes[i].intersectsWithBox(box);},
+        [&](uint32_t i) {return _engine.findOverlaps(boxes[i],found.data(),found.size());},result.box,result.boxSpeedup);
+    measureQueries(OVERLAP_QUERY_COUNT,[&](uint32_t i, const aabbox3df& box) {return sphereOverlapsBox(centers[i],radii[i],box);},
+        [&](uint32_t i) {return _engine.findOverlaps(centers[i],radii[i],found.data(),found.size());},result.sphere,result.sphereSpeedup);
+    measureQueries(FRUSTUM_QUERY_COUNT,[&](uint32_t i, const aabbox3df& box) {return frustums[i].intersectsAABB(box);},
+        [&](uint32_t i) {return _engine.findOverlaps(frustums[i],found.data(),found.size());},result.frustum,result.frustumSpeedup);
+
+    size_t bvhPairs = 0u;
+    result.pairs = measureMs([&]()
+        {
+            bvhPairs = 0u;
+            _engine.findOverlappingPairs([&](SCompoundCollider*, SCompoundCollider*) {bvhPairs++; return true;});
+        }
+    );
+    if (_colliders.size()<=MAX_BRUTE_FORCE_PAIRS_COLLIDERS)
+    {
+        size_t bruteForcePairs = 0u;
+        const double bruteForceMs = measureMs([&]()
+            {
+                bruteForcePairs = 0u;
+                for (size_t i=0u; i<bounds.size(); i++)
+                for (size_t j=i+1u; j<bounds.size(); j++)
+                    bruteForcePairs += bounds[i].intersectsWithBox(bounds[j]);
+            }
+        );
+        result.pairsSpeedup = bruteForceMs/result.pairs;
+        result.mismatches += bruteForcePairs!=bvhPairs;
+    }
+    return result;
+}
+
+//! Single ray FastCollide against the batched one, on the same rays, in rays/sec
+static void benchmarkBatched(const SCollisionEngine& _engine, const core::vector<SRay>& _rays, double& _single, double& _batched, size_t& _mismatches)
+{
+    core::vector<SCollisionRay> batch(_rays.size());
+    for (size_t i=0u; i<_rays.size(); i++)
+    {
+        batch[i].origin = _rays[i].origin;
+        batch[i].direction = _rays[i].direction;
+        batch[i].maxRayLen = 2.f*WORLD_SIZE;
+    }
+    core::vector<SHit> singleHits(_rays.size());
+    core::vector<SCollisionHit> batchedHits(_rays.size());
+
+    const double singleMs = measureMs([&]()
+        {
+            for (size_t i=0u; i<_rays.size(); i++)
+            {
+                SColliderData data;
+                singleHits[i].hit = _engine.FastCollide(data,singleHits[i].distance,_rays[i].origin,_rays[i].direction,2.f*WORLD_SIZE);
+            }
+        }
+    );
+    const double batchedMs = measureMs([&]() {_engine.FastCollide(batchedHits.data(),batch.data(),batch.size());});
+
+    for (size_t i=0u; i<_rays.size(); i++)
+        _mismatches += !sameHit(singleHits[i],{batchedHits[i].hit,batchedHits[i].collisionDistance});
+    _single = double(_rays.size())*1000.0/singleMs;
+    _batched = double(_rays.size())*1000.0/batchedMs;
+}
+
+//! Boxes and ellipsoids attached to nodes scattered around the world
+static SBatchResult benchmarkEngine(size_t _count, std::mt19937& _generator, SOverlapResult& _overlapResult)
+{
+    std::uniform_real_distribution<float> position(-0.5f*WORLD_SIZE,0.5f*WORLD_SIZE);
+    std::uniform_real_distribution<float> extent(0.5f,10.f);
+    std::uniform_real_distribution<float> unit(-1.f,1.f);
+
+    SCollisionEngine engine;
+    core::vector<CColliderNode*> nodes(_count);
+    core::vector<SCompoundCollider*> colliders(_count);
+    for (size_t i=0u; i<_count; i++)
+    {
+        nodes[i] = new CColliderNode();
+        nodes[i]->setPosition(vector3df(position(_generator),position(_generator),position(_generator)));
+        nodes[i]->setRotation(vector3df(unit(_generator),unit(_generator),unit(_generator))*180.f);
+        nodes[i]->updateAbsolutePosition();
+
+        colliders[i] = new SCompoundCollider();
+        if (i&0x1u)
+            colliders[i]->AddEllipsoid(vectorSIMDf(0.f),vectorSIMDf(extent(_generator),extent(_generator),extent(_generator)));
+        else
+            colliders[i]->AddBox(SAABoxCollider(aabbox3df(-extent(_generator),-extent(_generator),-extent(_generator),extent(_generator),extent(_generator),extent(_generator))));
+        SColliderData data;
+        data.attachedNode = nodes[i];
+        colliders[i]->setColliderData(data);
+        engine.addCompoundCollider(colliders[i]);
+    }
+
+    const core::vector<SRay> rays = randomRays(RAY_COUNT,WORLD_SIZE,_generator);
+    const size_t bruteForceRays = core::min_<size_t>(RAY_COUNT,core::max_<size_t>(BRUTE_FORCE_BUDGET/_count,64u));
+    core::vector<SHit> bruteForceHits(bruteForceRays), bvhHits(RAY_COUNT);
+    auto castBruteForce = [&]()
+    {
+        for (size_t i=0u; i<bruteForceRays; i++)
+            bruteForceHits[i] = bruteForce(colliders,rays[i],WORLD_SIZE);
+    };
+    auto castBVH = [&]()
+    {
+        for (size_t i=0u; i<RAY_COUNT; i++)
+        {
+            SColliderData data;
+            bvhHits[i].hit = engine.FastCollide(data,bvhHits[i].distance,rays[i].origin,rays[i].direction,WORLD_SIZE);
+        }
+    };
+    auto countMismatches = [&]()
+    {
+        size_t mismatches = 0u;
+        for (size_t i=0u; i<bruteForceRays; i++)
+            mismatches += !sameHit(bruteForceHits[i],bvhHits[i]);
+        return mismatches;
+    };
+
+    const double bruteForceMs = measureMs(castBruteForce);
+    const double buildMs = measureMs([&]()
+        {
+            // force a full rebuild every time
+            engine.removeCompoundCollider(colliders[0]);
+            engine.addCompoundCollider(colliders[0]);
+            engine.refit();
+        }
+    );
+    const double bvhMs = measureMs(castBVH);
+    size_t hitCount = 0u;
+    for (size_t i=0u; i<bruteForceRays; i++)
+        hitCount += bruteForceHits[i].hit;
+    size_t mismatches = countMismatches();
+
+    // a tenth of the colliders move a bit every frame
+    const double refitMs = measureMs([&]()
+        {
+            for (size_t i=0u; i<_count; i+=10u)
+            {
+                nodes[i]->setPosition(nodes[i]->getPosition()+vector3df(unit(_generator),unit(_generator),unit(_generator)));
+                nodes[i]->updateAbsolutePosition();
+            }
+            engine.refit();
+        }
+    );
+    castBruteForce();
+    castBVH();
+    mismatches += countMismatches();
+
+    printf("%10u %7.2f%% %10.2f %14.0f %14.0f %9.2fx %10.3f %10u\n",uint32_t(_count),100.0*double(hitCount)/double(bruteForceRays),buildMs,
+        double(bruteForceRays)*1000.0/bruteForceMs,double(RAY_COUNT)*1000.0/bvhMs,(bruteForceMs/double(bruteForceRays))/(bvhMs/double(RAY_COUNT)),refitMs,uint32_t(mismatches));
+
+    SBatchResult batchResult = {_count,0.0,0.0,0.0,0.0,0u};
+    benchmarkBatched(engine,rays,batchResult.singleRandom,batchResult.batchedRandom,batchResult.mismatches);
+    benchmarkBatched(engine,cameraRays(RAY_COUNT),batchResult.singleCoherent,batchResult.batchedCoherent,batchResult.mismatches);
+    _overlapResult = benchmarkOverlaps(engine,colliders,_generator);
+
+    for (size_t i=0u; i<_count; i++)
+    {
+        colliders[i]->drop();
+        nodes[i]->drop();
+    }
+    return batchResult;
+}
+
+//! A bumpy sphere made of `_rings*_segments*2` triangles, brute force tests every triangle like STriangleMeshCollider did before it had a BVH
+static void benchmarkMesh(uint32_t _rings, uint32_t _segments, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> bump(0.95f,1.05f);
+    core::vector<float> vertices;
+    for (uint32_t i=0u; i<=_rings; i++)
+    for (uint32_t j=0u; j<=_segments; j++)
+    {
+        const float theta = core::PI*float(i)/float(_rings);
+        const float phi = 2.f*core::PI*float(j)/float(_segments);
+        const float radius = 0.25f*WORLD_SIZE*bump(_generator);
+        vertices.push_back(radius*sinf(theta)*cosf(phi));
+        vertices.push_back(radius*cosf(theta));
+        vertices.push_back(radius*sinf(theta)*sinf(phi));
+    }
+    core::vector<uint32_t> indices;
+    for (uint32_t i=0u; i<_rings; i++)
+    for (uint32_t j=0u; j<_segments; j++)
+    {
+        const uint32_t corner = i*(_segments+1u)+j;
+        const uint32_t quad[6] = {corner,corner+_segments+1u,corner+1u,corner+1u,corner+_segments+1u,corner+_segments+2u};
+        indices.insert(indices.end(),quad,quad+6);
+    }
+
+    STriangleMeshCollider* mesh = new STriangleMeshCollider();
+    const double buildMs = measureMs([&]()
+        {
+            mesh->drop();
+            mesh = new STriangleMeshCollider();
+            mesh->Init(vertices.data(),indices.size(),indices.data());
+        }
+    );
+    core::vector<STriangleCollider> triangles;
+    for (size_t i=0u; i<indices.size(); i+=3u)
+    {
+        bool valid;
+        const float* v[3] = {vertices.data()+indices[i]*3u,vertices.data()+indices[i+1u]*3u,vertices.data()+indices[i+2u]*3u};
+        STriangleCollider triangle(vectorSIMDf(v[0][0],v[0][1],v[0][2]),vectorSIMDf(v[1][0],v[1][1],v[1][2]),vectorSIMDf(v[2][0],v[2][1],v[2][2]),valid);
+        if (valid)
+            triangles.push_back(triangle);
+    }
+
+    // rays from all around the sphere, most of them go through it
+    const core::vector<SRay> rays = randomRays(RAY_COUNT,WORLD_SIZE,_generator);
+    const size_t bruteForceRays = core::min_<size_t>(RAY_COUNT,core::max_<size_t>(BRUTE_FORCE_BUDGET/triangles.size(),64u));
+    core::vector<SHit> bruteForceHits(bruteForceRays), bvhHits(RAY_COUNT);
+    const double bruteForceMs = measureMs([&]()
+        {
+            for (size_t i=0u; i<bruteForceRays; i++)
+            {
+                SHit& hit = bruteForceHits[i];
+                hit = {false,WORLD_SIZE};
+                for (const auto& triangle : triangles)
+                {
+                    float distance;
+                    if (triangle.CollideWithRay(distance,rays[i].origin,rays[i].direction,hit.distance)&&distance<hit.distance)
+                    {
+                        hit.distance = distance;
+                        hit.hit = true;
+                    }
+                }
+            }
+        }
+    );
+    const double bvhMs = measureMs([&]()
+        {
+            for (size_t i=0u; i<RAY_COUNT; i++)
+                bvhHits[i].hit = mesh->CollideWithRay(bvhHits[i].distance,rays[i].origin,rays[i].direction,WORLD_SIZE);
+        }
+    );
+
+    size_t hitCount = 0u, mismatches = 0u;
+    for (size_t i=0u; i<bruteForceRays; i++)
+    {
+        hitCount += bruteForceHits[i].hit;
+        mismatches += !sameHit(bruteForceHits[i],bvhHits[i]);
+    }
+    printf("%10u %7.2f%% %10.2f %14.0f %14.0f %9.2fx %10s %10u\n",uint32_t(triangles.size()),100.0*double(hitCount)/double(bruteForceRays),buildMs,
+        double(bruteForceRays)*1000.0/bruteForceMs,double(RAY_COUNT)*1000.0/bvhMs,(bruteForceMs/double(bruteForceRays))/(bvhMs/double(RAY_COUNT)),"-",uint32_t(mismatches));
+
+    mesh->drop();
+}
+
+int main()
+{
+    printf("Task scheduler concurrency: %u\n",core::CTaskScheduler::getDefault()->getConcurrency());
+    printf("Best of %u runs, rays/sec of single threaded closest hit queries, build and refit in milliseconds,\n",REPETITIONS);
+    printf("brute force tests every collider or triangle (on at most %u rays), mismatches are rays on which it disagrees with the BVH\n",RAY_COUNT);
+    printf("%10s %8s %10s %14s %14s %10s %10s %10s\n","colliders","hit","build","brute force","BVH","speedup","refit 10%","mismatches");
+
+    std::mt19937 generator(0x45u);
+    core::vector<SBatchResult> batchResults;
+    core::vector<SOverlapResult> overlapResults;
+    for (size_t count=1024u; count<=(1u<<16u); count*=8u)
+    {
+        overlapResults.emplace_back();
+        batchResults.push_back(benchmarkEngine(count,generator,overlapResults.back()));
+    }
+
+    printf("%10s %8s %10s %14s %14s %10s %10s %10s\n","triangles","hit","build","brute force","BVH","speedup","","mismatches");
+    for (uint32_t rings=16u; rings<=512u; rings*=4u)
+        benchmarkMesh(rings,rings*2u,generator);
+
+    printf("Rays/sec of one FastCollide per ray and of the batched FastCollide, random rays and a camera's primary rays in 2x2 tiles\n");
+    printf("%10s %14s %14s %9s %14s %14s %9s %10s\n","colliders","random single","batched","speedup","camera single","batched","speedup","mismatches");
+    for (const auto& result : batchResults)
+        printf("%10u %14.0f %14.0f %8.2fx %14.0f %14.0f %8.2fx %10u\n",uint32_t(result.count),result.singleRandom,result.batchedRandom,result.batchedRandom/result.singleRandom,
+            result.singleCoherent,result.batchedCoherent,result.batchedCoherent/result.singleCoherent,uint32_t(result.mismatches));
+
+    printf("Overlap queries/sec (box, sphere, frustum) and milliseconds to find all overlapping pairs, speedups over brute force\n");
+    printf("%10s %12s %9s %12s %9s %12s %9s %10s %9s %10s\n","colliders","box","speedup","sphere","speedup","frustum","speedup","pairs","speedup","mismatches");
+    for (const auto& result : overlapResults)
+        printf("%10u %12.0f %8.2fx %12.0f %8.2fx %12.0f %8.2fx %10.2f %8.2fx %10u\n",uint32_t(result.count),result.box,result.boxSpeedup,result.sphere,result.sphereSpeedup,
+            result.frustum,result.frustumSpeedup,result.pairs,result.pairsSpeedup,uint32_t(result.mismatches));
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+#include "../source/Irrlicht/CInstanceLoDCuller.h"
+
+using namespace irr;
+using namespace core;
+
+#define WORLD_SIZE 2000.f
+#define REPETITIONS 5u
+
+// same layout as CMeshSceneNodeInstanced's instance input data without extra data, transform, 3x3 inverse transpose, visibility
+#define INSTANCE_STRIDE (48u+36u+4u)
+#define VISIBILITY_OFFSET (48u+36u)
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+//! What a typical CPUInstanceOutputFunc does, output the world transform
+static void writeWorldTransform(void* _output, const matrix4x3& _worldTransform, const uint8_t* _instanceData, uint32_t _lod)
+{
+    memcpy(_output,_worldTransform.pointer(),sizeof(matrix4x3));
+}
+
+//! The LoD selection shader's math for one instance at a time, LoDCount when culled
+static uint32_t classifyOneByOne(const uint8_t* _instance, const matrix4x3& _node, const aabbox3df& _box, const scene::SViewFrustum& _frustum,
+                                const vector3df& _eye, const core::vector<float>& _lodDistancesSQ, matrix4x3& _outWorld)
+{
+    const uint32_t lodCount = _lodDistancesSQ.size();
+    _outWorld = concatenateBFollowedByA(_node,*reinterpret_cast<const matrix4x3*>(_instance));
+    if (!_instance[VISIBILITY_OFFSET])
+        return lodCount;
+
+    aabbox3df box = _box;
+    _outWorld.transformBoxEx(box);
+    if (!_frustum.intersectsAABB(box))
+        return lodCount;
+
+    vector3df center = _box.getCenter();
+    _outWorld.transformVect(&center.X);
+    const float distanceSQ = (center-_eye).getLengthSQ();
+    uint32_t lod = 0u;
+    while (lod<lodCount&&distanceSQ>=_lodDistancesSQ[lod])
+        lod++;
+    return lod;
+}
+
+static void benchmark(size_t _count, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> position(-0.5f*WORLD_SIZE,0.5f*WORLD_SIZE);
+    std::uniform_real_distribution<float> angle(0.f,360.f);
+    std::uniform_int_distribution<uint32_t> hidden(0u,15u);
+
+    core::vector<uint8_t> instances(_count*INSTANCE_STRIDE);
+    for (size_t i=0u; i<_count; i++)
+    {
+        matrix4x3 transform;
+        transform.setRotationDegrees(vector3df(angle(_generator),angle(_generator),angle(_generator)));
+        transform.setTranslation(vector3df(position(_generator),position(_generator),position(_generator)));
+        uint8_t* instance = instances.data()+i*INSTANCE_STRIDE;
+        memcpy(instance,transform.pointer(),sizeof(matrix4x3));
+        instance[VISIBILITY_OFFSET] = hidden(_generator) ? 0xffu:0u;
+    }
+
+    matrix4x3 node;
+    node.setRotationDegrees(vector3df(0.f,30.f,0.f));
+    node.setTranslation(vector3df(10.f,-20.f,30.f));
+    const aabbox3df lodInvariantBox(-2.f,-1.f,-3.f,2.f,4.f,3.f);
+    const core::vector<float> lodDistancesSQ = {150.f*150.f,400.f*400.f,1000.f*1000.f};
+    const uint32_t lodCount = lodDistancesSQ.size();
+
+    // a camera in the middle of the world looking along +Z, like CCameraSceneNode sets it up
+    const vector3df eye(0.f);
+    const matrix4SIMD projection = matrix4SIMD::buildProjectionMatrixPerspectiveFovRH(0.5f*core::PI,16.f/9.f,1.f,WORLD_SIZE);
+    const matrix3x4SIMD view = matrix3x4SIMD::buildCameraLookAtMatrixLH(vectorSIMDf(0.f),vectorSIMDf(0.f,0.f,1.f),vectorSIMDf(0.f,1.f,0.f));
+    const scene::SViewFrustum frustum(concatenateBFollowedByA(projection,view));
+
+    // one list per LoD, then copied back to back like the GPU path's separate transform feedback buffers
+    core::vector<uint8_t> oneByOneLoDs(_count);
+    core::vector<core::vector<matrix4x3> > lodLists(lodCount);
+    core::vector<uint8_t> oneByOneOutput(_count*sizeof(matrix4x3));
+    const double oneByOneMs = measureMs([&]()
+        {
+            for (uint32_t lod=0u; lod<lodCount; lod++)
+                lodLists[lod].clear();
+            for (size_t i=0u; i<_count; i++)
+            {
+                matrix4x3 world;
+                const uint32_t lod = classifyOneByOne(instances.data()+i*INSTANCE_STRIDE,node,lodInvariantBox,frustum,eye,lodDistancesSQ,world);
+                oneByOneLoDs[i] = lod;
+                if (lod<lodCount)
+                    lodLists[lod].push_back(world);
+            }
+            uint8_t* out = oneByOneOutput.data();
+            for (uint32_t lod=0u; lod<lodCount; lod++)
+            for (const auto& world : lodLists[lod])
+            {
+                writeWorldTransform(out,world,nullptr,lod);
+                out += sizeof(matrix4x3);
+            }
+        }
+    );
+
+    scene::CInstanceLoDCuller culler;
+    culler.setLoDs(lodInvariantBox,lodDistancesSQ.data(),lodCount);
+    core::vector<uint8_t> batchedOutput(_count*sizeof(matrix4x3));
+    const double batchedMs = measureMs([&]()
+        {
+            culler.classify(instances.data(),_count,INSTANCE_STRIDE,VISIBILITY_OFFSET,node,&frustum,eye);
+            culler.write(batchedOutput.data(),sizeof(matrix4x3),writeWorldTransform);
+        }
+    );
+
+    size_t visible = 0u, mismatches = 0u;
+    for (size_t i=0u; i<_count; i++)
+    {
+        const uint32_t lod = culler.getInstanceLoD(i);
+        visible += oneByOneLoDs[i]<lodCount;
+        mismatches += (lod==scene::CInstanceLoDCuller::CulledLoD ? lodCount:lod)!=oneByOneLoDs[i];
+    }
+    const bool sameOutput = culler.getVisibleInstanceCount()==visible&&memcmp(oneByOneOutput.data(),batchedOutput.data(),visible*sizeof(matrix4x3))==0;
+
+    printf("%9u %9u %12.2f %12.2f %8.2fx %10u %s\n",uint32_t(_count),uint32_t(visible),oneByOneMs,batchedMs,oneByOneMs/batchedMs,uint32_t(mismatches),sameOutput ? "yes":"NO");
+}
+
+int main()
+{
+    printf("Task scheduler concurrency: %u\n",core::CTaskScheduler::getDefault()->getConcurrency());
+    printf("Best of %u runs in milliseconds, one by one is the culling shader's math for every instance with a list per LoD,\n",REPETITIONS);
+    printf("batched is CInstanceLoDCuller (classify and write), mismatches are instances whose LoD or culling differs\n");
+    printf("%9s %9s %12s %12s %9s %10s %s\n","instances","visible","one by one","batched","speedup","mismatches","same output");
+
+    std::mt19937 generator(0x45u);
+    for (size_t count=1024u; count<=(1u<<20u); count*=8u)
+        benchmark(count,generator);
+
+    return 0;
+}
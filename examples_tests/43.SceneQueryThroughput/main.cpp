@@ -0,0 +1,302 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../source/Irrlicht/CSceneNodeSpatialIndex.h"
+
+using namespace irr;
+using namespace core;
+
+#define WORLD_SIZE 4000.f
+#define REPETITIONS 5u
+#define QUERY_COUNT 1024u
+#define NEAREST_K 8u
+//! fraction of the nodes which move every frame
+#define MOVING_FRACTION 0.1f
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+//! The least a scene node can be, a box
+class CBoxNode : public scene::ISceneNode
+{
+        aabbox3df Box;
+    public:
+        CBoxNode(const aabbox3df& _box, scene::IDummyTransformationSceneNode* _parent=nullptr, scene::ISceneManager* _mgr=nullptr, bool _levelOrdered=true)
+            : scene::ISceneNode(_parent,_mgr), Box(_box), LevelOrdered(_levelOrdered) {}
+
+        void render() override {}
+        const aabbox3df& getBoundingBox() override {return Box;}
+        //! false makes the scene manager animate the node's whole subtree depth first, like it does for skinned meshes
+        bool supportsLevelOrderedUpdate() const override {return LevelOrdered;}
+    private:
+        bool LevelOrdered;
+};
+
+static float getDistanceSQ(const aabbox3df& _box, const vector3df& _point)
+{
+    const vector3df closest(core::clamp(_point.X,_box.MinEdge.X,_box.MaxEdge.X),core::clamp(_point.Y,_box.MinEdge.Y,_box.MaxEdge.Y),core::clamp(_point.Z,_box.MinEdge.Z,_box.MaxEdge.Z));
+    return (closest-_point).getLengthSQ();
+}
+
+//! What a walk over the whole scene graph does for every query, minus the walking
+struct SBruteForce
+{
+    core::vector<scene::ISceneNode*> nodes;
+    core::vector<aabbox3df> boxes;
+
+    void getNodesInBox(const aabbox3df& _box, core::vector<scene::ISceneNode*>& _out) const
+    {
+        for (size_t i=0u; i<boxes.size(); i++)
+        if (boxes[i].intersectsWithBox(_box))
+            _out.push_back(nodes[i]);
+    }
+    void getNodesInSphere(const vector3df& _center, float _radius, core::vector<scene::ISceneNode*>& _out) const
+    {
+        for (size_t i=0u; i<boxes.size(); i++)
+        if (getDistanceSQ(boxes[i],_center)<=_radius*_radius)
+            _out.push_back(nodes[i]);
+    }
+    void getNodesInFrustum(const scene::SViewFrustum& _frustum, core::vector<scene::ISceneNode*>& _out) const
+    {
+        for (size_t i=0u; i<boxes.size(); i++)
+        if (boxes[i].intersectsWithBox(_frustum.getBoundingBox())&&_frustum.intersectsAABB(boxes[i]))
+            _out.push_back(nodes[i]);
+    }
+    void getNearestNodes(const vector3df& _point, uint32_t _k, core::vector<scene::ISceneNode*>& _out) const
+    {
+        core::vector<std::pair<float,scene::ISceneNode*> > all(boxes.size());
+        for (size_t i=0u; i<boxes.size(); i++)
+            all[i] = {getDistanceSQ(boxes[i],_point),nodes[i]};
+        const size_t count = core::min_<size_t>(_k,all.size());
+        std::partial_sort(all.begin(),all.begin()+count,all.end(),[](const auto& a, const auto& b) {return a.first<b.first;});
+        for (size_t i=0u; i<count; i++)
+            _out.push_back(all[i].second);
+    }
+};
+
+//! Runs every query on both, returns how many of them disagree
+template<typename Q>
+static size_t countMismatches(const SBruteForce& _bruteForce, const scene::CSceneNodeSpatialIndex& _index, size_t _queryCount, Q&& _query, bool _ordered=false)
+{
+    size_t mismatches = 0u;
+    core::vector<scene::ISceneNode*> expected, result;
+    for (size_t i=0u; i<_queryCount; i++)
+    {
+        expected.clear();
+        result.clear();
+        _query(_bruteForce,expected,i);
+        _query(_index,result,i);
+        // nearest queries may break ties between equally far nodes differently
+        if (!_ordered)
+        {
+            std::sort(expected.begin(),expected.end());
+            std::sort(result.begin(),result.end());
+        }
+        mismatches += expected!=result;
+    }
+    return mismatches;
+}
+
+static void benchmark(size_t _count, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> position(-0.5f*WORLD_SIZE,0.5f*WORLD_SIZE);
+    std::uniform_real_distribution<float> extent(0.5f,10.f);
+    std::uniform_real_distribution<float> chance(0.f,1.f);
+
+    SBruteForce bruteForce;
+    bruteForce.nodes.resize(_count);
+    bruteForce.boxes.resize(_count);
+    for (size_t i=0u; i<_count; i++)
+    {
+        // a few buildings among the props
+        const float scale = chance(_generator)<0.02f ? 20.f:1.f;
+        auto node = new CBoxNode(aabbox3df(vector3df(-extent(_generator),-extent(_generator),-extent(_generator))*scale,vector3df(extent(_generator),extent(_generator),extent(_generator))*scale));
+        node->setPosition(vector3df(position(_generator),position(_generator),position(_generator)));
+        node->updateAbsolutePosition();
+        bruteForce.nodes[i] = node;
+        bruteForce.boxes[i] = node->getTransformedBoundingBox();
+    }
+
+    scene::CSceneNodeSpatialIndex index(8.f);
+    const double buildMs = measureMs([&]()
+        {
+            index.clear();
+            for (auto node : bruteForce.nodes)
+                index.update(node);
+        }
+    );
+
+    // what the scene manager does every frame, with a tenth of the nodes moving
+    core::vector<scene::ISceneNode*> moving;
+    for (auto node : bruteForce.nodes)
+    if (chance(_generator)<MOVING_FRACTION)
+        moving.push_back(node);
+    const double frameMs = measureMs([&]()
+        {
+            for (auto node : moving)
+            {
+                node->setPosition(node->getPosition()+vector3df(1.f,0.f,0.5f));
+                node->updateAbsolutePosition();
+            }
+            index.beginGeneration();
+            for (auto node : bruteForce.nodes)
+                index.touch(node);
+            for (auto node : moving)
+                index.update(node);
+            index.endGeneration();
+        }
+    );
+    for (size_t i=0u; i<_count; i++)
+        bruteForce.boxes[i] = bruteForce.nodes[i]->getTransformedBoundingBox();
+
+    core::vector<vector3df> points(QUERY_COUNT);
+    for (auto& point : points)
+        point.set(position(_generator),position(_generator),position(_generator));
+    auto boxQuery = [&](const auto& _structure, core::vector<scene::ISceneNode*>& _out, size_t _i)
+    {
+        _structure.getNodesInBox(aabbox3df(points[_i]-vector3df(50.f),points[_i]+vector3df(50.f)),_out);
+    };
+    auto sphereQuery = [&](const auto& _structure, core::vector<scene::ISceneNode*>& _out, size_t _i)
+    {
+        _structure.getNodesInSphere(points[_i],50.f,_out);
+    };
+    auto nearestQuery = [&](const auto& _structure, core::vector<scene::ISceneNode*>& _out, size_t _i)
+    {
+        _structure.getNearestNodes(points[_i],NEAREST_K,_out);
+    };
+    // a camera in the middle of the world, looking along +Z, with a view distance of an eighth of the world
+    const matrix4SIMD projection = matrix4SIMD::buildProjectionMatrixPerspectiveFovRH(0.5f*core::PI,16.f/9.f,1.f,WORLD_SIZE/8.f);
+    const matrix3x4SIMD view = matrix3x4SIMD::buildCameraLookAtMatrixLH(vectorSIMDf(0.f),vectorSIMDf(0.f,0.f,1.f),vectorSIMDf(0.f,1.f,0.f));
+    const scene::SViewFrustum frustum(concatenateBFollowedByA(projection,view));
+    auto frustumQuery = [&](const auto& _structure, core::vector<scene::ISceneNode*>& _out, size_t _i)
+    {
+        _structure.getNodesInFrustum(frustum,_out);
+    };
+
+    core::vector<scene::ISceneNode*> out;
+    auto timeQueries = [&](const auto& _structure, auto& _query, size_t _queryCount)
+    {
+        return measureMs([&]()
+            {
+                for (size_t i=0u; i<_queryCount; i++)
+                {
+                    out.clear();
+                    _query(_structure,out,i);
+                }
+            }
+        );
+    };
+    // keep the brute force runs bounded
+    const size_t bruteForceQueries = core::max_<size_t>(QUERY_COUNT*1024u/_count,16u);
+    const double bruteForceMs[4] = {
+        timeQueries(bruteForce,boxQuery,bruteForceQueries)*QUERY_COUNT/bruteForceQueries,
+        timeQueries(bruteForce,sphereQuery,bruteForceQueries)*QUERY_COUNT/bruteForceQueries,
+        timeQueries(bruteForce,nearestQuery,bruteForceQueries)*QUERY_COUNT/bruteForceQueries,
+        timeQueries(bruteForce,frustumQuery,1u)
+    };
+    const double indexMs[4] = {
+        timeQueries(index,boxQuery,QUERY_COUNT),
+        timeQueries(index,sphereQuery,QUERY_COUNT),
+        timeQueries(index,nearestQuery,QUERY_COUNT),
+        timeQueries(index,frustumQuery,1u)
+    };
+    const size_t mismatches =   countMismatches(bruteForce,index,bruteForceQueries,boxQuery)+countMismatches(bruteForce,index,bruteForceQueries,sphereQuery)+
+                                countMismatches(bruteForce,index,bruteForceQueries,nearestQuery)+countMismatches(bruteForce,index,1u,frustumQuery);
+
+    printf("%9u %9.2f %9.2f",uint32_t(_count),buildMs,frameMs);
+    for (uint32_t i=0u; i<4u; i++)
+        printf(" %8.1fx",bruteForceMs[i]/indexMs[i]);
+    printf(" %10u\n",uint32_t(mismatches));
+
+    index.clear();
+    for (auto node : bruteForce.nodes)
+        node->drop();
+}
+
+static bool check(const char* _name, bool _passed)
+{
+    printf("  %-64s %s\n",_name,_passed ? "ok":"FAILED");
+    return _passed;
+}
+
+static bool isInBox(scene::ISceneManager* _smgr, const aabbox3df& _box, scene::ISceneNode* _node)
+{
+    core::vector<scene::ISceneNode*> found;
+    _smgr->getSceneNodesInBox(_box,found);
+    return std::find(found.begin(),found.end(),_node)!=found.end();
+}
+
+//! The scene manager's index has to keep the nodes below a skinned mesh, whose subtree does not get animated level by level
+static bool testSceneManager()
+{
+    printf("Scene manager index below a recursively animated node:\n");
+    bool ok = true;
+
+    irr::SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return check("device created",false);
+    auto smgr = device->getSceneManager();
+    smgr->setSpatialIndexEnabled(true);
+
+    const aabbox3df unitBox(-0.5f,-0.5f,-0.5f,0.5f,0.5f,0.5f);
+    auto skinned = new CBoxNode(unitBox,smgr->getRootSceneNode(),smgr,false);
+    auto attachment = new CBoxNode(unitBox,skinned,smgr);
+    auto nested = new CBoxNode(unitBox,attachment,smgr);
+    attachment->setPosition(vector3df(10.f,0.f,0.f));
+
+    const aabbox3df around(vector3df(9.f,-1.f,-1.f),vector3df(11.f,1.f,1.f));
+    for (uint32_t frame=0u; frame<3u; frame++)
+        smgr->drawAll();
+    ok = check("the skinned node stays indexed",isInBox(smgr,unitBox,skinned))&&ok;
+    ok = check("its descendants stay indexed across frames",isInBox(smgr,around,attachment)&&isInBox(smgr,around,nested))&&ok;
+
+    skinned->setPosition(vector3df(0.f,100.f,0.f));
+    smgr->drawAll();
+    const aabbox3df moved(around.MinEdge+vector3df(0.f,100.f,0.f),around.MaxEdge+vector3df(0.f,100.f,0.f));
+    ok = check("moving the skinned node moves its descendants in the index",isInBox(smgr,moved,attachment)&&!isInBox(smgr,around,attachment))&&ok;
+
+    attachment->setVisible(false);
+    smgr->drawAll();
+    ok = check("an invisible descendant gets dropped with its subtree",!isInBox(smgr,moved,attachment)&&!isInBox(smgr,moved,nested))&&ok;
+
+    nested->drop();
+    attachment->drop();
+    skinned->drop();
+    device->drop();
+    return ok;
+}
+
+int main()
+{
+    const bool ok = testSceneManager();
+
+    printf("Task scheduler concurrency: %u\n",core::CTaskScheduler::getDefault()->getConcurrency());
+    printf("Best of %u runs in milliseconds, build inserts every node, frame touches every node and moves %.0f%% of them,\n",REPETITIONS,MOVING_FRACTION*100.f);
+    printf("speedups are CSceneNodeSpatialIndex over testing every node's world box for %u box, sphere and %u-nearest queries and one frustum query,\n",QUERY_COUNT,NEAREST_K);
+    printf("mismatches are queries on which the two disagree\n");
+    printf("%9s %9s %9s %9s %9s %9s %9s %10s\n","nodes","build","frame","box","sphere","nearest","frustum","mismatches");
+
+    std::mt19937 generator(0x45u);
+    for (size_t count=1024u; count<=(1u<<20u); count*=8u)
+        benchmark(count,generator);
+
+    return ok ? 0:1;
+}
@@ -0,0 +1,229 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+
+using namespace irr;
+using namespace core;
+
+#define REPETITIONS 5u
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+//! An uber shader, specialization picks the material and whether there is fog
+static const char* FragmentShader = R"===(
+#version 450 core
+
+layout(constant_id = 0) const uint MATERIAL = 0u;
+layout(constant_id = 1) const bool FOG = true;
+layout(constant_id = 2) const uint LIGHT_COUNT = 4u;
+
+layout(location = 0) in vec3 WorldPos;
+layout(location = 1) in vec3 Normal;
+layout(location = 2) in vec2 UV;
+layout(location = 0) out vec4 Color;
+
+layout(set = 0, binding = 0) uniform sampler2D Albedo;
+layout(set = 0, binding = 1) uniform Lights
+{
+    vec4 positionAndRadius[16];
+    vec4 color[16];
+    vec4 cameraPosAndFogDensity;
+};
+
+float ggx(float NdotH, float roughness)
+{
+    float a2 = roughness*roughness*roughness*roughness;
+    float d = NdotH*NdotH*(a2-1.0)+1.0;
+    return a2/(3.14159265*d*d);
+}
+
+vec3 lambert(vec3 albedo, vec3 N, vec3 L)
+{
+    return albedo*max(dot(N,L),0.0);
+}
+
+vec3 blinnPhong(vec3 albedo, vec3 N, vec3 L, vec3 V)
+{
+    vec3 H = normalize(L+V);
+    return lambert(albedo,N,L)+vec3(pow(max(dot(N,H),0.0),64.0));
+}
+
+vec3 cookTorrance(vec3 albedo, vec3 N, vec3 L, vec3 V)
+{
+    vec3 H = normalize(L+V);
+    float NdotL = max(dot(N,L),0.0);
+    float NdotV = max(dot(N,V),0.0001);
+    float fresnel = 0.04+0.96*pow(1.0-max(dot(H,V),0.0),5.0);
+    float spec = ggx(max(dot(N,H),0.0),0.4)*fresnel/(4.0*NdotV);
+    return (albedo*(1.0-fresnel)/3.14159265+vec3(spec))*NdotL;
+}
+
+void main()
+{
+    vec3 albedo = texture(Albedo,UV).rgb;
+    vec3 N = normalize(Normal);
+    vec3 V = normalize(cameraPosAndFogDensity.xyz-WorldPos);
+
+    vec3 result = vec3(0.0);
+    for (uint i=0u; i<LIGHT_COUNT; i++)
+    {
+        vec3 toLight = positionAndRadius[i].xyz-WorldPos;
+        float attenuation = max(1.0-length(toLight)/positionAndRadius[i].w,0.0);
+        vec3 L = normalize(toLight);
+        vec3 lit;
+        if (MATERIAL==0u)
+            lit = lambert(albedo,N,L);
+        else if (MATERIAL==1u)
+            lit = blinnPhong(albedo,N,L,V);
+        else
+            lit = cookTorrance(albedo,N,L,V);
+        result += lit*color[i].rgb*attenuation;
+    }
+
+    if (FOG)
+    {
+        float fog = exp(-cameraPosAndFogDensity.w*length(cameraPosAndFogDensity.xyz-WorldPos));
+        result = mix(vec3(0.5,0.6,0.7),result,fog);
+    }
+    Color = vec4(result,1.0);
+}
+)===";
+
+//! A prefix sum, lots of barriers and shared memory
+static const char* ComputeShader = R"===(
+#version 450 core
+
+layout(local_size_x = 256) in;
+
+layout(set = 0, binding = 0) buffer Data
+{
+    uint values[];
+};
+shared uint scratch[256];
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    uint local = gl_LocalInvocationIndex;
+    scratch[local] = values[index];
+    barrier();
+    for (uint offset=1u; offset<256u; offset<<=1u)
+    {
+        uint addend = local>=offset ? scratch[local-offset]:0u;
+        barrier();
+        scratch[local] += addend;
+        barrier();
+    }
+    values[index] = scratch[local];
+}
+)===";
+
+static size_t getByteSize(const asset::ICPUShader* _shader)
+{
+    return _shader ? _shader->getSPIR_VBytecode()->getSize():0u;
+}
+
+//! Prints one row per option set, sizes relative to what the compiler emitted
+template<typename F>
+static void printRow(const char* _name, const asset::CSPIRVOptimizer* _optimizer, size_t _originalSize, F&& _makeShader)
+{
+    asset::ICPUShader* shader = nullptr;
+    const double ms = measureMs([&]()
+        {
+            if (shader)
+                shader->drop();
+            shader = _makeShader();
+        }
+    );
+    const size_t size = getByteSize(shader);
+    const bool valid = shader && _optimizer->validate(shader);
+    printf("  %-34s %9u %8.1f%% %9.2f %6s\n",_name,uint32_t(size),100.0*double(size)/double(_originalSize),ms,valid ? "yes":"NO");
+    if (shader)
+        shader->drop();
+}
+
+static void benchmark(const char* _name, asset::IGLSLCompiler* _compiler, const asset::CSPIRVOptimizer* _optimizer, const char* _glsl, asset::E_SHADER_STAGE _stage, bool _debug)
+{
+    asset::ICPUShader* original = _compiler->createShaderFromGLSL(_glsl,_stage,"main",_debug,_name);
+    if (!original)
+    {
+        printf("%s failed to compile\n",_name);
+        return;
+    }
+    const size_t originalSize = getByteSize(original);
+    printf("%s, %s debug info, %u bytes as compiled\n",_name,_debug ? "with":"without",uint32_t(originalSize));
+
+    const struct
+    {
+        const char* name;
+        asset::CSPIRVOptimizer::SOptions options;
+    } rows[] = {
+        {"strip",               {asset::CSPIRVOptimizer::EP_NONE,true,true}},
+        {"performance",         {asset::CSPIRVOptimizer::EP_PERFORMANCE,false,true}},
+        {"performance+strip",   {asset::CSPIRVOptimizer::EP_PERFORMANCE,true,true}},
+        {"size",                {asset::CSPIRVOptimizer::EP_SIZE,false,true}},
+        {"size+strip",          {asset::CSPIRVOptimizer::EP_SIZE,true,true}}
+    };
+    for (const auto& row : rows)
+        printRow(row.name,_optimizer,originalSize,[&]() {return _optimizer->optimize(original,row.options);});
+
+    // every material with fog and a fixed light count, the values live in one buffer
+    if (_stage==asset::ESS_FRAGMENT)
+    {
+        core::vector<asset::SSpecializationMapEntry> entries = {{0u,0u,4u},{1u,4u,4u},{2u,8u,4u}};
+        auto specData = new asset::ICPUBuffer(3u*sizeof(uint32_t));
+        auto info = new asset::ISpecializationInfo(std::move(entries),specData,"main",_stage);
+        for (uint32_t material=0u; material<3u; material++)
+        {
+            const uint32_t values[3] = {material,1u,2u};
+            memcpy(specData->getPointer(),values,sizeof(values));
+            auto specialized = new asset::ICPUSpecializedShader(original,info);
+            for (const auto& row : rows)
+            {
+                char name[64];
+                snprintf(name,sizeof(name),"material %u, %s",material,row.name);
+                printRow(name,_optimizer,originalSize,[&]() {return _optimizer->specializeAndOptimize(specialized,row.options);});
+            }
+            specialized->drop();
+        }
+        info->drop();
+        specData->drop();
+    }
+    original->drop();
+}
+
+int main()
+{
+#ifndef _IRR_COMPILE_WITH_SPIRV_TOOLS_
+    printf("Irrlicht was built with IRR_COMPILE_WITH_SPIRV_TOOLS off, there is no optimizer to measure\n");
+    return 0;
+#endif
+    printf("Best of %u runs in milliseconds, sizes in bytes and relative to the compiler's output,\n",REPETITIONS);
+    printf("valid is whether the SPIRV-Tools validator accepts the result\n");
+    printf("  %-34s %9s %9s %9s %6s\n","options","bytes","size","ms","valid");
+
+    auto compiler = core::make_smart_refctd_ptr<asset::IGLSLCompiler>();
+    // only the SPIR-V version's rules, the shaders are not tied to a client API
+    auto optimizer = core::make_smart_refctd_ptr<asset::CSPIRVOptimizer>(asset::CSPIRVOptimizer::ETE_UNIVERSAL_1_3);
+    for (bool debug : {false,true})
+    {
+        benchmark("uber fragment shader",compiler.get(),optimizer.get(),FragmentShader,asset::ESS_FRAGMENT,debug);
+        benchmark("prefix sum compute shader",compiler.get(),optimizer.get(),ComputeShader,asset::ESS_COMPUTE,debug);
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+using namespace irr;
+using namespace core;
+
+#define REPETITIONS 3u
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+struct SVertex
+{
+    float pos[3];
+    float uv[2];
+};
+
+static core::smart_refctd_ptr<asset::ICPUMeshBuffer> createMeshBuffer(const core::vector<SVertex>& _vertices, const core::vector<uint32_t>& _indices)
+{
+    auto vertices = core::make_smart_refctd_ptr<asset::ICPUBuffer>(_vertices.size()*sizeof(SVertex));
+    memcpy(vertices->getPointer(),_vertices.data(),vertices->getSize());
+    auto indices = core::make_smart_refctd_ptr<asset::ICPUBuffer>(_indices.size()*sizeof(uint32_t));
+    memcpy(indices->getPointer(),_indices.data(),indices->getSize());
+
+    auto desc = core::make_smart_refctd_ptr<asset::ICPUMeshDataFormatDesc>();
+    desc->setVertexAttrBuffer(core::smart_refctd_ptr(vertices),asset::EVAI_ATTR0,asset::EF_R32G32B32_SFLOAT,sizeof(SVertex),offsetof(SVertex,pos));
+    desc->setVertexAttrBuffer(std::move(vertices),asset::EVAI_ATTR2,asset::EF_R32G32_SFLOAT,sizeof(SVertex),offsetof(SVertex,uv));
+    desc->setIndexBuffer(std::move(indices));
+
+    auto meshbuffer = core::make_smart_refctd_ptr<asset::ICPUMeshBuffer>();
+    meshbuffer->setMeshDataAndFormat(std::move(desc));
+    meshbuffer->setIndexType(asset::EIT_32BIT);
+    meshbuffer->setIndexCount(_indices.size());
+    meshbuffer->setPrimitiveType(asset::EPT_TRIANGLES);
+    meshbuffer->recalculateBoundingBox();
+    return meshbuffer;
+}
+
+//! A bumpy UV sphere, the u=0 and u=1 columns are separate vertices so there is a UV seam
+static core::smart_refctd_ptr<asset::ICPUMeshBuffer> createRock(uint32_t _segments, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> phase(0.f,2.f*core::PI);
+    const float phases[3] = {phase(_generator),phase(_generator),phase(_generator)};
+
+    const uint32_t rings = _segments/2u;
+    core::vector<SVertex> vertices;
+    for (uint32_t r=0u; r<=rings; r++)
+    for (uint32_t s=0u; s<=_segments; s++)
+    {
+        const float theta = core::PI*float(r)/float(rings);
+        const float phi = 2.f*core::PI*float(s%_segments)/float(_segments);
+        const float radius = 1.f+0.1f*sinf(5.f*theta+phases[0])*cosf(3.f*phi+phases[1])+0.02f*sinf(23.f*phi+phases[2]);
+        // poles are one point, give it one UV too
+        const float u = r==0u||r==rings ? 0.5f:float(s)/float(_segments);
+        vertices.push_back({{radius*sinf(theta)*cosf(phi),radius*cosf(theta),radius*sinf(theta)*sinf(phi)},{u,float(r)/float(rings)}});
+        if (r==0u||r==rings)
+            vertices.back().pos[0] = vertices.back().pos[2] = 0.f;
+    }
+
+    core::vector<uint32_t> indices;
+    for (uint32_t r=0u; r<rings; r++)
+    for (uint32_t s=0u; s<_segments; s++)
+    {
+        const uint32_t a = r*(_segments+1u)+s, b = a+1u, c = a+_segments+1u, d = c+1u;
+        if (r!=0u)
+            indices.insert(indices.end(),{a,b,c});
+        if (r!=rings-1u)
+            indices.insert(indices.end(),{b,d,c});
+    }
+    return createMeshBuffer(vertices,indices);
+}
+
+//! A heightfield, open borders all around
+static core::smart_refctd_ptr<asset::ICPUMeshBuffer> createTerrain(uint32_t _size, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> roughness(0.f,0.002f);
+
+    core::vector<SVertex> vertices;
+    for (uint32_t y=0u; y<=_size; y++)
+    for (uint32_t x=0u; x<=_size; x++)
+    {
+        const float u = float(x)/float(_size), v = float(y)/float(_size);
+        vertices.push_back({{u,0.1f*sinf(6.f*u)*cosf(4.f*v)+roughness(_generator),v},{u,v}});
+    }
+
+    core::vector<uint32_t> indices;
+    for (uint32_t y=0u; y<_size; y++)
+    for (uint32_t x=0u; x<_size; x++)
+    {
+        const uint32_t a = y*(_size+1u)+x, b = a+1u, c = a+_size+1u, d = c+1u;
+        indices.insert(indices.end(),{a,c,b,b,c,d});
+    }
+    return createMeshBuffer(vertices,indices);
+}
+
+static void benchmark(const char* _name, const asset::ICPUMeshBuffer* _meshbuffer)
+{
+    const asset::IMeshManipulator::SSimplificationTarget levels[] = {
+        {0.5f,0.002f},
+        {0.25f,0.005f},
+        {0.1f,0.01f},
+        {0.02f,0.05f}
+    };
+    constexpr uint32_t levelCount = sizeof(levels)/sizeof(levels[0]);
+
+    core::vector<core::smart_refctd_ptr<asset::ICPUMeshBuffer> > lods;
+    float errors[levelCount];
+    const double chainMs = measureMs([&]() {lods = asset::IMeshManipulator::createLoDChain(_meshbuffer,levels,levelCount,nullptr,errors);});
+
+    printf("%s, %u triangles, whole chain in %.2f ms\n",_name,uint32_t(_meshbuffer->getIndexCount()/3u),chainMs);
+    for (uint32_t i=0u; i<lods.size(); i++)
+    {
+        // what it costs to get there straight from the original
+        const double directMs = measureMs([&]() {asset::IMeshManipulator::createMeshBufferSimplified(_meshbuffer,levels[i]);});
+        printf("  %5.2f %6.3f %9u %9.5f %9s %11.2f\n",levels[i].triangleRatio,levels[i].maxError,uint32_t(lods[i]->getIndexCount()/3u),errors[i],
+            lods[i]->getIndexType()==asset::EIT_16BIT ? "16bit":"32bit",directMs);
+    }
+}
+
+int main()
+{
+    printf("Best of %u runs in milliseconds, errors relative to the longest side of the bounding box\n",REPETITIONS);
+    printf("  %5s %6s %9s %9s %9s %11s\n","ratio","limit","triangles","error","indices","direct ms");
+
+    std::mt19937 generator(0x45u);
+    for (uint32_t segments : {128u,512u})
+    {
+        char name[64];
+        snprintf(name,sizeof(name),"rock, %u segments",segments);
+        benchmark(name,createRock(segments,generator).get());
+    }
+    for (uint32_t size : {128u,512u})
+    {
+        char name[64];
+        snprintf(name,sizeof(name),"terrain, %ux%u",size,size);
+        benchmark(name,createTerrain(size,generator).get());
+    }
+
+    return 0;
+}
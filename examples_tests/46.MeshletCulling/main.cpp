@@ -0,0 +1,164 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+using namespace irr;
+using namespace core;
+
+#define REPETITIONS 3u
+#define CAMERA_COUNT 64u
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+struct SVertex
+{
+    float pos[3];
+    float uv[2];
+};
+
+static core::smart_refctd_ptr<asset::ICPUMeshBuffer> createMeshBuffer(const core::vector<SVertex>& _vertices, const core::vector<uint32_t>& _indices)
+{
+    auto vertices = core::make_smart_refctd_ptr<asset::ICPUBuffer>(_vertices.size()*sizeof(SVertex));
+    memcpy(vertices->getPointer(),_vertices.data(),vertices->getSize());
+    auto indices = core::make_smart_refctd_ptr<asset::ICPUBuffer>(_indices.size()*sizeof(uint32_t));
+    memcpy(indices->getPointer(),_indices.data(),indices->getSize());
+
+    auto desc = core::make_smart_refctd_ptr<asset::ICPUMeshDataFormatDesc>();
+    desc->setVertexAttrBuffer(core::smart_refctd_ptr(vertices),asset::EVAI_ATTR0,asset::EF_R32G32B32_SFLOAT,sizeof(SVertex),offsetof(SVertex,pos));
+    desc->setVertexAttrBuffer(std::move(vertices),asset::EVAI_ATTR2,asset::EF_R32G32_SFLOAT,sizeof(SVertex),offsetof(SVertex,uv));
+    desc->setIndexBuffer(std::move(indices));
+
+    auto meshbuffer = core::make_smart_refctd_ptr<asset::ICPUMeshBuffer>();
+    meshbuffer->setMeshDataAndFormat(std::move(desc));
+    meshbuffer->setIndexType(asset::EIT_32BIT);
+    meshbuffer->setIndexCount(_indices.size());
+    meshbuffer->setPrimitiveType(asset::EPT_TRIANGLES);
+    meshbuffer->recalculateBoundingBox();
+    return meshbuffer;
+}
+
+//! A bumpy UV sphere, like a scanned rock
+static core::smart_refctd_ptr<asset::ICPUMeshBuffer> createRock(uint32_t _segments, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> phase(0.f,2.f*core::PI);
+    const float phases[3] = {phase(_generator),phase(_generator),phase(_generator)};
+
+    const uint32_t rings = _segments/2u;
+    core::vector<SVertex> vertices;
+    for (uint32_t r=0u; r<=rings; r++)
+    for (uint32_t s=0u; s<=_segments; s++)
+    {
+        const float theta = core::PI*float(r)/float(rings);
+        const float phi = 2.f*core::PI*float(s%_segments)/float(_segments);
+        const float radius = 1.f+0.1f*sinf(5.f*theta+phases[0])*cosf(3.f*phi+phases[1])+0.02f*sinf(23.f*phi+phases[2]);
+        vertices.push_back({{radius*sinf(theta)*cosf(phi),radius*cosf(theta),radius*sinf(theta)*sinf(phi)},{float(s)/float(_segments),float(r)/float(rings)}});
+    }
+
+    core::vector<uint32_t> indices;
+    for (uint32_t r=0u; r<rings; r++)
+    for (uint32_t s=0u; s<_segments; s++)
+    {
+        const uint32_t a = r*(_segments+1u)+s, b = a+1u, c = a+_segments+1u, d = c+1u;
+        if (r!=0u)
+            indices.insert(indices.end(),{a,b,c});
+        if (r!=rings-1u)
+            indices.insert(indices.end(),{b,d,c});
+    }
+    return createMeshBuffer(vertices,indices);
+}
+
+//! A rough heightfield, its normals mostly point up
+static core::smart_refctd_ptr<asset::ICPUMeshBuffer> createTerrain(uint32_t _size, std::mt19937& _generator)
+{
+    std::uniform_real_distribution<float> roughness(0.f,0.002f);
+
+    core::vector<SVertex> vertices;
+    for (uint32_t y=0u; y<=_size; y++)
+    for (uint32_t x=0u; x<=_size; x++)
+    {
+        const float u = float(x)/float(_size), v = float(y)/float(_size);
+        vertices.push_back({{u,0.1f*sinf(6.f*u)*cosf(4.f*v)+roughness(_generator),v},{u,v}});
+    }
+
+    core::vector<uint32_t> indices;
+    for (uint32_t y=0u; y<_size; y++)
+    for (uint32_t x=0u; x<_size; x++)
+    {
+        const uint32_t a = y*(_size+1u)+x, b = a+1u, c = a+_size+1u, d = c+1u;
+        indices.insert(indices.end(),{a,c,b,b,c,d});
+    }
+    return createMeshBuffer(vertices,indices);
+}
+
+static void benchmark(const char* _name, const asset::ICPUMeshBuffer* _meshbuffer, uint32_t _maxVertices, uint32_t _maxTriangles)
+{
+    core::smart_refctd_ptr<asset::ICPUMeshletMeshBuffer> meshletized;
+    const double buildMs = measureMs([&]() {meshletized = asset::IMeshManipulator::createMeshletizedMeshBuffer(_meshbuffer,_maxVertices,_maxTriangles);});
+    const auto& meshlets = meshletized->getMeshlets();
+
+    uint64_t vertices = 0u, triangles = 0u;
+    float radius = 0.f;
+    for (const auto& meshlet : meshlets)
+    {
+        vertices += meshlet.vertexCount;
+        triangles += meshlet.triangleCount;
+        radius += meshlet.radius;
+    }
+
+    // cameras all around the mesh, whole meshbuffer backface culling could never reject anything from any of them
+    const auto& box = _meshbuffer->getBoundingBox();
+    const core::vectorSIMDf center((box.MinEdge.X+box.MaxEdge.X)*0.5f,(box.MinEdge.Y+box.MaxEdge.Y)*0.5f,(box.MinEdge.Z+box.MaxEdge.Z)*0.5f);
+    const float distance = box.getExtent().getLength()*1.5f;
+    uint64_t culledTriangles = 0u;
+    for (uint32_t c=0u; c<CAMERA_COUNT; c++)
+    {
+        // fibonacci sphere
+        const float y = 1.f-2.f*(float(c)+0.5f)/float(CAMERA_COUNT);
+        const float r = sqrtf(1.f-y*y);
+        const float phi = float(c)*core::PI*(3.f-sqrtf(5.f));
+        const core::vectorSIMDf camera = center+core::vectorSIMDf(r*cosf(phi),y,r*sinf(phi))*distance;
+        for (const auto& meshlet : meshlets)
+        if (meshlet.isBackfacing(camera))
+            culledTriangles += meshlet.triangleCount;
+    }
+
+    printf("%-24s %3u/%3u %8u %8.1f %8.1f %9.5f %9.1f%% %9.2f\n",_name,_maxVertices,_maxTriangles,uint32_t(meshlets.size()),
+        double(vertices)/double(meshlets.size()),double(triangles)/double(meshlets.size()),radius/float(meshlets.size()),
+        100.0*double(culledTriangles)/double(triangles*CAMERA_COUNT),buildMs);
+}
+
+int main()
+{
+    printf("Best of %u runs in milliseconds, cone culling averaged over %u cameras around each mesh\n",REPETITIONS,CAMERA_COUNT);
+    printf("%-24s %7s %8s %8s %8s %9s %10s %9s\n","mesh","limits","meshlets","avg vtx","avg tri","avg rad","culled","build ms");
+
+    std::mt19937 generator(0x46u);
+    core::vector<std::pair<std::string,core::smart_refctd_ptr<asset::ICPUMeshBuffer> > > meshes;
+    for (uint32_t segments : {128u,512u})
+        meshes.emplace_back("rock, "+std::to_string(segments)+" segments",createRock(segments,generator));
+    for (uint32_t size : {128u,512u})
+        meshes.emplace_back("terrain, "+std::to_string(size)+"x"+std::to_string(size),createTerrain(size,generator));
+
+    for (const auto& mesh : meshes)
+    {
+        benchmark(mesh.first.c_str(),mesh.second.get(),64u,126u);
+        benchmark(mesh.first.c_str(),mesh.second.get(),128u,256u);
+    }
+
+    return 0;
+}
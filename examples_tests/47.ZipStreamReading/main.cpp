@@ -0,0 +1,217 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+#include "zlib/zlib.h"
+
+using namespace irr;
+using namespace core;
+
+#define REPETITIONS 3u
+#define RANDOM_READS 256u
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+//! Half noise, half patterns, so deflate emits plenty of blocks but still compresses
+static core::vector<uint8_t> createContents(size_t _size, std::mt19937& _generator)
+{
+    core::vector<uint8_t> contents(_size);
+    for (size_t i=0u; i<_size; i++)
+        contents[i] = (i%1000u)<500u ? uint8_t(_generator()&0x3u):uint8_t(i*7u);
+    return contents;
+}
+
+static core::vector<uint8_t> deflateRaw(const core::vector<uint8_t>& _contents)
+{
+    z_stream stream = {};
+    // negative window bits write a raw deflate stream without the zlib header, as zip entries store it
+    deflateInit2(&stream,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-MAX_WBITS,8,Z_DEFAULT_STRATEGY);
+    core::vector<uint8_t> compressed(deflateBound(&stream,_contents.size()));
+    stream.next_in = const_cast<uint8_t*>(_contents.data());
+    stream.avail_in = _contents.size();
+    stream.next_out = compressed.data();
+    stream.avail_out = compressed.size();
+    deflate(&stream,Z_FINISH);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+    return compressed;
+}
+
+struct SEntry
+{
+    std::string name;
+    uint16_t method;
+    core::vector<uint8_t> contents;
+};
+
+//! Writes a minimal zip archive with local headers, a central directory and its end record
+static core::vector<uint8_t> createArchive(const core::vector<SEntry>& _entries)
+{
+    core::vector<uint8_t> archive, centralDirectory;
+    auto put16 = [](core::vector<uint8_t>& _out, uint32_t _value) { _out.push_back(_value&0xffu); _out.push_back((_value>>8u)&0xffu); };
+    auto put32 = [&](core::vector<uint8_t>& _out, uint32_t _value) { put16(_out,_value&0xffffu); put16(_out,_value>>16u); };
+
+    for (const auto& entry : _entries)
+    {
+        const core::vector<uint8_t> data = entry.method ? deflateRaw(entry.contents):entry.contents;
+        const uint32_t crc = ::crc32(0ul,entry.contents.data(),entry.contents.size());
+        const uint32_t localOffset = archive.size();
+
+        put32(archive,0x04034b50u);
+        put16(archive,20u); // version needed
+        put16(archive,0u); // flags
+        put16(archive,entry.method);
+        put32(archive,0u); // time and date
+        put32(archive,crc);
+        put32(archive,data.size());
+        put32(archive,entry.contents.size());
+        put16(archive,entry.name.size());
+        put16(archive,0u); // extra field
+        archive.insert(archive.end(),entry.name.begin(),entry.name.end());
+        archive.insert(archive.end(),data.begin(),data.end());
+
+        put32(centralDirectory,0x02014b50u);
+        put16(centralDirectory,20u); // version made by
+        put16(centralDirectory,20u); // version needed
+        put16(centralDirectory,0u); // flags
+        put16(centralDirectory,entry.method);
+        put32(centralDirectory,0u); // time and date
+        put32(centralDirectory,crc);
+        put32(centralDirectory,data.size());
+        put32(centralDirectory,entry.contents.size());
+        put16(centralDirectory,entry.name.size());
+        put16(centralDirectory,0u); // extra field
+        put16(centralDirectory,0u); // comment
+        put16(centralDirectory,0u); // disk
+        put16(centralDirectory,0u); // internal attributes
+        put32(centralDirectory,0u); // external attributes
+        put32(centralDirectory,localOffset);
+        centralDirectory.insert(centralDirectory.end(),entry.name.begin(),entry.name.end());
+    }
+
+    const uint32_t centralDirectoryOffset = archive.size();
+    archive.insert(archive.end(),centralDirectory.begin(),centralDirectory.end());
+    put32(archive,0x06054b50u);
+    put16(archive,0u); // disk
+    put16(archive,0u); // disk with the central directory
+    put16(archive,_entries.size());
+    put16(archive,_entries.size());
+    put32(archive,centralDirectory.size());
+    put32(archive,centralDirectoryOffset);
+    put16(archive,0u); // comment
+    return archive;
+}
+
+static bool readAndCompare(io::IReadFile* _file, size_t _offset, size_t _size, const core::vector<uint8_t>& _expected, core::vector<uint8_t>& _scratch)
+{
+    _scratch.resize(_size);
+    if (!_file->seek(_offset))
+        return false;
+    // odd chunk sizes so reads straddle the decoder's internal buffers
+    for (size_t done=0u; done<_size; )
+    {
+        const int32_t readSize = _file->read(_scratch.data()+done,core::min_<size_t>(77777u,_size-done));
+        if (readSize<=0)
+            return false;
+        done += readSize;
+    }
+    return _file->getPos()==_offset+_size && memcmp(_scratch.data(),_expected.data()+_offset,_size)==0;
+}
+
+static bool test(io::IFileArchive* _archive, const SEntry& _entry, std::mt19937& _generator)
+{
+    io::IReadFile* file = _archive->createAndOpenFile(_entry.name.c_str());
+    if (!file)
+    {
+        printf("%-24s could not be opened\n",_entry.name.c_str());
+        return false;
+    }
+
+    const auto& expected = _entry.contents;
+    const size_t size = expected.size();
+    core::vector<uint8_t> scratch;
+    bool ok = file->getSize()==size;
+
+    // whole entry round trip
+    bool sequentialOk = true;
+    const double sequentialMs = measureMs([&]() {sequentialOk = readAndCompare(file,0u,size,expected,scratch)&&sequentialOk;});
+    ok = ok&&sequentialOk;
+
+    // from the end back to the start and into the middle, far outside of what any decode window keeps
+    bool backwardsOk = readAndCompare(file,size-size/8u,size/8u,expected,scratch);
+    const double backwardsMs = measureMs([&]() {backwardsOk = readAndCompare(file,size/2u,4096u,expected,scratch)&&backwardsOk;});
+    backwardsOk = backwardsOk&&readAndCompare(file,0u,4096u,expected,scratch)&&readAndCompare(file,size-4096u,4096u,expected,scratch)&&readAndCompare(file,1u,4096u,expected,scratch);
+    ok = ok&&backwardsOk;
+
+    bool randomOk = true;
+    const double randomMs = measureMs([&]()
+        {
+            for (uint32_t i=0u; i<RANDOM_READS; i++)
+            {
+                const size_t offset = _generator()%size;
+                const size_t length = core::min_<size_t>(_generator()%(1u<<18),size-offset);
+                randomOk = readAndCompare(file,offset,length,expected,scratch)&&randomOk;
+            }
+        }
+    );
+    ok = ok&&randomOk;
+    file->drop();
+
+    printf("%-24s %8s %10.2f %10.1f %10.3f %10.3f %6s\n",_entry.name.c_str(),_entry.method ? "deflate":"stored",double(size)/double(1u<<20),
+        double(size)/double(1u<<20)/(sequentialMs*0.001),backwardsMs,randomMs/double(RANDOM_READS),ok ? "ok":"FAILED");
+    return ok;
+}
+
+int main()
+{
+    SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return 1;
+    io::IFileSystem* fs = device->getFileSystem();
+
+    // entries up to a MiB get decompressed into memory on open, bigger ones are streamed by CZipStreamReadFile
+    std::mt19937 generator(0x47u);
+    core::vector<SEntry> entries;
+    entries.push_back({"small.stored",0u,createContents(200000u,generator)});
+    entries.push_back({"small.deflate",8u,createContents(300000u,generator)});
+    entries.push_back({"large.stored",0u,createContents(24u<<20,generator)});
+    entries.push_back({"large.deflate",8u,createContents(24u<<20,generator)});
+    const core::vector<uint8_t> archiveData = createArchive(entries);
+
+    io::IReadFile* archiveFile = fs->createMemoryReadFile(archiveData.data(),archiveData.size(),"test.zip");
+    io::IFileArchive* archive = nullptr;
+    if (!fs->addFileArchive(archiveFile,true,true,io::EFAT_ZIP,"",&archive) || !archive)
+    {
+        printf("Could not mount the archive\n");
+        archiveFile->drop();
+        device->drop();
+        return 1;
+    }
+    archiveFile->drop();
+
+    printf("Best of %u runs in milliseconds, random reads average over %u reads of up to 256kB\n",REPETITIONS,RANDOM_READS);
+    printf("%-24s %8s %10s %10s %10s %10s %6s\n","entry","method","MiB","seq MiB/s","back ms","random ms","result");
+    bool ok = true;
+    for (const auto& entry : entries)
+        ok = test(archive,entry,generator)&&ok;
+
+    device->drop();
+    return ok ? 0:1;
+}
@@ -0,0 +1,265 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+#include <functional>
+
+using namespace irr;
+using namespace core;
+
+#define REPETITIONS 3u
+#define VARIANT_COUNT 32u
+
+//! Files are written to (and removed from) the working directory
+#define CACHE_DIRECTORY "./"
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+static bool check(const char* _name, bool _passed)
+{
+    printf("  %-56s %s\n",_name,_passed ? "ok":"FAILED");
+    return _passed;
+}
+
+//! Same naming as CSPIRVCache uses for its files
+static std::string getCacheFilePath(const asset::CSPIRVCache::SKey& _key)
+{
+    char name[4u*16u+1u];
+    for (uint32_t i=0u; i<4u; i++)
+        snprintf(name+i*16u,17u,"%016llx",static_cast<unsigned long long>(_key.hash[i]));
+    return std::string(CACHE_DIRECTORY)+name+".spv";
+}
+
+static bool overwriteFile(const std::string& _path, long _offset, const void* _data, size_t _size)
+{
+    FILE* file = fopen(_path.c_str(),"r+b");
+    if (!file)
+        return false;
+    const bool ok = fseek(file,_offset,SEEK_SET)==0 && fwrite(_data,_size,1u,file)==1u;
+    return (fclose(file)==0) && ok;
+}
+
+static bool truncateFile(const std::string& _path, size_t _size)
+{
+    core::vector<uint8_t> contents(_size);
+    FILE* file = fopen(_path.c_str(),"rb");
+    if (!file)
+        return false;
+    const bool readOk = fread(contents.data(),1u,_size,file)==_size;
+    fclose(file);
+    file = fopen(_path.c_str(),"wb");
+    if (!readOk || !file)
+        return false;
+    const bool ok = fwrite(contents.data(),1u,_size,file)==_size;
+    return (fclose(file)==0) && ok;
+}
+
+static bool testRoundTripAndCorruption()
+{
+    printf("Cache on its own:\n");
+    bool ok = true;
+
+    asset::CSPIRVCache::SKey key = {{0x48u,0x5350495256u,0x4361636865u,0x1u}};
+    core::vector<uint32_t> spirv(1024u);
+    for (uint32_t i=0u; i<spirv.size(); i++)
+        spirv[i] = i*2654435761u;
+    const std::string path = getCacheFilePath(key);
+    remove(path.c_str());
+
+    {
+        auto cache = core::make_smart_refctd_ptr<asset::CSPIRVCache>(CACHE_DIRECTORY);
+        core::vector<uint32_t> found;
+        ok = check("miss on an empty cache",!cache->find(key,found)&&found.empty())&&ok;
+        cache->insert(key,spirv.data(),spirv.size());
+        ok = check("hit in memory after insert",cache->find(key,found)&&found==spirv)&&ok;
+        cache->clearMemory();
+        found.clear();
+        ok = check("hit on disk after clearing memory",cache->find(key,found)&&found==spirv)&&ok;
+    }
+    {
+        auto cache = core::make_smart_refctd_ptr<asset::CSPIRVCache>(CACHE_DIRECTORY);
+        core::vector<uint32_t> found;
+        ok = check("hit on disk from a new cache",cache->find(key,found)&&found==spirv)&&ok;
+    }
+
+    // every one of these has to be a miss which leaves the output alone, and a later insert has to repair the file
+    const uint64_t hugeWordCount = 1ull<<60ull;
+    const uint32_t flippedWord = ~spirv[512];
+    const uint32_t badMagic = 0u;
+    const struct
+    {
+        const char* name;
+        std::function<bool()> corrupt;
+    } corruptions[] = {
+        {"miss on a flipped word",[&]() {return overwriteFile(path,long(48u+512u*sizeof(uint32_t)),&flippedWord,sizeof(flippedWord));}},
+        {"miss on a truncated file",[&]() {return truncateFile(path,48u+100u*sizeof(uint32_t));}},
+        {"miss on a truncated header",[&]() {return truncateFile(path,20u);}},
+        {"miss on a word count bigger than the file",[&]() {return overwriteFile(path,8,&hugeWordCount,sizeof(hugeWordCount));}},
+        {"miss on a bad magic",[&]() {return overwriteFile(path,0,&badMagic,sizeof(badMagic));}}
+    };
+    for (const auto& corruption : corruptions)
+    {
+        auto cache = core::make_smart_refctd_ptr<asset::CSPIRVCache>(CACHE_DIRECTORY);
+        cache->insert(key,spirv.data(),spirv.size());
+        cache->clearMemory();
+
+        core::vector<uint32_t> found = {0xdeadbeefu};
+        ok = check(corruption.name,corruption.corrupt()&&!cache->find(key,found)&&found.size()==1u&&found[0]==0xdeadbeefu)&&ok;
+    }
+    {
+        auto cache = core::make_smart_refctd_ptr<asset::CSPIRVCache>(CACHE_DIRECTORY);
+        cache->insert(key,spirv.data(),spirv.size());
+        auto reopened = core::make_smart_refctd_ptr<asset::CSPIRVCache>(CACHE_DIRECTORY);
+        core::vector<uint32_t> found;
+        ok = check("insert over a corrupted file repairs it",reopened->find(key,found)&&found==spirv)&&ok;
+    }
+
+    {
+        auto cache = core::make_smart_refctd_ptr<asset::CSPIRVCache>("",4u*spirv.size()*sizeof(uint32_t));
+        for (uint64_t i=0u; i<16u; i++)
+        {
+            const asset::CSPIRVCache::SKey other = {{i,i,i,i}};
+            cache->insert(other,spirv.data(),spirv.size());
+        }
+        core::vector<uint32_t> found;
+        const asset::CSPIRVCache::SKey oldest = {{0u,0u,0u,0u}}, newest = {{15u,15u,15u,15u}};
+        ok = check("memory stays within the byte budget",cache->getByteSize()<=cache->getByteBudget())&&ok;
+        ok = check("least recently used entries get evicted",!cache->find(oldest,found)&&cache->find(newest,found))&&ok;
+    }
+
+    remove(path.c_str());
+    return ok;
+}
+
+static std::string createShaderVariant(uint32_t _variant)
+{
+    return R"===(
+#version 450 core
+layout(local_size_x = 64) in;
+layout(set = 0, binding = 0) buffer Data
+{
+    float values[];
+};
+)==="
+    "#define VARIANT "+std::to_string(_variant)+"u\n"
+    R"===(
+void main()
+{
+    float value = values[gl_GlobalInvocationID.x];
+    for (uint i=0u; i<VARIANT+1u; i++)
+        value = sin(value)*float(i+VARIANT)+cos(value*0.5);
+    values[gl_GlobalInvocationID.x] = value;
+}
+)===";
+}
+
+static bool testBatchCompile()
+{
+    printf("Batch compile of %u compute shader variants:\n",VARIANT_COUNT);
+    bool ok = true;
+
+    core::vector<std::string> sources;
+    core::vector<asset::IGLSLCompiler::SCompileRequest> requests;
+    for (uint32_t i=0u; i<VARIANT_COUNT; i++)
+        sources.push_back(createShaderVariant(i));
+    for (const auto& source : sources)
+        requests.push_back({source.c_str(),asset::ESS_COMPUTE,"main"});
+
+    auto compiler = core::make_smart_refctd_ptr<asset::IGLSLCompiler>();
+    core::vector<asset::CSPIRVCache::SKey> keys(VARIANT_COUNT);
+    for (uint32_t i=0u; i<VARIANT_COUNT; i++)
+        ok = compiler->computeCacheKey(keys[i],requests[i].glslCode,requests[i].stage,requests[i].entryPoint)&&ok;
+    auto removeFiles = [&]()
+    {
+        for (const auto& key : keys)
+            remove(getCacheFilePath(key).c_str());
+    };
+    removeFiles();
+
+    core::vector<asset::ICPUShader*> reference(VARIANT_COUNT,nullptr), shaders(VARIANT_COUNT,nullptr);
+    auto dropAll = [](core::vector<asset::ICPUShader*>& _shaders)
+    {
+        for (auto& shader : _shaders)
+        if (shader)
+        {
+            shader->drop();
+            shader = nullptr;
+        }
+    };
+    auto sameAsReference = [&]()
+    {
+        for (uint32_t i=0u; i<VARIANT_COUNT; i++)
+        {
+            if (!shaders[i] || !reference[i])
+                return false;
+            const auto* a = shaders[i]->getSPIR_VBytecode();
+            const auto* b = reference[i]->getSPIR_VBytecode();
+            if (a->getSize()!=b->getSize() || memcmp(a->getPointer(),b->getPointer(),a->getSize())!=0)
+                return false;
+        }
+        return true;
+    };
+
+    const double uncachedMs = measureMs([&]()
+        {
+            dropAll(reference);
+            compiler->createShadersFromGLSL(requests.data(),requests.data()+requests.size(),reference.data());
+        }
+    );
+
+    compiler->setCache(core::make_smart_refctd_ptr<asset::CSPIRVCache>(CACHE_DIRECTORY));
+    // only the first run misses
+    const auto coldBegin = std::chrono::high_resolution_clock::now();
+    compiler->createShadersFromGLSL(requests.data(),requests.data()+requests.size(),shaders.data());
+    const double coldMs = std::chrono::duration<double,std::milli>(std::chrono::high_resolution_clock::now()-coldBegin).count();
+    ok = check("cold cache gives the same SPIR-V as no cache",sameAsReference())&&ok;
+
+    const double memoryMs = measureMs([&]()
+        {
+            dropAll(shaders);
+            compiler->createShadersFromGLSL(requests.data(),requests.data()+requests.size(),shaders.data());
+        }
+    );
+    ok = check("memory hits give the same SPIR-V",sameAsReference())&&ok;
+
+    const double diskMs = measureMs([&]()
+        {
+            dropAll(shaders);
+            compiler->getCache()->clearMemory();
+            compiler->createShadersFromGLSL(requests.data(),requests.data()+requests.size(),shaders.data());
+        }
+    );
+    ok = check("disk hits give the same SPIR-V",sameAsReference())&&ok;
+
+    printf("  %-24s %10s %10s\n","","total ms","per shader");
+    printf("  %-24s %10.2f %10.3f\n","no cache",uncachedMs,uncachedMs/double(VARIANT_COUNT));
+    printf("  %-24s %10.2f %10.3f\n","cold cache",coldMs,coldMs/double(VARIANT_COUNT));
+    printf("  %-24s %10.2f %10.3f\n","memory hits",memoryMs,memoryMs/double(VARIANT_COUNT));
+    printf("  %-24s %10.2f %10.3f\n","disk hits",diskMs,diskMs/double(VARIANT_COUNT));
+
+    dropAll(reference);
+    dropAll(shaders);
+    removeFiles();
+    return ok;
+}
+
+int main()
+{
+    printf("Best of %u runs in milliseconds\n",REPETITIONS);
+    bool ok = testRoundTripAndCorruption();
+    ok = testBatchCompile()&&ok;
+    return ok ? 0:1;
+}
@@ -0,0 +1,203 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <chrono>
+
+#include "irr/asset/CBoundedAssetCache.h"
+
+using namespace irr;
+using namespace core;
+
+#define REPETITIONS 3u
+#define ENTRY_SIZE 1024u
+#define LOOKUP_ENTRIES 65536u
+
+template<typename F>
+static double measureMs(F&& _f)
+{
+    double best = FLT_MAX;
+    for (uint32_t r=0u; r<REPETITIONS; r++)
+    {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        _f();
+        const auto finish = std::chrono::high_resolution_clock::now();
+        best = core::min_(best,std::chrono::duration<double,std::milli>(finish-begin).count());
+    }
+    return best;
+}
+
+static bool check(const char* _name, bool _passed)
+{
+    printf("  %-56s %s\n",_name,_passed ? "ok":"FAILED");
+    return _passed;
+}
+
+static asset::SAssetBundle createBundle(size_t _size)
+{
+    return asset::SAssetBundle({core::make_smart_refctd_ptr<asset::ICPUBuffer>(_size)});
+}
+
+static std::string getKey(uint32_t _i)
+{
+    return "assets/buffer"+std::to_string(_i)+".bin";
+}
+
+//! Looks the key up, which also marks it as most recently used
+static bool lookup(const asset::CBoundedAssetCache& _cache, const std::string& _key)
+{
+    asset::SAssetBundle found;
+    size_t count = 1u;
+    _cache.findAndStoreRange(_key,count,&found);
+    return count==1u;
+}
+
+//! Keys from most to least recently used
+static core::vector<std::string> getOrder(const asset::CBoundedAssetCache& _cache)
+{
+    size_t count = 0u;
+    _cache.outputAll(count,nullptr);
+    core::vector<asset::CBoundedAssetCache::MutablePairType> entries(count);
+    _cache.outputAll(count,entries.data());
+    core::vector<std::string> keys;
+    for (size_t i=0u; i<count; i++)
+        keys.push_back(entries[i].first);
+    return keys;
+}
+
+static bool testEviction()
+{
+    printf("Eviction with a budget of 4 entries of %u bytes:\n",ENTRY_SIZE);
+    bool ok = true;
+
+    uint32_t greeted = 0u, disposed = 0u;
+    asset::CBoundedAssetCache cache([&](asset::SAssetBundle&) {greeted++;},[&](asset::SAssetBundle&) {disposed++;});
+    cache.setByteBudget(4u*ENTRY_SIZE);
+
+    for (uint32_t i=0u; i<8u; i++)
+        cache.insert(getKey(i),createBundle(ENTRY_SIZE));
+    ok = check("memory stays within the byte budget",cache.getByteSize()<=cache.getByteBudget())&&ok;
+    ok = check("only the budget's worth of entries is left",cache.getSize()==4u&&cache.getByteSize()==4u*ENTRY_SIZE)&&ok;
+    ok = check("the first inserted entries got evicted",!lookup(cache,getKey(0u))&&!lookup(cache,getKey(3u))&&lookup(cache,getKey(4u))&&lookup(cache,getKey(7u)))&&ok;
+    ok = check("every entry greeted once, evicted ones disposed once",greeted==8u&&disposed==4u)&&ok;
+
+    cache.insert("huge",createBundle(8u*ENTRY_SIZE));
+    ok = check("an entry over the budget evicts all others but stays",cache.getSize()==1u&&lookup(cache,"huge"))&&ok;
+
+    cache.clear();
+    for (uint32_t i=0u; i<4u; i++)
+        cache.insert(getKey(i),createBundle(ENTRY_SIZE));
+    cache.setByteBudget(2u*ENTRY_SIZE);
+    ok = check("lowering the budget evicts right away",cache.getSize()==2u&&cache.getByteSize()==2u*ENTRY_SIZE)&&ok;
+
+    cache.setByteBudget(asset::CBoundedAssetCache::Unbounded);
+    cache.clear();
+    ok = check("clear disposes of everything",cache.getSize()==0u&&cache.getByteSize()==0u&&disposed==greeted)&&ok;
+    return ok;
+}
+
+static bool testLRUOrder()
+{
+    printf("Least recently used order:\n");
+    bool ok = true;
+
+    asset::CBoundedAssetCache cache([](asset::SAssetBundle&) {},[](asset::SAssetBundle&) {});
+    cache.setByteBudget(4u*ENTRY_SIZE);
+    for (uint32_t i=0u; i<4u; i++)
+        cache.insert(getKey(i),createBundle(ENTRY_SIZE));
+    ok = check("most recently inserted first",getOrder(cache)==core::vector<std::string>{getKey(3u),getKey(2u),getKey(1u),getKey(0u)})&&ok;
+
+    lookup(cache,getKey(0u));
+    ok = check("a lookup moves the entry to the front",getOrder(cache)==core::vector<std::string>{getKey(0u),getKey(3u),getKey(2u),getKey(1u)})&&ok;
+
+    cache.insert(getKey(4u),createBundle(ENTRY_SIZE));
+    ok = check("the entry looked up survives, the oldest one goes",lookup(cache,getKey(0u))&&!lookup(cache,getKey(1u)))&&ok;
+
+    lookup(cache,getKey(2u));
+    cache.insert(getKey(5u),createBundle(ENTRY_SIZE));
+    cache.insert(getKey(6u),createBundle(ENTRY_SIZE));
+    ok = check("eviction keeps following the use order",getOrder(cache)==core::vector<std::string>{getKey(6u),getKey(5u),getKey(2u),getKey(0u)})&&ok;
+    return ok;
+}
+
+static bool testLookups()
+{
+    printf("Lookups of %u entries:\n",LOOKUP_ENTRIES);
+
+    asset::CBoundedAssetCache cache([](asset::SAssetBundle&) {},[](asset::SAssetBundle&) {});
+    core::vector<std::string> keys;
+    for (uint32_t i=0u; i<LOOKUP_ENTRIES; i++)
+        keys.push_back(getKey(i));
+    const auto bundle = createBundle(16u);
+    for (const auto& key : keys)
+        cache.insert(key,bundle);
+
+    volatile uint64_t hashSum = 0u;
+    const double hashMs = measureMs([&]()
+        {
+            uint64_t sum = 0u;
+            for (const auto& key : keys)
+                sum += asset::CBoundedAssetCache::hashKey(key);
+            hashSum = sum;
+        }
+    );
+    uint32_t found = 0u;
+    const double lookupMs = measureMs([&]()
+        {
+            found = 0u;
+            for (const auto& key : keys)
+                found += lookup(cache,key);
+        }
+    );
+
+    printf("  %-24s %10s %10s\n","","total ms","ns per key");
+    printf("  %-24s %10.2f %10.1f\n","hashKey",hashMs,hashMs*1000000.0/double(LOOKUP_ENTRIES));
+    printf("  %-24s %10.2f %10.1f\n","findAndStoreRange",lookupMs,lookupMs*1000000.0/double(LOOKUP_ENTRIES));
+    return check("every key found",found==LOOKUP_ENTRIES);
+}
+
+//! Goes through IAssetManager, which only uses the bounded cache when built with the IRR_BOUNDED_ASSET_CACHE CMake option
+static bool testAssetManager()
+{
+#ifdef _IRR_BOUNDED_ASSET_CACHE_
+    printf("IAssetManager with a budget of 4 buffers of %u bytes:\n",ENTRY_SIZE);
+    bool ok = true;
+
+    irr::SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return check("device created",false);
+    auto am = device->getAssetManager();
+
+    const uint64_t bufferCache = asset::IAsset::ET_BUFFER;
+    am->setAssetCacheByteBudget(4u*ENTRY_SIZE,asset::IAssetManager::AssetCacheType::EEP_REMOVE,bufferCache);
+    for (uint32_t i=0u; i<8u; i++)
+    {
+        auto bundle = createBundle(ENTRY_SIZE);
+        am->changeAssetKey(bundle,getKey(i));
+        am->insertAssetIntoCache(bundle);
+    }
+    ok = check("the buffer cache stays within the byte budget",am->getAssetCacheByteSize(bufferCache)==4u*ENTRY_SIZE)&&ok;
+    ok = check("the first inserted buffers got evicted",am->findAssets(getKey(0u)).empty()&&am->findAssets(getKey(7u)).size()==1u)&&ok;
+
+    am->clearAllAssetCache(bufferCache);
+    ok = check("clearing empties the budget",am->getAssetCacheByteSize(bufferCache)==0u)&&ok;
+
+    device->drop();
+    return ok;
+#else
+    printf("IAssetManager: built without IRR_BOUNDED_ASSET_CACHE, skipped\n");
+    return true;
+#endif
+}
+
+int main()
+{
+    printf("Best of %u runs in milliseconds\n",REPETITIONS);
+    bool ok = testEviction();
+    ok = testLRUOrder()&&ok;
+    ok = testLookups()&&ok;
+    ok = testAssetManager()&&ok;
+    return ok ? 0:1;
+}
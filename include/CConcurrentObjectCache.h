@@ -1,8 +1,9 @@
 #ifndef __C_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
 #define __C_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
 
+#include <shared_mutex>
+
 #include "CObjectCache.h"
-#include "../source/Irrlicht/FW_Mutex.h"
 
 namespace irr { namespace core
 {
@@ -18,15 +19,17 @@ namespace impl
         CConcurrentObjectCacheBase& operator=(const CConcurrentObjectCacheBase&) = delete;
         CConcurrentObjectCacheBase& operator=(CConcurrentObjectCacheBase&&) = delete;
 
+        //! Blocking reader-writer lock, waiting threads sleep instead of spinning so heavy contention does not burn the cores doing the actual work
+        /** For caches which get looked up far more often than modified prefer CShardedConcurrentObjectCache. */
         struct
         {
-            void lockRead() const { FW_AtomicCounterIncr(ctr); }
-            void unlockRead() const { FW_AtomicCounterDecr(ctr); }
-            void lockWrite() const { FW_AtomicCounterBlock(ctr); }
-            void unlockWrite() const { FW_AtomicCounterUnBlock(ctr); }
+            void lockRead() const { mtx.lock_shared(); }
+            void unlockRead() const { mtx.unlock_shared(); }
+            void lockWrite() const { mtx.lock(); }
+            void unlockWrite() const { mtx.unlock(); }
 
         private:
-            mutable FW_AtomicCounter ctr = 0;
+            mutable std::shared_timed_mutex mtx;
         } m_lock;
     };
 
@@ -96,6 +99,20 @@ namespace impl
 
         bool getAndStoreKeyRangeOrReserve(const typename BaseCache::KeyType_impl& _key, size_t& _inOutStorageSize, typename BaseCache::ValueType_impl* _out, bool* _gotAll)
         {
+            // most calls find something, so try with a shared lock first and only take the exclusive one if we need to reserve
+            this->m_lock.lockRead();
+            const auto rng = static_cast<const BaseCache*>(this)->findRange(_key);
+            if (BaseCache::isNonZeroRange(rng))
+            {
+                const bool gotAll = BaseCache::outputRange(rng, _inOutStorageSize, _out);
+                this->m_lock.unlockRead();
+                if (_gotAll)
+                    *_gotAll = gotAll;
+                return true;
+            }
+            this->m_lock.unlockRead();
+
+            // somebody could have reserved in the meantime, but the base implementation checks again
             this->m_lock.lockWrite();
             const bool r = BaseCache::getAndStoreKeyRangeOrReserve(_key, _inOutStorageSize, _out, _gotAll);
             this->m_lock.unlockWrite();
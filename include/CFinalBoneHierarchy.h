@@ -6,6 +6,7 @@
 #include <functional>
 #include "irr/core/core.h"
 #include "irr/asset/ICPUSkinnedMesh.h"
+#include "irr/asset/CCompressedBoneAnimation.h"
 #include "irr/asset/bawformat/BlobSerializable.h"
 #include "irr/asset/bawformat/blobs/FinalBoneHierarchyBlob.h"
 
@@ -32,6 +33,8 @@ namespace asset
                     free(interpolatedAnimations);
                 if (nonInterpolatedAnimations)
                     free(nonInterpolatedAnimations);
+                if (compressedAnimations)
+                    delete compressedAnimations;
             }
         public:
             #include "irr/irrpack.h"
@@ -43,19 +46,13 @@ namespace asset
                 uint32_t parentOffsetRelative;
                 uint32_t parentOffsetFromTop;
             } PACK_STRUCT;
-            struct AnimationKeyData
-            {
-                float Rotation[4];
-                float Position[3];
-                float Scale[3];
-                float Padding[2];
-            } PACK_STRUCT;
             #include "irr/irrunpack.h"
+            typedef SBoneAnimationKey AnimationKeyData;
 
 
             CFinalBoneHierarchy(const core::vector<asset::ICPUSkinnedMesh::SJoint*>& inLevelFixedJoints, const core::vector<size_t>& inJointsLevelEnd)
                     : boneCount(inLevelFixedJoints.size()), NumLevelsInHierarchy(inJointsLevelEnd.size()),
-                    keyframeCount(0), keyframes(NULL), interpolatedAnimations(NULL), nonInterpolatedAnimations(NULL)
+                    keyframeCount(0), keyframes(NULL), interpolatedAnimations(NULL), nonInterpolatedAnimations(NULL), compressedAnimations(NULL)
             {
                 boneFlatArray = (BoneReferenceData*)malloc(sizeof(BoneReferenceData)*boneCount);
                 boneNames = _IRR_NEW_ARRAY(core::stringc,boneCount);
@@ -100,7 +97,7 @@ namespace asset
 				const float* _keyframesBegin, const float* _keyframesEnd,
 				const void* _interpAnimsBegin, const void* _interpAnimsEnd,
 				const void* _nonInterpAnimsBegin, const void* _nonInterpAnimsEnd)
-			: boneCount((BoneReferenceData*)_bonesEnd - (BoneReferenceData*)_bonesBegin), NumLevelsInHierarchy(_levelsEnd - _levelsBegin), keyframeCount(_keyframesEnd - _keyframesBegin)
+			: boneCount((BoneReferenceData*)_bonesEnd - (BoneReferenceData*)_bonesBegin), NumLevelsInHierarchy(_levelsEnd - _levelsBegin), keyframeCount(_keyframesEnd - _keyframesBegin), compressedAnimations(NULL)
 			{
 				_IRR_DEBUG_BREAK_IF(_bonesBegin > _bonesEnd ||
 					_boneNamesBegin > _boneNamesEnd ||
@@ -129,6 +126,36 @@ namespace asset
 				memcpy(nonInterpolatedAnimations, _nonInterpAnimsBegin, sizeof(AnimationKeyData)*getAnimationCount());
 			}
 
+			//! Same as above, but the animations are the serialized form of a CCompressedBoneAnimation (see CCompressedBoneAnimation::validate)
+			CFinalBoneHierarchy(const void* _bonesBegin, const void* _bonesEnd,
+				core::stringc* _boneNamesBegin, core::stringc* _boneNamesEnd,
+				const std::size_t* _levelsBegin, const std::size_t* _levelsEnd,
+				const float* _keyframesBegin, const float* _keyframesEnd,
+				const void* _compressedAnimsBegin, const void* _compressedAnimsEnd)
+			: boneCount((BoneReferenceData*)_bonesEnd - (BoneReferenceData*)_bonesBegin), NumLevelsInHierarchy(_levelsEnd - _levelsBegin), keyframeCount(_keyframesEnd - _keyframesBegin),
+				interpolatedAnimations(NULL), nonInterpolatedAnimations(NULL)
+			{
+				_IRR_DEBUG_BREAK_IF(_bonesBegin > _bonesEnd ||
+					_boneNamesBegin > _boneNamesEnd ||
+					_levelsBegin > _levelsEnd ||
+					_keyframesBegin > _keyframesEnd ||
+					_compressedAnimsBegin > _compressedAnimsEnd
+				)
+				_IRR_DEBUG_BREAK_IF(_boneNamesEnd - _boneNamesBegin != static_cast<std::make_signed<decltype(boneCount)>::type>(boneCount))
+
+				boneNames = _IRR_NEW_ARRAY(core::stringc,boneCount);
+				boneFlatArray = (BoneReferenceData*)malloc(sizeof(BoneReferenceData)*boneCount);
+				boneTreeLevelEnd = (size_t*)malloc(sizeof(size_t)*NumLevelsInHierarchy);
+				keyframes = (float*)malloc(sizeof(float)*keyframeCount);
+
+				for (size_t i = 0; i < boneCount; ++i)
+					boneNames[i] = _boneNamesBegin[i];
+				memcpy(boneFlatArray, _bonesBegin, sizeof(BoneReferenceData)*boneCount);
+				memcpy(boneTreeLevelEnd, _levelsBegin, sizeof(size_t)*NumLevelsInHierarchy);
+				memcpy(keyframes, _keyframesBegin, sizeof(float)*keyframeCount);
+				compressedAnimations = new CCompressedBoneAnimation(_compressedAnimsBegin, (const uint8_t*)_compressedAnimsEnd - (const uint8_t*)_compressedAnimsBegin);
+			}
+
 			virtual void* serializeToBlob(void* _stackPtr = NULL, const size_t& _stackSize = 0) const
 			{
 				return asset::CorrespondingBlobTypeFor<CFinalBoneHierarchy>::type::createAndTryOnStack(static_cast<const CFinalBoneHierarchy*>(this), _stackPtr, _stackSize);
@@ -202,6 +229,26 @@ namespace asset
             inline const float* getKeys() const {return keyframes;}
 
 			inline size_t getAnimationCount() const { return getKeyFrameCount()*getBoneCount(); }
+
+            //! Replaces the animation data with a CCompressedBoneAnimation, returns false if already compressed
+            /** Afterwards `getInterpolatedAnimationData` and `getNonInterpolatedAnimationData` return NULL, use `sampleAnimation` or `getLocalMatrix`.
+            The keyframes can no longer be inserted, deleted or transformed. */
+            inline bool compressAnimations(const CCompressedBoneAnimation::SCompressionParams& params=CCompressedBoneAnimation::SCompressionParams())
+            {
+                if (compressedAnimations)
+                    return false;
+
+                compressedAnimations = new CCompressedBoneAnimation(boneCount,keyframeCount,keyframes,interpolatedAnimations,nonInterpolatedAnimations,params);
+                free(interpolatedAnimations);
+                free(nonInterpolatedAnimations);
+                interpolatedAnimations = NULL;
+                nonInterpolatedAnimations = NULL;
+                return true;
+            }
+
+            inline bool hasCompressedAnimations() const {return compressedAnimations!=NULL;}
+
+            inline const CCompressedBoneAnimation* getCompressedAnimations() const {return compressedAnimations;}
 /**
             //! ready but untested
             inline void putInGPUBuffer(video::IGPUBuffer* buffer, const size_t& byteOffset=0)
@@ -262,9 +309,62 @@ namespace asset
                 return getLowerBoundBoneKeyframes(tmpDummy,frame);
             }
 
-            inline const AnimationKeyData* getInterpolatedAnimationData(const size_t& boneID=0) const {return interpolatedAnimations+keyframeCount*boneID;}
+            //! NULL once the animations are compressed
+            inline const AnimationKeyData* getInterpolatedAnimationData(const size_t& boneID=0) const {return interpolatedAnimations ? interpolatedAnimations+keyframeCount*boneID:NULL;}
+
+            //! NULL once the animations are compressed
+            inline const AnimationKeyData* getNonInterpolatedAnimationData(const size_t& boneID=0) const {return nonInterpolatedAnimations ? nonInterpolatedAnimations+keyframeCount*boneID:NULL;}
+
+            //! Writes the pose of bones [boneBegin,boneEnd) at `frame` to `out`, whether the animations are compressed or not
+            inline void sampleAnimation(AnimationKeyData* out, const float& frame, const bool& interpolate, const size_t& boneBegin, const size_t& boneEnd) const
+            {
+                float interpolationFactor;
+                const size_t foundKeyIx = getLowerBoundBoneKeyframes(interpolationFactor,frame);
+                if (compressedAnimations)
+                {
+                    compressedAnimations->sample(out,boneBegin,boneEnd,keyframes,foundKeyIx,frame,interpolate);
+                    return;
+                }
+
+                float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
+                core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
+                for (size_t i=boneBegin; i<boneEnd; i++,out++)
+                {
+                    const AnimationKeyData* animation = (interpolate ? interpolatedAnimations:nonInterpolatedAnimations)+keyframeCount*i;
+                    if (!interpolate||interpolationFactor>=1.f)
+                    {
+                        *out = animation[foundKeyIx];
+                        continue;
+                    }
+
+                    core::vectorSIMDf   tmpPos;
+                    core::quaternion    tmpRot;
+                    core::vectorSIMDf   tmpScale;
+                    getMatrixFromKeys(tmpPos,tmpRot,tmpScale,animation[foundKeyIx-1],animation[foundKeyIx],interpolationFactor,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+                    memcpy(out->Rotation,tmpRot.getPointer(),sizeof(out->Rotation));
+                    memcpy(out->Position,tmpPos.pointer,sizeof(out->Position));
+                    memcpy(out->Scale,tmpScale.pointer,sizeof(out->Scale));
+                    out->Padding[0] = out->Padding[1] = 0.f;
+                }
+            }
+
+            //! Local transform of a bone at `frame`, whether the animations are compressed or not
+            inline core::matrix3x4SIMD getLocalMatrix(const size_t& boneID, const float& frame, const bool& interpolate) const
+            {
+                if (compressedAnimations)
+                {
+                    AnimationKeyData key;
+                    sampleAnimation(&key,frame,interpolate,boneID,boneID+1u);
+                    return getMatrixFromKey(key);
+                }
 
-            inline const AnimationKeyData* getNonInterpolatedAnimationData(const size_t& boneID=0) const {return nonInterpolatedAnimations+keyframeCount*boneID;}
+                float interpolationFactor;
+                const size_t foundKeyIx = getLowerBoundBoneKeyframes(interpolationFactor,frame);
+                const AnimationKeyData* animation = interpolate ? getInterpolatedAnimationData(boneID):getNonInterpolatedAnimationData(boneID);
+                if (interpolate&&interpolationFactor<1.f)
+                    return getMatrixFromKeys(animation[foundKeyIx-1],animation[foundKeyIx],interpolationFactor);
+                return getMatrixFromKey(animation[foundKeyIx]);
+            }
 
 
             //interpolant of 1 means full B
@@ -313,6 +413,10 @@ namespace asset
             //effectively downsamples our animation
             inline void deleteKeyframes(const size_t& keyframesToRemoveCount, const float* sortedKeyFramesToRemove)
             {
+                _IRR_DEBUG_BREAK_IF(compressedAnimations)
+                if (compressedAnimations)
+                    return;
+
                 const float* keyframesIn = keyframes;
                 const float* const keyframesEnd = keyframes+keyframeCount;
                 const AnimationKeyData* inAnimationsIn = interpolatedAnimations;
@@ -375,6 +479,10 @@ namespace asset
             //effectively upsamples our animation
             inline void insertKeyframes(const size_t& keyframesToAddCount, const float* sortedKeyFramesToAdd)
             {
+                _IRR_DEBUG_BREAK_IF(compressedAnimations)
+                if (compressedAnimations)
+                    return;
+
                 const float* keyframesIn = keyframes;
                 const float* const keyframesEnd = keyframes+keyframeCount;
                 const AnimationKeyData* inAnimationsIn = interpolatedAnimations;
@@ -465,6 +573,10 @@ namespace asset
             inline void transformAnimation(const float& rangeStart, const float& rangeEnd, AnimationKeyframeTransformFunc transformFunc,
                                            const size_t& keyframesToAddCount=0, const float* keyFramesToAdd=NULL)
             {
+                _IRR_DEBUG_BREAK_IF(compressedAnimations)
+                if (compressedAnimations)
+                    return;
+
                 //add keyframes if needed
                 if (keyframesToAddCount)
                     insertKeyframes(keyframesToAddCount,keyFramesToAdd);
@@ -714,6 +826,8 @@ namespace asset
             float* keyframes;
             AnimationKeyData* interpolatedAnimations;
             AnimationKeyData* nonInterpolatedAnimations;
+            //! replaces the two arrays above once the animations get compressed
+            CCompressedBoneAnimation* compressedAnimations;
     };
 
 } // end namespace asset
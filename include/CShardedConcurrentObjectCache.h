@@ -0,0 +1,427 @@
+#ifndef __C_SHARDED_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
+#define __C_SHARDED_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#include "irr/static_if.h"
+#include "irr/macros.h"
+#include "irr/core/Types.h"
+
+namespace irr { namespace core
+{
+
+namespace impl
+{
+    //! Read-mostly cache split into `1<<ShardCountLog2` independent shards picked by key hash.
+    /** Every shard keeps its entries in an immutable sorted snapshot which is replaced wholesale on modification (copy-on-write).
+    Readers never take a lock nor spin on a writer, they only announce themselves on one of two per-shard reader counters (RCU-style grace periods),
+    writers of the same shard serialize on a mutex and wait for readers of the previous snapshot to leave before freeing it.
+    Modifications cost O(shard size), so this is meant for caches looked up far more often than they are modified (i.e. asset caches).
+
+    Greeting and disposal have the same semantics as in CObjectCacheBase, except that disposal happens only once
+    no reader can be copying the object out anymore.
+    */
+    template<typename K, typename T, bool IsMultiCache, uint32_t ShardCountLog2, typename Hash>
+    class CShardedConcurrentObjectCacheBase
+    {
+        public:
+            using KeyType = K;
+            using CachedType = T;
+            using PairType = std::pair<K, T>;
+            using MutablePairType = PairType;
+
+            using GreetFuncType = std::function<void(T&)>;
+            using DisposalFuncType = std::function<void(T&)>;
+
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t ShardCount = 0x1u<<ShardCountLog2;
+
+            CShardedConcurrentObjectCacheBase() = default;
+            inline explicit CShardedConcurrentObjectCacheBase(const GreetFuncType& _greeting, const DisposalFuncType& _disposal) : m_greetingFunc(_greeting), m_disposalFunc(_disposal) {}
+            inline explicit CShardedConcurrentObjectCacheBase(GreetFuncType&& _greeting, DisposalFuncType&& _disposal) : m_greetingFunc(std::move(_greeting)), m_disposalFunc(std::move(_disposal)) {}
+            // explicitely making concurrent caches non-copy-and-move-constructible and non-copy-and-move-assignable
+            CShardedConcurrentObjectCacheBase(const CShardedConcurrentObjectCacheBase&) = delete;
+            CShardedConcurrentObjectCacheBase(CShardedConcurrentObjectCacheBase&&) = delete;
+            CShardedConcurrentObjectCacheBase& operator=(const CShardedConcurrentObjectCacheBase&) = delete;
+            CShardedConcurrentObjectCacheBase& operator=(CShardedConcurrentObjectCacheBase&&) = delete;
+
+            virtual ~CShardedConcurrentObjectCacheBase()
+            {
+                for (auto& shard : m_shards)
+                {
+                    SSnapshot* snapshot = shard.snapshot.load();
+                    for (auto& e : snapshot->entries)
+                        dispose(e.second);
+                    SSnapshot::destroy(snapshot);
+                }
+            }
+
+            //! @returns false if the cache is not a multi-cache and there already is an object under `_key`
+            inline bool insert(const K& _key, const T& _val)
+            {
+                return modify(_key,[&](SSnapshot* _next, vector<T>&) -> bool
+                {
+                    auto rng = findRange(_next->entries,_key);
+                    if (!IsMultiCache && rng.first!=rng.second)
+                        return false;
+                    greet(_next->entries.insert(rng.second,PairType{_key,_val})->second);
+                    return true;
+                });
+            }
+
+            //! Linear in the size of the cache, avoid in hot paths
+            inline bool contains(const T& _object) const
+            {
+                for (const auto& shard : m_shards)
+                {
+                    SReadGuard guard(shard);
+                    for (const auto& e : guard.snapshot->entries)
+                    if (e.second==_object)
+                        return true;
+                }
+                return false;
+            }
+
+            //! Sum of all shards' sizes, only a snapshot if there are concurrent modifications
+            inline size_t getSize() const
+            {
+                size_t retval = 0u;
+                for (const auto& shard : m_shards)
+                {
+                    SReadGuard guard(shard);
+                    retval += guard.snapshot->entries.size();
+                }
+                return retval;
+            }
+
+            inline void clear()
+            {
+                for (auto& shard : m_shards)
+                {
+                    std::unique_lock<std::mutex> lk(shard.writeLock);
+                    SSnapshot* next = SSnapshot::create();
+                    SSnapshot* prev = publish(shard,next);
+                    for (auto& e : prev->entries)
+                        dispose(e.second);
+                    SSnapshot::destroy(prev);
+                }
+            }
+
+            //! Returns true if had to insert
+            bool swapObjectValue(const K& _key, const T& _obj, const T& _val)
+            {
+                bool inserted = false;
+                modify(_key,[&](SSnapshot* _next, vector<T>& _disposeLater) -> bool
+                {
+                    auto rng = findRange(_next->entries,_key);
+                    auto found = std::find_if(rng.first,rng.second,[&_obj](const PairType& _e) {return _e.second==_obj;});
+                    if (found!=rng.second)
+                    {
+                        _disposeLater.push_back(found->second);
+                        found->second = _val;
+                    }
+                    else
+                    {
+                        found = _next->entries.insert(rng.second,PairType{_key,_val});
+                        inserted = true;
+                    }
+                    greet(found->second);
+                    return true;
+                });
+                return inserted;
+            }
+
+            //! Same as findAndStoreRange, but if nothing was found a value-initialized object gets inserted under `_key` as a placeholder
+            /** @returns true if found. */
+            bool getAndStoreKeyRangeOrReserve(const K& _key, size_t& _inOutStorageSize, T* _out, bool* _gotAll)
+            {
+                bool dummy;
+                if (!_gotAll)
+                    _gotAll = &dummy;
+                // optimistic read-only path first, we only need to pay for a copy of the shard if we actually reserve
+                {
+                    SReadGuard guard(getShard(_key));
+                    auto rng = findRange(guard.snapshot->entries,_key);
+                    if (rng.first!=rng.second)
+                    {
+                        *_gotAll = outputRange(rng,_inOutStorageSize,_out);
+                        return true;
+                    }
+                }
+
+                bool found = false;
+                modify(_key,[&](SSnapshot* _next, vector<T>&) -> bool
+                {
+                    auto rng = findRange(_next->entries,_key);
+                    if (rng.first==rng.second)
+                    {
+                        rng.first = _next->entries.insert(rng.second,PairType{_key,T()});
+                        rng.second = std::next(rng.first);
+                        greet(rng.first->second);
+                    }
+                    else
+                        found = true;
+                    *_gotAll = outputRange(typename SSnapshot::const_range_t(rng),_inOutStorageSize,_out);
+                    return !found;
+                });
+                return found;
+            }
+
+            //! @returns true if object was removed (i.e. was present in cache)
+            inline bool removeObject(const T& _obj, const K& _key)
+            {
+                return removeObject_impl<true>(_obj,_key);
+            }
+
+            //! Semantics of CObjectCacheBase::outputRange, if `_out` is null the amount of objects under `_key` gets written to `_inOutStorageSize`
+            inline bool findAndStoreRange(const K& _key, size_t& _inOutStorageSize, MutablePairType* _out) const
+            {
+                SReadGuard guard(getShard(_key));
+                return outputRange(findRange(guard.snapshot->entries,_key),_inOutStorageSize,_out);
+            }
+            inline bool findAndStoreRange(const K& _key, size_t& _inOutStorageSize, T* _out) const
+            {
+                SReadGuard guard(getShard(_key));
+                return outputRange(findRange(guard.snapshot->entries,_key),_inOutStorageSize,_out);
+            }
+
+            //! Entries are grouped by shard, so only sorted by key within a shard
+            inline bool outputAll(size_t& _inOutStorageSize, MutablePairType* _out) const
+            {
+                const size_t availableSize = _inOutStorageSize;
+                size_t reqSize = 0u;
+                _inOutStorageSize = 0u;
+                for (const auto& shard : m_shards)
+                {
+                    SReadGuard guard(shard);
+                    const auto& entries = guard.snapshot->entries;
+                    reqSize += entries.size();
+                    if (!_out)
+                        continue;
+                    for (auto it=entries.begin(); it!=entries.end() && _inOutStorageSize<availableSize; it++)
+                        _out[_inOutStorageSize++] = *it;
+                }
+                if (!_out)
+                {
+                    _inOutStorageSize = reqSize;
+                    return false;
+                }
+                return availableSize<=reqSize;
+            }
+
+            //! Neither disposes nor greets the object
+            /** Not atomic if the keys land in different shards, a concurrent reader may briefly find the object under neither key. */
+            inline bool changeObjectKey(const T& _obj, const K& _key, const K& _newKey)
+            {
+                constexpr bool DoGreetOrDispose = false;
+                if (!removeObject_impl<DoGreetOrDispose>(_obj,_key))
+                    return false;
+                modify(_newKey,[&](SSnapshot* _next, vector<T>&) -> bool
+                {
+                    auto rng = findRange(_next->entries,_newKey);
+                    _next->entries.insert(rng.second,PairType{_newKey,_obj});
+                    return true;
+                });
+                return true;
+            }
+
+        private:
+            struct SSnapshot
+            {
+                using container_t = vector<PairType>;
+                using range_t = std::pair<typename container_t::iterator,typename container_t::iterator>;
+                using const_range_t = std::pair<typename container_t::const_iterator,typename container_t::const_iterator>;
+
+                container_t entries;
+
+                // spelled out because _IRR_NEW and _IRR_DELETE cannot be used with a dependent type
+                static inline SSnapshot* create()
+                {
+                    return AlignedWithAllocator<SSnapshot>::new_(_IRR_DEFAULT_ALIGNMENT(SSnapshot),core::allocator<SSnapshot>());
+                }
+                static inline void destroy(SSnapshot* _snapshot)
+                {
+                    AlignedWithAllocator<SSnapshot>::delete_(_snapshot);
+                }
+            };
+
+            struct alignas(64) SShard
+            {
+                SShard() : snapshot(SSnapshot::create()), epoch(0u)
+                {
+                    readers[0] = 0u;
+                    readers[1] = 0u;
+                }
+
+                std::atomic<SSnapshot*> snapshot;
+                //! readers register on the counter of the epoch's parity, writers flip the epoch and wait for the old parity to drain
+                mutable std::atomic<uint32_t> readers[2];
+                std::atomic<uint32_t> epoch;
+                std::mutex writeLock;
+            };
+
+            //! All operations are sequentially consistent on purpose, the grace period argument relies on a single total order of the epoch flip, the reader registration and the snapshot swap
+            struct SReadGuard
+            {
+                SReadGuard(const SShard& _shard) : shard(_shard)
+                {
+                    while (true)
+                    {
+                        const uint32_t epoch = shard.epoch.load();
+                        parity = epoch&0x1u;
+                        shard.readers[parity]++;
+                        if (shard.epoch.load()==epoch)
+                            break;
+                        // writer flipped the epoch in the meantime, it may not be waiting for us so register again
+                        shard.readers[parity]--;
+                    }
+                    snapshot = shard.snapshot.load();
+                }
+                ~SReadGuard()
+                {
+                    shard.readers[parity]--;
+                }
+
+                const SShard& shard;
+                const SSnapshot* snapshot;
+                uint32_t parity;
+            };
+
+            inline const SShard& getShard(const K& _key) const { return m_shards[shardIndex(_key)]; }
+            inline SShard& getShard(const K& _key) { return m_shards[shardIndex(_key)]; }
+            inline uint32_t shardIndex(const K& _key) const
+            {
+                // mix the high bits in, plenty of std::hash implementations are the identity for integers and pointers
+                const uint64_t h = uint64_t(Hash()(_key))*0x9E3779B97F4A7C15ull;
+                return uint32_t(h>>(64u-ShardCountLog2))&(ShardCount-1u);
+            }
+
+            //! Swaps in the new snapshot and returns the old one once no reader can see it anymore, must be called with the shard's write lock held
+            static inline SSnapshot* publish(SShard& _shard, SSnapshot* _next)
+            {
+                SSnapshot* prev = _shard.snapshot.exchange(_next);
+                const uint32_t oldParity = _shard.epoch.fetch_add(1u)&0x1u;
+                while (_shard.readers[oldParity].load()!=0u)
+                    std::this_thread::yield();
+                return prev;
+            }
+
+            //! Copies the shard of `_key`, lets `_f(nextSnapshot,disposeLater)` modify it and publishes it if `_f` returns true
+            template<class F>
+            inline bool modify(const K& _key, F&& _f)
+            {
+                SShard& shard = getShard(_key);
+                std::unique_lock<std::mutex> lk(shard.writeLock);
+
+                SSnapshot* next = SSnapshot::create();
+                next->entries = shard.snapshot.load()->entries;
+                vector<T> disposeLater;
+                if (!_f(next,disposeLater))
+                {
+                    SSnapshot::destroy(next);
+                    return false;
+                }
+
+                SSnapshot::destroy(publish(shard,next));
+                for (auto& obj : disposeLater)
+                    dispose(obj);
+                return true;
+            }
+
+            template<bool DisposeOnRemove>
+            inline bool removeObject_impl(const T& _obj, const K& _key)
+            {
+                return modify(_key,[&](SSnapshot* _next, vector<T>& _disposeLater) -> bool
+                {
+                    auto rng = findRange(_next->entries,_key);
+                    auto found = std::find_if(rng.first,rng.second,[&_obj](const PairType& _e) {return _e.second==_obj;});
+                    if (found==rng.second)
+                        return false;
+                    if (DisposeOnRemove)
+                        _disposeLater.push_back(found->second);
+                    _next->entries.erase(found);
+                    return true;
+                });
+            }
+
+            // used `<` instead of `==` operator here to keep consistency with the other caches (so key type doesn't need to define operator==)
+            template<class ContainerT>
+            static inline auto findRange(ContainerT& _entries, const K& _key)
+            {
+                auto first = std::lower_bound(_entries.begin(),_entries.end(),_key,[](const PairType& _a, const K& _b) -> bool {return _a.first<_b;});
+                auto last = std::upper_bound(first,_entries.end(),_key,[](const K& _a, const PairType& _b) -> bool {return _a<_b.first;});
+                return std::make_pair(first,last);
+            }
+
+            template<typename StorageT>
+            static inline void outputThis(const PairType& _entry, StorageT& _storage)
+            {
+                IRR_PSEUDO_IF_CONSTEXPR_BEGIN(std::is_same<StorageT,MutablePairType>::value)
+                {
+                    _storage = _entry;
+                }
+                IRR_PSEUDO_ELSE_CONSTEXPR
+                {
+                    _storage = _entry.second;
+                }
+                IRR_PSEUDO_IF_CONSTEXPR_END
+            }
+
+            template<typename StorageT>
+            static inline bool outputRange(const typename SSnapshot::const_range_t& _rng, size_t& _inOutStorageSize, StorageT* _out)
+            {
+                const size_t reqSize = std::distance(_rng.first,_rng.second);
+                if (!_out)
+                {
+                    _inOutStorageSize = reqSize;
+                    return false;
+                }
+                size_t i = 0u;
+                for (auto it=_rng.first; it!=_rng.second && i<_inOutStorageSize; ++it)
+                    outputThis(*it,_out[i++]);
+                const bool res = _inOutStorageSize<=reqSize;
+                _inOutStorageSize = i;
+                return res;
+            }
+
+            inline void greet(T& _object) const
+            {
+                if (m_greetingFunc)
+                    m_greetingFunc(_object);
+            }
+            inline void dispose(T& _object) const
+            {
+                if (m_disposalFunc)
+                    m_disposalFunc(_object);
+            }
+
+            GreetFuncType m_greetingFunc;
+            DisposalFuncType m_disposalFunc;
+            SShard m_shards[ShardCount];
+    };
+}
+
+//! Drop-in replacement for CConcurrentObjectCache when lookups vastly outnumber modifications, see impl::CShardedConcurrentObjectCacheBase
+template<
+    typename K,
+    typename T,
+    uint32_t ShardCountLog2 = 5u,
+    typename Hash = std::hash<K>
+>
+using CShardedConcurrentObjectCache = impl::CShardedConcurrentObjectCacheBase<K, T, false, ShardCountLog2, Hash>;
+
+//! Drop-in replacement for CConcurrentMultiObjectCache when lookups vastly outnumber modifications, see impl::CShardedConcurrentObjectCacheBase
+template<
+    typename K,
+    typename T,
+    uint32_t ShardCountLog2 = 5u,
+    typename Hash = std::hash<K>
+>
+using CShardedConcurrentMultiObjectCache = impl::CShardedConcurrentObjectCacheBase<K, T, true, ShardCountLog2, Hash>;
+
+}}
+
+#endif
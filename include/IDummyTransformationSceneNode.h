@@ -9,6 +9,7 @@
 #include "ISceneNodeAnimator.h"
 #include <algorithm>
 #include "matrix4x3.h"
+#include "matrix3x4SIMD.h"
 #include "ESceneNodeTypes.h"
 
 namespace irr
@@ -41,6 +42,8 @@ class IDummyTransformationSceneNode : public virtual core::IReferenceCounted
         uint64_t lastTimeRelativeTransRead[5];
 
         uint64_t relativeTransChanged;
+        //! bumped every time AbsoluteTransformation gets recomputed, children compare it against lastTimeRelativeTransRead[4]
+        uint64_t absoluteTransChanged;
         bool relativeTransNeedsUpdate;
 
         virtual ~IDummyTransformationSceneNode()
@@ -59,7 +62,7 @@ class IDummyTransformationSceneNode : public virtual core::IReferenceCounted
 				const core::vector3df& rotation = core::vector3df(0,0,0),
 				const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f)) :
                 RelativeTranslation(position), RelativeRotation(rotation), RelativeScale(scale),
-				Parent(0),  relativeTransChanged(1), relativeTransNeedsUpdate(true)
+				Parent(0),  relativeTransChanged(1), absoluteTransChanged(0), relativeTransNeedsUpdate(true)
         {
             memset(lastTimeRelativeTransRead,0,sizeof(uint64_t)*5);
 
@@ -71,6 +74,14 @@ class IDummyTransformationSceneNode : public virtual core::IReferenceCounted
 
         virtual bool isISceneNode() const {return false;}
 
+        //! Whether the scene manager may animate this node breadth first, together with all other nodes at the same depth
+        /** The scene manager runs the animators of a whole depth level and then recomputes the absolute transformations
+        of that level in parallel. Returning false gets the node and its whole subtree animated recursively and depth first
+        on the calling thread instead.
+        \attention Nodes which override updateAbsolutePosition() must return false, as it never gets called otherwise.
+        ISceneNode returns false by default, because the same goes for ISceneNode::OnAnimate(). */
+        virtual bool supportsLevelOrderedUpdate() const {return true;}
+
         //! Returns a reference to the current relative transformation matrix.
         /** This is the matrix, this scene node uses instead of scale, translation
         and rotation. */
@@ -107,7 +118,7 @@ class IDummyTransformationSceneNode : public virtual core::IReferenceCounted
 
         inline const uint64_t& getRelativeTransChangedHint() const {return relativeTransChanged;}
 
-        inline const uint64_t& getAbsoluteTransformLastRecomputeHint() const {return lastTimeRelativeTransRead[3];}
+        inline const uint64_t& getAbsoluteTransformLastRecomputeHint() const {return absoluteTransChanged;}
 
         inline const core::vector3df& getScale()
         {
@@ -225,6 +236,14 @@ class IDummyTransformationSceneNode : public virtual core::IReferenceCounted
 			hierarchy you might want to update the parents first.*/
 		inline virtual void updateAbsolutePosition()
 		{
+            recomputeAbsoluteTransformation();
+		}
+
+		//! Non-virtual body of updateAbsolutePosition()
+		/** Only touches this node, so the scene manager calls it for many nodes of the same depth at once.
+		\return Whether the relative transformation or the parent's absolute one changed and the absolute transformation had to be recomputed. */
+		inline bool recomputeAbsoluteTransformation()
+		{
             bool recompute = relativeTransNeedsUpdate||lastTimeRelativeTransRead[3]<relativeTransChanged;
 
             if (Parent)
@@ -235,20 +254,24 @@ class IDummyTransformationSceneNode : public virtual core::IReferenceCounted
                     lastTimeRelativeTransRead[4] = parentAbsoluteHint;
                     recompute = true;
                 }
-
-                // recompute if local transform has changed
-                if (recompute)
-                {
-                    const core::matrix4x3& rel = getRelativeTransformationMatrix();
-                    AbsoluteTransformation = concatenateBFollowedByA(Parent->getAbsoluteTransformation(),rel);
-                    lastTimeRelativeTransRead[3] = relativeTransChanged;
-                }
             }
-            else if (recompute)
+
+            if (!recompute)
+                return false;
+
+            const core::matrix4x3& rel = getRelativeTransformationMatrix();
+            if (Parent)
             {
-                AbsoluteTransformation = getRelativeTransformationMatrix();
-                lastTimeRelativeTransRead[3] = relativeTransChanged;
+                core::matrix3x4SIMD parentAbsolute,relative;
+                parentAbsolute.set(Parent->getAbsoluteTransformation());
+                relative.set(rel);
+                AbsoluteTransformation = core::matrix3x4SIMD::concatenateBFollowedByA(parentAbsolute,relative).getAsRetardedIrrlichtMatrix();
             }
+            else
+                AbsoluteTransformation = rel;
+            lastTimeRelativeTransRead[3] = relativeTransChanged;
+            absoluteTransChanged++;
+            return true;
 		}
 
 
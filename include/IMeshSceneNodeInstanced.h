@@ -35,6 +35,14 @@ class IMeshSceneNodeInstanced : public ISceneNode
 
         typedef core::smart_refctd_ptr<asset::IMeshDataFormatDesc<video::IGPUBuffer> > (*VaoSetupOverrideFunc)(ISceneManager*,video::IGPUBuffer*,const size_t&,const asset::IMeshDataFormatDesc<video::IGPUBuffer>*, void* userData);
 
+        //! CPU counterpart of what "lodSelectionShader" outputs, has to write `dataSizePerInstanceOutput` bytes for an instance which survived culling
+        /** \param output Where the instance's output data goes, in the buffer the VAOs from VaoSetupOverrideFunc read.
+        \param worldTransform The node's absolute transformation followed by the instance's.
+        \param instanceData The instance's input data (transform, 3x3 inverse transpose, extra data).
+        \param lod LoD the instance got assigned to.
+        Gets called from many threads at once. */
+        typedef void (*CPUInstanceOutputFunc)(void* output, const core::matrix4x3& worldTransform, const uint8_t* instanceData, const uint32_t& lod, void* userData);
+
         struct MeshLoD
         {
 			video::IGPUMesh* mesh;
@@ -74,6 +82,16 @@ class IMeshSceneNodeInstanced : public ISceneNode
 
         virtual const core::aabbox3df& getLoDInvariantBBox() const = 0;
 
+        //! Culls instances and selects their LoDs on the CPU instead of with "lodSelectionShader"
+        /** The instances get culled by their world space bounding box against the active camera's frustum, and their LoD is picked by the distance
+        from the camera to the center of their LoD invariant box, past the last LoD's distance they get culled. Instances made invisible with
+        setInstanceVisible() get culled as well. The survivors are classified in parallel, then their output is written straight into a mapped
+        upload buffer, one tightly packed list per LoD, so no transform feedback or query objects are needed.
+        \param outputFunc Writes one instance's output data, NULL switches back to culling on the GPU (default). */
+        virtual void setCPUCulling(CPUInstanceOutputFunc outputFunc, void* userData=NULL) = 0;
+
+        virtual bool isCPUCullingEnabled() const = 0;
+
 
         inline void setBBoxUpdateEnabled() {wantBBoxUpdate = true;}
         inline void setBBoxUpdateDisabled() {wantBBoxUpdate = false;}
@@ -43,6 +43,15 @@ namespace io
 		//! Get name of file.
 		/** \return File name as zero terminated character string. */
 		virtual const io::path& getFileName() const = 0;
+
+		//! Get direct read-only access to a range of the file's contents, without copying.
+		/** Only available for files which are already in memory or memory-mapped,
+		the pointer stays valid for as long as the file object is alive. Does not change the position in the file.
+		\param offset Offset of the range from the beginning of the file.
+		\param size Size of the range in bytes.
+		\return Pointer to the first byte of the range, or nullptr if the range is out of bounds
+		or the file does not support direct access, use read() then. */
+		virtual const void* getMappedRange(const size_t& offset, const size_t& size) const { return nullptr; }
 	};
 
 } // end namespace io
@@ -92,6 +92,7 @@ namespace scene
 	class ISceneNode;
 	class ISceneNodeAnimator;
 	class ISceneNodeAnimatorCollisionResponse;
+	struct SViewFrustum;
 
 	namespace quake3
 	{
@@ -429,7 +430,9 @@ namespace scene
 		\param pass: Specifies when the node wants to be drawn in relation to the other nodes.
 		For example, if the node is a shadow, it usually wants to be drawn after all other nodes
 		and will use ESNRP_SHADOW for this. See scene::E_SCENE_NODE_RENDER_PASS for details.
-		\return scene will be rendered ( passed culling ) */
+		\return scene will be rendered ( passed culling ). The solid, transparent, transparent effect and automatic passes
+		get culled all at once after every node registered, so for those this only says the node got queued, and whether it
+		passed culling is only known once ISceneNode::OnCullingDone() gets called. Zero still always means not rendered. */
 		virtual uint32_t registerNodeForRendering(ISceneNode* node,
 			E_SCENE_NODE_RENDER_PASS pass = ESNRP_AUTOMATIC) = 0;
 
@@ -552,6 +555,34 @@ namespace scene
 		\return True if node is not visible in the current scene, else
 		false. */
 		virtual bool isCulled(ISceneNode* node) const =0;
+
+		//! Makes the scene manager keep a spatial index over the world space bounding boxes of its scene nodes
+		/** The index gets updated at the end of every animation pass, only for nodes whose absolute transformation
+		changed (and for the whole subtrees of nodes which don't support level ordered updates, since those get animated
+		depth first and might animate their bounding boxes). It contains all visible scene nodes, invisible subtrees are
+		left out. Changes to a node's local bounding box alone only get picked up
+		when it moves. The queries below see the scene as it was after the last drawAll().
+		\param enabled Disabling frees the index and drops its nodes.
+		\param smallestCellSize Side of the smallest cells, ideally about the size of the smallest nodes. */
+		virtual void setSpatialIndexEnabled(bool enabled, float smallestCellSize=1.f) = 0;
+
+		virtual bool isSpatialIndexEnabled() const = 0;
+
+		//! Appends the indexed scene nodes whose world bounding box overlaps a box
+		/** \return False if the spatial index is disabled. */
+		virtual bool getSceneNodesInBox(const core::aabbox3df& box, core::vector<ISceneNode*>& outNodes) const = 0;
+
+		//! Appends the indexed scene nodes whose world bounding box is no further than radius from center
+		/** \return False if the spatial index is disabled. */
+		virtual bool getSceneNodesInSphere(const core::vector3df& center, float radius, core::vector<ISceneNode*>& outNodes) const = 0;
+
+		//! Appends the indexed scene nodes whose world bounding box isn't culled by the frustum, whole cells of the index get rejected at once
+		/** \return False if the spatial index is disabled. */
+		virtual bool getSceneNodesInFrustum(const SViewFrustum& frustum, core::vector<ISceneNode*>& outNodes) const = 0;
+
+		//! Appends the k indexed scene nodes whose world bounding box is closest to a point, closest first
+		/** \return False if the spatial index is disabled. */
+		virtual bool getNearestSceneNodes(const core::vector3df& point, uint32_t k, core::vector<ISceneNode*>& outNodes) const = 0;
 	};
 
 
@@ -24,6 +24,7 @@ namespace scene
 {
 	class ISceneManager;
     class ISceneNode;
+	class CSceneNodeSpatialIndex;
 
 
 
@@ -48,7 +49,7 @@ namespace scene
                 SceneManager(mgr), renderFence(0), fenceBehaviour(EFRB_SKIP_DRAW),
                 ID(id), AutomaticCullingState(EAC_FRUSTUM_BOX),
                 DebugDataVisible(EDS_OFF), mobid(0), mobtype(0), IsVisible(true),
-                IsDebugObject(false), staticmeshid(0),blockposX(0),blockposY(0),blockposZ(0), renderPriority(0x80000000u)
+                IsDebugObject(false), staticmeshid(0),blockposX(0),blockposY(0),blockposZ(0), renderPriority(0x80000000u), SpatialIndexEntry(0xffffffffu)
 		{
 		}
 
@@ -96,6 +97,14 @@ namespace scene
 			OnRegisterSceneNode_static(this);
 		}
 
+		//! Tells the node whether one of its registrations for rendering passed culling
+		/** The scene manager culls everything registered for the solid, transparent, transparent effect and automatic passes
+		at once, after all nodes got OnRegisterSceneNode() called. This gets called once per such registration after that,
+		and before anything is rendered, so work which only makes sense for a node that will be rendered belongs here
+		rather than after ISceneManager::registerNodeForRendering() returns.
+		\param passedCulling Whether the node got added to the render list of the pass it registered for. */
+		virtual void OnCullingDone(bool passedCulling) {}
+
 		//! Adds a child to this scene node.
 		/** If the scene node already has a parent it is first removed
 		from the other parent.
@@ -112,11 +121,19 @@ namespace scene
 			IDummyTransformationSceneNode::addChild(child);
 		}
 
+		//! Scene nodes get animated recursively through OnAnimate() unless they opt in
+		/** Returning true lets the scene manager skip OnAnimate() and animate the node together with its whole depth level,
+		only do that if neither OnAnimate() nor updateAbsolutePosition() are overridden.
+		All scene node types of the engine except the skinned mesh opt in. */
+		virtual bool supportsLevelOrderedUpdate() const {return false;}
+
 		//! OnAnimate() is called just before rendering the whole scene.
 		/** Nodes may calculate or store animations here, and may do other useful things,
 		depending on what they are. Also, OnAnimate() should be called for all
 		child scene nodes here. This method will be called once per frame, independent
 		of whether the scene node is visible or not.
+		\attention The scene manager only calls it for nodes which return false from supportsLevelOrderedUpdate(),
+		which is the default for scene nodes. A node type returning true must not override this.
 		\param timeMs Current time in milliseconds. */
 		virtual void OnAnimate(uint32_t timeMs)
 		{
@@ -467,32 +484,41 @@ namespace scene
 		//! Is debug object?
 		bool IsDebugObject;
 
+		//! Where the node is in its scene manager's spatial index, if it has one
+		uint32_t SpatialIndexEntry;
+		friend class CSceneNodeSpatialIndex;
+
+        //! Runs all animators of the node, without touching its transformation or children
+        static void animateNode_static(IDummyTransformationSceneNode* node, uint32_t timeMs)
+        {
+            //! The bloody animator can remove itself during animateNode!!!!
+            const ISceneNodeAnimatorArray& animators = node->getAnimators();
+            size_t prevSize = animators.size();
+            for (size_t i=0; i<prevSize;)
+            {
+                ISceneNodeAnimator* anim = animators[i];
+                anim->animateNode(node, timeMs);
+                if (animators[i]>anim)
+                    prevSize = animators.size();
+                else
+                    i++;
+            }
+        }
+
         static void OnAnimate_static(IDummyTransformationSceneNode* node, uint32_t timeMs) // could be pushed up to IDummyTransformationSceneNode
 		{
             ISceneNode* tmp = static_cast<ISceneNode*>(node);
 			if (!node->isISceneNode()||tmp->IsVisible)
 			{
 				// animate this node with all animators
-
-				//! The bloody animator can remove itself during animateNode!!!!
-				const ISceneNodeAnimatorArray& animators = node->getAnimators();
-				size_t prevSize = animators.size();
-				for (size_t i=0; i<prevSize;)
-                {
-					ISceneNodeAnimator* anim = animators[i];
-					anim->animateNode(node, timeMs);
-					if (animators[i]>anim)
-                        prevSize = animators.size();
-                    else
-                        i++;
-				}
+				animateNode_static(node,timeMs);
 
 				// update absolute position
 				node->updateAbsolutePosition();
 
 				// perform the post render process on all children
                 const IDummyTransformationSceneNodeArray& children = node->getChildren();
-				prevSize = children.size();
+				size_t prevSize = children.size();
 				for (size_t i=0; i<prevSize;)
                 {
                     IDummyTransformationSceneNode* tmpChild = children[i];
@@ -80,6 +80,9 @@ namespace scene
 		//! OnAnimate() is called just before rendering the whole scene.
 		virtual void OnAnimate(uint32_t timeMs) = 0;
 
+		//! Performs the boning of its children bones in OnAnimate(), so the subtree has to be animated depth first
+		virtual bool supportsLevelOrderedUpdate() const {return false;}
+
 		//! renders the node.
 		virtual void render() = 0;
 
@@ -87,6 +87,23 @@ namespace scene
             typedef core::PoolAddressAllocatorST<uint32_t>                                              InstanceDataAddressAllocator;
         public:
             constexpr static decltype(InstanceDataAddressAllocator::invalid_address) kInvalidInstanceID = InstanceDataAddressAllocator::invalid_address;
+            constexpr static uint32_t kNoBoneMask = 0xffffffffu;
+
+            //! One clip in the layer stack of an instance, see `setAnimationLayers`
+            struct SAnimationLayer
+            {
+                SAnimationLayer(const float& _frame=0.f, const float& _weight=1.f) : frame(_frame), weight(_weight), referenceFrame(0.f), boneMask(kNoBoneMask), interpolate(true), additive(false) {}
+
+                float frame;
+                //! how much of the layer gets applied, multiplied by the bone's weight in `boneMask`
+                float weight;
+                //! additive layers apply the difference between their pose at `frame` and the pose at this frame
+                float referenceFrame;
+                //! what `addBoneMask` returned, or kNoBoneMask for the layer to affect every bone fully
+                uint32_t boneMask;
+                bool interpolate;
+                bool additive;
+            };
 
             enum E_BONE_UPDATE_MODE
             {
@@ -169,7 +186,10 @@ namespace scene
                             return IDummyTransformationSceneNode::needsDeepAbsoluteTransformRecompute();
                     }
 
-                    /// if the MODE is READ, have to do implicit boning of an instance :D
+                    //! bones get implicitly boned through their owner manager, which is not thread safe
+                    inline virtual bool supportsLevelOrderedUpdate() const {return false;}
+
+                    /// if the MODE is READ, have to do implicit boning of an instance :D
                     inline virtual void updateAbsolutePosition()
                     {
                         ownerManager->implicitBone(InstanceID,BoneIndex);
@@ -190,18 +210,20 @@ namespace scene
                                 const core::matrix4x3& rel = getRelativeTransformationMatrix();
                                 AbsoluteTransformation = concatenateBFollowedByA(Parent->getAbsoluteTransformation(),rel);
                                 lastTimeRelativeTransRead[3] = relativeTransChanged;
+                                absoluteTransChanged++;
                             }
                         }
                         else if (recompute)
                         {
                             AbsoluteTransformation = getRelativeTransformationMatrix();
                             lastTimeRelativeTransRead[3] = relativeTransChanged;
-                        }
+                            absoluteTransChanged++;
+                        }
                     }
 
-                    inline bool getTransformChangedBoningHint() const {return lastTimePulledAbsoluteTFormForBoning<lastTimeRelativeTransRead[3];}
+                    inline bool getTransformChangedBoningHint() const {return lastTimePulledAbsoluteTFormForBoning<absoluteTransChanged;}
 
-                    inline void setTransformChangedBoningHint() {lastTimePulledAbsoluteTFormForBoning = lastTimeRelativeTransRead[3];}
+                    inline void setTransformChangedBoningHint() {lastTimePulledAbsoluteTFormForBoning = absoluteTransChanged;}
 
                 protected:
                     ISkinningStateManager* ownerManager;
@@ -256,6 +278,8 @@ namespace scene
                 if ((instance->refCount--)>1)
                     return false;
 
+                instanceLayers.erase(ID);
+
                 //proceed to delete
                 auto instanceBones = getBones(instance);
                 for (size_t i=0; i<referenceHierarchy->getBoneLevelRangeEnd(0); i++)
@@ -297,6 +321,43 @@ namespace scene
                 getBoneHierarchyInstanceFromAddr(ID)->frame = frame;
             }
 
+            //! Adds a set of per bone weights for SAnimationLayer::boneMask, `boneWeights` needs one for every bone of the hierarchy
+            inline uint32_t addBoneMask(const float* boneWeights)
+            {
+                const uint32_t retval = boneMasks.size()/referenceHierarchy->getBoneCount();
+                boneMasks.insert(boneMasks.end(),boneWeights,boneWeights+referenceHierarchy->getBoneCount());
+                return retval;
+            }
+
+            //! Animates the instance with a stack of layers instead of the single frame from `setFrame`, only in EBUM_NONE and EBUM_READ
+            /** The first layer is the base pose, its weight, mask and additive flag are ignored. Every following layer, in order, either
+            moves the pose towards its own by its weight, or if additive, adds the difference between its pose at `frame` and at `referenceFrame`.
+            Crossfading N clips with weights w_i is done by giving layer i a weight of w_i/(w_0+...+w_i).
+            The layers get copied, so this has to be called again whenever any of them changes, a `count` of 0 goes back to `setFrame`. */
+            inline void setAnimationLayers(const SAnimationLayer* layers, const uint32_t& count, const uint32_t& ID)
+            {
+                BoneHierarchyInstanceData* instance = getBoneHierarchyInstanceFromAddr(ID);
+                if (count)
+                {
+                    instanceLayers[ID].assign(layers,layers+count);
+                    instance->frame = layers[0].frame;
+                    instance->interpolateAnimation = layers[0].interpolate;
+                }
+                else
+                    instanceLayers.erase(ID);
+
+                // the pose can change without the frame changing
+                if (boneControlMode!=EBUM_CONTROL)
+                    instance->lastAnimatedFrame = -FLT_MAX;
+            }
+
+            //! nullptr if the instance has no layers
+            inline const core::vector<SAnimationLayer>* getAnimationLayers(const uint32_t& ID) const
+            {
+                auto found = instanceLayers.find(ID);
+                return found!=instanceLayers.end() ? &found->second:nullptr;
+            }
+
             inline IBoneSceneNode* getBone(const uint32_t& boneID, const uint32_t& ID)
             {
                 assert(boneID<referenceHierarchy->getBoneCount());
@@ -336,6 +397,11 @@ namespace scene
             const E_BONE_UPDATE_MODE boneControlMode;
             const asset::CFinalBoneHierarchy* referenceHierarchy;
 
+            //! getBoneCount() weights per mask
+            core::vector<float> boneMasks;
+            //! only instances with layers are in here
+            core::unordered_map<uint32_t,core::vector<SAnimationLayer> > instanceLayers;
+
             size_t actualSizeOfInstanceDataElement;
             class BoneHierarchyInstanceData : public core::AlignedBase<_IRR_SIMD_ALIGNMENT>
             {
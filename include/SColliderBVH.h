@@ -0,0 +1,631 @@
+#ifndef __S_COLLIDER_BVH_H_INCLUDED__
+#define __S_COLLIDER_BVH_H_INCLUDED__
+
+#include <algorithm>
+#include <numeric>
+
+#include "vectorSIMD.h"
+#include "aabbox3d.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! 4-wide bounding volume hierarchy over arbitrary primitives given by their bounding boxes
+/**
+Built top-down with a binned surface area heuristic, every node splits its primitives twice so it ends up with up to 4 children.
+The bounds of the 4 children are kept as a structure-of-arrays, so a ray gets tested against all of them with a few SSE instructions.
+
+The hierarchy only knows primitive indices, what a primitive is and how a ray hits it is up to the leaf callback of traverseRay().
+When primitives move, refit() grows or shrinks the nodes above them without changing the topology, which is much cheaper than
+a rebuild but makes the tree worse the further things move from where they were at build time (watch the SAH cost it returns).
+*/
+class SColliderBVH// : public AllocationOverrideDefault EBO inheritance problem
+{
+    public:
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t Width = 4u;
+        //! Deepest node level built with the surface area heuristic, below that nodes get split at the median to bound the traversal stack
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t MaxSAHDepth = 24u;
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t StackSize = 192u;
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t BinCount = 16u;
+
+        //! Throws away the old tree and builds a new one
+        /**
+        @param bounds Bounding box of every primitive.
+        @param primitiveCount Number of primitives.
+        @param maxLeafSize Nodes with this many primitives or less become leaves.
+        */
+        inline void build(const aabbox3df* bounds, const uint32_t& primitiveCount, const uint32_t& maxLeafSize)
+        {
+            Nodes.clear();
+            PrimitiveIndices.resize(primitiveCount);
+            std::iota(PrimitiveIndices.begin(),PrimitiveIndices.end(),0u);
+            if (primitiveCount==0u)
+                return;
+
+            Centroids.resize(primitiveCount);
+            for (uint32_t i=0u; i<primitiveCount; i++)
+                Centroids[i] = bounds[i].getCenter();
+
+            LeafSize = core::max_(maxLeafSize,1u);
+            buildNode(bounds,0u,primitiveCount,0u);
+            Centroids.clear();
+        }
+
+        //! Fits the nodes around new primitive bounds, the topology of the tree stays the same
+        /**
+        @param bounds New bounding box of every primitive, indexed the same way as in build().
+        @param changed One flag per primitive, only nodes above primitives with a nonzero flag get recomputed. NULL means all of them.
+        @returns The SAH cost of the refitted tree, same as getSAHCost().
+        */
+        inline float refit(const aabbox3df* bounds, const uint8_t* changed=NULL)
+        {
+            if (Nodes.size()==0u)
+                return 0.f;
+
+            NodeChanged.resize(Nodes.size());
+            // children always come after their parents
+            for (size_t n=Nodes.size(); n--;)
+            {
+                SNode& node = Nodes[n];
+                bool nodeChanged = false;
+                for (uint32_t i=0u; i<Width; i++)
+                {
+                    if (node.count[i]==InternalNode)
+                    {
+                        if (!NodeChanged[node.child[i]])
+                            continue;
+                        setChildBounds(node,i,Nodes[node.child[i]].getBounds());
+                    }
+                    else if (node.count[i])
+                    {
+                        const uint32_t* primitives = PrimitiveIndices.data()+node.child[i];
+                        bool leafChanged = !changed;
+                        for (uint32_t j=0u; j<node.count[i] && !leafChanged; j++)
+                            leafChanged = changed[primitives[j]];
+                        if (!leafChanged)
+                            continue;
+
+                        aabbox3df box(bounds[primitives[0]]);
+                        for (uint32_t j=1u; j<node.count[i]; j++)
+                            box.addInternalBox(bounds[primitives[j]]);
+                        setChildBounds(node,i,box);
+                    }
+                    else
+                        continue;
+                    nodeChanged = true;
+                }
+                NodeChanged[n] = nodeChanged;
+            }
+            return getSAHCost();
+        }
+
+        //! Expected cost of a random ray query, in node visits and primitive tests relative to the root's surface area
+        /** Only comparable between trees over the same primitives, mostly useful to tell when refitting has degraded a tree enough to rebuild it. */
+        inline float getSAHCost() const
+        {
+            if (Nodes.size()==0u)
+                return 0.f;
+
+            const float rootArea = getHalfArea(Nodes[0].getBounds());
+            if (rootArea<=0.f)
+                return 0.f;
+
+            float cost = 0.f;
+            for (const auto& node : Nodes)
+            for (uint32_t i=0u; i<Width; i++)
+            {
+                if (node.count[i]==InternalNode)
+                    cost += getHalfArea(node.getChildBounds(i));
+                else if (node.count[i])
+                    cost += getHalfArea(node.getChildBounds(i))*float(node.count[i]);
+            }
+            return cost/rootArea+1.f;
+        }
+
+        inline bool empty() const {return Nodes.size()==0u;}
+        inline size_t getNodeCount() const {return Nodes.size();}
+
+        //! Primitive indices in leaf order, leaf callbacks get ranges of this array
+        inline const uint32_t* getPrimitiveIndices() const {return PrimitiveIndices.data();}
+        inline uint32_t getPrimitiveIndex(const uint32_t& leafOrderIndex) const {return PrimitiveIndices[leafOrderIndex];}
+
+        //! Bounds of the whole tree, valid only if not empty()
+        inline aabbox3df getBounds() const {return Nodes[0].getBounds();}
+
+        //! Finds the closest hit along a ray by visiting the leaves it passes through from front to back
+        /**
+        @param origin Start point of the ray.
+        @param direction Direction of the ray, does not need to be normalized.
+        @param[in,out] maxT Leaves further away than `maxT` multiples of `direction` get skipped.
+        @param leaf Gets called as `bool leaf(uint32_t first, uint32_t count, float& maxT)` for every leaf the ray enters,
+        needs to test the primitives `getPrimitiveIndices()[first]` to `getPrimitiveIndices()[first+count-1]`, lower `maxT` to the closest hit
+        and return whether it found one which is closer than the `maxT` it got.
+        @returns Whether any leaf callback returned true.
+        */
+        template<class LeafF>
+        inline bool traverseRay(const vectorSIMDf& origin, const vectorSIMDf& direction, float& maxT, LeafF&& leaf) const
+        {
+            if (Nodes.size()==0u)
+                return false;
+
+            __m128 rayOrigin[3], rayInvDir[3];
+            uint32_t nearBound[3], farBound[3];
+            for (uint32_t j=0u; j<3u; j++)
+            {
+                rayOrigin[j] = _mm_set1_ps(origin.pointer[j]);
+                rayInvDir[j] = _mm_set1_ps(1.f/direction.pointer[j]);
+                // the slab a ray enters first depends on which way it goes, NaNs from 0*inf get ignored by the min/max below
+                nearBound[j] = direction.pointer[j]<0.f ? EB_MAX_X+j:EB_MIN_X+j;
+                farBound[j] = direction.pointer[j]<0.f ? EB_MIN_X+j:EB_MAX_X+j;
+            }
+
+            struct SStackEntry
+            {
+                uint32_t child;
+                uint32_t count;
+                float tNear;
+            } stack[StackSize];
+            uint32_t stackSize = 1u;
+            stack[0] = {0u,InternalNode,0.f};
+
+            bool retval = false;
+            while (stackSize)
+            {
+                const SStackEntry entry = stack[--stackSize];
+                if (entry.tNear>maxT)
+                    continue;
+                if (entry.count!=InternalNode)
+                {
+                    retval = leaf(entry.child,entry.count,maxT)||retval;
+                    continue;
+                }
+
+                const SNode& node = Nodes[entry.child];
+                __m128 tMin = _mm_setzero_ps();
+                __m128 tMax = _mm_set1_ps(maxT);
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    const __m128 tNear = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[nearBound[j]]),rayOrigin[j]),rayInvDir[j]);
+                    const __m128 tFar = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.bounds[farBound[j]]),rayOrigin[j]),rayInvDir[j]);
+                    tMin = _mm_max_ps(tNear,tMin);
+                    tMax = _mm_min_ps(tFar,tMax);
+                }
+                uint32_t hitMask = _mm_movemask_ps(_mm_cmple_ps(tMin,tMax));
+                if (!hitMask)
+                    continue;
+
+                float tEntry[Width];
+                _mm_storeu_ps(tEntry,tMin);
+                // sort the hit children far to near so the nearest gets popped first
+                SStackEntry hits[Width];
+                uint32_t hitCount = 0u;
+                for (uint32_t i=0u; i<Width; i++)
+                {
+                    if (!(hitMask&(0x1u<<i)) || node.count[i]==0u)
+                        continue;
+
+                    uint32_t j = hitCount++;
+                    for (; j && hits[j-1u].tNear<tEntry[i]; j--)
+                        hits[j] = hits[j-1u];
+                    hits[j] = {node.child[i],node.count[i],tEntry[i]};
+                }
+                _IRR_DEBUG_BREAK_IF(stackSize+hitCount>StackSize);
+                for (uint32_t i=0u; i<hitCount; i++)
+                    stack[stackSize++] = hits[i];
+            }
+            return retval;
+        }
+
+        //! Bitmask of the lanes which are true
+        static inline uint32_t getLaneMask(const vector4db_SIMD& mask)
+        {
+            return _mm_movemask_ps(_mm_castsi128_ps(mask.getAsRegister()));
+        }
+
+        //! 4 rays which get traversed together, lane `i` of every member belongs to the `i`-th ray
+        struct SRayPacket
+        {
+            vectorSIMDf origin[3];
+            vectorSIMDf invDirection[3];
+
+            inline void setRay(const uint32_t& lane, const vectorSIMDf& rayOrigin, const vectorSIMDf& rayDirection)
+            {
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    origin[j].pointer[lane] = rayOrigin.pointer[j];
+                    invDirection[j].pointer[lane] = 1.f/rayDirection.pointer[j];
+                }
+            }
+        };
+
+        //! Same as traverseRay() but for 4 rays at once, a node gets visited once for all rays which pass through it
+        /**
+        Pays off when the rays are coherent (similar origins and directions), as then they mostly visit the same nodes.
+        @param packet The rays, lanes not in `activeLanes` can hold anything.
+        @param[in,out] maxT Per lane `maxT` of traverseRay().
+        @param activeLanes Bitmask of the lanes holding rays.
+        @param leaf Gets called as `uint32_t leaf(uint32_t first, uint32_t count, uint32_t lanes, vectorSIMDf& maxT)` for every leaf
+        which any of the rays in the `lanes` bitmask enters, it needs to test those rays against the primitives like in traverseRay(),
+        lower their lanes of `maxT` and return the bitmask of lanes which found a closer hit.
+        @returns Bitmask of the lanes which found a hit.
+        */
+        template<class LeafF>
+        inline uint32_t traverseRayPacket(const SRayPacket& packet, vectorSIMDf& maxT, const uint32_t& activeLanes, LeafF&& leaf) const
+        {
+            if (Nodes.size()==0u || !activeLanes)
+                return 0u;
+
+            struct SStackEntry
+            {
+                uint32_t child;
+                uint32_t count;
+                uint32_t lanes;
+                //! closest entry point of any of the lanes
+                float tNear;
+            } stack[StackSize];
+            uint32_t stackSize = 1u;
+            stack[0] = {0u,InternalNode,activeLanes,0.f};
+
+            uint32_t retval = 0u;
+            while (stackSize)
+            {
+                const SStackEntry entry = stack[--stackSize];
+                // rays which already hit something in front of this entry lose interest
+                const uint32_t lanes = entry.lanes&getLaneMask(vectorSIMDf(entry.tNear)<=maxT);
+                if (!lanes)
+                    continue;
+                if (entry.count!=InternalNode)
+                {
+                    retval |= leaf(entry.child,entry.count,lanes,maxT);
+                    continue;
+                }
+
+                const SNode& node = Nodes[entry.child];
+                SStackEntry hits[Width];
+                uint32_t hitCount = 0u;
+                for (uint32_t i=0u; i<Width; i++)
+                {
+                    if (node.count[i]==0u)
+                        continue;
+
+                    // no near and far slab per axis as the rays might go different ways, min/max ignore NaNs from 0*inf
+                    vectorSIMDf tMin(0.f), tMax(maxT);
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        const vectorSIMDf t1 = (vectorSIMDf(node.bounds[EB_MIN_X+j][i])-packet.origin[j])*packet.invDirection[j];
+                        const vectorSIMDf t2 = (vectorSIMDf(node.bounds[EB_MAX_X+j][i])-packet.origin[j])*packet.invDirection[j];
+                        tMin = max_(min_(t1,t2),tMin);
+                        tMax = min_(max_(t1,t2),tMax);
+                    }
+                    const uint32_t childLanes = lanes&getLaneMask(tMin<=tMax);
+                    if (!childLanes)
+                        continue;
+
+                    float tEntry = FLT_MAX;
+                    for (uint32_t l=0u; l<Width; l++)
+                    {
+                        if (childLanes&(0x1u<<l))
+                            tEntry = core::min_(tEntry,tMin.pointer[l]);
+                    }
+                    // sort far to near like in traverseRay()
+                    uint32_t j = hitCount++;
+                    for (; j && hits[j-1u].tNear<tEntry; j--)
+                        hits[j] = hits[j-1u];
+                    hits[j] = {node.child[i],node.count[i],childLanes,tEntry};
+                }
+                _IRR_DEBUG_BREAK_IF(stackSize+hitCount>StackSize);
+                for (uint32_t i=0u; i<hitCount; i++)
+                    stack[stackSize++] = hits[i];
+            }
+            return retval;
+        }
+
+        //! Up to 4 boxes, lane `i` of every member belongs to the `i`-th box
+        struct SBoxPacket
+        {
+            vectorSIMDf minEdge[3];
+            vectorSIMDf maxEdge[3];
+
+            inline void setBox(const uint32_t& lane, const aabbox3df& box)
+            {
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    minEdge[j].pointer[lane] = (&box.MinEdge.X)[j];
+                    maxEdge[j].pointer[lane] = (&box.MaxEdge.X)[j];
+                }
+            }
+        };
+
+        //! Visits every leaf whose bounds pass a test, such as overlapping a query volume
+        /**
+        @param test Gets called as `uint32_t test(const SBoxPacket& boxes)` with the bounds of a node's children,
+        needs to return the bitmask of lanes which pass. It should be conservative, a lane passing does not guarantee anything about the primitives inside.
+        @param leaf Gets called as `bool leaf(uint32_t first, uint32_t count)` for every leaf which passed, with the same ranges as in traverseRay(),
+        returning false stops the traversal.
+        @returns False if a leaf callback stopped the traversal.
+        */
+        template<class TestF, class LeafF>
+        inline bool traverseOverlaps(TestF&& test, LeafF&& leaf) const
+        {
+            if (Nodes.size()==0u)
+                return true;
+
+            struct SStackEntry
+            {
+                uint32_t child;
+                uint32_t count;
+            } stack[StackSize];
+            uint32_t stackSize = 1u;
+            stack[0] = {0u,InternalNode};
+
+            while (stackSize)
+            {
+                const SStackEntry entry = stack[--stackSize];
+                if (entry.count!=InternalNode)
+                {
+                    if (!leaf(entry.child,entry.count))
+                        return false;
+                    continue;
+                }
+
+                const SNode& node = Nodes[entry.child];
+                SBoxPacket children;
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    children.minEdge[j] = vectorSIMDf(node.bounds[EB_MIN_X+j]);
+                    children.maxEdge[j] = vectorSIMDf(node.bounds[EB_MAX_X+j]);
+                }
+                const uint32_t passed = test(children);
+                _IRR_DEBUG_BREAK_IF(stackSize+Width>StackSize);
+                for (uint32_t i=Width; i--;)
+                {
+                    if ((passed&(0x1u<<i)) && node.count[i])
+                        stack[stackSize++] = {node.child[i],node.count[i]};
+                }
+            }
+            return true;
+        }
+
+    private:
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t InternalNode = 0xffffffffu;
+
+        enum E_BOUND
+        {
+            EB_MIN_X = 0,
+            EB_MIN_Y,
+            EB_MIN_Z,
+            EB_MAX_X,
+            EB_MAX_Y,
+            EB_MAX_Z,
+            EB_COUNT
+        };
+
+        struct SNode
+        {
+            SNode()
+            {
+                for (uint32_t i=0u; i<Width; i++)
+                {
+                    // empty slots never get hit
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        bounds[EB_MIN_X+j][i] = FLT_MAX;
+                        bounds[EB_MAX_X+j][i] = -FLT_MAX;
+                    }
+                    child[i] = 0u;
+                    count[i] = 0u;
+                }
+            }
+
+            inline aabbox3df getChildBounds(const uint32_t& i) const
+            {
+                return aabbox3df(bounds[EB_MIN_X][i],bounds[EB_MIN_Y][i],bounds[EB_MIN_Z][i],bounds[EB_MAX_X][i],bounds[EB_MAX_Y][i],bounds[EB_MAX_Z][i]);
+            }
+
+            inline aabbox3df getBounds() const
+            {
+                aabbox3df box(getChildBounds(0u));
+                for (uint32_t i=1u; i<Width; i++)
+                {
+                    if (count[i])
+                        box.addInternalBox(getChildBounds(i));
+                }
+                return box;
+            }
+
+            //! one row per E_BOUND, one column per child
+            float bounds[EB_COUNT][Width];
+            //! node index for internal children, first entry in PrimitiveIndices for leaves
+            uint32_t child[Width];
+            //! InternalNode, primitive count of a leaf or 0 for an unused slot
+            uint32_t count[Width];
+        };
+
+        struct SRange
+        {
+            uint32_t begin;
+            uint32_t end;
+            aabbox3df box;
+        };
+
+
+        static inline float getHalfArea(const aabbox3df& box)
+        {
+            const vector3df extent = box.MaxEdge-box.MinEdge;
+            return extent.X*extent.Y+extent.Y*extent.Z+extent.Z*extent.X;
+        }
+
+        static inline void setChildBounds(SNode& node, const uint32_t& i, const aabbox3df& box)
+        {
+            for (uint32_t j=0u; j<3u; j++)
+            {
+                node.bounds[EB_MIN_X+j][i] = (&box.MinEdge.X)[j];
+                node.bounds[EB_MAX_X+j][i] = (&box.MaxEdge.X)[j];
+            }
+        }
+
+        inline aabbox3df getRangeBounds(const aabbox3df* bounds, const uint32_t& begin, const uint32_t& end) const
+        {
+            aabbox3df box(bounds[PrimitiveIndices[begin]]);
+            for (uint32_t i=begin+1u; i<end; i++)
+                box.addInternalBox(bounds[PrimitiveIndices[i]]);
+            return box;
+        }
+
+        //! Splits a range of primitives in two, by the binned SAH or at the median of the longest centroid axis
+        inline uint32_t splitRange(const aabbox3df* bounds, const SRange& range, const uint32_t& depth)
+        {
+            uint32_t* const begin = PrimitiveIndices.data()+range.begin;
+            uint32_t* const end = PrimitiveIndices.data()+range.end;
+
+            aabbox3df centroidBox(Centroids[*begin]);
+            for (const uint32_t* it=begin+1; it!=end; it++)
+                centroidBox.addInternalPoint(Centroids[*it]);
+            const vector3df centroidExtent = centroidBox.MaxEdge-centroidBox.MinEdge;
+            uint32_t longestAxis = centroidExtent.X>centroidExtent.Y ? 0u:1u;
+            if (centroidExtent.Z>(&centroidExtent.X)[longestAxis])
+                longestAxis = 2u;
+
+            auto medianSplit = [&]() -> uint32_t
+            {
+                uint32_t* middle = begin+(end-begin)/2;
+                std::nth_element(begin,middle,end,[&](uint32_t a, uint32_t b) {return (&Centroids[a].X)[longestAxis]<(&Centroids[b].X)[longestAxis];});
+                return middle-PrimitiveIndices.data();
+            };
+            if ((&centroidExtent.X)[longestAxis]<=0.f || depth>=MaxSAHDepth)
+                return medianSplit();
+
+            float bestCost = FLT_MAX;
+            uint32_t bestAxis = 0u, bestBin = 0u;
+            for (uint32_t axis=0u; axis<3u; axis++)
+            {
+                const float axisMin = (&centroidBox.MinEdge.X)[axis];
+                const float axisExtent = (&centroidExtent.X)[axis];
+                if (axisExtent<=0.f)
+                    continue;
+
+                struct SBin
+                {
+                    aabbox3df box;
+                    uint32_t count = 0u;
+                } bins[BinCount];
+                const float binScale = float(BinCount)*(1.f-FLT_EPSILON)/axisExtent;
+                for (const uint32_t* it=begin; it!=end; it++)
+                {
+                    auto& bin = bins[core::min_(uint32_t(((&Centroids[*it].X)[axis]-axisMin)*binScale),BinCount-1u)];
+                    if (bin.count++)
+                        bin.box.addInternalBox(bounds[*it]);
+                    else
+                        bin.box = bounds[*it];
+                }
+
+                // sweep from the right to get the cost of everything above each split plane
+                float rightCost[BinCount];
+                aabbox3df box;
+                uint32_t count = 0u;
+                for (uint32_t i=BinCount-1u; i; i--)
+                {
+                    if (bins[i].count)
+                    {
+                        if (count)
+                            box.addInternalBox(bins[i].box);
+                        else
+                            box = bins[i].box;
+                        count += bins[i].count;
+                    }
+                    rightCost[i] = count ? getHalfArea(box)*float(count):0.f;
+                }
+                count = 0u;
+                for (uint32_t i=0u; i<BinCount-1u; i++)
+                {
+                    if (bins[i].count)
+                    {
+                        if (count)
+                            box.addInternalBox(bins[i].box);
+                        else
+                            box = bins[i].box;
+                        count += bins[i].count;
+                    }
+                    if (count==0u || count==range.end-range.begin)
+                        continue;
+
+                    const float cost = getHalfArea(box)*float(count)+rightCost[i+1u];
+                    if (cost<bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = i;
+                    }
+                }
+            }
+            if (bestCost==FLT_MAX)
+                return medianSplit();
+
+            const float axisMin = (&centroidBox.MinEdge.X)[bestAxis];
+            const float binScale = float(BinCount)*(1.f-FLT_EPSILON)/(&centroidExtent.X)[bestAxis];
+            const uint32_t* middle = std::partition(begin,end,[&](uint32_t i) {return core::min_(uint32_t(((&Centroids[i].X)[bestAxis]-axisMin)*binScale),BinCount-1u)<=bestBin;});
+            return middle-PrimitiveIndices.data();
+        }
+
+        inline uint32_t buildNode(const aabbox3df* bounds, const uint32_t& begin, const uint32_t& end, const uint32_t& depth)
+        {
+            SRange ranges[Width];
+            uint32_t rangeCount = 1u;
+            ranges[0] = {begin,end,getRangeBounds(bounds,begin,end)};
+            // split the biggest range which is too large for a leaf, until there are 4 of them
+            while (rangeCount<Width)
+            {
+                float biggestArea = -1.f;
+                uint32_t biggest = 0u;
+                for (uint32_t i=0u; i<rangeCount; i++)
+                {
+                    const float area = getHalfArea(ranges[i].box);
+                    if (ranges[i].end-ranges[i].begin>LeafSize && area>biggestArea)
+                    {
+                        biggestArea = area;
+                        biggest = i;
+                    }
+                }
+                if (biggestArea<0.f)
+                    break;
+
+                const SRange range = ranges[biggest];
+                const uint32_t middle = splitRange(bounds,range,depth);
+                ranges[biggest] = {range.begin,middle,getRangeBounds(bounds,range.begin,middle)};
+                ranges[rangeCount++] = {middle,range.end,getRangeBounds(bounds,middle,range.end)};
+            }
+
+            const uint32_t nodeIndex = Nodes.size();
+            Nodes.emplace_back();
+            for (uint32_t i=0u; i<rangeCount; i++)
+            {
+                uint32_t child = ranges[i].begin, count = ranges[i].end-ranges[i].begin;
+                if (count>LeafSize)
+                {
+                    child = buildNode(bounds,ranges[i].begin,ranges[i].end,depth+1u);
+                    count = InternalNode;
+                }
+                // Nodes might have been reallocated
+                SNode& node = Nodes[nodeIndex];
+                setChildBounds(node,i,ranges[i].box);
+                node.child[i] = child;
+                node.count[i] = count;
+            }
+            return nodeIndex;
+        }
+
+        vector<SNode> Nodes;
+        vector<uint32_t> PrimitiveIndices;
+        //! only used during build() and refit()
+        vector<vector3df> Centroids;
+        vector<uint8_t> NodeChanged;
+        uint32_t LeafSize = 1u;
+};
+
+
+}
+}
+
+#endif
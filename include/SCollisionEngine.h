@@ -1,20 +1,160 @@
 #ifndef __S_COLLISION_ENGINE_H_INCLUDED__
 #define __S_COLLISION_ENGINE_H_INCLUDED__
 
+#include <atomic>
+
 #include "irrlicht.h"
 #include "SCompoundCollider.h"
 #include "SViewFrustum.h"
+#include "irr/core/parallel/parallel_for.h"
 
 namespace irr
 {
 namespace core
 {
 
+//! A ray of a batched SCollisionEngine::FastCollide query
+struct SCollisionRay
+{
+    vectorSIMDf origin;
+    //! Normalized direction
+    vectorSIMDf direction;
+    float maxRayLen = FLT_MAX;
+};
+
+//! The result of a batched SCollisionEngine::FastCollide query, for one ray
+struct SCollisionHit
+{
+    //! Data of the collider which got hit, untouched if `hit` is false
+    SColliderData hitPointObjectData;
+    //! Distance to the closest hit, `maxRayLen` of the ray if nothing got hit
+    float collisionDistance;
+    bool hit;
+};
+
+//! Ray and overlap queries against a set of compound colliders
+/**
+The colliders sit in a SColliderBVH built over their world space bounds, which refit() keeps up to date as they move.
+Until the first refit() after adding or removing colliders, queries fall back to testing every collider.
+Overlap queries (findOverlaps, findOverlappingPairs) are a broad phase, they only look at the world space bounding boxes.
+*/
 class SCollisionEngine : public AllocationOverrideDefault
 {
         vector<SCompoundCollider*> colliders;
+        //! world space bounds of `colliders` as of the last refit()
+        vector<aabbox3df> colliderBounds;
+        vector<uint8_t> colliderMoved;
+        SColliderBVH bvh;
+        float builtSAHCost = 0.f;
+        bool bvhOutOfDate = false;
+
+        inline void rebuildBVH()
+        {
+            bvh.build(colliderBounds.data(),colliders.size(),MaxLeafColliders);
+            builtSAHCost = bvh.getSAHCost();
+            bvhOutOfDate = false;
+        }
+
+        inline bool collideWithRange(SColliderData& hitPointObjectData, float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction,
+                                        const uint32_t& first, const uint32_t& count, const uint32_t* indices) const
+        {
+            bool retval = false;
+            for (uint32_t i=first; i<first+count; i++)
+            {
+                const SCompoundCollider* collider = colliders[indices ? indices[i]:i];
+                float tmpDist;
+                if (collider->CollideWithRay(tmpDist,origin,direction,collisionDistance)&&tmpDist<collisionDistance)
+                {
+                    collisionDistance = tmpDist;
+                    hitPointObjectData = collider->getColliderData();
+                    retval = true;
+                }
+            }
+            return retval;
+        }
+
+        //! traverses one packet of rays together and writes their results
+        inline size_t collidePacket(SCollisionHit* hits, const SCollisionRay* rays, const uint32_t& rayCount) const
+        {
+            // rays going into different octants hardly ever visit the same nodes, so they are faster one by one
+            const uint32_t octant = _mm_movemask_ps(rays[0].direction.getAsRegister())&0x7u;
+            for (uint32_t lane=1u; lane<rayCount; lane++)
+            {
+                if ((_mm_movemask_ps(rays[lane].direction.getAsRegister())&0x7u)==octant)
+                    continue;
+
+                size_t hitCount = 0u;
+                for (uint32_t i=0u; i<rayCount; i++)
+                {
+                    hits[i].hit = FastCollide(hits[i].hitPointObjectData,hits[i].collisionDistance,rays[i].origin,rays[i].direction,rays[i].maxRayLen);
+                    hitCount += hits[i].hit;
+                }
+                return hitCount;
+            }
+
+            SColliderBVH::SRayPacket packet;
+            vectorSIMDf maxT;
+            for (uint32_t lane=0u; lane<rayCount; lane++)
+            {
+                packet.setRay(lane,rays[lane].origin,rays[lane].direction);
+                maxT.pointer[lane] = rays[lane].maxRayLen;
+                hits[lane].collisionDistance = rays[lane].maxRayLen;
+                hits[lane].hit = false;
+            }
+
+            const uint32_t hitLanes = bvh.traverseRayPacket(packet,maxT,(0x1u<<rayCount)-1u,[&](uint32_t first, uint32_t count, uint32_t lanes, vectorSIMDf& packetMaxT)
+                {
+                    uint32_t retval = 0u;
+                    for (uint32_t i=first; i<first+count; i++)
+                    {
+                        // the node's transformation gets inverted once for the whole packet
+                        const SCompoundCollider* collider = colliders[bvh.getPrimitiveIndex(i)];
+                        matrix4x3 worldToLocal;
+                        if (!collider->getWorldToLocalTransform(worldToLocal))
+                            continue;
+
+                        for (uint32_t lane=0u; lane<rayCount; lane++)
+                        {
+                            if (!(lanes&(0x1u<<lane)))
+                                continue;
+
+                            vectorSIMDf origin(rays[lane].origin), direction(rays[lane].direction);
+                            if (collider->getColliderData().attachedNode)
+                                SCompoundCollider::transformRay(worldToLocal,origin,direction);
+                            float tmpDist;
+                            if (collider->CollideWithLocalRay(tmpDist,origin,direction,packetMaxT.pointer[lane])&&tmpDist<packetMaxT.pointer[lane])
+                            {
+                                packetMaxT.pointer[lane] = tmpDist;
+                                hits[lane].hitPointObjectData = collider->getColliderData();
+                                retval |= 0x1u<<lane;
+                            }
+                        }
+                    }
+                    return retval;
+                }
+            );
+
+            size_t hitCount = 0u;
+            for (uint32_t lane=0u; lane<rayCount; lane++)
+            {
+                hits[lane].collisionDistance = maxT.pointer[lane];
+                hits[lane].hit = hitLanes&(0x1u<<lane);
+                hitCount += hits[lane].hit;
+            }
+            return hitCount;
+        }
 
     public:
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t MaxLeafColliders = 2u;
+        //! rays which get traversed together by the batched FastCollide
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t RayPacketSize = SColliderBVH::Width;
+        //! roughly how many rays a worker thread should get in one go during a batched FastCollide
+        _IRR_STATIC_INLINE_CONSTEXPR size_t RayGrain = 256u;
+        //! roughly how many colliders a worker thread should get in one go during refit()
+        _IRR_STATIC_INLINE_CONSTEXPR size_t ColliderGrain = 1024u;
+        //! refit() rebuilds the BVH once refitting made its SAH cost this many times worse than right after the last build
+        _IRR_STATIC_INLINE_CONSTEXPR float RebuildCostRatio = 2.f;
+
 		//! Destructor.
         ~SCollisionEngine()
         {
@@ -114,6 +254,7 @@ class SCollisionEngine : public AllocationOverrideDefault
 
             collider->grab();
             colliders.insert(found,collider);
+            bvhOutOfDate = true;
         }
 
 		//! Removes collider pointed by `collider`
@@ -132,37 +273,320 @@ class SCollisionEngine : public AllocationOverrideDefault
 
 			(*found)->drop();
             colliders.erase(found);
+            bvhOutOfDate = true;
         }
 
 		//! Gets current amount of colliders
 		/** @rturns Current amount of colliders. */
         inline size_t getColliderCount() const { return colliders.size(); }
 
+		//! Brings the BVH up to date with where the colliders are now
+		/** Recomputes the world space bounds of every collider (in parallel) and refits the nodes above the ones which moved.
+		The BVH gets rebuilt instead if colliders were added or removed, or if refitting made it more than RebuildCostRatio times slower to traverse.
+		Colliders attached to scene nodes only follow them through this, so call it after the scene got animated and before the ray queries of a frame.
+		*/
+        inline void refit()
+        {
+            const size_t count = colliders.size();
+            colliderBounds.resize(count);
+            colliderMoved.resize(count);
+            parallel_for<size_t>(0u,count,[&](size_t i)
+                {
+                    const aabbox3df box = colliders[i]->getWorldBoundingBox();
+                    colliderMoved[i] = box!=colliderBounds[i];
+                    colliderBounds[i] = box;
+                },ColliderGrain
+            );
+
+            if (bvhOutOfDate)
+                rebuildBVH();
+            else if (std::find(colliderMoved.begin(),colliderMoved.end(),1u)!=colliderMoved.end() && bvh.refit(colliderBounds.data(),colliderMoved.data())>RebuildCostRatio*builtSAHCost)
+                rebuildBVH();
+        }
+
+		//! @returns Whether queries have to test every collider because colliders got added or removed since the last refit().
+        inline bool isBVHOutOfDate() const { return bvhOutOfDate; }
+
 		//! Performs collision test with a given ray defined by `origin`, `direction` and `maxRayLen` parameters
 		/**
 		@param[out] hitPointObjectData Data of collider with which the collision occured. Does not get touched if no collision occured.
-		@param[out] collisionDistance If no collision occured - gets value of `maxRayLen` parameter. Otherwise - ???
+		@param[out] collisionDistance If no collision occured - gets value of `maxRayLen` parameter. Otherwise - distance to the closest hit, in multiples of `direction`.
 		@param[in] origin Start point point of the input ray
 		@param[in] direction Normalized vector denoting direction of the input ray
 		@param[in] maxRayLen Length of the input ray
 		*/
         inline bool FastCollide(SColliderData& hitPointObjectData, float &collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& maxRayLen=FLT_MAX) const
         {
-            bool retval = false;
-
             collisionDistance = maxRayLen;
-            for (size_t i=0; i<colliders.size(); i++)
+            if (bvhOutOfDate)
+                return collideWithRange(hitPointObjectData,collisionDistance,origin,direction,0u,colliders.size(),NULL);
+
+            return bvh.traverseRay(origin,direction,collisionDistance,[&](uint32_t first, uint32_t count, float& maxT)
+                {
+                    return collideWithRange(hitPointObjectData,maxT,origin,direction,first,count,bvh.getPrimitiveIndices());
+                }
+            );
+        }
+
+		//! Performs collision tests with many rays at once
+		/**
+		Consecutive rays get traversed through the BVH in packets of RayPacketSize, so sort them to keep rays which go the same way
+		from about the same place next to each other (by screen tile, by listener, etc.), packets of rays going into different octants
+		get traversed one ray at a time. Big batches get split across the task scheduler's threads.
+		Finds the same closest hits as calling the single ray FastCollide for every ray.
+		@param[out] hits One result per ray.
+		@param[in] rays The rays.
+		@param[in] rayCount Number of rays and results.
+		@returns How many of the rays hit something.
+		*/
+        inline size_t FastCollide(SCollisionHit* hits, const SCollisionRay* rays, const size_t& rayCount) const
+        {
+            std::atomic<size_t> hitCount(0u);
+            if (bvhOutOfDate)
             {
-                float tmpDist;
-                if (colliders[i]->CollideWithRay(tmpDist,origin,direction,collisionDistance)&&tmpDist<collisionDistance)
+                parallel_for_range<size_t>(0u,rayCount,[&](size_t rangeBegin, size_t rangeEnd)
+                    {
+                        size_t rangeHitCount = 0u;
+                        for (size_t i=rangeBegin; i<rangeEnd; i++)
+                        {
+                            hits[i].hit = FastCollide(hits[i].hitPointObjectData,hits[i].collisionDistance,rays[i].origin,rays[i].direction,rays[i].maxRayLen);
+                            rangeHitCount += hits[i].hit;
+                        }
+                        hitCount += rangeHitCount;
+                    },RayGrain
+                );
+                return hitCount;
+            }
+
+            const size_t packetCount = (rayCount+RayPacketSize-1u)/RayPacketSize;
+            parallel_for_range<size_t>(0u,packetCount,[&](size_t rangeBegin, size_t rangeEnd)
                 {
-                    collisionDistance = tmpDist;
-                    hitPointObjectData = colliders[i]->getColliderData();
-                    retval = true;
+                    size_t rangeHitCount = 0u;
+                    for (size_t packet=rangeBegin; packet<rangeEnd; packet++)
+                    {
+                        const size_t first = packet*RayPacketSize;
+                        rangeHitCount += collidePacket(hits+first,rays+first,core::min_<size_t>(rayCount-first,RayPacketSize));
+                    }
+                    hitCount += rangeHitCount;
+                },RayGrain/RayPacketSize
+            );
+            return hitCount;
+        }
+
+		//! Calls `callback(SCompoundCollider*)` for every collider whose world space bounding box overlaps `box`, until it returns false.
+        template<class CallbackF>
+        inline void findOverlaps(const aabbox3df& box, CallbackF&& callback) const
+        {
+            forEachOverlap(SBoxTest(box),[&](uint32_t i) {return callback(colliders[i]);});
+        }
+		//! Calls `callback(SCompoundCollider*)` for every collider whose world space bounding box overlaps a sphere, until it returns false.
+        template<class CallbackF>
+        inline void findOverlaps(const vectorSIMDf& center, const float& radius, CallbackF&& callback) const
+        {
+            forEachOverlap(SSphereTest(center,radius),[&](uint32_t i) {return callback(colliders[i]);});
+        }
+		//! Calls `callback(SCompoundCollider*)` for every collider whose world space bounding box is not entirely outside of one of the frustum's planes, until it returns false.
+        template<class CallbackF>
+        inline void findOverlaps(const scene::SViewFrustum& frustum, CallbackF&& callback) const
+        {
+            forEachOverlap(SFrustumTest(frustum),[&](uint32_t i) {return callback(colliders[i]);});
+        }
+
+		//! Finds the colliders whose world space bounding box overlaps `box`, without allocating.
+		/**
+		@param[out] overlaps Gets the first `capacity` colliders found.
+		@param[in] capacity Size of `overlaps`.
+		@returns Number of colliders found, if it is more than `capacity` then the rest did not fit.
+		*/
+        inline size_t findOverlaps(const aabbox3df& box, SCompoundCollider** overlaps, const size_t& capacity) const
+        {
+            return collectOverlaps(SBoxTest(box),overlaps,capacity);
+        }
+		//! Same as above, with the colliders whose world space bounding box overlaps a sphere.
+        inline size_t findOverlaps(const vectorSIMDf& center, const float& radius, SCompoundCollider** overlaps, const size_t& capacity) const
+        {
+            return collectOverlaps(SSphereTest(center,radius),overlaps,capacity);
+        }
+		//! Same as above, with the colliders whose world space bounding box is not entirely outside of one of the frustum's planes.
+        inline size_t findOverlaps(const scene::SViewFrustum& frustum, SCompoundCollider** overlaps, const size_t& capacity) const
+        {
+            return collectOverlaps(SFrustumTest(frustum),overlaps,capacity);
+        }
+
+		//! Calls `callback(SCompoundCollider*,SCompoundCollider*)` once for every pair of colliders with overlapping world space bounding boxes, until it returns false.
+		/** Each collider's box gets looked up in the BVH, so it takes O(n log n) instead of O(n^2) as long as the BVH is not out of date. */
+        template<class CallbackF>
+        inline void findOverlappingPairs(CallbackF&& callback) const
+        {
+            for (uint32_t i=0u; i<colliders.size(); i++)
+            {
+                bool keepGoing = true;
+                forEachOverlap(SBoxTest(getBounds(i)),[&](uint32_t j)
+                    {
+                        // every pair only once
+                        if (j<=i)
+                            return true;
+                        return keepGoing = callback(colliders[i],colliders[j]);
+                    }
+                );
+                if (!keepGoing)
+                    return;
+            }
+        }
+		//! Finds every pair of colliders with overlapping world space bounding boxes, without allocating.
+		/**
+		@param[out] pairs Gets the first `capacity` pairs found.
+		@param[in] capacity Size of `pairs`.
+		@returns Number of pairs found, if it is more than `capacity` then the rest did not fit.
+		*/
+        inline size_t findOverlappingPairs(std::pair<SCompoundCollider*,SCompoundCollider*>* pairs, const size_t& capacity) const
+        {
+            size_t count = 0u;
+            findOverlappingPairs([&](SCompoundCollider* a, SCompoundCollider* b)
+                {
+                    if (count<capacity)
+                        pairs[count] = std::make_pair(a,b);
+                    count++;
+                    return true;
+                }
+            );
+            return count;
+        }
+
+    private:
+        //! world space bounds of a collider, the cached ones unless they are out of date
+        inline aabbox3df getBounds(const uint32_t& i) const
+        {
+            return bvhOutOfDate ? colliders[i]->getWorldBoundingBox():colliderBounds[i];
+        }
+
+        //! the query volumes, test 4 boxes at a time and return the bitmask of those which overlap
+        struct SBoxTest
+        {
+            SBoxTest(const aabbox3df& box)
+            {
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    queryMin[j] = vectorSIMDf((&box.MinEdge.X)[j]);
+                    queryMax[j] = vectorSIMDf((&box.MaxEdge.X)[j]);
                 }
             }
 
-            return retval;
+            inline uint32_t operator()(const SColliderBVH::SBoxPacket& boxes) const
+            {
+                uint32_t overlapping = 0xfu;
+                for (uint32_t j=0u; j<3u; j++)
+                    overlapping &= SColliderBVH::getLaneMask(boxes.minEdge[j]<=queryMax[j])&SColliderBVH::getLaneMask(boxes.maxEdge[j]>=queryMin[j]);
+                return overlapping;
+            }
+
+            vectorSIMDf queryMin[3], queryMax[3];
+        };
+        struct SSphereTest
+        {
+            SSphereTest(const vectorSIMDf& center, const float& radius) : radius2(radius*radius)
+            {
+                for (uint32_t j=0u; j<3u; j++)
+                    this->center[j] = vectorSIMDf(center.pointer[j]);
+            }
+
+            inline uint32_t operator()(const SColliderBVH::SBoxPacket& boxes) const
+            {
+                // squared distance from the center to the closest point of every box
+                vectorSIMDf distance2(0.f);
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    const vectorSIMDf d = max_(boxes.minEdge[j]-center[j],vectorSIMDf(0.f))+max_(center[j]-boxes.maxEdge[j],vectorSIMDf(0.f));
+                    distance2 += d*d;
+                }
+                return SColliderBVH::getLaneMask(distance2<=radius2);
+            }
+
+            vectorSIMDf center[3];
+            vectorSIMDf radius2;
+        };
+        struct SFrustumTest
+        {
+            SFrustumTest(const scene::SViewFrustum& frustum)
+            {
+                for (uint32_t i=0u; i<scene::SViewFrustum::VF_PLANE_COUNT; i++)
+                {
+                    const float* plane = reinterpret_cast<const float*>(frustum.planes+i);
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        planes[i].normal[j] = vectorSIMDf(plane[j]);
+                        planes[i].positiveMax[j] = plane[j]>0.f;
+                    }
+                    planes[i].distance = vectorSIMDf(plane[3]);
+                }
+            }
+
+            inline uint32_t operator()(const SColliderBVH::SBoxPacket& boxes) const
+            {
+                // same as SViewFrustum::intersectsAABB, the corner furthest along every normal has to be inside
+                uint32_t inside = 0xfu;
+                for (const auto& plane : planes)
+                {
+                    vectorSIMDf distance = plane.distance;
+                    for (uint32_t j=0u; j<3u; j++)
+                        distance += plane.normal[j]*(plane.positiveMax[j] ? boxes.maxEdge[j]:boxes.minEdge[j]);
+                    inside &= SColliderBVH::getLaneMask(distance>=vectorSIMDf(0.f));
+                }
+                return inside;
+            }
+
+            struct SPlane
+            {
+                vectorSIMDf normal[3];
+                vectorSIMDf distance;
+                //! whether the corner furthest along the normal has the max component
+                bool positiveMax[3];
+            } planes[scene::SViewFrustum::VF_PLANE_COUNT];
+        };
+
+        //! calls `callback(colliderIndex)` for the colliders whose world space bounds pass `test`, until it returns false
+        template<class TestF, class CallbackF>
+        inline void forEachOverlap(TestF&& test, CallbackF&& callback) const
+        {
+            // bounds get tested 4 at a time, a BVH leaf takes one packet
+            auto testColliders = [&](const uint32_t& first, const uint32_t& count, const uint32_t* indices) -> bool
+            {
+                for (uint32_t packetBegin=first; packetBegin<first+count; packetBegin+=SColliderBVH::Width)
+                {
+                    const uint32_t packetSize = core::min_(first+count-packetBegin,SColliderBVH::Width);
+                    SColliderBVH::SBoxPacket boxes;
+                    for (uint32_t lane=0u; lane<packetSize; lane++)
+                        boxes.setBox(lane,getBounds(indices ? indices[packetBegin+lane]:(packetBegin+lane)));
+
+                    const uint32_t passed = test(boxes);
+                    for (uint32_t lane=0u; lane<packetSize; lane++)
+                    {
+                        if ((passed&(0x1u<<lane)) && !callback(indices ? indices[packetBegin+lane]:(packetBegin+lane)))
+                            return false;
+                    }
+                }
+                return true;
+            };
+
+            if (bvhOutOfDate)
+                testColliders(0u,colliders.size(),NULL);
+            else
+                bvh.traverseOverlaps(test,[&](uint32_t first, uint32_t count) {return testColliders(first,count,bvh.getPrimitiveIndices());});
+        }
+
+        template<class TestF>
+        inline size_t collectOverlaps(TestF&& test, SCompoundCollider** overlaps, const size_t& capacity) const
+        {
+            size_t count = 0u;
+            forEachOverlap(test,[&](uint32_t i)
+                {
+                    if (count<capacity)
+                        overlaps[count] = colliders[i];
+                    count++;
+                    return true;
+                }
+            );
+            return count;
         }
 };
 
@@ -141,35 +141,58 @@ class SCompoundCollider : public IReferenceCounted
         {
             if (colliderData.attachedNode)
             {
-                matrix4x3 absoluteTransform = colliderData.attachedNode->getAbsoluteTransformation();
-                bool retval = absoluteTransform.makeInverse();
-                if (!retval)
+                matrix4x3 worldToLocal;
+                if (!getWorldToLocalTransform(worldToLocal))
                     return false;
+                transformRay(worldToLocal,origin,direction);
+            }
+            return CollideWithLocalRay(collisionDistance,origin,direction,dirMaxMultiplier);
+        }
 
-                absoluteTransform.transformVect(origin.pointer,origin.pointer);
-                origin.pointer[3] = 0.f;
-                absoluteTransform.mulSub3x3With3x1(direction.pointer,direction.pointer); /// Actually a 3x3 submatrix multiply
+		//! Gets the transformation from world space to the space of the shapes, the inverse of the attached node's (and instance's) transformation.
+		/**
+		@param[out] worldToLocal The transformation, identity if there is no attached node.
+		@returns Whether the transformation is invertible, rays can't hit the collider if it is not.
+		*/
+        inline bool getWorldToLocalTransform(matrix4x3& worldToLocal) const
+        {
+            worldToLocal = matrix4x3();
+            if (!colliderData.attachedNode)
+                return true;
 
-                switch (colliderData.attachedNode->getType())
-                {
-                    case scene::ESNT_MESH_INSTANCED:
-                        {
-                            core::matrix4x3 instanceTform = static_cast<scene::IMeshSceneNodeInstanced*>(colliderData.attachedNode)->getInstanceTransform(colliderData.instanceID);
-                            retval = instanceTform.makeInverse();
-                            if (!retval)
-                                return false;
-
-                            instanceTform.transformVect(origin.pointer,origin.pointer);
-                            origin.pointer[3] = 0.f;
-                            instanceTform.mulSub3x3With3x1(direction.pointer,direction.pointer);
-                        }
-                        break;
-                    ///case ESNT_INSTANCED_ANIMATED_MESH:
-                    default:
-                        break;
-                }
+            worldToLocal = colliderData.attachedNode->getAbsoluteTransformation();
+            if (!worldToLocal.makeInverse())
+                return false;
+
+            switch (colliderData.attachedNode->getType())
+            {
+                case scene::ESNT_MESH_INSTANCED:
+                    {
+                        core::matrix4x3 instanceTform = static_cast<scene::IMeshSceneNodeInstanced*>(colliderData.attachedNode)->getInstanceTransform(colliderData.instanceID);
+                        if (!instanceTform.makeInverse())
+                            return false;
+                        worldToLocal = concatenateBFollowedByA(instanceTform,worldToLocal);
+                    }
+                    break;
+                ///case ESNT_INSTANCED_ANIMATED_MESH:
+                default:
+                    break;
             }
+            return true;
+        }
 
+		//! Transforms a ray, from world space to the space of the shapes with the result of getWorldToLocalTransform() for instance.
+        static inline void transformRay(const matrix4x3& transform, vectorSIMDf& origin, vectorSIMDf& direction)
+        {
+            transform.transformVect(origin.pointer,origin.pointer);
+            origin.pointer[3] = 0.f;
+            transform.mulSub3x3With3x1(direction.pointer,direction.pointer); /// Actually a 3x3 submatrix multiply
+        }
+
+		//! Same as CollideWithRay(), but the ray is already in the space of the shapes.
+		/** Lets callers with many rays against the same collider compute getWorldToLocalTransform() once for all of them. */
+        inline bool CollideWithLocalRay(float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& dirMaxMultiplier) const
+        {
             vectorSIMDf direction_reciprocal = reciprocal(direction);
             float dummyPosition;
             if (!BBox.CollideWithRay(dummyPosition,origin,direction,dirMaxMultiplier,direction_reciprocal))
@@ -178,48 +201,73 @@ class SCompoundCollider : public IReferenceCounted
             }
 
 
+            // the closest shape, so the collision engine can rely on the distance
+            bool retval = false;
+            float closest = dirMaxMultiplier;
             for (size_t i=0; i<Shapes.size(); i++)
             {
+                bool hit = false;
+                float shapeDistance;
                 switch (Shapes[i].objectType)
                 {
                     case SCollisionShapeDef::ECST_AABOX:
                         {
                             SAABoxCollider* tmp = static_cast<SAABoxCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier,direction_reciprocal))
-                                return true;
+                            if (tmp->CollideWithRay(shapeDistance,origin,direction,closest,direction_reciprocal))
+                                hit = true;
                         }
                         break;
                     case SCollisionShapeDef::ECST_ELLIPSOID:
                         {
                             SEllipsoidCollider* tmp = static_cast<SEllipsoidCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
+                            if (tmp->CollideWithRay(shapeDistance,origin,direction,closest))
+                                hit = true;
                         }
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE:
                         {
                             STriangleCollider* tmp = static_cast<STriangleCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
+                            if (tmp->CollideWithRay(shapeDistance,origin,direction,closest))
+                                hit = true;
                         }
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE_MESH:
                         {
                             STriangleMeshCollider* tmp = static_cast<STriangleMeshCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
+                            if (tmp->CollideWithRay(shapeDistance,origin,direction,closest))
+                                hit = true;
                         }
                         break;
                     case SCollisionShapeDef::ECST_COUNT:
                         assert(0);
                         break;
                 }
+                if (hit&&shapeDistance<closest)
+                {
+                    closest = shapeDistance;
+                    retval = true;
+                }
             }
-            return false;
+            if (retval)
+                collisionDistance = closest;
+            return retval;
         }
 
 		inline size_t getShapeCount() const { return Shapes.size(); }
 		inline const SAABoxCollider& getBoundingBox() const { return BBox; }
+
+		//! @returns Bounding box of all shapes after the transformation of the attached node (and instance), what SCollisionEngine builds its BVH from.
+        inline aabbox3df getWorldBoundingBox() const
+        {
+            aabbox3df box = BBox.Box;
+            if (colliderData.attachedNode)
+            {
+                if (colliderData.attachedNode->getType()==scene::ESNT_MESH_INSTANCED)
+                    static_cast<scene::IMeshSceneNodeInstanced*>(colliderData.attachedNode)->getInstanceTransform(colliderData.instanceID).transformBoxEx(box);
+                colliderData.attachedNode->getAbsoluteTransformation().transformBoxEx(box);
+            }
+            return box;
+        }
         inline const SColliderData& getColliderData() const {return colliderData;}
 
 		//! Sets collider data.
@@ -2,6 +2,7 @@
 #define __S_TRIANGLE_MESH_COLLIDER_H_INCLUDED__
 
 #include "SAABoxCollider.h"
+#include "SColliderBVH.h"
 #include "irr/core/IReferenceCounted.h"
 
 namespace irr
@@ -16,39 +17,43 @@ class STriangleCollider// : public AllocationOverrideDefault EBO inheritance pro
         STriangleCollider(const vectorSIMDf& A, const vectorSIMDf& B, const vectorSIMDf& C, bool& validTriangle)
         {
             vectorSIMDf normal = planeEq = cross(B-A,C-A);
-            if ((normal==vectorSIMDf(0.f)).all())
+            const float normalLen2 = dot(normal,normal).X;
+            if (normalLen2==0.f)
             {
                 validTriangle = false;
                 return;
             }
-            boundaryPlanes[0] = cross(normal,B-A);
-            boundaryPlanes[1] = cross(C-A,normal);
+            // scaled so that a point's distance to them is its barycentric coordinate along C and B
+            boundaryPlanes[0] = cross(normal,B-A)/normalLen2;
+            boundaryPlanes[1] = cross(C-A,normal)/normalLen2;
 
-            planeEq.W = dot(planeEq,A).X;
-            boundaryPlanes[0].W = dot(boundaryPlanes[0],A).X;
-            boundaryPlanes[1].W = dot(boundaryPlanes[1],A).X;
+            planeEq.W = dot(normal,A).X;
+            boundaryPlanes[0].W = -dot(boundaryPlanes[0],A).X;
+            boundaryPlanes[1].W = -dot(boundaryPlanes[1],A).X;
             validTriangle = true;
         }
 
         inline bool CollideWithRay(float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& dirMaxMultiplier) const
         {
-            float NdotD = dot(direction,planeEq).X;
-            if (NdotD!=0.f)
+            vectorSIMDf normal = planeEq;
+            normal.W = 0.f;
+            float NdotD = dot(direction,normal).X;
+            if (NdotD==0.f)
                 return false;
 
-            float NdotOrigin = -dot(origin,planeEq).X;
+            float NdotOrigin = dot(origin,normal).X;
             float d = planeEq.W;
 
-            float t = (NdotOrigin-d)/NdotD;
+            float t = (d-NdotOrigin)/NdotD;
             if (t>=dirMaxMultiplier||t<0.f)
                 return false;
 
-            vectorSIMDf outPoint = origin+direction*t;
+            vectorSIMDf outPointW1 = origin+direction*t;
+            outPointW1.W = 1.f;
 
-            vectorSIMDf extraComponent(0.f,0.f,0.f,1.f);
-            vectorSIMDf outPointW1 = outPoint|reinterpret_cast<const vectorSIMDu32&>(extraComponent);
-
-            if (dot(outPointW1,boundaryPlanes[0]).X>=0.f&&dot(outPointW1,boundaryPlanes[1]).X>=0.f)
+            const float v = dot(outPointW1,boundaryPlanes[0]).X;
+            const float u = dot(outPointW1,boundaryPlanes[1]).X;
+            if (u>=0.f&&v>=0.f&&u+v<=1.f)
             {
                 collisionDistance = t;
                 return true;
@@ -69,8 +74,29 @@ class STriangleMeshCollider : public IReferenceCounted
         SAABoxCollider BBox;
         ///matrix4x3 cachedTransformInverse;
         ///matrix4x3 cachedTransform;
+        //! in the leaf order of the BVH
         vector<STriangleCollider> triangles;
+        vector<aabbox3df> triangleBounds;
+        SColliderBVH bvh;
+
+        //! Rebuilds the BVH and puts the triangles in its leaf order, so a leaf is a contiguous range of them
+        inline void buildBVH()
+        {
+            bvh.build(triangleBounds.data(),triangles.size(),MaxLeafTriangles);
+
+            vector<STriangleCollider> sortedTriangles(triangles.size());
+            vector<aabbox3df> sortedBounds(triangles.size());
+            for (size_t i=0; i<triangles.size(); i++)
+            {
+                sortedTriangles[i] = triangles[bvh.getPrimitiveIndex(i)];
+                sortedBounds[i] = triangleBounds[bvh.getPrimitiveIndex(i)];
+            }
+            triangles.swap(sortedTriangles);
+            triangleBounds.swap(sortedBounds);
+        }
     public:
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t MaxLeafTriangles = 4u;
+
         STriangleMeshCollider() : BBox(core::aabbox3df()) {}
 
 
@@ -78,9 +104,10 @@ class STriangleMeshCollider : public IReferenceCounted
 
         inline size_t getTriangleCount() const {return triangles.size();}
 
+        //! Adds triangles, given as a triangle list of 3 floats per vertex, and rebuilds the BVH over all of them
         inline bool Init(float* vertices, const size_t &indexCount, uint32_t* indices=NULL)
         {
-            bool firstPoint = true;
+            bool firstPoint = triangles.size()==0;
             if (indices)
             {
                 for (size_t i=0; i<indexCount; i+=3)
@@ -103,6 +130,10 @@ class STriangleMeshCollider : public IReferenceCounted
                         BBox.Box.addInternalPoint(B.getAsVector3df());
                         BBox.Box.addInternalPoint(C.getAsVector3df());
                         triangles.push_back(triangle);
+                        aabbox3df triangleBox(A.getAsVector3df());
+                        triangleBox.addInternalPoint(B.getAsVector3df());
+                        triangleBox.addInternalPoint(C.getAsVector3df());
+                        triangleBounds.push_back(triangleBox);
                     }
                 }
             }
@@ -128,10 +159,15 @@ class STriangleMeshCollider : public IReferenceCounted
                         BBox.Box.addInternalPoint(B.getAsVector3df());
                         BBox.Box.addInternalPoint(C.getAsVector3df());
                         triangles.push_back(triangle);
+                        aabbox3df triangleBox(A.getAsVector3df());
+                        triangleBox.addInternalPoint(B.getAsVector3df());
+                        triangleBox.addInternalPoint(C.getAsVector3df());
+                        triangleBounds.push_back(triangleBox);
                     }
                 }
             }
 
+            buildBVH();
             return triangles.size();
         }
 
@@ -146,13 +182,26 @@ class STriangleMeshCollider : public IReferenceCounted
             if (!BBox.CollideWithRay(dummyDist,origin,direction,dirMaxMultiplier,direction_reciprocal))
                 return false;
 
-            for (size_t i=0; i<triangles.size(); i++)
-            {
-                if (triangles[i].CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                    return true;
-            }
-
-            return false;
+            // closest triangle, not just any
+            float closest = dirMaxMultiplier;
+            bool retval = bvh.traverseRay(origin,direction,closest,[&](uint32_t first, uint32_t count, float& maxT)
+                {
+                    bool hit = false;
+                    for (uint32_t i=first; i<first+count; i++)
+                    {
+                        float dist;
+                        if (triangles[i].CollideWithRay(dist,origin,direction,maxT)&&dist<maxT)
+                        {
+                            maxT = dist;
+                            hit = true;
+                        }
+                    }
+                    return hit;
+                }
+            );
+            if (retval)
+                collisionDistance = closest;
+            return retval;
         }
 /**
         inline bool UpdateTransformation(const matrix4x3& newTransform)
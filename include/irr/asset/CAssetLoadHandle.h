@@ -0,0 +1,78 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_ASSET_LOAD_HANDLE_H_INCLUDED__
+#define __IRR_C_ASSET_LOAD_HANDLE_H_INCLUDED__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "irr/core/parallel/CTaskScheduler.h"
+#include "irr/asset/IAsset.h"
+
+namespace irr
+{
+namespace asset
+{
+
+class IAssetManager;
+
+//! Future-like handle to an asset load started with IAssetManager::getAssetAsync
+/** Every caller which requested the same (cacheable) path with the same parameters while the load was in flight gets the same handle. */
+class CAssetLoadHandle : public core::IReferenceCounted
+{
+    public:
+        CAssetLoadHandle(core::CTaskScheduler* _scheduler) : m_scheduler(_scheduler), m_ready(false) {}
+
+        //! Non-blocking, the load makes progress on the scheduler's workers even if nobody ever calls `wait()`
+        inline bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+
+        //! Blocks until the load finishes, the calling thread executes other pending tasks (such as this load's sub-assets) in the meantime
+        /** Sleeps once there is nothing left to help with. Must not be called from within the load itself.
+        @returns Empty bundle if the load failed. */
+        inline const SAssetBundle& wait() const
+        {
+            while (!isReady())
+            {
+                if (m_scheduler->tryExecuteOne())
+                    continue;
+
+                // the timeout makes us look for work again, in case a task submitted meanwhile is the one the load needs
+                std::unique_lock<std::mutex> lk(m_readyLock);
+                m_readyCondition.wait_for(lk,std::chrono::milliseconds(1),[this]() {return isReady();});
+            }
+            return m_bundle;
+        }
+
+        _IRR_INTERFACE_CHILD_DEFAULT(CAssetLoadHandle);
+
+    private:
+        friend class IAssetManager;
+
+        inline void publish(SAssetBundle&& _bundle)
+        {
+            {
+                std::unique_lock<std::mutex> lk(m_readyLock);
+                m_bundle = std::move(_bundle);
+                m_ready.store(true,std::memory_order_release);
+            }
+            m_readyCondition.notify_all();
+        }
+
+        core::CTaskScheduler* m_scheduler;
+        SAssetBundle m_bundle;
+        std::atomic<bool> m_ready;
+        mutable std::mutex m_readyLock;
+        mutable std::condition_variable m_readyCondition;
+        //! thread executing the load, default constructed until an async load gets picked up, guarded by IAssetManager's in-flight lock
+        std::thread::id m_owner;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_BLOCK_COMPRESSOR_H_INCLUDED__
+#define __C_BLOCK_COMPRESSOR_H_INCLUDED__
+
+#include "irr/core/core.h"
+#include "irr/asset/CImageData.h"
+#include "irr/asset/ICPUTexture.h"
+
+namespace irr { namespace asset
+{
+
+//! Encoder for the BCn block compressed formats
+/**
+Supports BC1 (with and without punch-through alpha), BC3, BC4, BC5 and BC7 in both UNORM and sRGB flavours where the format has one.
+Source images of any non-planar, non-block-compressed format are first converted to 8bit RGBA in the encoding of the destination
+(sRGB for the sRGB block formats, linear otherwise), the blocks are then encoded independently on the task scheduler.
+
+BC7 is encoded with mode 6 only (single subset, RGBA endpoints with per-endpoint p-bits, 4bit indices),
+which handles opaque and translucent content alike at a fraction of the cost of a full mode search.
+*/
+class CBlockCompressor
+{
+    public:
+        enum E_QUALITY
+        {
+            //! Bounding box endpoints, one pass of index selection
+            EQ_FAST = 0,
+            //! Principal axis endpoints with one least-squares refinement
+            EQ_NORMAL,
+            //! Several least-squares refinements followed by a local endpoint search
+            EQ_HIGH
+        };
+
+        //! Returns whether `_fmt` can be produced by `compress`
+        static bool isSupportedFormat(E_FORMAT _fmt);
+
+        //! Picks a quality level for a writer compression level in [0,1]
+        static inline E_QUALITY qualityFromCompressionLevel(float _level)
+        {
+            if (_level < 0.34f)
+                return EQ_FAST;
+            if (_level < 0.67f)
+                return EQ_NORMAL;
+            return EQ_HIGH;
+        }
+
+        //! Returns a new image holding `_image` encoded as `_dstFmt`, nullptr if either format is unsupported
+        static CImageData* compress(const CImageData* _image, E_FORMAT _dstFmt, E_QUALITY _quality=EQ_NORMAL, core::CTaskScheduler* _scheduler=core::CTaskScheduler::getDefault());
+
+        //! Compresses every range of `_texture`, the result keeps the name and type of the original
+        static ICPUTexture* compress(const ICPUTexture* _texture, E_FORMAT _dstFmt, E_QUALITY _quality=EQ_NORMAL, core::CTaskScheduler* _scheduler=core::CTaskScheduler::getDefault());
+
+        //! Single block entry points, `_texels` are 16 RGBA8 texels of a 4x4 block in row major order
+        static void compressBC1Block(const uint8_t* _texels, void* _out, E_QUALITY _quality, bool _punchThroughAlpha);
+        static void compressBC3Block(const uint8_t* _texels, void* _out, E_QUALITY _quality);
+        //! `_channel` picks the component of `_texels` to encode
+        static void compressBC4Block(const uint8_t* _texels, void* _out, E_QUALITY _quality, uint32_t _channel=0u);
+        static void compressBC5Block(const uint8_t* _texels, void* _out, E_QUALITY _quality);
+        static void compressBC7Block(const uint8_t* _texels, void* _out, E_QUALITY _quality);
+
+    private:
+        CBlockCompressor() = delete;
+};
+
+}}
+
+#endif
@@ -0,0 +1,152 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_BOUNDED_ASSET_CACHE_H_INCLUDED__
+#define __IRR_C_BOUNDED_ASSET_CACHE_H_INCLUDED__
+
+#include <functional>
+
+#include "irr/asset/IAsset.h"
+
+namespace irr
+{
+namespace asset
+{
+
+//! Path-based asset cache with a memory budget, alternative backend for IAssetManager::AssetCacheType (see the IRR_BOUNDED_ASSET_CACHE CMake option).
+/** Entries are indexed by a 64-bit hash of the path, paths are still compared on lookup so hash collisions only cost a string compare.
+Every entry remembers the sum of IAsset::conservativeSizeEstimate() of the bundle's contents at insertion time,
+once the sum over the whole cache exceeds the byte budget the least recently inserted or looked up entries are evicted according to E_EVICTION_POLICY.
+
+Same interface and greet/dispose semantics as the other concurrent caches, all methods are thread-safe.
+Lookups reorder the LRU list, so unlike CShardedConcurrentObjectCache they are serialized on a mutex.
+*/
+class CBoundedAssetCache
+{
+    public:
+        using KeyType = std::string;
+        using CachedType = SAssetBundle;
+        using PairType = std::pair<std::string,SAssetBundle>;
+        using MutablePairType = PairType;
+
+        using GreetFuncType = std::function<void(SAssetBundle&)>;
+        using DisposalFuncType = std::function<void(SAssetBundle&)>;
+        //! Has to call IAsset::convertToDummyObject() on every asset of the bundle
+        using DummyConversionFuncType = std::function<void(SAssetBundle&)>;
+
+        enum E_EVICTION_POLICY
+        {
+            //! Removes the entry, the memory gets released as soon as nobody else holds a reference to the assets
+            EEP_REMOVE,
+            //! Keeps the entry but converts its assets to dummies, only makes sense if you cache their GPU counterparts with IAssetManager::convertAssetToEmptyCacheHandle
+            EEP_CONVERT_TO_DUMMY
+        };
+
+        _IRR_STATIC_INLINE_CONSTEXPR size_t Unbounded = ~size_t(0u);
+
+        CBoundedAssetCache(GreetFuncType&& _greeting, DisposalFuncType&& _disposal, DummyConversionFuncType&& _dummyConversion=nullptr) :
+            m_greetingFunc(std::move(_greeting)), m_disposalFunc(std::move(_disposal)), m_dummyConversionFunc(std::move(_dummyConversion)),
+            m_byteBudget(Unbounded), m_policy(EEP_REMOVE), m_byteSize(0u)
+        {
+        }
+        // explicitely making concurrent caches non-copy-and-move-constructible and non-copy-and-move-assignable
+        CBoundedAssetCache(const CBoundedAssetCache&) = delete;
+        CBoundedAssetCache(CBoundedAssetCache&&) = delete;
+        CBoundedAssetCache& operator=(const CBoundedAssetCache&) = delete;
+        CBoundedAssetCache& operator=(CBoundedAssetCache&&) = delete;
+
+        ~CBoundedAssetCache()
+        {
+            clear();
+        }
+
+        //! Evicts right away if the cache is already over the new budget
+        void setByteBudget(size_t _bytes, E_EVICTION_POLICY _policy=EEP_REMOVE);
+        inline size_t getByteBudget() const
+        {
+            std::unique_lock<core::fast_mutex> lk(m_lock);
+            return m_byteBudget;
+        }
+        //! Sum of the size estimates of all non-dummy entries
+        inline size_t getByteSize() const
+        {
+            std::unique_lock<core::fast_mutex> lk(m_lock);
+            return m_byteSize;
+        }
+
+        //! Always succeeds since this is a multi-cache, may evict other entries (but never the one just inserted)
+        bool insert(const std::string& _key, const SAssetBundle& _val);
+
+        bool contains(const SAssetBundle& _object) const;
+
+        inline size_t getSize() const
+        {
+            std::unique_lock<core::fast_mutex> lk(m_lock);
+            return m_index.size();
+        }
+
+        void clear();
+
+        //! Returns true if had to insert
+        bool swapObjectValue(const std::string& _key, const SAssetBundle& _obj, const SAssetBundle& _val);
+
+        //! @returns true if object was removed (i.e. was present in cache)
+        bool removeObject(const SAssetBundle& _obj, const std::string& _key);
+
+        //! Semantics of CObjectCacheBase::outputRange, found entries count as used for the purpose of eviction
+        bool findAndStoreRange(const std::string& _key, size_t& _inOutStorageSize, MutablePairType* _out) const;
+        bool findAndStoreRange(const std::string& _key, size_t& _inOutStorageSize, SAssetBundle* _out) const;
+
+        //! Most recently used first, dummies last
+        bool outputAll(size_t& _inOutStorageSize, MutablePairType* _out) const;
+
+        //! Neither disposes nor greets the object
+        bool changeObjectKey(const SAssetBundle& _obj, const std::string& _key, const std::string& _newKey);
+
+        static uint64_t hashKey(const std::string& _key);
+
+    private:
+        struct SEntry
+        {
+            std::string key;
+            SAssetBundle bundle;
+            uint64_t keyHash;
+            size_t byteSize;
+            bool isDummy;
+        };
+        using entry_list_t = core::list<SEntry>;
+        using entry_iterator_t = entry_list_t::iterator;
+        using index_t = core::unordered_multimap<uint64_t,entry_iterator_t>;
+
+        static size_t estimateSize(const SAssetBundle& _bundle);
+
+        // all of the below must be called with the lock held
+        index_t::iterator find(const std::string& _key, const SAssetBundle& _obj);
+        SEntry& link(const std::string& _key, const SAssetBundle& _val);
+        void unlink(index_t::iterator _indexIt, bool _dispose);
+        void evictOverBudget(const SEntry* _keep);
+
+        template<typename StorageT>
+        bool findAndStoreRange_impl(const std::string& _key, size_t& _inOutStorageSize, StorageT* _out) const;
+
+        GreetFuncType m_greetingFunc;
+        DisposalFuncType m_disposalFunc;
+        DummyConversionFuncType m_dummyConversionFunc;
+
+        mutable core::fast_mutex m_lock;
+        //! front is the most recently used, only holds entries which are not dummies
+        mutable entry_list_t m_lru;
+        //! entries already converted to dummies, these are never evicted and don't count towards the budget
+        entry_list_t m_dummies;
+        index_t m_index;
+
+        size_t m_byteBudget;
+        E_EVICTION_POLICY m_policy;
+        size_t m_byteSize;
+};
+
+}
+}
+
+#endif
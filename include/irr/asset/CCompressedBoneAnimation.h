@@ -0,0 +1,126 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_COMPRESSED_BONE_ANIMATION_H_INCLUDED__
+#define __C_COMPRESSED_BONE_ANIMATION_H_INCLUDED__
+
+#include "irr/core/core.h"
+
+namespace irr { namespace asset
+{
+
+#include "irr/irrpack.h"
+//! Pose of one bone at one keyframe, this is what CFinalBoneHierarchy::AnimationKeyData refers to
+struct SBoneAnimationKey
+{
+    float Rotation[4];
+    float Position[3];
+    float Scale[3];
+    float Padding[2];
+} PACK_STRUCT;
+#include "irr/irrunpack.h"
+
+//! Lossy, error-bounded storage of the interpolated and non-interpolated animation tracks of a CFinalBoneHierarchy
+/**
+Every bone has a rotation, a position and a scale track for each of the two animation flavours, and every track is stored on its own:
+- a track which never strays from its first key by more than the tolerance is stored as that single key, in full precision
+- rotations are quantized to the three smallest components of the unit quaternion with 15 bits each (48 bits per key)
+- positions and scales are quantized to 16 bits per component within the range spanned by the track
+- keys which the neighbouring kept keys reproduce within the tolerance are dropped, with linear interpolation for the interpolated
+flavour and by holding the previous key for the non-interpolated one; the first and last key of a track are always kept
+- a non-interpolated track which is the same as the interpolated one only gets stored once
+
+The tolerances are checked against the dequantized kept keys, so they bound the combined error of quantization and key reduction
+(the only exception are positions and scales spanning a range so large that 16 bits cannot represent it within the tolerance).
+
+The whole object is a single block of memory which is also its serialized form, see `getSerializedData`.
+Key times are not stored, `sample` takes them from the owning hierarchy.
+*/
+class CCompressedBoneAnimation
+{
+    public:
+        struct SCompressionParams
+        {
+            SCompressionParams() : rotationTolerance(0.0005f), positionTolerance(0.0001f), scaleTolerance(0.0001f) {}
+
+            //! Largest angle (radians) a decoded bone rotation may differ from the original by
+            float rotationTolerance;
+            //! Largest distance a decoded bone position may differ from the original by
+            float positionTolerance;
+            //! Largest difference of any decoded scale component
+            float scaleTolerance;
+        };
+
+        //! Compresses the animations, both arrays are bone major with `_keyframeCount` keys for every bone
+        CCompressedBoneAnimation(size_t _boneCount, size_t _keyframeCount, const float* _keyframes,
+                                 const SBoneAnimationKey* _interpolated, const SBoneAnimationKey* _nonInterpolated,
+                                 const SCompressionParams& _params=SCompressionParams(), core::CTaskScheduler* _scheduler=core::CTaskScheduler::getDefault());
+        //! Copies an already compressed animation, `_data` is what `getSerializedData` returned, see `validate`
+        CCompressedBoneAnimation(const void* _data, size_t _size);
+
+        //! Returns whether `_size` bytes at `_data` hold a complete compressed animation
+        static bool validate(const void* _data, size_t _size, size_t _boneCount, size_t _keyframeCount);
+        //! Size in bytes of the compressed animation starting at `_data`, the header at its start has to be readable
+        static size_t getSerializedSize(const void* _data);
+
+        inline const void* getSerializedData() const { return Data.data(); }
+        inline size_t getSerializedSize() const { return Data.size(); }
+
+        inline size_t getBoneCount() const { return getHeader().boneCount; }
+        //! Number of quantized keys kept over all tracks
+        inline size_t getKeyCount() const { return getHeader().keyCount; }
+
+        //! Decodes the pose of bones [_boneBegin,_boneEnd) at `_frame`
+        /** `_keyframes` are the key times of the hierarchy and `_foundKeyIx` what CFinalBoneHierarchy::getLowerBoundBoneKeyframes returned for `_frame`.
+        Sampling the interpolated flavour interpolates between the two kept keys around `_frame`, the non-interpolated one returns the last kept key
+        at or before `_foundKeyIx`, the same key the uncompressed hierarchy would use up to the tolerance. */
+        void sample(SBoneAnimationKey* _out, size_t _boneBegin, size_t _boneEnd, const float* _keyframes, size_t _foundKeyIx, float _frame, bool _interpolate) const;
+
+    private:
+        enum E_CHANNEL
+        {
+            EC_ROTATION = 0,
+            EC_POSITION,
+            EC_SCALE,
+            EC_COUNT
+        };
+
+        #include "irr/irrpack.h"
+        struct SHeader
+        {
+            uint32_t boneCount;
+            uint32_t keyCount;
+        } PACK_STRUCT;
+        struct STrack
+        {
+            uint32_t firstKey;
+            //! 0 for a constant track, the value is then in `base`
+            uint32_t keyCount;
+            //! the constant value, or the minimum of the range of a quantized position or scale track
+            float base[4];
+            //! size of one quantization step of a position or scale track
+            float step[3];
+        } PACK_STRUCT;
+        #include "irr/irrunpack.h"
+        // Data layout: SHeader, STrack[2][boneCount][EC_COUNT], uint32_t keyframe index of every key, uint16_t[3] of every key plus one padding uint16_t
+
+        static inline size_t calcTracksOffset() { return sizeof(SHeader); }
+        static inline size_t calcKeyIndicesOffset(size_t _boneCount) { return calcTracksOffset()+sizeof(STrack)*2u*_boneCount*EC_COUNT; }
+        static inline size_t calcKeyDataOffset(size_t _boneCount, size_t _keyCount) { return calcKeyIndicesOffset(_boneCount)+sizeof(uint32_t)*_keyCount; }
+        static inline size_t calcSize(size_t _boneCount, size_t _keyCount) { return calcKeyDataOffset(_boneCount,_keyCount)+sizeof(uint16_t)*(_keyCount*3u+1u); }
+
+        inline const SHeader& getHeader() const { return *reinterpret_cast<const SHeader*>(Data.data()); }
+        inline const STrack* getTracks(bool _interpolated) const
+        {
+            return reinterpret_cast<const STrack*>(Data.data()+calcTracksOffset())+(_interpolated ? 0u:getHeader().boneCount*EC_COUNT);
+        }
+        inline const uint32_t* getKeyIndices() const { return reinterpret_cast<const uint32_t*>(Data.data()+calcKeyIndicesOffset(getHeader().boneCount)); }
+        inline const uint16_t* getKeyData() const { return reinterpret_cast<const uint16_t*>(Data.data()+calcKeyDataOffset(getHeader().boneCount,getHeader().keyCount)); }
+
+        core::vector<uint8_t> Data;
+};
+
+}}
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_MIP_MAP_GENERATOR_H_INCLUDED__
+#define __C_MIP_MAP_GENERATOR_H_INCLUDED__
+
+#include "irr/core/core.h"
+#include "irr/asset/CImageData.h"
+#include "irr/asset/ICPUTexture.h"
+
+namespace irr { namespace asset
+{
+
+//! Builds mip chains of CPU side images
+/**
+Every level is resampled from the one above it with a separable kernel. The source is decoded to 32bit float RGBA once,
+sRGB formats are decoded to linear values and re-encoded per level so averaging happens in linear space,
+normalized formats are clamped after filtering so the ringing of the windowed sinc kernels does not carry over to further levels.
+Each level is split into tiles of destination texels which get filtered and encoded on the task scheduler independently.
+
+Block compressed, planar and integer formats cannot be filtered.
+*/
+class CMipMapGenerator
+{
+    public:
+        enum E_KERNEL
+        {
+            //! Area average, the classic 2x2 box for even sizes
+            EK_BOX = 0,
+            //! Sinc windowed by a Kaiser window (radius 3, alpha 4), sharp with little ringing
+            EK_KAISER,
+            //! Sinc windowed by a sinc of three lobes, the sharpest and most ringing of the three
+            EK_LANCZOS3
+        };
+
+        //! Returns whether images in `_fmt` can be filtered
+        static bool isSupportedFormat(E_FORMAT _fmt);
+
+        //! Generates the levels following `_base`, from its supposed mip level + 1 down to 1x1
+        /** The returned levels have the format and unpack alignment of `_base`, their offsets are the ones of `_base` shifted down,
+        every one of them needs to be dropped by the caller. The vector is empty if the format is not supported.
+        @param _volume Whether the depth is halved as well (3D textures), otherwise the slices are treated as array layers.
+        @param _maxLevelCount Upper bound on the amount of generated levels, 0 means no bound. */
+        static core::vector<CImageData*> generateMipChain(const CImageData* _base, E_KERNEL _kernel=EK_KAISER, bool _volume=false, uint32_t _maxLevelCount=0u, core::CTaskScheduler* _scheduler=core::CTaskScheduler::getDefault());
+
+        //! Returns a new texture made of the base level of `_texture` and a full chain generated from it
+        /** The base level needs to be a single range, nullptr is returned otherwise, for textures without any ranges or if the format is not supported. */
+        static ICPUTexture* createMipMappedTexture(const ICPUTexture* _texture, E_KERNEL _kernel=EK_KAISER, core::CTaskScheduler* _scheduler=core::CTaskScheduler::getDefault());
+
+    private:
+        CMipMapGenerator() = delete;
+};
+
+}}
+
+#endif
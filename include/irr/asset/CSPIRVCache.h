@@ -0,0 +1,107 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_SPIRV_CACHE_H_INCLUDED__
+#define __IRR_C_SPIRV_CACHE_H_INCLUDED__
+
+#include <string>
+
+#include "irr/core/IReferenceCounted.h"
+#include "irr/core/Types.h"
+
+namespace irr
+{
+namespace asset
+{
+
+//! Content-addressed cache of compiled SPIR-V, see IGLSLCompiler::setCache
+/** Keys are 256-bit hashes of everything the compilation result depends on, IGLSLCompiler::computeCacheKey makes them.
+Recently used results are kept in memory up to a byte budget, least recently inserted or looked up ones get evicted first.
+If a directory is given, every result also gets written to a file named after its key, and memory misses fall back to reading those,
+so the cache survives restarts. Files are written to a temporary name first and then renamed, many threads and processes can share a directory,
+files which fail to read or don't match their checksum count as misses. The directory has to exist, nothing ever deletes its files.
+
+All methods are thread-safe.
+*/
+class CSPIRVCache : public core::IReferenceCounted
+{
+    public:
+        struct SKey
+        {
+            uint64_t hash[4];
+
+            inline bool operator==(const SKey& _other) const {return memcmp(hash,_other.hash,sizeof(hash))==0;}
+        };
+
+        //! Bumped whenever the meaning of keys or the file layout changes, so stale files are never read back
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t FormatVersion = 1u;
+        _IRR_STATIC_INLINE_CONSTEXPR size_t DefaultByteBudget = 64ull<<20ull;
+
+        //! An empty `_directory` keeps everything in memory only
+        CSPIRVCache(const std::string& _directory = "", size_t _byteBudget = DefaultByteBudget);
+
+        //! Looks in memory, then on disk (and brings what it finds there into memory)
+        /** @returns false on a miss, `_outSPIRV` is left alone then. */
+        bool find(const SKey& _key, core::vector<uint32_t>& _outSPIRV) const;
+
+        //! Replaces a result with the same key, also in the directory
+        void insert(const SKey& _key, const uint32_t* _spirv, size_t _wordCount);
+
+        //! Evicts right away if the memory part is already over the new budget
+        void setByteBudget(size_t _bytes);
+        inline size_t getByteBudget() const
+        {
+            std::unique_lock<core::fast_mutex> lk(m_lock);
+            return m_byteBudget;
+        }
+        inline size_t getByteSize() const
+        {
+            std::unique_lock<core::fast_mutex> lk(m_lock);
+            return m_byteSize;
+        }
+
+        inline const std::string& getDirectory() const {return m_directory;}
+
+        //! Only forgets the results in memory
+        void clearMemory();
+
+    protected:
+        virtual ~CSPIRVCache() = default;
+
+    private:
+        struct SKeyHash
+        {
+            inline size_t operator()(const SKey& _key) const {return _key.hash[0];}
+        };
+        struct SEntry
+        {
+            SKey key;
+            core::vector<uint32_t> spirv;
+        };
+        using entry_list_t = core::list<SEntry>;
+
+        std::string getFilePath(const SKey& _key) const;
+        bool readFile(const SKey& _key, core::vector<uint32_t>& _outSPIRV) const;
+        void writeFile(const SKey& _key, const uint32_t* _spirv, size_t _wordCount) const;
+
+        // must be called with the lock held
+        void link(const SKey& _key, core::vector<uint32_t>&& _spirv) const;
+        void evictOverBudget() const;
+
+        const std::string m_directory;
+        //! makes temporary file names unique across processes sharing the directory
+        const uint64_t m_tmpFilePrefix;
+
+        mutable core::fast_mutex m_lock;
+        //! front is the most recently used
+        mutable entry_list_t m_lru;
+        mutable core::unordered_map<SKey,entry_list_t::iterator,SKeyHash> m_index;
+        mutable size_t m_byteSize;
+        size_t m_byteBudget;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,85 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_SPIRV_OPTIMIZER_H_INCLUDED__
+#define __IRR_C_SPIRV_OPTIMIZER_H_INCLUDED__
+
+#include "irr/core/IReferenceCounted.h"
+#include "irr/asset/ShaderCommons.h"
+
+namespace irr { namespace asset
+{
+class ICPUShader;
+class ICPUSpecializedShader;
+
+//! Runs the SPIRV-Tools optimizer over shaders, optional step between IGLSLCompiler and the driver or an asset writer
+/** Every result is validated, on any failure the errors get logged and nullptr is returned, so callers can fall back to the input.
+Inputs are never modified, results are new shaders with their own bytecode.
+
+All methods are const and thread-safe, every call sets up its own optimizer for the target environment given at construction.
+Without _IRR_COMPILE_WITH_SPIRV_TOOLS_ (the IRR_COMPILE_WITH_SPIRV_TOOLS CMake option) every call fails.
+*/
+class CSPIRVOptimizer : public core::IReferenceCounted
+{
+public:
+    //! SPIR-V environment whose rules the optimizer's passes and the validator follow
+    enum E_TARGET_ENV : uint32_t
+    {
+        //! SPIR-V 1.0 without any client API's rules
+        ETE_UNIVERSAL_1_0,
+        ETE_UNIVERSAL_1_1,
+        ETE_UNIVERSAL_1_2,
+        //! SPIR-V 1.3 without any client API's rules, accepts every module IGLSLCompiler emits
+        ETE_UNIVERSAL_1_3,
+        //! What GL_ARB_gl_spirv drivers consume
+        ETE_OPENGL_4_5,
+        ETE_VULKAN_1_0,
+        ETE_VULKAN_1_1
+    };
+
+    enum E_PRESET : uint32_t
+    {
+        //! Only what the other options ask for
+        EP_NONE,
+        //! SPIRV-Tools' performance passes, what `spirv-opt -O` does
+        EP_PERFORMANCE,
+        //! SPIRV-Tools' size passes, what `spirv-opt -Os` does
+        EP_SIZE
+    };
+
+    struct SOptions
+    {
+        E_PRESET preset = EP_PERFORMANCE;
+        //! Removes OpName, OpLine, OpSource and similar
+        /** Introspection and SPIRV-Cross then only see generated names, so only strip shaders which don't get looked up by name. */
+        bool stripDebugInfo = false;
+        //! Renumbers ids so there are no gaps, makes the module smaller
+        bool compactIds = true;
+    };
+
+    explicit CSPIRVOptimizer(E_TARGET_ENV _targetEnv = ETE_UNIVERSAL_1_3) : m_targetEnv(_targetEnv) {}
+
+    E_TARGET_ENV getTargetEnv() const { return m_targetEnv; }
+
+    //! Whole module optimization, specialization constants stay specializable
+    ICPUShader* optimize(const ICPUShader* _shader, const SOptions& _options) const;
+
+    //! Bakes the values `_specialized` gives its specialization constants into the module, then optimizes
+    /** Constants without a value in the specialization info get frozen with their default.
+    Branches and functions which the frozen constants make unreachable are always removed, even with EP_NONE.
+    The result has no specialization constants left, so it can be paired with any ISpecializationInfo with the same entry point and stage. */
+    ICPUShader* specializeAndOptimize(const ICPUSpecializedShader* _specialized, const SOptions& _options) const;
+
+    //! @returns whether the SPIRV-Tools validator accepts `_shader`, the reasons why not get logged
+    bool validate(const ICPUShader* _shader) const;
+
+protected:
+    virtual ~CSPIRVOptimizer() = default;
+
+    const E_TARGET_ENV m_targetEnv;
+};
+
+}}
+
+#endif//__IRR_C_SPIRV_OPTIMIZER_H_INCLUDED__
@@ -7,6 +7,8 @@
 namespace irr { namespace asset
 {
 
+class CAssetLoadHandle;
+
 class IAssetLoader : public virtual core::IReferenceCounted
 {
 public:
@@ -163,6 +165,8 @@ protected:
     SAssetBundle interm_getAssetInHierarchy(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
     SAssetBundle interm_getAssetInHierarchy(IAssetManager* _mgr, io::IReadFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
     SAssetBundle interm_getAssetInHierarchy(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
+    //! Lets a loader kick off all of its sub-asset loads up front and have them run concurrently, call CAssetLoadHandle::wait() when the result is needed
+    core::smart_refctd_ptr<CAssetLoadHandle> interm_getAssetInHierarchyAsync(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
 };
 
 }}
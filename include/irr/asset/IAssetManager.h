@@ -8,8 +8,10 @@
 #include <array>
 #include <ostream>
 
+#include "IrrCompileConfig.h"
 #include "irr/core/Types.h"
 #include "CConcurrentObjectCache.h"
+#include "CShardedConcurrentObjectCache.h"
 
 #include "IFileSystem.h"
 #include "IReadFile.h"
@@ -19,7 +21,13 @@
 #include "irr/asset/IMeshManipulator.h"
 #include "irr/asset/IAssetLoader.h"
 #include "irr/asset/IAssetWriter.h"
+#include "irr/asset/CAssetLoadHandle.h"
+#include "irr/asset/CBoundedAssetCache.h"
 
+#ifdef _IRR_BOUNDED_ASSET_CACHE_ // IRR_BOUNDED_ASSET_CACHE CMake option
+#define USE_BOUNDED_PATH_BASED_CACHE //memory-bounded with LRU eviction for long running processes, see IAssetManager::setAssetCacheByteBudget
+#endif
+#define USE_SHARDED_PATH_BASED_CACHE //lookups by many loader threads vastly outnumber insertions, see examples_tests/35.ConcurrentCacheContention
 #define USE_MAPS_FOR_PATH_BASED_CACHE //benchmark and choose, paths can be full system paths
 
 namespace irr
@@ -30,19 +38,25 @@ namespace asset
 
     std::function<void(SAssetBundle&)> makeAssetGreetFunc(const IAssetManager* const _mgr);
     std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* const _mgr);
+    std::function<void(SAssetBundle&)> makeAssetDummyConversionFunc(const IAssetManager* const _mgr);
 
 	class IAssetManager : public core::IReferenceCounted
 	{
         // the point of those functions is that lambdas returned by them "inherits" friendship
         friend std::function<void(SAssetBundle&)> makeAssetGreetFunc(const IAssetManager* const _mgr);
         friend std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* const _mgr);
+        friend std::function<void(SAssetBundle&)> makeAssetDummyConversionFunc(const IAssetManager* const _mgr);
 
     public:
-#ifdef USE_MAPS_FOR_PATH_BASED_CACHE
+#if defined(USE_BOUNDED_PATH_BASED_CACHE)
+        using AssetCacheType = CBoundedAssetCache;
+#elif defined(USE_SHARDED_PATH_BASED_CACHE)
+        using AssetCacheType = core::CShardedConcurrentMultiObjectCache<std::string, SAssetBundle>;
+#elif defined(USE_MAPS_FOR_PATH_BASED_CACHE)
         using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, SAssetBundle, std::multimap>;
 #else
         using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, IAssetBundle, std::vector>;
-#endif //USE_MAPS_FOR_PATH_BASED_CACHE
+#endif
 
         using CpuGpuCacheType = core::CConcurrentObjectCache<const IAsset*, core::smart_refctd_ptr<core::IReferenceCounted> >;
 
@@ -108,16 +122,29 @@ namespace asset
         // called as a part of constructor only
         void initializeMeshTools();
 
+        core::CTaskScheduler* m_scheduler;
+        //! Loads which are currently executing, keyed by the filename after IAssetLoaderOverride::getLoadFilename and everything else that can change the result
+        /** Any cacheable request for a path which is already being loaded with the same parameters waits on the existing handle instead of loading the file again. */
+        core::unordered_map<std::string, core::smart_refctd_ptr<CAssetLoadHandle> > m_inFlight;
+        //! The in-flight load each thread is currently blocked on, to detect waits which could never return
+        core::unordered_map<std::thread::id, const CAssetLoadHandle*> m_awaitedLoads;
+        std::mutex m_inFlightLock;
+
     public:
         //! Constructor
         explicit IAssetManager(core::smart_refctd_ptr<io::IFileSystem>&& _fs) :
             m_fileSystem(std::move(_fs)),
-            m_defaultLoaderOverride{nullptr}
+            m_defaultLoaderOverride{nullptr},
+            m_scheduler(core::CTaskScheduler::getDefault())
         {
             initializeMeshTools();
 
             for (size_t i = 0u; i < m_assetCache.size(); ++i)
+#ifdef USE_BOUNDED_PATH_BASED_CACHE
+                m_assetCache[i] = new AssetCacheType(asset::makeAssetGreetFunc(this), asset::makeAssetDisposeFunc(this), asset::makeAssetDummyConversionFunc(this));
+#else
                 m_assetCache[i] = new AssetCacheType(asset::makeAssetGreetFunc(this), asset::makeAssetDisposeFunc(this));
+#endif
             for (size_t i = 0u; i < m_cpuGpuCache.size(); ++i)
                 m_cpuGpuCache[i] = new CpuGpuCacheType();
             m_defaultLoaderOverride = IAssetLoader::IAssetLoaderOverride{this};
@@ -215,15 +242,67 @@ namespace asset
 
             std::string filename = _filename;
             _override->getLoadFilename(filename, ctx, _hierarchyLevel);
-            io::IReadFile* file = m_fileSystem->createAndOpenFile(filename.c_str());
 
-            SAssetBundle asset = getAssetInHierarchy(file, _filename, _params, _hierarchyLevel, _override);
+            if (!isLoadDeduplicable(_params, _hierarchyLevel))
+                return loadAssetFromPath(filename, _filename, _params, _hierarchyLevel, _override);
 
-            if (file)
-                file->drop();
+            const std::string key = makeInFlightKey(filename, _params, _hierarchyLevel, _override);
+            E_IN_FLIGHT_ROLE role;
+            const CAssetLoadHandle* previouslyAwaited = nullptr;
+            auto handle = acquireInFlightLoad(key, role, &previouslyAwaited);
+            if (role==EIFR_REENTRANT)
+                return loadAssetFromPath(filename, _filename, _params, _hierarchyLevel, _override);
+            if (role==EIFR_WAITER)
+            {
+                SAssetBundle asset = handle->wait();
+                stopWaitingOnInFlightLoad(previouslyAwaited);
+                return asset;
+            }
 
+            SAssetBundle asset = loadAssetFromPath(filename, _filename, _params, _hierarchyLevel, _override);
+            finishInFlightLoad(key, handle.get(), SAssetBundle(asset));
             return asset;
         }
+        //! Asynchronous counterpart of the string-based getAssetInHierarchy, `_params.decryptionKey` and `_override` must outlive the load
+        core::smart_refctd_ptr<CAssetLoadHandle> getAssetInHierarchyAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            IAssetLoader::SAssetLoadContext ctx{_params, nullptr};
+
+            std::string filename = _filename;
+            _override->getLoadFilename(filename, ctx, _hierarchyLevel);
+
+            core::smart_refctd_ptr<CAssetLoadHandle> handle;
+            const bool deduplicate = isLoadDeduplicable(_params, _hierarchyLevel);
+            std::string key;
+            if (deduplicate)
+            {
+                key = makeInFlightKey(filename, _params, _hierarchyLevel, _override);
+                E_IN_FLIGHT_ROLE role;
+                handle = acquireInFlightLoad(key, role, nullptr);
+                if (role!=EIFR_OWNER)
+                    return handle;
+            }
+            else
+                handle = core::make_smart_refctd_ptr<CAssetLoadHandle>(m_scheduler);
+
+            core::smart_refctd_ptr<IAssetManager> self(this);
+            m_scheduler->run([self,handle,filename,_filename,_params,_hierarchyLevel,_override,deduplicate,key]() mutable
+                {
+                    if (deduplicate)
+                        self->startInFlightLoad(handle.get());
+                    SAssetBundle asset = self->loadAssetFromPath(filename, _filename, _params, _hierarchyLevel, _override);
+                    if (deduplicate)
+                        self->finishInFlightLoad(key, handle.get(), std::move(asset));
+                    else
+                        handle->publish(std::move(asset));
+                }
+            );
+            return handle;
+        }
+        core::smart_refctd_ptr<CAssetLoadHandle> getAssetInHierarchyAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel)
+        {
+            return getAssetInHierarchyAsync(_filename, _params, _hierarchyLevel, &m_defaultLoaderOverride);
+        }
 
         //TODO change name
         SAssetBundle getAssetInHierarchy(io::IReadFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel)
@@ -263,6 +342,21 @@ namespace asset
             return getAsset(_file, _supposedFilename, _params, &m_defaultLoaderOverride);
         }
 
+        //! Starts loading on the task scheduler and returns immediately, see CAssetLoadHandle
+        /** Concurrent requests for the same path with the same parameters and override share a single load, unless ECF_DUPLICATE_TOP_LEVEL is set.
+        `_params.decryptionKey` and `_override` must stay valid until the handle is ready. */
+        core::smart_refctd_ptr<CAssetLoadHandle> getAssetAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            return getAssetInHierarchyAsync(_filename, _params, 0u, _override);
+        }
+        core::smart_refctd_ptr<CAssetLoadHandle> getAssetAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params)
+        {
+            return getAssetAsync(_filename, _params, &m_defaultLoaderOverride);
+        }
+
+        //! Scheduler used for asynchronous loads
+        inline core::CTaskScheduler* getTaskScheduler() const { return m_scheduler; }
+
         //TODO change name
         inline bool findAssets(size_t& _inOutStorageSize, SAssetBundle* _out, const std::string& _key, const IAsset::E_TYPE* _types = nullptr) const
         {
@@ -359,6 +453,27 @@ namespace asset
                     m_assetCache[i]->clear();
         }
 
+#ifdef USE_BOUNDED_PATH_BASED_CACHE
+        //! Caps the memory held by the specified caches (all by default), every asset type gets a budget of `_bytes` of its own
+        /** Sizes are IAsset::conservativeSizeEstimate() at the time of insertion, least recently used assets get evicted first. */
+        void setAssetCacheByteBudget(size_t _bytes, AssetCacheType::E_EVICTION_POLICY _policy = AssetCacheType::EEP_REMOVE, const uint64_t& _assetTypeBitFlags = 0xffffffffffffffffull)
+        {
+            for (size_t i = 0u; i < IAsset::ET_STANDARD_TYPES_COUNT; ++i)
+                if ((_assetTypeBitFlags>>i) & 1ull)
+                    m_assetCache[i]->setByteBudget(_bytes, _policy);
+        }
+
+        //! Sum of the size estimates of the non-dummy assets in the specified caches
+        size_t getAssetCacheByteSize(const uint64_t& _assetTypeBitFlags = 0xffffffffffffffffull) const
+        {
+            size_t retval = 0u;
+            for (size_t i = 0u; i < IAsset::ET_STANDARD_TYPES_COUNT; ++i)
+                if ((_assetTypeBitFlags>>i) & 1ull)
+                    retval += m_assetCache[i]->getByteSize();
+            return retval;
+        }
+#endif
+
         //! This function frees most of the memory consumed by IAssets, but not destroying them.
         /** Keeping assets around (by their pointers) helps a lot by letting the loaders retrieve them from the cache and not load cpu objects which have been loaded, converted to gpu resources and then would have been disposed of. However each dummy object needs to have a GPU object associated with it in yet-another-cache for use when we convert CPU objects to GPU objects.*/
         void convertAssetToEmptyCacheHandle(IAsset* _asset, core::smart_refctd_ptr<core::IReferenceCounted>&& _gpuObject)
@@ -536,9 +651,131 @@ namespace asset
                 .c_str();
         }
 
+        static inline bool isLoadDeduplicable(const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel)
+        {
+            const uint64_t levelFlags = _params.cacheFlags >> ((uint64_t)_hierarchyLevel * 2ull);
+            return (levelFlags & IAssetLoader::ECF_DUPLICATE_TOP_LEVEL) != IAssetLoader::ECF_DUPLICATE_TOP_LEVEL;
+        }
+
+        //! `_filename` has already been through IAssetLoaderOverride::getLoadFilename
+        SAssetBundle loadAssetFromPath(const std::string& _filename, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            io::IReadFile* file = m_fileSystem->createAndOpenFile(_filename.c_str());
+
+            SAssetBundle asset = getAssetInHierarchy(file, _supposedFilename, _params, _hierarchyLevel, _override);
+
+            if (file)
+                file->drop();
+
+            return asset;
+        }
+
+        //! Two loads can only share a result if they agree on the file, the caching flags, the decryption key, the hierarchy level and the override
+        static inline std::string makeInFlightKey(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, const IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            std::string key = _filename;
+            key.push_back('\0');
+            const uint64_t cacheFlags = _params.cacheFlags;
+            key.append(reinterpret_cast<const char*>(&cacheFlags), sizeof(cacheFlags));
+            key.append(reinterpret_cast<const char*>(&_hierarchyLevel), sizeof(_hierarchyLevel));
+            key.append(reinterpret_cast<const char*>(&_override), sizeof(_override));
+            if (_params.decryptionKey)
+                key.append(reinterpret_cast<const char*>(_params.decryptionKey), _params.decryptionKeyLen);
+            return key;
+        }
+
+        enum E_IN_FLIGHT_ROLE
+        {
+            //! registered a new load, the caller has to perform it and call finishInFlightLoad
+            EIFR_OWNER,
+            //! the load is already in flight, wait on the returned handle
+            EIFR_WAITER,
+            //! the load in flight can only finish after the calling thread returns, it has to load the asset itself without deduplication
+            EIFR_REENTRANT
+        };
+        //! Returns the handle of the load in flight for `_key`, or registers a new one owned by the calling thread
+        /** A thread waiting on a load executes other tasks meanwhile, one of which may request a load the same thread is
+        executing further down its stack, or one that (transitively through other waiting threads) waits on such a load.
+        Waiting on it would never return, so these requests come back as EIFR_REENTRANT.
+        @param _outPreviouslyAwaited If not null, a waiter gets registered as blocked on the handle for the cycle detection,
+        whatever the thread awaited before gets written here and has to be passed to stopWaitingOnInFlightLoad after the wait.
+        Null for callers which do not wait (async), owned loads then get their owner set by startInFlightLoad. */
+        core::smart_refctd_ptr<CAssetLoadHandle> acquireInFlightLoad(const std::string& _key, E_IN_FLIGHT_ROLE& _outRole, const CAssetLoadHandle** _outPreviouslyAwaited)
+        {
+            const std::thread::id thisThread = std::this_thread::get_id();
+            std::unique_lock<std::mutex> lk(m_inFlightLock);
+            auto found = m_inFlight.find(_key);
+            if (found==m_inFlight.end())
+            {
+                auto handle = core::make_smart_refctd_ptr<CAssetLoadHandle>(m_scheduler);
+                if (_outPreviouslyAwaited)
+                    handle->m_owner = thisThread;
+                m_inFlight.insert({_key,handle});
+                _outRole = EIFR_OWNER;
+                return handle;
+            }
+
+            _outRole = EIFR_WAITER;
+            if (!_outPreviouslyAwaited)
+                return found->second;
+
+            // follow who the owner is waiting for, the walk is bounded in case other threads are deadlocked among themselves
+            const CAssetLoadHandle* blocking = found->second.get();
+            for (size_t i=0u; blocking && i<=m_awaitedLoads.size(); i++)
+            {
+                if (blocking->m_owner==thisThread)
+                {
+                    _outRole = EIFR_REENTRANT;
+                    return nullptr;
+                }
+                auto awaited = m_awaitedLoads.find(blocking->m_owner);
+                blocking = awaited!=m_awaitedLoads.end() ? awaited->second:nullptr;
+            }
+
+            // registered in the same critical section as the check, so two threads cannot both decide to wait on each other
+            auto& awaited = m_awaitedLoads[thisThread];
+            *_outPreviouslyAwaited = awaited;
+            awaited = found->second.get();
+            return found->second;
+        }
+
+        //! Restores what the calling thread waited on before the wait that just finished (nested waits happen while helping with tasks)
+        void stopWaitingOnInFlightLoad(const CAssetLoadHandle* _previouslyAwaited)
+        {
+            std::unique_lock<std::mutex> lk(m_inFlightLock);
+            if (_previouslyAwaited)
+                m_awaitedLoads[std::this_thread::get_id()] = _previouslyAwaited;
+            else
+                m_awaitedLoads.erase(std::this_thread::get_id());
+        }
+
+        //! Called by the task performing an async load once it starts executing
+        void startInFlightLoad(CAssetLoadHandle* _handle)
+        {
+            std::unique_lock<std::mutex> lk(m_inFlightLock);
+            _handle->m_owner = std::this_thread::get_id();
+        }
+
+        //! The asset is already in the cache by now (if it was supposed to be cached), so later requests will find it there
+        void finishInFlightLoad(const std::string& _key, CAssetLoadHandle* _handle, SAssetBundle&& _asset)
+        {
+            {
+                std::unique_lock<std::mutex> lk(m_inFlightLock);
+                m_inFlight.erase(_key);
+            }
+            _handle->publish(std::move(_asset));
+        }
+
         // for greet/dispose lambdas for asset caches so we don't have to make another friend decl.
         //TODO change name
         inline void setAssetCached(SAssetBundle& _asset, bool _val) const { _asset.setCached(_val); }
+        inline void convertAssetToDummy(SAssetBundle& _asset) const
+        {
+            auto contents = _asset.getContents();
+            for (auto it = contents.first; it != contents.second; ++it)
+            if (*it)
+                it->get()->convertToDummyObject();
+        }
 
 		//
 		void addLoadersAndWriters();
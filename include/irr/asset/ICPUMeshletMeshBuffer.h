@@ -0,0 +1,79 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_I_CPU_MESHLET_MESH_BUFFER_H_INCLUDED__
+#define __IRR_I_CPU_MESHLET_MESH_BUFFER_H_INCLUDED__
+
+#include "irr/asset/ICPUMeshBuffer.h"
+#include "irr/asset/bawformat/blobs/MeshletMeshBufferBlob.h"
+
+namespace irr
+{
+namespace asset
+{
+
+//! A static triangle list meshbuffer whose index buffer is split into small clusters of bounded vertex and triangle counts
+/**
+The triangles of every meshlet are contiguous in the index buffer, so the whole meshbuffer still draws as usual,
+while a culling pass can test each meshlet's bounding sphere and normal cone and only draw the index ranges which survive.
+@see IMeshManipulator::createMeshletizedMeshBuffer()
+*/
+class ICPUMeshletMeshBuffer final : public ICPUMeshBuffer
+{
+    public:
+        //! Layout is part of the BAW format, do not reorder
+        struct SMeshlet
+        {
+            //! First index of the meshlet, relative to the meshbuffer's index buffer offset
+            uint32_t indexOffset;
+            uint32_t triangleCount;
+            //! Number of distinct vertices referenced by the meshlet's triangles
+            uint32_t vertexCount;
+
+            float center[3];
+            float radius;
+
+            //! All triangles face away from any camera for which `dot(normalize(coneApex-camera),coneAxis) >= coneCutoff`
+            float coneApex[3];
+            float coneAxis[3];
+            //! Cosine of the half angle of the cone of view directions, 1 when the normals spread too wide for the meshlet to ever be backface culled
+            float coneCutoff;
+
+            //! Whether every triangle of the meshlet faces away from `_cameraPos`, the camera has to be in the meshbuffer's space
+            inline bool isBackfacing(const core::vectorSIMDf& _cameraPos) const
+            {
+                const core::vectorSIMDf toApex = core::vectorSIMDf(coneApex[0], coneApex[1], coneApex[2])-core::vectorSIMDf(_cameraPos.x, _cameraPos.y, _cameraPos.z);
+                const float len = core::length(toApex).x;
+                return core::dot(toApex, core::vectorSIMDf(coneAxis[0], coneAxis[1], coneAxis[2])).x >= coneCutoff*len;
+            }
+        };
+        static_assert(sizeof(SMeshlet)==56u, "ICPUMeshletMeshBuffer::SMeshlet is serialized as is and must be 56 bytes");
+
+        //! Default constructor
+        ICPUMeshletMeshBuffer()
+        {
+            #ifdef _IRR_DEBUG
+            setDebugName("ICPUMeshletMeshBuffer");
+            #endif
+        }
+
+        inline void* serializeToBlob(void* _stackPtr = NULL, const size_t& _stackSize = 0) const override
+        {
+            return asset::CorrespondingBlobTypeFor<ICPUMeshletMeshBuffer>::type::createAndTryOnStack(this, _stackPtr, _stackSize);
+        }
+
+        virtual size_t conservativeSizeEstimate() const override { return ICPUMeshBuffer::conservativeSizeEstimate() + meshlets.size()*sizeof(SMeshlet); }
+
+        inline void setMeshlets(core::vector<SMeshlet>&& _meshlets) { meshlets = std::move(_meshlets); }
+        inline const core::vector<SMeshlet>& getMeshlets() const { return meshlets; }
+
+    private:
+        core::vector<SMeshlet> meshlets;
+};
+
+
+} // end namespace asset
+} // end namespace irr
+
+#endif
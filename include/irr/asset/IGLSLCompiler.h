@@ -3,6 +3,7 @@
 
 #include "irr/core/IReferenceCounted.h"
 #include "irr/asset/ShaderCommons.h"
+#include "irr/asset/CSPIRVCache.h"
 
 namespace irr { namespace asset
 {
@@ -12,6 +13,16 @@ class ICPUShader;
 class IGLSLCompiler : public core::IReferenceCounted
 {
 public:
+    //! Arguments of one createShaderFromGLSL call, for batches
+    struct SCompileRequest
+    {
+        const char* glslCode;
+        E_SHADER_STAGE stage;
+        const char* entryPoint;
+        bool debug = false;
+        const char* compilationId = nullptr;
+    };
+
     /**
     If _stage is ESS_UNKNOWN, then compiler will try to deduce shader stage from #pragma annotation, i.e.:
     #pragma shader_stage(vertex),       or
@@ -22,8 +33,27 @@ public:
     #pragma shader_stage(compute)
 
     Such annotation should be placed right after #version directive.
+
+    With a cache set, the compilation is skipped if the cache has a result for the key computeCacheKey() gives, and its result gets cached otherwise.
+    Safe to call from many threads at once, every thread keeps its own compiler.
+    @returns nullptr if the compilation failed, the errors get logged.
     */
     ICPUShader* createShaderFromGLSL(const char* _glslCode, E_SHADER_STAGE _stage, const char* _entryPoint, bool _debug = false, const char* compilationId = nullptr) const;
+
+    //! Does createShaderFromGLSL for every request in parallel on the task scheduler, `_outShaders[i]` gets the result of `_begin[i]`
+    void createShadersFromGLSL(const SCompileRequest* _begin, const SCompileRequest* _end, ICPUShader** _outShaders) const;
+
+    //! Key under which createShaderFromGLSL caches, a hash of the preprocessed source, the stage, entry point, options and SPIR-V version
+    /** Only the preprocessor runs, so it is a lot cheaper than compiling.
+    @returns false if preprocessing failed. */
+    bool computeCacheKey(CSPIRVCache::SKey& _outKey, const char* _glslCode, E_SHADER_STAGE _stage, const char* _entryPoint, bool _debug = false, const char* _compilationId = nullptr) const;
+
+    //! Not safe to call while other threads compile with this compiler, nullptr disables caching
+    inline void setCache(core::smart_refctd_ptr<CSPIRVCache>&& _cache) { m_cache = std::move(_cache); }
+    inline CSPIRVCache* getCache() const { return m_cache.get(); }
+
+private:
+    core::smart_refctd_ptr<CSPIRVCache> m_cache;
 };
 
 }}
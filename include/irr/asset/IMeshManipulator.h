@@ -11,6 +11,7 @@
 #include "vector3d.h"
 #include "aabbox3d.h"
 #include "irr/asset/ICPUMeshBuffer.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
 #include "irr/asset/CCPUMesh.h"
 
 namespace irr
@@ -70,6 +71,15 @@ namespace asset
 		};
 		typedef std::function<bool(const IMeshManipulator::SSNGVertexData&, const IMeshManipulator::SSNGVertexData&, ICPUMeshBuffer*)> VxCmpFunction;
 
+		//! Where simplification of a meshbuffer stops, whichever of the two limits gets hit first.
+		struct SSimplificationTarget
+		{
+			//! Fraction of the original meshbuffer's triangles to keep.
+			float triangleRatio = 0.5f;
+			//! Largest distance the surface may move by, relative to the longest side of the meshbuffer's bounding box.
+			float maxError = 0.01f;
+		};
+
 	public:
 		//! Flips the direction of surfaces.
 		/** Changes backfacing triangles to frontfacing
@@ -112,6 +122,42 @@ namespace asset
 		*/
 		static void requantizeMeshBuffer(ICPUMeshBuffer* _meshbuffer, const SErrorMetric* _errMetric);
 
+		//! Reduces the triangle count by collapsing edges in the order of smallest quadric error. Only triangle lists are supported.
+		/**
+			Vertices only collapse onto other existing vertices, so the returned meshbuffer shares all vertex buffers with the input and only gets a new index buffer.
+		Vertices with equal positions are welded first if all their other attributes compare equal under `_errMetrics`, those which don't are attribute seams (UV or normal splits),
+		seams and open borders only ever collapse along themselves so they keep their shape.
+		Meshes with many triangles get simplified in parallel per spatial cluster.
+		@param _inbuffer Input meshbuffer, left untouched.
+		@param _target When to stop.
+		@param _errMetrics Array of EVAI_COUNT structs, decides which vertices are the same apart from their position. nullptr means every attribute uses the default SErrorMetric.
+		@param _outError If not nullptr, receives the error actually made, in the same units as `_target.maxError`.
+		@returns A new meshbuffer or nullptr if the input was not a triangle list with a position attribute.
+		*/
+		static core::smart_refctd_ptr<ICPUMeshBuffer> createMeshBufferSimplified(const ICPUMeshBuffer* _inbuffer, const SSimplificationTarget& _target, const SErrorMetric* _errMetrics = nullptr, float* _outError = nullptr);
+
+		//! Creates successively simpler levels of detail, all of them sharing the vertex buffers of `_inbuffer`.
+		/**
+			Every level gets simplified from the previous one rather than from the input, so `_levels` should have decreasing triangle ratios and increasing errors,
+		both relative to `_inbuffer`. The error already made by the previous levels counts against each level's `maxError`.
+		The meshbuffers are ordered from the most to the least detailed, ready to be put into `IMeshSceneNodeInstanced::setLoDMeshes`.
+		@param _outErrors If not nullptr, an array of `_levelCount` which receives the accumulated error of every level.
+		@returns `_levelCount` meshbuffers or an empty vector on the same failures as createMeshBufferSimplified().
+		*/
+		static core::vector<core::smart_refctd_ptr<ICPUMeshBuffer> > createLoDChain(const ICPUMeshBuffer* _inbuffer, const SSimplificationTarget* _levels, uint32_t _levelCount, const SErrorMetric* _errMetrics = nullptr, float* _outErrors = nullptr);
+
+		//! Splits a triangle list into meshlets, small clusters of triangles which can be culled one by one.
+		/**
+			Meshlets grow over shared vertices so they stay connected and compact, each one gets a bounding sphere and a normal cone for backface culling.
+		The returned meshbuffer shares all vertex buffers with the input and only gets a new index buffer with the triangles ordered meshlet by meshlet,
+		so it still draws as a whole and every meshlet is a range of the index buffer.
+		@param _inbuffer Input meshbuffer, left untouched.
+		@param _maxVertices Most distinct vertices any meshlet may reference, at least 3.
+		@param _maxTriangles Most triangles in any meshlet, at least 1.
+		@returns A new meshbuffer or nullptr if the input was not a static triangle list with a position attribute.
+		*/
+		static core::smart_refctd_ptr<ICPUMeshletMeshBuffer> createMeshletizedMeshBuffer(const ICPUMeshBuffer* _inbuffer, uint32_t _maxVertices = 64u, uint32_t _maxTriangles = 126u);
+
 		static core::smart_refctd_ptr<ICPUMeshBuffer> createMeshBufferDuplicate(const ICPUMeshBuffer* _src);
 
         //! Creates new index buffer with invalid triangles removed.
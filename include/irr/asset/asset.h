@@ -28,6 +28,7 @@
 #include "irr/asset/IBuiltinIncludeLoader.h"
 #include "irr/asset/IParsedShaderSource.h"
 #include "irr/asset/IGLSLCompiler.h"
+#include "irr/asset/CSPIRVOptimizer.h"
 #include "irr/asset/ISPIR_VProgram.h"
 #include "irr/asset/ICPUShader.h"
 #include "irr/asset/ICPUSpecializedShader.h"
@@ -35,6 +36,7 @@
 // meshes
 #include "irr/asset/ICPUMeshBuffer.h"
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
 #include "irr/asset/ICPUMesh.h"
 #include "irr/asset/CCPUMesh.h" // refactor
 #include "irr/asset/ICPUSkinnedMesh.h"
@@ -54,6 +56,7 @@
 
 // importexport
 #include "irr/asset/IAssetLoader.h"
+#include "irr/asset/CAssetLoadHandle.h"
 #include "irr/asset/IAssetManager.h"
 #include "irr/asset/IAssetWriter.h"
 
@@ -37,6 +37,7 @@ namespace asset
 			EBT_DATA_FORMAT_DESC,
 			EBT_FINAL_BONE_HIERARCHY,
 			EBT_TEXTURE_PATH,
+			EBT_MESHLET_MESH_BUFFER,
 			EBT_COUNT
 		};
 
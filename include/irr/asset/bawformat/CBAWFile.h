@@ -17,6 +17,7 @@
 #include "irr/asset/bawformat/blobs/TexturePathBlob.h"
 #include "irr/asset/bawformat/blobs/MeshBufferBlob.h"
 #include "irr/asset/bawformat/blobs/SkinnedMeshBufferBlob.h"
+#include "irr/asset/bawformat/blobs/MeshletMeshBufferBlob.h"
 #include "irr/asset/bawformat/blobs/MeshBlob.h"
 #include "irr/asset/bawformat/blobs/SkinnedMeshBlob.h"
 
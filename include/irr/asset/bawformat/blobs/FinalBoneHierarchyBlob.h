@@ -80,6 +80,14 @@ public:
 	size_t calcNonInterpolatedAnimsByteSize() const;
 	// size of bone names is not dependent of any of 'count variables'. Since it's the last block its size can be calculated by {blobSize - boneNamesOffset}.
 
+	//! Set in `keyframeCount` when the hierarchy has compressed animations.
+	/** The interpolated animations block then holds the serialized CCompressedBoneAnimation and the non-interpolated one is empty.
+	Blobs without the flag are laid out exactly as before, so existing files keep loading. */
+	_IRR_STATIC_INLINE_CONSTEXPR size_t CompressedAnimationsFlag = size_t(1u) << (sizeof(size_t)*8u-1u);
+
+	inline bool hasCompressedAnimations() const { return keyframeCount & CompressedAnimationsFlag; }
+	inline size_t getKeyframeCount() const { return keyframeCount & ~CompressedAnimationsFlag; }
+
     size_t boneCount;
     size_t numLevelsInHierarchy;
     size_t keyframeCount;
@@ -0,0 +1,56 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_MESHLET_MESH_BUFFER_BLOB_H_INCLUDED__
+#define __IRR_MESHLET_MESH_BUFFER_BLOB_H_INCLUDED__
+
+namespace irr
+{
+namespace asset
+{
+
+class ICPUMeshletMeshBuffer;
+
+#include "irr/irrpack.h"
+//! Same members as MeshBufferBlobV0, followed by `meshletCount` tightly packed ICPUMeshletMeshBuffer::SMeshlet
+struct IRR_FORCE_EBO MeshletMeshBufferBlobV0 : TypedBlob<MeshletMeshBufferBlobV0, ICPUMeshletMeshBuffer>, VariableSizeBlob<MeshletMeshBufferBlobV0, ICPUMeshletMeshBuffer>
+{
+	//! Constructor filling all members, including the meshlets
+	explicit MeshletMeshBufferBlobV0(const ICPUMeshletMeshBuffer*);
+
+	video::SCPUMaterial mat;
+	core::aabbox3df box;
+	uint64_t descPtr;
+	uint32_t indexType;
+	uint32_t baseVertex;
+	uint64_t indexCount;
+	size_t indexBufOffset;
+	size_t instanceCount;
+	uint32_t baseInstance;
+	uint32_t primitiveType;
+	uint32_t posAttrId;
+	uint32_t meshletCount;
+
+	//! Meshlets are not necessarily aligned within the blob, copy them out with memcpy
+	inline const uint8_t* getMeshletData() const { return reinterpret_cast<const uint8_t*>(this)+sizeof(MeshletMeshBufferBlobV0); }
+	inline uint8_t* getMeshletData() { return reinterpret_cast<uint8_t*>(this)+sizeof(MeshletMeshBufferBlobV0); }
+} PACK_STRUCT;
+#include "irr/irrunpack.h"
+static_assert(
+    sizeof(MeshletMeshBufferBlobV0) ==
+    sizeof(MeshletMeshBufferBlobV0::mat) + sizeof(MeshletMeshBufferBlobV0::box) + sizeof(MeshletMeshBufferBlobV0::descPtr) + sizeof(MeshletMeshBufferBlobV0::indexType) + sizeof(MeshletMeshBufferBlobV0::baseVertex)
+    + sizeof(MeshletMeshBufferBlobV0::indexCount) + sizeof(MeshletMeshBufferBlobV0::indexBufOffset) + sizeof(MeshletMeshBufferBlobV0::instanceCount) + sizeof(MeshletMeshBufferBlobV0::baseInstance)
+    + sizeof(MeshletMeshBufferBlobV0::primitiveType) + sizeof(MeshletMeshBufferBlobV0::posAttrId) + sizeof(MeshletMeshBufferBlobV0::meshletCount),
+    "MeshletMeshBufferBlobV0: Size of blob is not sum of its contents!"
+);
+
+using MeshletMeshBufferBlobV1 = MeshletMeshBufferBlobV0;
+
+template<>
+struct CorrespondingBlobTypeFor<ICPUMeshletMeshBuffer> { typedef MeshletMeshBufferBlobV1 type; };
+
+}
+} // irr::asset
+
+#endif
@@ -7,6 +7,7 @@
 #include "irr/asset/format/EFormat.h"
 #include "decodePixels.h"
 #include "encodePixels.h"
+#include "convertColorBatch.h"
 
 #ifdef __GNUC__
     #pragma GCC diagnostic push
@@ -123,50 +124,117 @@ namespace irr { namespace video
             impl::SCallEncode<dF, encT>{}(dstPix, encbuf);
         }
     }
+    //! Converts `_texelCount` consecutive texels of a non-planar, non-block-compressed format
+    /** Format pairs with a batch converter (identical formats, RGBA8/BGRA8 UNORM and sRGB, RGBA16F, A2B10G10R10 UNORM, RGBA32F)
+    convert whole rows with SSE4 and truncate integers like encodePixels, everything else falls back to converting texel by texel. */
     template<asset::E_FORMAT sF, asset::E_FORMAT dF>
-    inline void convertColor(const void* srcPix[4], void* dstPix, size_t _pixOrBlockCnt, core::vector3d<uint32_t>& _imgSize)
+    inline void convertColorRow(const void* _src, void* _dst, size_t _texelCount)
     {
         using namespace asset;
+        static_assert(!isPlanarFormat<sF>() && !isPlanarFormat<dF>() && !isBlockCompressionFormat<sF>() && !isBlockCompressionFormat<dF>(), "Only formats with single texel blocks can be converted by rows!");
+
+        IRR_PSEUDO_IF_CONSTEXPR_BEGIN(sF==dF)
+        {
+            memcpy(_dst, _src, _texelCount*getTexelOrBlockBytesize(sF));
+        }
+        IRR_PSEUDO_ELSE_CONSTEXPR
+        {
+            IRR_PSEUDO_IF_CONSTEXPR_BEGIN(impl::SBatchConverter<sF,dF>::value)
+            {
+                impl::SBatchConverter<sF,dF>::convert(_src, _dst, _texelCount);
+            }
+            IRR_PSEUDO_ELSE_CONSTEXPR
+            {
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                const uint32_t srcStride = getTexelOrBlockBytesize(sF);
+                const uint32_t dstStride = getTexelOrBlockBytesize(dF);
+                for (size_t i = 0u; i < _texelCount; ++i)
+                {
+                    const void* pix[4] = { src+i*srcStride, nullptr, nullptr, nullptr };
+                    convertColor<sF, dF>(pix, dst+i*dstStride, 0u, 0u);
+                }
+            }
+            IRR_PSEUDO_IF_CONSTEXPR_END
+        }
+        IRR_PSEUDO_IF_CONSTEXPR_END
+    }
 
-        const uint32_t srcStride = getTexelOrBlockBytesize(sF);
-        const uint32_t dstStride = getTexelOrBlockBytesize(dF);
+    //! Converts a `_width` by `_height` slice row by row, `_srcPitch` and `_dstPitch` are in bytes
+    /** Large slices get their rows spread over the default task scheduler. */
+    template<asset::E_FORMAT sF, asset::E_FORMAT dF>
+    inline void convertColorSlice(const void* _src, void* _dst, uint32_t _width, uint32_t _height, size_t _srcPitch, size_t _dstPitch)
+    {
+        constexpr size_t MinTexelsPerTask = 0x1u<<16u;
+
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+        auto convertRows = [=](uint32_t _begin, uint32_t _end)
+        {
+            for (uint32_t y = _begin; y < _end; ++y)
+                convertColorRow<sF, dF>(src+y*_srcPitch, dst+y*_dstPitch, _width);
+        };
 
-        uint32_t hPlaneReduction[4], vPlaneReduction[4], chCntInPlane[4];
-        getHorizontalReductionFactorPerPlane(sF, hPlaneReduction);
-        getVerticalReductionFactorPerPlane(sF, vPlaneReduction);
-        getChannelsPerPlane(sF, chCntInPlane);
+        if (size_t(_width)*_height < 2u*MinTexelsPerTask || _width == 0u)
+            convertRows(0u, _height);
+        else
+            core::parallel_for_range<uint32_t>(0u, _height, convertRows, core::max_<uint32_t>(MinTexelsPerTask/_width, 1u));
+    }
 
-        const auto sdims = getBlockDimensions(sF);
+    template<asset::E_FORMAT sF, asset::E_FORMAT dF>
+    inline void convertColor(const void* srcPix[4], void* dstPix, size_t _pixOrBlockCnt, core::vector3d<uint32_t>& _imgSize)
+    {
+        using namespace asset;
 
-        const uint8_t** src = reinterpret_cast<const uint8_t**>(srcPix);
-        uint8_t* const dst_begin = reinterpret_cast<uint8_t*>(dstPix);
-        for (size_t i = 0u; i < _pixOrBlockCnt; ++i)
+        IRR_PSEUDO_IF_CONSTEXPR_BEGIN(impl::SBatchConverter<sF,dF>::value || (sF==dF && !isPlanarFormat<sF>() && !isBlockCompressionFormat<sF>()))
         {
-            // assuming _imgSize is always represented in texels
-            const uint32_t px = i % (_imgSize.X / sdims.X);
-            const uint32_t py = i / (_imgSize.X / sdims.X);
-            //px, py are block or texel position
-            //x, y are position within block
-            for (uint32_t x = 0u; x < sdims.X; ++x)
+            // batch formats have 1x1 texel blocks, so texel `i` of the source always lands on texel `i` of the destination
+            convertColorRow<sF, dF>(srcPix[0], dstPix, _pixOrBlockCnt);
+            srcPix[0] = reinterpret_cast<const uint8_t*>(srcPix[0]) + _pixOrBlockCnt*getTexelOrBlockBytesize(sF);
+        }
+        IRR_PSEUDO_ELSE_CONSTEXPR
+        {
+            const uint32_t srcStride = getTexelOrBlockBytesize(sF);
+            const uint32_t dstStride = getTexelOrBlockBytesize(dF);
+
+            uint32_t hPlaneReduction[4], vPlaneReduction[4], chCntInPlane[4];
+            getHorizontalReductionFactorPerPlane(sF, hPlaneReduction);
+            getVerticalReductionFactorPerPlane(sF, vPlaneReduction);
+            getChannelsPerPlane(sF, chCntInPlane);
+
+            const auto sdims = getBlockDimensions(sF);
+
+            const uint8_t** src = reinterpret_cast<const uint8_t**>(srcPix);
+            uint8_t* const dst_begin = reinterpret_cast<uint8_t*>(dstPix);
+            for (size_t i = 0u; i < _pixOrBlockCnt; ++i)
             {
-                for (uint32_t y = 0u; y < sdims.Y; ++y)
+                // assuming _imgSize is always represented in texels
+                const uint32_t px = i % (_imgSize.X / sdims.X);
+                const uint32_t py = i / (_imgSize.X / sdims.X);
+                //px, py are block or texel position
+                //x, y are position within block
+                for (uint32_t x = 0u; x < sdims.X; ++x)
                 {
-                    const ptrdiff_t off = ((sdims.Y * py + y)*_imgSize.X + px * sdims.X + x);
-                    convertColor<sF, dF>(reinterpret_cast<const void**>(src), dst_begin + static_cast<ptrdiff_t>(dstStride)*off, x, y);
+                    for (uint32_t y = 0u; y < sdims.Y; ++y)
+                    {
+                        const ptrdiff_t off = ((sdims.Y * py + y)*_imgSize.X + px * sdims.X + x);
+                        convertColor<sF, dF>(reinterpret_cast<const void**>(src), dst_begin + static_cast<ptrdiff_t>(dstStride)*off, x, y);
+                    }
+                }
+                if (!isPlanarFormat<sF>())
+                {
+                    src[0] += srcStride;
+                }
+                else
+                {
+                    const uint32_t px = i % _imgSize.X;
+                    const uint32_t py = i / _imgSize.X;
+                    for (uint32_t j = 0u; j < 4u; ++j)
+                        src[j] = reinterpret_cast<const uint8_t*>(srcPix[j]) + chCntInPlane[j]*((_imgSize.X/hPlaneReduction[j]) * (py/vPlaneReduction[j]) + px/hPlaneReduction[j]);
                 }
-            }
-            if (!isPlanarFormat<sF>())
-            {
-                src[0] += srcStride;
-            }
-            else
-            {
-                const uint32_t px = i % _imgSize.X;
-                const uint32_t py = i / _imgSize.X;
-                for (uint32_t j = 0u; j < 4u; ++j)
-                    src[j] = reinterpret_cast<const uint8_t*>(srcPix[j]) + chCntInPlane[j]*((_imgSize.X/hPlaneReduction[j]) * (py/vPlaneReduction[j]) + px/hPlaneReduction[j]);
             }
         }
+        IRR_PSEUDO_IF_CONSTEXPR_END
     }
 
     void convertColor(asset::E_FORMAT _sfmt, asset::E_FORMAT _dfmt, const void* _srcPix[4], void* _dstPix, size_t _pixOrBlockCnt, core::vector3d<uint32_t>& _imgSize);
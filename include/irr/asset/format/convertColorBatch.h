@@ -0,0 +1,396 @@
+#ifndef __IRR_CONVERT_COLOR_BATCH_H_INCLUDED__
+#define __IRR_CONVERT_COLOR_BATCH_H_INCLUDED__
+
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#include "irr/asset/format/EFormat.h"
+#include "decodePixels.h"
+
+namespace irr { namespace video
+{
+    namespace impl
+    {
+        /**
+        Row codecs between a format and tightly packed RGBA32F, used by `convertColorRow` and `convertColorSlice`
+        to convert whole rows without going through `double` for every channel of every texel.
+        Only formats which have a specialization get the batch path, the rest stay on the per-texel path.
+
+        Integer encodes truncate like `encodePixels` does, but clamp to the representable range instead of wrapping around.
+        */
+        template<asset::E_FORMAT fmt>
+        struct SRGBAFloatCodec : std::false_type {};
+
+        template<>
+        struct SRGBAFloatCodec<asset::EF_R32G32B32A32_SFLOAT> : std::true_type
+        {
+            static inline void decode(const void* _src, float* _dst, size_t _texelCount)
+            {
+                memcpy(_dst, _src, _texelCount*4u*sizeof(float));
+            }
+            static inline void encode(const float* _src, void* _dst, size_t _texelCount)
+            {
+                memcpy(_dst, _src, _texelCount*4u*sizeof(float));
+            }
+        };
+
+#ifdef __IRR_COMPILE_WITH_X86_SIMD_
+        //! Swaps R and B in four RGBA8 or BGRA8 texels
+        inline __m128i swapRB8(__m128i _texels)
+        {
+            return _mm_shuffle_epi8(_texels, _mm_setr_epi8(2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15));
+        }
+
+        //! Clamps to [0,1] and truncates `_v*_scale` like `encodePixels`
+        /** Multiplies in double, where the product of a float and an integer of up to 29 bits is exact, so no product rounds up to the next integer. */
+        inline __m128i quantizeUNORM(__m128 _v, __m128d _scale)
+        {
+            // max(x,0) also turns NaN into 0
+            _v = _mm_min_ps(_mm_max_ps(_v,_mm_setzero_ps()),_mm_set1_ps(1.f));
+            const __m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_v),_scale));
+            const __m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(_v,_v)),_scale));
+            return _mm_unpacklo_epi64(lo,hi);
+        }
+
+        //! Four RGBA float texels to four RGBA8 UNORM texels
+        inline __m128i packUNORM8(const float* _src)
+        {
+            const __m128d scale = _mm_set1_pd(255.0);
+
+            __m128i texel[4];
+            for (uint32_t i=0u; i<4u; i++)
+                texel[i] = quantizeUNORM(_mm_loadu_ps(_src+4u*i),scale);
+            return _mm_packus_epi16(_mm_packs_epi32(texel[0],texel[1]),_mm_packs_epi32(texel[2],texel[3]));
+        }
+
+        //! Four RGBA8 UNORM texels to four RGBA float texels
+        inline void unpackUNORM8(__m128i _texels, float* _dst)
+        {
+            const __m128 scale = _mm_set1_ps(1.f/255.f);
+            _mm_storeu_ps(_dst+0u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_texels)),scale));
+            _mm_storeu_ps(_dst+4u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(_texels,4))),scale));
+            _mm_storeu_ps(_dst+8u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(_texels,8))),scale));
+            _mm_storeu_ps(_dst+12u, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(_texels,12))),scale));
+        }
+
+        template<bool swapRB>
+        struct SUNORM8Codec : std::true_type
+        {
+            static inline void decode(const void* _src, float* _dst, size_t _texelCount)
+            {
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+                size_t i = 0u;
+                for (; i+4u<=_texelCount; i+=4u)
+                {
+                    __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+4u*i));
+                    if (swapRB)
+                        texels = swapRB8(texels);
+                    unpackUNORM8(texels,_dst+4u*i);
+                }
+                for (; i<_texelCount; i++)
+                for (uint32_t c=0u; c<4u; c++)
+                    _dst[4u*i+c] = float(src[4u*i+(swapRB&&c!=3u ? 2u-c:c)])/255.f;
+            }
+            static inline void encode(const float* _src, void* _dst, size_t _texelCount)
+            {
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                size_t i = 0u;
+                for (; i+4u<=_texelCount; i+=4u)
+                {
+                    __m128i texels = packUNORM8(_src+4u*i);
+                    if (swapRB)
+                        texels = swapRB8(texels);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+4u*i),texels);
+                }
+                if (i<_texelCount)
+                {
+                    alignas(16) float tmp[16] = {};
+                    memcpy(tmp, _src+4u*i, (_texelCount-i)*4u*sizeof(float));
+                    __m128i texels = packUNORM8(tmp);
+                    if (swapRB)
+                        texels = swapRB8(texels);
+                    alignas(16) uint8_t out[16];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(out),texels);
+                    memcpy(dst+4u*i, out, (_texelCount-i)*4u);
+                }
+            }
+        };
+
+        //! Lookup tables for 8bit sRGB, built once on first use
+        struct SSRGB8Tables
+        {
+            //! Smallest float which can encode to anything other than 0, and the coarse table resolution
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t MinBits = (127u-13u)<<23u;
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t AlmostOneBits = 0x3f7fffffu;
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t CoarseShift = 16u;
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t CoarseCount = ((AlmostOneBits-MinBits)>>CoarseShift)+1u;
+
+            //! linear value of every sRGB code
+            float toLinear[256];
+            //! linear value at which truncation switches from code `i` to `i+1`
+            float threshold[256];
+            //! lowest code any float in the bucket can encode to
+            uint8_t coarse[CoarseCount];
+
+            static const SSRGB8Tables& get()
+            {
+                static const SSRGB8Tables tables;
+                return tables;
+            }
+
+            inline uint8_t encode(float _linear) const
+            {
+                uint32_t bits;
+                memcpy(&bits, &_linear, 4u);
+                // also takes care of negatives and NaN
+                if (!(_linear > 0.f) || bits<MinBits)
+                    return 0u;
+                if (bits>AlmostOneBits)
+                    return 255u;
+
+                uint32_t code = coarse[(bits-MinBits)>>CoarseShift];
+                while (_linear>=threshold[code])
+                    code++;
+                return code;
+            }
+
+        private:
+            SSRGB8Tables()
+            {
+                for (uint32_t i=0u; i<256u; i++)
+                {
+                    toLinear[i] = srgb2lin(i/255.);
+                    if (i==255u)
+                    {
+                        threshold[i] = 2.f;
+                        continue;
+                    }
+                    // round the threshold up, so the float comparison truncates exactly like the double one would
+                    const double exact = srgb2lin((i+1u)/255.);
+                    threshold[i] = float(exact);
+                    if (double(threshold[i])<exact)
+                        threshold[i] = std::nextafter(threshold[i],2.f);
+                }
+                uint32_t code = 0u;
+                for (uint32_t i=0u; i<CoarseCount; i++)
+                {
+                    const uint32_t bits = MinBits+(i<<CoarseShift);
+                    float lowest;
+                    memcpy(&lowest, &bits, 4u);
+                    while (lowest>=threshold[code])
+                        code++;
+                    coarse[i] = code;
+                }
+            }
+        };
+
+        template<bool swapRB>
+        struct SSRGB8Codec : std::true_type
+        {
+            static inline void decode(const void* _src, float* _dst, size_t _texelCount)
+            {
+                const auto& tables = SSRGB8Tables::get();
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+                for (size_t i=0u; i<_texelCount; i++, src+=4u, _dst+=4u)
+                {
+                    _dst[0] = tables.toLinear[src[swapRB ? 2u:0u]];
+                    _dst[1] = tables.toLinear[src[1]];
+                    _dst[2] = tables.toLinear[src[swapRB ? 0u:2u]];
+                    _dst[3] = float(src[3])/255.f;
+                }
+            }
+            static inline void encode(const float* _src, void* _dst, size_t _texelCount)
+            {
+                const auto& tables = SSRGB8Tables::get();
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                for (size_t i=0u; i<_texelCount; i++, _src+=4u, dst+=4u)
+                {
+                    dst[swapRB ? 2u:0u] = tables.encode(_src[0]);
+                    dst[1] = tables.encode(_src[1]);
+                    dst[swapRB ? 0u:2u] = tables.encode(_src[2]);
+                    // alpha is linear
+                    dst[3] = uint8_t(double(core::min_(core::max_(_src[3],0.f),1.f))*255.0);
+                }
+            }
+        };
+
+        //! Half floats in the low 16 bits of every lane to floats, handles denormals, infinities and NaN
+        inline __m128 halfToFloat(__m128i _h)
+        {
+            const __m128i expMant = _mm_and_si128(_h,_mm_set1_epi32(0x7fff));
+            const __m128i sign = _mm_slli_epi32(_mm_xor_si128(_h,expMant),16);
+            // rebias the exponent by multiplying with 2^112, this also normalizes denormals
+            const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant,13)),_mm_castsi128_ps(_mm_set1_epi32((254-15)<<23)));
+            const __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMant,_mm_set1_epi32(0x7bff)),_mm_set1_epi32(255<<23));
+            return _mm_or_ps(scaled,_mm_castsi128_ps(_mm_or_si128(sign,infNan)));
+        }
+
+        //! Floats to half floats in the low 16 bits of every lane, truncates the mantissa like core::Float16Compressor
+        inline __m128i floatToHalf(__m128 _f)
+        {
+            __m128i u = _mm_castps_si128(_f);
+            const __m128i sign = _mm_and_si128(u,_mm_set1_epi32(0x80000000));
+            u = _mm_xor_si128(u,sign);
+
+            const __m128i nan = _mm_cmpgt_epi32(u,_mm_set1_epi32(255<<23));
+            const __m128i infNan = _mm_blendv_epi8(_mm_set1_epi32(0x7c00),_mm_set1_epi32(0x7e00),nan);
+
+            // half denormals are multiples of 2^-24
+            const __m128i denorm = _mm_cvttps_epi32(_mm_mul_ps(_mm_castsi128_ps(u),_mm_set1_ps(16777216.f)));
+            const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(u,_mm_set1_epi32(112<<23)),13);
+
+            __m128i result = _mm_blendv_epi8(normal,denorm,_mm_cmplt_epi32(u,_mm_set1_epi32(113<<23)));
+            // anything above the largest half becomes infinity, 0x477fe000 is 65504.f
+            result = _mm_blendv_epi8(result,infNan,_mm_cmpgt_epi32(u,_mm_set1_epi32(0x477fe000)));
+            return _mm_or_si128(result,_mm_srli_epi32(sign,16));
+        }
+
+        template<>
+        struct SRGBAFloatCodec<asset::EF_R16G16B16A16_SFLOAT> : std::true_type
+        {
+            static inline void decode(const void* _src, float* _dst, size_t _texelCount)
+            {
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+                size_t i = 0u;
+                for (; i+2u<=_texelCount; i+=2u)
+                {
+                    const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+8u*i));
+                    _mm_storeu_ps(_dst+4u*i, halfToFloat(_mm_cvtepu16_epi32(halves)));
+                    _mm_storeu_ps(_dst+4u*i+4u, halfToFloat(_mm_cvtepu16_epi32(_mm_srli_si128(halves,8))));
+                }
+                if (i<_texelCount)
+                    _mm_storeu_ps(_dst+4u*i, halfToFloat(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src+8u*i)))));
+            }
+            static inline void encode(const float* _src, void* _dst, size_t _texelCount)
+            {
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                size_t i = 0u;
+                for (; i+2u<=_texelCount; i+=2u)
+                {
+                    const __m128i lo = floatToHalf(_mm_loadu_ps(_src+4u*i));
+                    const __m128i hi = floatToHalf(_mm_loadu_ps(_src+4u*i+4u));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+8u*i), _mm_packus_epi32(lo,hi));
+                }
+                if (i<_texelCount)
+                {
+                    const __m128i lo = floatToHalf(_mm_loadu_ps(_src+4u*i));
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst+8u*i), _mm_packus_epi32(lo,lo));
+                }
+            }
+        };
+
+        template<>
+        struct SRGBAFloatCodec<asset::EF_A2B10G10R10_UNORM_PACK32> : std::true_type
+        {
+            static inline void decode(const void* _src, float* _dst, size_t _texelCount)
+            {
+                const uint32_t* src = reinterpret_cast<const uint32_t*>(_src);
+                const __m128i mask = _mm_set1_epi32(0x3ff);
+                // dividing (unlike multiplying by the reciprocal) makes every code survive the truncating encode
+                const __m128 scale = _mm_set1_ps(1023.f);
+                size_t i = 0u;
+                for (; i+4u<=_texelCount; i+=4u)
+                {
+                    const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+                    __m128 r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(texels,mask)),scale);
+                    __m128 g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels,10),mask)),scale);
+                    __m128 b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels,20),mask)),scale);
+                    __m128 a = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(texels,30)),_mm_set1_ps(3.f));
+                    _MM_TRANSPOSE4_PS(r,g,b,a);
+                    _mm_storeu_ps(_dst+4u*i, r);
+                    _mm_storeu_ps(_dst+4u*i+4u, g);
+                    _mm_storeu_ps(_dst+4u*i+8u, b);
+                    _mm_storeu_ps(_dst+4u*i+12u, a);
+                }
+                for (; i<_texelCount; i++)
+                {
+                    _dst[4u*i+0u] = float((src[i]>>0u)&0x3ffu)/1023.f;
+                    _dst[4u*i+1u] = float((src[i]>>10u)&0x3ffu)/1023.f;
+                    _dst[4u*i+2u] = float((src[i]>>20u)&0x3ffu)/1023.f;
+                    _dst[4u*i+3u] = float(src[i]>>30u)/3.f;
+                }
+            }
+            static inline void encode(const float* _src, void* _dst, size_t _texelCount)
+            {
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                for (size_t i=0u; i<_texelCount; i+=4u)
+                {
+                    const size_t count = core::min_<size_t>(_texelCount-i,4u);
+                    alignas(16) float tmp[16] = {};
+                    memcpy(tmp, _src+4u*i, count*4u*sizeof(float));
+
+                    __m128 r = _mm_load_ps(tmp), g = _mm_load_ps(tmp+4u), b = _mm_load_ps(tmp+8u), a = _mm_load_ps(tmp+12u);
+                    _MM_TRANSPOSE4_PS(r,g,b,a);
+                    const __m128d scale = _mm_set1_pd(1023.0);
+                    __m128i texels = quantizeUNORM(r,scale);
+                    texels = _mm_or_si128(texels,_mm_slli_epi32(quantizeUNORM(g,scale),10));
+                    texels = _mm_or_si128(texels,_mm_slli_epi32(quantizeUNORM(b,scale),20));
+                    texels = _mm_or_si128(texels,_mm_slli_epi32(quantizeUNORM(a,_mm_set1_pd(3.0)),30));
+
+                    alignas(16) uint32_t out[4];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(out),texels);
+                    memcpy(dst+4u*i, out, count*4u);
+                }
+            }
+        };
+
+        template<> struct SRGBAFloatCodec<asset::EF_R8G8B8A8_UNORM> : SUNORM8Codec<false> {};
+        template<> struct SRGBAFloatCodec<asset::EF_B8G8R8A8_UNORM> : SUNORM8Codec<true> {};
+        template<> struct SRGBAFloatCodec<asset::EF_R8G8B8A8_SRGB> : SSRGB8Codec<false> {};
+        template<> struct SRGBAFloatCodec<asset::EF_B8G8R8A8_SRGB> : SSRGB8Codec<true> {};
+#endif // __IRR_COMPILE_WITH_X86_SIMD_
+
+        //! Converts whole rows, the generic version goes through a small RGBA32F buffer on the stack
+        template<asset::E_FORMAT sF, asset::E_FORMAT dF>
+        struct SBatchConverter : std::integral_constant<bool,SRGBAFloatCodec<sF>::value&&SRGBAFloatCodec<dF>::value>
+        {
+            _IRR_STATIC_INLINE_CONSTEXPR size_t ChunkTexels = 256u;
+
+            static inline void convert(const void* _src, void* _dst, size_t _texelCount)
+            {
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                const size_t srcStride = asset::getTexelOrBlockBytesize(sF);
+                const size_t dstStride = asset::getTexelOrBlockBytesize(dF);
+
+                alignas(16) float tmp[4u*ChunkTexels];
+                for (size_t i=0u; i<_texelCount; i+=ChunkTexels)
+                {
+                    const size_t count = core::min_(_texelCount-i,ChunkTexels);
+                    SRGBAFloatCodec<sF>::decode(src+i*srcStride, tmp, count);
+                    SRGBAFloatCodec<dF>::encode(tmp, dst+i*dstStride, count);
+                }
+            }
+        };
+
+#ifdef __IRR_COMPILE_WITH_X86_SIMD_
+        //! Pure swizzles between 8bit formats with the same encoding never need to leave the integer domain
+        struct SSwapRB8Converter : std::true_type
+        {
+            static inline void convert(const void* _src, void* _dst, size_t _texelCount)
+            {
+                const uint8_t* src = reinterpret_cast<const uint8_t*>(_src);
+                uint8_t* dst = reinterpret_cast<uint8_t*>(_dst);
+                size_t i = 0u;
+                for (; i+4u<=_texelCount; i+=4u)
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+4u*i),swapRB8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+4u*i))));
+                for (; i<_texelCount; i++)
+                {
+                    dst[4u*i+0u] = src[4u*i+2u];
+                    dst[4u*i+1u] = src[4u*i+1u];
+                    dst[4u*i+2u] = src[4u*i+0u];
+                    dst[4u*i+3u] = src[4u*i+3u];
+                }
+            }
+        };
+
+        template<> struct SBatchConverter<asset::EF_R8G8B8A8_UNORM,asset::EF_B8G8R8A8_UNORM> : SSwapRB8Converter {};
+        template<> struct SBatchConverter<asset::EF_B8G8R8A8_UNORM,asset::EF_R8G8B8A8_UNORM> : SSwapRB8Converter {};
+        template<> struct SBatchConverter<asset::EF_R8G8B8A8_SRGB,asset::EF_B8G8R8A8_SRGB> : SSwapRB8Converter {};
+        template<> struct SBatchConverter<asset::EF_B8G8R8A8_SRGB,asset::EF_R8G8B8A8_SRGB> : SSwapRB8Converter {};
+#endif // __IRR_COMPILE_WITH_X86_SIMD_
+    } //namespace impl
+}} //irr:video
+
+#endif //__IRR_CONVERT_COLOR_BATCH_H_INCLUDED__
@@ -0,0 +1,80 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_RADIX_SORT_H_INCLUDED__
+#define __IRR_RADIX_SORT_H_INCLUDED__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace irr
+{
+namespace core
+{
+
+//! Maps a float to an unsigned integer with the same ordering, negative numbers and all
+inline uint32_t float_to_sortable_uint(float _f)
+{
+    uint32_t bits;
+    memcpy(&bits,&_f,sizeof(bits));
+    return bits^((bits&0x80000000u) ? 0xffffffffu:0x80000000u);
+}
+
+//! Stable LSD radix sort of [_begin,_end) by the unsigned integer `_key(element)` in ascending order
+/** Does 8 bits per pass and skips the passes in which every key has the same byte, so small or narrow keys
+(material IDs, render priorities) only cost a few passes. `_scratch` must have room for as many elements as the range,
+the result always ends up in [_begin,_end). Short ranges fall back to `std::stable_sort`. */
+template<typename T, typename KeyF>
+inline void radix_sort(T* _begin, T* _end, T* _scratch, KeyF&& _key)
+{
+    typedef typename std::decay<decltype(_key(*_begin))>::type key_t;
+    static_assert(std::is_unsigned<key_t>::value,"Radix sort keys must be unsigned integers!");
+    constexpr size_t PassCount = sizeof(key_t);
+    constexpr size_t MinRadixSortCount = 64u;
+
+    const size_t count = _end-_begin;
+    if (count<MinRadixSortCount)
+    {
+        std::stable_sort(_begin,_end,[&_key](const T& a, const T& b) {return _key(a)<_key(b);});
+        return;
+    }
+
+    uint32_t histograms[PassCount][256u] = {};
+    for (const T* it=_begin; it!=_end; it++)
+    {
+        const key_t key = _key(*it);
+        for (size_t pass=0u; pass<PassCount; pass++)
+            histograms[pass][(key>>(pass*8u))&0xffu]++;
+    }
+
+    T* src = _begin;
+    T* dst = _scratch;
+    const key_t firstKey = _key(*_begin);
+    for (size_t pass=0u; pass<PassCount; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        const uint32_t shift = pass*8u;
+        if (histogram[(firstKey>>shift)&0xffu]==count)
+            continue;
+
+        for (uint32_t i=0u, sum=0u; i<256u; i++)
+        {
+            const uint32_t digitCount = histogram[i];
+            histogram[i] = sum;
+            sum += digitCount;
+        }
+        for (T* it=src; it!=src+count; it++)
+            dst[histogram[(_key(*it)>>shift)&0xffu]++] = std::move(*it);
+        std::swap(src,dst);
+    }
+    if (src!=_begin)
+        std::move(src,src+count,_begin);
+}
+
+} // end namespace core
+} // end namespace irr
+
+#endif
@@ -28,6 +28,8 @@
 #include "irr/core/alloc/PoolAddressAllocator.h"
 #include "irr/core/alloc/ResizableHeterogenousMemoryAllocator.h"
 #include "irr/core/alloc/StackAddressAllocator.h"
+// algorithm
+#include "irr/core/algorithm/radix_sort.h"
 // math
 #include "irr/core/math/floatutil.h"
 #include "irr/core/math/irrMath.h"
@@ -42,6 +44,8 @@
 // parallel
 #include "irr/core/parallel/IThreadBound.h"
 #include "irr/core/parallel/unlock_guard.h"
+#include "irr/core/parallel/CTaskScheduler.h"
+#include "irr/core/parallel/parallel_for.h"
 // string
 #include "irr/core/string/stringutil.h"
 // other useful things
@@ -0,0 +1,275 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_TASK_SCHEDULER_H_INCLUDED__
+#define __IRR_C_TASK_SCHEDULER_H_INCLUDED__
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+
+#include "irr/core/Types.h"
+#include "irr/core/IReferenceCounted.h"
+
+namespace irr
+{
+namespace core
+{
+
+class CTaskGroup;
+class CTaskScheduler;
+
+//! Unit of work executed by a CTaskScheduler, always allocated with _IRR_NEW and owned by the scheduler after submission
+class ITask
+{
+    public:
+        virtual ~ITask() {}
+
+        virtual void execute() = 0;
+
+    private:
+        friend class CTaskScheduler;
+        friend class CTaskGroup;
+
+        CTaskGroup* m_group = nullptr;
+};
+
+namespace impl
+{
+    template<typename F>
+    class CCallableTask final : public ITask
+    {
+            F m_callable;
+
+        public:
+            CCallableTask(F&& _callable) : m_callable(std::move(_callable)) {}
+            CCallableTask(const F& _callable) : m_callable(_callable) {}
+
+            void execute() override { m_callable(); }
+    };
+
+    template<typename F>
+    inline ITask* createCallableTask(F&& _callable)
+    {
+        using task_t = CCallableTask<std::decay_t<F> >;
+        // spelled out because _IRR_NEW cannot be used with a dependent type
+        return AlignedWithAllocator<task_t>::new_(_IRR_DEFAULT_ALIGNMENT(task_t),core::allocator<task_t>(),std::forward<F>(_callable));
+    }
+}
+
+//! Work-stealing thread pool.
+/** Every worker owns a deque, it pushes and pops tasks at the back (LIFO for cache locality),
+while idle workers steal from the front of other workers' deques (FIFO, so the biggest chunks of work get stolen).
+Tasks submitted from threads which are not workers of this scheduler land in a shared injection queue.
+
+Threads in CTaskGroup::wait() execute pending tasks and only go to sleep once there are none left to take,
+so nested parallelism (a task waiting on its own children) cannot deadlock.
+There is always at least one worker, so fire-and-forget tasks and tasks which are only polled for still make progress.
+*/
+class CTaskScheduler : public IReferenceCounted
+{
+    public:
+        //! Sentinel meaning "one worker per hardware thread minus the calling thread, but at least one"
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t DefaultWorkerCount = 0xffffffffu;
+
+        explicit CTaskScheduler(uint32_t _workerCount=DefaultWorkerCount);
+
+        //! Process-wide scheduler shared by the engine's loaders and CPU-side converters, created on first use
+        static CTaskScheduler* getDefault();
+
+        //! Amount of dedicated worker threads (the threads calling `wait()` help in addition to these)
+        inline uint32_t getWorkerCount() const { return m_workerCount; }
+
+        //! Amount of threads that can be executing tasks at the same time, useful for choosing a grain size
+        inline uint32_t getConcurrency() const { return m_workerCount+1u; }
+
+        //! Returns the index of the calling thread if its a worker of this scheduler, `getWorkerCount()` otherwise
+        uint32_t getCurrentWorkerIndex() const;
+
+        //! Fire and forget, use CTaskGroup if you need to wait for completion
+        template<typename F>
+        inline void run(F&& _callable)
+        {
+            submit(impl::createCallableTask(std::forward<F>(_callable)));
+        }
+
+        //! Takes ownership of the task, it gets deleted after execution
+        void submit(ITask* _task);
+
+        //! Pops or steals a single task and executes it on the calling thread
+        /** @returns false if no task was available. */
+        bool tryExecuteOne();
+
+    protected:
+        virtual ~CTaskScheduler();
+
+    private:
+        struct alignas(64) SWorkerQueue
+        {
+            fast_mutex lock;
+            deque<ITask*> tasks;
+
+            inline void push(ITask* _task)
+            {
+                std::unique_lock<fast_mutex> lk(lock);
+                tasks.push_back(_task);
+            }
+            //! owner end
+            inline ITask* pop()
+            {
+                std::unique_lock<fast_mutex> lk(lock);
+                if (tasks.empty())
+                    return nullptr;
+                ITask* retval = tasks.back();
+                tasks.pop_back();
+                return retval;
+            }
+            //! thief end, non-blocking steals skip queues which are momentarily locked
+            inline ITask* steal(bool _blocking)
+            {
+                std::unique_lock<fast_mutex> lk(lock,std::defer_lock);
+                if (_blocking)
+                    lk.lock();
+                else if (!lk.try_lock())
+                    return nullptr;
+                if (tasks.empty())
+                    return nullptr;
+                ITask* retval = tasks.front();
+                tasks.pop_front();
+                return retval;
+            }
+        };
+
+        ITask* acquireTask(uint32_t _workerIx);
+        void execute(ITask* _task);
+        void workerLoop(uint32_t _workerIx);
+
+        uint32_t m_workerCount;
+        //! `m_workerCount` worker queues followed by the injection queue for external threads
+        SWorkerQueue* m_queues;
+        vector<std::thread> m_threads;
+
+        std::atomic<uint32_t> m_queuedTasks;
+        std::atomic<bool> m_exiting;
+        std::mutex m_sleepLock;
+        std::condition_variable m_sleepCondition;
+};
+
+
+//! Tracks completion of a set of tasks, optionally followed by a continuation.
+/** Must outlive all of its tasks, which is guaranteed by the destructor calling `wait()`. */
+class CTaskGroup : public Uncopyable
+{
+    public:
+        CTaskGroup(CTaskScheduler* _scheduler=CTaskScheduler::getDefault()) : m_scheduler(_scheduler), m_pending(0u), m_continuation(nullptr) {}
+        ~CTaskGroup()
+        {
+            wait();
+        }
+
+        inline CTaskScheduler* getScheduler() const { return m_scheduler; }
+
+        template<typename F>
+        inline void run(F&& _callable)
+        {
+            submit(impl::createCallableTask(std::forward<F>(_callable)));
+        }
+
+        //! Takes ownership of the task
+        inline void submit(ITask* _task)
+        {
+            _task->m_group = this;
+            m_pending++;
+            m_scheduler->submit(_task);
+        }
+
+        //! Schedules `_callable` as part of this group once every task submitted so far has finished
+        /** Only one continuation can be pending at a time, if the group is already idle it is submitted right away.
+        `wait()` also waits for the continuation (and anything it submits to this group). */
+        template<typename F>
+        inline void then(F&& _callable)
+        {
+            ITask* task = impl::createCallableTask(std::forward<F>(_callable));
+            task->m_group = this;
+
+            std::unique_lock<fast_mutex> lk(m_continuationLock);
+            _IRR_DEBUG_BREAK_IF(m_continuation!=nullptr);
+            if (m_pending.load()==0u)
+            {
+                m_pending++;
+                lk.unlock();
+                m_scheduler->submit(task);
+            }
+            else
+                m_continuation = task;
+        }
+
+        //! Non-blocking completion check
+        inline bool isDone() const
+        {
+            if (m_pending.load()!=0u)
+                return false;
+            std::unique_lock<fast_mutex> lk(m_continuationLock);
+            return m_pending.load()==0u && !m_continuation;
+        }
+
+        //! Executes pending tasks on the calling thread until the group is done
+        /** Once there is nothing left to take, the rest of the group is running on other threads and the caller sleeps until it finishes. */
+        inline void wait()
+        {
+            while (!isDone())
+            {
+                if (m_scheduler->tryExecuteOne())
+                    continue;
+
+                // the timeout makes us look for work again, in case a task submitted meanwhile by a thread which never waits is the one we need
+                std::unique_lock<fast_mutex> lk(m_continuationLock);
+                m_idleCondition.wait_for(lk,std::chrono::milliseconds(1),[this]() {return m_pending.load()==0u && !m_continuation;});
+            }
+        }
+
+    private:
+        friend class CTaskScheduler;
+
+        //! Only the decrement which may bring the count to zero takes the lock
+        inline void finishTask()
+        {
+            uint32_t pending = m_pending.load();
+            while (pending>1u)
+            {
+                if (m_pending.compare_exchange_weak(pending,pending-1u))
+                    return;
+            }
+
+            // the last decrement happens under the lock so that a waiter can never observe an idle group and destroy it while we still touch it
+            CTaskScheduler* scheduler = m_scheduler;
+            std::unique_lock<fast_mutex> lk(m_continuationLock);
+            if (m_pending.fetch_sub(1u)!=1u)
+                return;
+            if (!m_continuation)
+            {
+                m_idleCondition.notify_all();
+                return;
+            }
+
+            ITask* continuation = m_continuation;
+            m_continuation = nullptr;
+            m_pending++;
+            lk.unlock();
+            scheduler->submit(continuation);
+        }
+
+        CTaskScheduler* m_scheduler;
+        std::atomic<uint32_t> m_pending;
+        mutable fast_mutex m_continuationLock;
+        //! signalled under `m_continuationLock` when the group becomes idle
+        std::condition_variable m_idleCondition;
+        ITask* m_continuation;
+};
+
+} // end namespace core
+} // end namespace irr
+
+#endif
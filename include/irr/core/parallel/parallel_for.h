@@ -0,0 +1,68 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_PARALLEL_FOR_H_INCLUDED__
+#define __IRR_PARALLEL_FOR_H_INCLUDED__
+
+#include "irr/core/math/irrMath.h"
+#include "irr/core/parallel/CTaskScheduler.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Picks a grain size giving every thread a few chunks so that stealing can even out the imbalance
+inline size_t parallel_for_default_grain(size_t _count, const CTaskScheduler* _scheduler)
+{
+    const size_t chunks = size_t(_scheduler->getConcurrency())*4u;
+    return core::max_<size_t>((_count+chunks-1u)/chunks,1u);
+}
+
+//! Calls `_f(rangeBegin,rangeEnd)` for consecutive subranges of [_begin,_end) of at most `_grain` indices, and blocks until all are done
+/** The calling thread participates, so this is safe to call from inside a task.
+If `_grain` is 0 a default is chosen with `parallel_for_default_grain`. */
+template<typename IndexT, typename F>
+inline void parallel_for_range(IndexT _begin, IndexT _end, F&& _f, size_t _grain=0u, CTaskScheduler* _scheduler=CTaskScheduler::getDefault())
+{
+    if (_end<=_begin)
+        return;
+
+    const size_t count = size_t(_end-_begin);
+    if (_grain==0u)
+        _grain = parallel_for_default_grain(count,_scheduler);
+    if (count<=_grain || _scheduler->getWorkerCount()==0u)
+    {
+        _f(_begin,_end);
+        return;
+    }
+
+    CTaskGroup group(_scheduler);
+    // keep the first chunk for ourselves
+    for (size_t offset=_grain; offset<count; offset+=_grain)
+    {
+        const IndexT chunkBegin = _begin+IndexT(offset);
+        const IndexT chunkEnd = _begin+IndexT(core::min_<size_t>(offset+_grain,count));
+        group.run([&_f,chunkBegin,chunkEnd]() {_f(chunkBegin,chunkEnd);});
+    }
+    _f(_begin,_begin+IndexT(_grain));
+    group.wait();
+}
+
+//! Calls `_f(index)` for every index in [_begin,_end), see `parallel_for_range`
+template<typename IndexT, typename F>
+inline void parallel_for(IndexT _begin, IndexT _end, F&& _f, size_t _grain=0u, CTaskScheduler* _scheduler=CTaskScheduler::getDefault())
+{
+    parallel_for_range(_begin,_end,[&_f](IndexT _rangeBegin, IndexT _rangeEnd)
+        {
+            for (IndexT i=_rangeBegin; i<_rangeEnd; i++)
+                _f(i);
+        },_grain,_scheduler
+    );
+}
+
+} // end namespace core
+} // end namespace irr
+
+#endif
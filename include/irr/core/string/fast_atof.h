@@ -0,0 +1,204 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_FAST_ATOF_H_INCLUDED__
+#define __IRR_FAST_ATOF_H_INCLUDED__
+
+#include <cstring>
+#include <limits>
+
+#include "IrrCompileConfig.h"
+#include "irr/core/Types.h"
+#include "irr/core/math/irrMath.h"
+
+namespace irr
+{
+namespace core
+{
+
+namespace impl
+{
+    //! Converts exactly 8 ASCII digits at once (SWAR), most significant digit first
+    inline uint32_t parse8Digits(const char* _str)
+    {
+        uint64_t val;
+        memcpy(&val,_str,sizeof(val));
+        val = (val&0x0F0F0F0F0F0F0F0Full)*2561ull>>8u;
+        val = (val&0x00FF00FF00FF00FFull)*6553601ull>>16u;
+        return uint32_t((val&0x0000FFFF0000FFFFull)*42949672960001ull>>32u);
+    }
+
+    //! Length of the run of decimal digits starting at `_str`
+    inline size_t digitRunLength(const char* _str, const char* const _end)
+    {
+        const char* it = _str;
+#ifdef __IRR_COMPILE_WITH_X86_SIMD_
+        // 16 characters at a time, (c-'0') as unsigned is a digit iff <=9
+        const __m128i zeroChar = _mm_set1_epi8('0');
+        const __m128i nine = _mm_set1_epi8(9);
+        while (_end-it>=16)
+        {
+            const __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)),zeroChar);
+            const uint32_t isDigit = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(digits,nine),digits)));
+            if (isDigit!=0xffffu)
+                return size_t(it-_str)+size_t(core::findLSB<uint32_t>(~isDigit));
+            it += 16;
+        }
+#endif
+        while (it!=_end && uint8_t(*it-'0')<=9u)
+            it++;
+        return size_t(it-_str);
+    }
+
+    //! Accumulates a run of digits into `_mantissa`, digits which don't fit into 19 significant ones only bump `_droppedDigits`
+    inline void accumulateDigits(const char* _str, size_t _count, uint64_t& _mantissa, uint32_t& _significantDigits, int32_t& _droppedDigits)
+    {
+        // leading zeroes are not significant
+        if (_significantDigits==0u)
+        {
+            while (_count && *_str=='0')
+            {
+                _str++;
+                _count--;
+            }
+        }
+
+        const size_t room = _significantDigits<19u ? (19u-_significantDigits):0u;
+        const size_t taken = _count<room ? _count:room;
+        size_t i = 0u;
+        for (; i+8u<=taken; i+=8u)
+            _mantissa = _mantissa*100000000ull+parse8Digits(_str+i);
+        for (; i<taken; i++)
+            _mantissa = _mantissa*10ull+uint64_t(_str[i]-'0');
+        _significantDigits += uint32_t(taken);
+        _droppedDigits += int32_t(_count-taken);
+    }
+
+    inline double pow10(int32_t _exp)
+    {
+        static const double exact[] = {
+            1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+            1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22
+        };
+        const bool negative = _exp<0;
+        uint32_t e = negative ? uint32_t(-_exp):uint32_t(_exp);
+        double retval = 1.0;
+        for (; e>22u; e-=22u)
+            retval *= exact[22];
+        retval *= exact[e];
+        return negative ? 1.0/retval:retval;
+    }
+}
+
+//! Locale-independent decimal floating point parser, does not need the input to be null-terminated.
+/** Parses `[+-]digits[.digits][(e|E)[+-]digits]` (either digit group may be empty, but not both) starting at `_in`.
+Numbers with up to 15 significant digits and a decimal exponent within [-22,22] are converted exactly to double (and then rounded to float),
+other numbers come out within a few ULPs of the double nearest to them, which makes no difference after rounding to float for any realistic input.
+@param _out receives 0 on failure
+@returns pointer past the last consumed character, equal to `_in` if no number could be parsed. */
+inline const char* fast_atof_move(const char* _in, const char* const _end, float& _out)
+{
+    _out = 0.f;
+    const char* it = _in;
+    if (it==_end)
+        return _in;
+
+    const bool negative = *it=='-';
+    if (negative || *it=='+')
+        it++;
+
+    uint64_t mantissa = 0ull;
+    uint32_t significantDigits = 0u;
+    int32_t exponent = 0;
+
+    size_t count = impl::digitRunLength(it,_end);
+    size_t totalDigits = count;
+    impl::accumulateDigits(it,count,mantissa,significantDigits,exponent);
+    it += count;
+
+    if (it!=_end && *it=='.')
+    {
+        it++;
+        count = impl::digitRunLength(it,_end);
+        totalDigits += count;
+        int32_t dropped = 0;
+        impl::accumulateDigits(it,count,mantissa,significantDigits,dropped);
+        // every fractional digit which made it into the mantissa shifts the decimal point
+        exponent -= int32_t(count)-dropped;
+        it += count;
+    }
+    if (totalDigits==0u)
+        return _in;
+
+    if (it!=_end && (*it=='e' || *it=='E'))
+    {
+        const char* expIt = it+1;
+        const bool negativeExp = expIt!=_end && *expIt=='-';
+        if (expIt!=_end && (*expIt=='-' || *expIt=='+'))
+            expIt++;
+        count = impl::digitRunLength(expIt,_end);
+        // "1e" or "1e+" is just 1 followed by garbage
+        if (count)
+        {
+            int32_t exp10 = 0;
+            for (size_t i=0u; i<count && exp10<100000; i++)
+                exp10 = exp10*10+int32_t(expIt[i]-'0');
+            exponent += negativeExp ? -exp10:exp10;
+            it = expIt+count;
+        }
+    }
+
+    double value = double(mantissa);
+    if (mantissa)
+    {
+        if (exponent<-(std::numeric_limits<double>::max_exponent10+20))
+            value = 0.0;
+        else if (exponent>std::numeric_limits<double>::max_exponent10)
+            value = std::numeric_limits<double>::infinity();
+        else if (exponent<0)
+            value /= impl::pow10(-exponent); // division by an exact power of ten is correctly rounded, multiplication by its reciprocal isn't
+        else
+            value *= impl::pow10(exponent);
+    }
+    _out = float(negative ? -value:value);
+    return it;
+}
+
+//! Convenience overload for null-terminated strings
+inline float fast_atof(const char* _in)
+{
+    float retval;
+    fast_atof_move(_in,_in+strlen(_in),retval);
+    return retval;
+}
+
+//! Parses an optionally signed decimal integer, see fast_atof_move
+inline const char* fast_atoi_move(const char* _in, const char* const _end, int32_t& _out)
+{
+    _out = 0;
+    const char* it = _in;
+    if (it==_end)
+        return _in;
+
+    const bool negative = *it=='-';
+    if (negative || *it=='+')
+        it++;
+
+    const size_t count = impl::digitRunLength(it,_end);
+    if (count==0u)
+        return _in;
+
+    int64_t value = 0;
+    for (size_t i=0u; i<count && value<=std::numeric_limits<int32_t>::max(); i++)
+        value = value*10+int64_t(it[i]-'0');
+    if (value>std::numeric_limits<int32_t>::max())
+        value = std::numeric_limits<int32_t>::max();
+    _out = int32_t(negative ? -value:value);
+    return it+count;
+}
+
+} // end namespace core
+} // end namespace irr
+
+#endif
@@ -68,6 +68,9 @@ public:
 	//! Returns type of the scene node
 	virtual ESCENE_NODE_TYPE getType() const { return ESNT_BILLBOARD; }
 
+	//! Neither OnAnimate() nor updateAbsolutePosition() are overridden, so the scene manager may animate it level by level
+	virtual bool supportsLevelOrderedUpdate() const { return true; }
+
 	//! Creates a clone of this scene node and its children.
 	virtual ISceneNode* clone(IDummyTransformationSceneNode* newParent=0, ISceneManager* newManager=0) { assert(false); return nullptr; }
 
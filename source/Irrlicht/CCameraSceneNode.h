@@ -119,6 +119,9 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const { return ESNT_CAMERA; }
 
+		//! Neither OnAnimate() nor updateAbsolutePosition() are overridden, so the scene manager may animate it level by level
+		virtual bool supportsLevelOrderedUpdate() const { return true; }
+
 		//! Binds the camera scene node's rotation to its target position and vice vera, or unbinds them.
 		virtual void bindTargetAndRotation(bool bound);
 
@@ -6,6 +6,7 @@
 #include <list>
 #include "CFileSystem.h"
 #include "CReadFile.h"
+#include "CMappedReadFile.h"
 #include "IWriteFile.h"
 #include "CZipReader.h"
 #include "CMountPointReader.h"
@@ -114,9 +115,23 @@ IReadFile* CFileSystem::createAndOpenFile(const io::path& filename)
 
 	// Create the file using an absolute path so that it matches
 	// the scheme used by CNullDriver::getTexture().
-    file = new CReadFile(getAbsolutePath(filename));
+    const io::path absolutePath = getAbsolutePath(filename);
+    file = new CReadFile(absolutePath);
     if (static_cast<CReadFile*>(file)->isOpen())
+    {
+        // big files get memory-mapped, so loaders can parse them in place
+        if (file->getSize() >= MinMappedFileSize)
+        {
+            CMappedReadFile* mapped = new CMappedReadFile(absolutePath);
+            if (mapped->isOpen())
+            {
+                file->drop();
+                return mapped;
+            }
+            mapped->drop();
+        }
         return file;
+    }
 
     file->drop();
     return 0;
@@ -25,6 +25,8 @@ class CFileSystem : public IFileSystem
         //! destructor
         virtual ~CFileSystem();
     public:
+        //! Files at least this big are memory-mapped by createAndOpenFile, smaller ones are cheaper to just read
+        _IRR_STATIC_INLINE_CONSTEXPR size_t MinMappedFileSize = 0x1u<<20u;
 
         //! constructor
         CFileSystem();
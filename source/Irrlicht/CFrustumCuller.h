@@ -0,0 +1,300 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_FRUSTUM_CULLER_H_INCLUDED__
+#define __C_FRUSTUM_CULLER_H_INCLUDED__
+
+#include "SViewFrustum.h"
+#include "ECullingTypes.h"
+#include "irr/core/parallel/parallel_for.h"
+
+namespace irr
+{
+namespace scene
+{
+
+    //! Culls many bounding boxes against a view frustum, four boxes at a time
+    /**
+        Boxes get queued with their local bounds, a pointer to their world transformation and the E_CULLING_TYPE flags of their node.
+        cull() then transforms all of them into world space AABBs kept as a packed structure-of-arrays (one array per min/max component),
+        and tests one SSE register of boxes against each frustum plane (and the frustum's bounding box for EAC_BOX) at a time.
+        The boxes are split across the task scheduler's threads, each thread transforms and tests its own range.
+        cullBox() tests a single box right away instead, for callers which need the answer before the whole batch is known.
+
+        Does the same tests as ISceneManager::isCulled, but never touches a scene node or the video driver,
+        so it runs just as well with the null driver.
+    */
+    class CFrustumCuller
+    {
+        public:
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t BatchSize = 4u;
+            //! roughly how many boxes a worker thread should get in one go
+            _IRR_STATIC_INLINE_CONSTEXPR size_t BoxGrain = 2048u;
+
+            //! Forgets all boxes, keeps the memory
+            inline void clear()
+            {
+                LocalBoxes.clear();
+                WorldTransforms.clear();
+                CullingTypes.clear();
+            }
+
+            inline size_t getBoxCount() const {return LocalBoxes.size();}
+
+            //! Queues a box for the next cull()
+            /** \param _world Has to stay valid until cull() returns.
+            \return Index of the box, for isVisible() and getWorldBox(). */
+            inline uint32_t addBox(const core::aabbox3df& _localBox, const core::matrix4x3* _world, const uint32_t& _cullingType)
+            {
+                const uint32_t index = LocalBoxes.size();
+                LocalBoxes.push_back(_localBox);
+                WorldTransforms.push_back(_world);
+                // degenerate boxes always get culled, like in isCulled
+                CullingTypes.push_back((_cullingType&(EAC_BOX|EAC_FRUSTUM_BOX))|(_localBox.MinEdge==_localBox.MaxEdge ? uint32_t(ECF_EMPTY):0u));
+                return index;
+            }
+
+            //! Prepares the frustum the boxes get tested against, by cull() and cullBox()
+            /** \param _frustum Nothing gets culled if this is null (no active camera). */
+            inline void setFrustum(const SViewFrustum* _frustum)
+            {
+                HasFrustum = _frustum!=nullptr;
+                if (!HasFrustum)
+                    return;
+
+                for (uint32_t i=0u; i<SViewFrustum::VF_PLANE_COUNT; i++)
+                {
+                    const float* plane = reinterpret_cast<const float*>(_frustum->planes+i);
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        Planes.Normal[i][j] = _mm_set1_ps(plane[j]);
+                        // component of the corner furthest along the normal
+                        Planes.PositiveComponent[i][j] = plane[j]>0.f ? EWB_MAX_X+j:EWB_MIN_X+j;
+                    }
+                    Planes.Distance[i] = _mm_set1_ps(plane[3]);
+                }
+                const core::aabbox3df& frustumBox = _frustum->getBoundingBox();
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    Planes.BoxMin[j] = _mm_set1_ps((&frustumBox.MinEdge.X)[j]);
+                    Planes.BoxMax[j] = _mm_set1_ps((&frustumBox.MaxEdge.X)[j]);
+                }
+            }
+
+            //! Transforms all queued boxes to world space and culls them
+            /** \param _frustum Nothing gets culled if this is null (no active camera). */
+            inline void cull(const SViewFrustum* _frustum)
+            {
+                const size_t boxCount = LocalBoxes.size();
+                const size_t paddedCount = (boxCount+BatchSize-1u)&~size_t(BatchSize-1u);
+                for (auto& component : WorldBounds)
+                    component.resize(paddedCount);
+                Visible.resize(paddedCount);
+                setFrustum(_frustum);
+                if (!HasFrustum)
+                {
+                    std::fill(Visible.begin(),Visible.end(),1u);
+                    return;
+                }
+
+                core::parallel_for_range<size_t>(0u,paddedCount/BatchSize,[&](size_t rangeBegin, size_t rangeEnd)
+                    {
+                        for (size_t batch=rangeBegin; batch<rangeEnd; batch++)
+                            cullBatch(batch*BatchSize,core::min_<size_t>(boxCount-batch*BatchSize,BatchSize));
+                    },BoxGrain/BatchSize
+                );
+            }
+
+            //! Tests a single box right away against the frustum given to the last setFrustum() or cull(), without queueing it
+            /** Same sums in the same order as cull(), so the two always agree.
+            \return Whether the box is visible. */
+            inline bool cullBox(const core::aabbox3df& _localBox, const core::matrix4x3& _world, const uint32_t& _cullingType) const
+            {
+                if (!HasFrustum)
+                    return true;
+                // degenerate boxes always get culled, like in isCulled
+                if (_localBox.MinEdge==_localBox.MaxEdge)
+                    return false;
+
+                const float* matrix = reinterpret_cast<const float*>(&_world);
+                const float* localMin = &_localBox.MinEdge.X;
+                const float* localMax = &_localBox.MaxEdge.X;
+                float bounds[EWB_COUNT];
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    float minSum = 0.f, maxSum = 0.f;
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        const float element = matrix[j*3u+i];
+                        const float minTerm = element*(element<0.f ? localMax[j]:localMin[j]);
+                        const float maxTerm = element*(element<0.f ? localMin[j]:localMax[j]);
+                        minSum = j ? minSum+minTerm:minTerm;
+                        maxSum = j ? maxSum+maxTerm:maxTerm;
+                    }
+                    bounds[EWB_MIN_X+i] = minSum+matrix[9u+i];
+                    bounds[EWB_MAX_X+i] = maxSum+matrix[9u+i];
+                }
+
+                if (_cullingType&EAC_BOX)
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    if (bounds[EWB_MIN_X+j]>_mm_cvtss_f32(Planes.BoxMax[j]) || bounds[EWB_MAX_X+j]<_mm_cvtss_f32(Planes.BoxMin[j]))
+                        return false;
+                }
+
+                if (_cullingType&EAC_FRUSTUM_BOX)
+                for (uint32_t i=0u; i<SViewFrustum::VF_PLANE_COUNT; i++)
+                {
+                    float distance = _mm_cvtss_f32(Planes.Distance[i]);
+                    for (uint32_t j=0u; j<3u; j++)
+                        distance += _mm_cvtss_f32(Planes.Normal[i][j])*bounds[Planes.PositiveComponent[i][j]];
+                    if (distance<0.f)
+                        return false;
+                }
+                return true;
+            }
+
+            //! Whether the box survived the last cull()
+            inline bool isVisible(const uint32_t& _index) const {return Visible[_index];}
+
+            //! World space bounds of a box, as computed by the last cull() (not computed if there was no frustum)
+            inline core::aabbox3df getWorldBox(const uint32_t& _index) const
+            {
+                return core::aabbox3df( WorldBounds[EWB_MIN_X][_index],WorldBounds[EWB_MIN_Y][_index],WorldBounds[EWB_MIN_Z][_index],
+                                        WorldBounds[EWB_MAX_X][_index],WorldBounds[EWB_MAX_Y][_index],WorldBounds[EWB_MAX_Z][_index]);
+            }
+
+        private:
+            enum E_CULLING_FLAGS : uint8_t
+            {
+                ECF_EMPTY = 0x80u
+            };
+            static_assert((EAC_BOX|EAC_FRUSTUM_BOX)<ECF_EMPTY,"E_CULLING_TYPE flags overlap with internal ones!");
+
+            enum E_WORLD_BOUND
+            {
+                EWB_MIN_X = 0,
+                EWB_MIN_Y,
+                EWB_MIN_Z,
+                EWB_MAX_X,
+                EWB_MAX_Y,
+                EWB_MAX_Z,
+                EWB_COUNT
+            };
+
+            //! the frustum splatted across all lanes
+            struct SPlanes
+            {
+                __m128 Normal[SViewFrustum::VF_PLANE_COUNT][3];
+                __m128 Distance[SViewFrustum::VF_PLANE_COUNT];
+                uint32_t PositiveComponent[SViewFrustum::VF_PLANE_COUNT][3];
+                __m128 BoxMin[3];
+                __m128 BoxMax[3];
+            };
+
+            inline void cullBatch(const size_t& _first, const size_t& _count)
+            {
+                // gather 4 matrices and boxes and transpose them into one register per element, padding lanes repeat the first box
+                __m128 matrix[12];
+                __m128 localMin[3], localMax[3];
+                uint32_t boxCulling = 0u, frustumCulling = 0u, empty = 0u;
+                {
+                    const float* matrices[BatchSize];
+                    const float* boxes[BatchSize];
+                    for (size_t lane=0u; lane<BatchSize; lane++)
+                    {
+                        const size_t i = _first+(lane<_count ? lane:0u);
+                        matrices[lane] = reinterpret_cast<const float*>(WorldTransforms[i]);
+                        boxes[lane] = &LocalBoxes[i].MinEdge.X;
+                        if (lane<_count)
+                        {
+                            boxCulling |= (CullingTypes[i]&EAC_BOX ? 1u:0u)<<lane;
+                            frustumCulling |= (CullingTypes[i]&EAC_FRUSTUM_BOX ? 1u:0u)<<lane;
+                            empty |= (CullingTypes[i]&ECF_EMPTY ? 1u:0u)<<lane;
+                        }
+                    }
+
+                    // matrix4x3 is 4 columns of 3 floats
+                    for (uint32_t k=0u; k<12u; k+=4u)
+                    {
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                            matrix[k+lane] = _mm_loadu_ps(matrices[lane]+k);
+                        _MM_TRANSPOSE4_PS(matrix[k],matrix[k+1u],matrix[k+2u],matrix[k+3u]);
+                    }
+                    // aabbox3df is 6 floats, load the first and last 4
+                    __m128 lower[4], upper[4];
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                    {
+                        lower[lane] = _mm_loadu_ps(boxes[lane]);
+                        upper[lane] = _mm_loadu_ps(boxes[lane]+2u);
+                    }
+                    _MM_TRANSPOSE4_PS(lower[0],lower[1],lower[2],lower[3]);
+                    _MM_TRANSPOSE4_PS(upper[0],upper[1],upper[2],upper[3]);
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        localMin[j] = lower[j];
+                        localMax[j] = upper[j+1u];
+                    }
+                }
+
+                // same sums in the same order as matrix4x3::transformBoxEx
+                __m128 bounds[EWB_COUNT];
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    __m128 minSum, maxSum;
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        const __m128 element = matrix[j*3u+i];
+                        const __m128 negative = _mm_cmplt_ps(element,_mm_setzero_ps());
+                        const __m128 minTerm = _mm_mul_ps(element,_mm_blendv_ps(localMin[j],localMax[j],negative));
+                        const __m128 maxTerm = _mm_mul_ps(element,_mm_blendv_ps(localMax[j],localMin[j],negative));
+                        minSum = j ? _mm_add_ps(minSum,minTerm):minTerm;
+                        maxSum = j ? _mm_add_ps(maxSum,maxTerm):maxTerm;
+                    }
+                    bounds[EWB_MIN_X+i] = _mm_add_ps(minSum,matrix[9u+i]);
+                    bounds[EWB_MAX_X+i] = _mm_add_ps(maxSum,matrix[9u+i]);
+                }
+                for (uint32_t j=0u; j<EWB_COUNT; j++)
+                    _mm_storeu_ps(WorldBounds[j].data()+_first,bounds[j]);
+
+                // EAC_BOX, the frustum's bounding box
+                __m128 outside = _mm_setzero_ps();
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    outside = _mm_or_ps(outside,_mm_cmpgt_ps(bounds[EWB_MIN_X+j],Planes.BoxMax[j]));
+                    outside = _mm_or_ps(outside,_mm_cmplt_ps(bounds[EWB_MAX_X+j],Planes.BoxMin[j]));
+                }
+                uint32_t culled = boxCulling&uint32_t(_mm_movemask_ps(outside));
+
+                // EAC_FRUSTUM_BOX, the corner furthest along each plane's normal has to be on the inside
+                outside = _mm_setzero_ps();
+                for (uint32_t i=0u; i<SViewFrustum::VF_PLANE_COUNT; i++)
+                {
+                    __m128 distance = Planes.Distance[i];
+                    for (uint32_t j=0u; j<3u; j++)
+                        distance = _mm_add_ps(distance,_mm_mul_ps(Planes.Normal[i][j],bounds[Planes.PositiveComponent[i][j]]));
+                    outside = _mm_or_ps(outside,_mm_cmplt_ps(distance,_mm_setzero_ps()));
+                }
+                culled |= frustumCulling&uint32_t(_mm_movemask_ps(outside));
+                culled |= empty;
+
+                for (size_t lane=0u; lane<BatchSize; lane++)
+                    Visible[_first+lane] = (culled>>lane)&0x1u ? 0u:1u;
+            }
+
+            core::vector<core::aabbox3df> LocalBoxes;
+            core::vector<const core::matrix4x3*> WorldTransforms;
+            core::vector<uint8_t> CullingTypes;
+
+            core::vector<float> WorldBounds[EWB_COUNT];
+            core::vector<uint8_t> Visible;
+
+            SPlanes Planes;
+            bool HasFrustum = false;
+    };
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -0,0 +1,327 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_INSTANCE_LOD_CULLER_H_INCLUDED__
+#define __C_INSTANCE_LOD_CULLER_H_INCLUDED__
+
+#include "SViewFrustum.h"
+#include "irr/core/parallel/parallel_for.h"
+
+namespace irr
+{
+namespace scene
+{
+
+    //! CPU counterpart of the transform feedback culling and LoD selection pass of IMeshSceneNodeInstanced
+    /**
+        classify() reads the instances' transforms straight out of the node's interleaved instance input data, four instances at a time,
+        and concatenates them with the node's transformation into a packed array of world transforms (survivors only) and a packed structure-of-arrays of
+        world AABBs of the LoD invariant box. Instances get culled by their AABB against the six frustum planes, then the squared distance
+        from the eye to the center of their box picks the first LoD whose squared distance is larger (past the last one they get culled),
+        exactly like the culling shader in examples_tests/08.HardwareInstancing. Instances with their visibility byte cleared always get culled.
+
+        The instances are split into fixed chunks across the task scheduler's threads, every chunk counts its instances per LoD,
+        so write() can scatter the survivors into one tightly packed list per LoD (in instance order) without any synchronization.
+        Never touches the video driver, so it runs just as well headless.
+    */
+    class CInstanceLoDCuller
+    {
+        public:
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t BatchSize = 4u;
+            //! instances per chunk, multiple of BatchSize
+            _IRR_STATIC_INLINE_CONSTEXPR size_t InstanceGrain = 1024u;
+            //! LoD of a culled instance, also the maximum LoD count
+            _IRR_STATIC_INLINE_CONSTEXPR uint8_t CulledLoD = 0xffu;
+
+            //! Sets the box all instances share and the squared LoD distances, which have to be increasing
+            inline void setLoDs(const core::aabbox3df& _lodInvariantBox, const float* _lodDistancesSQ, const uint32_t& _lodCount)
+            {
+                _IRR_DEBUG_BREAK_IF(_lodCount>=CulledLoD);
+                LoDInvariantBox = _lodInvariantBox;
+                LoDDistancesSQ.assign(_lodDistancesSQ,_lodDistancesSQ+_lodCount);
+                LoDCounts.assign(_lodCount,0u);
+                LoDFirstInstances.assign(_lodCount,0u);
+            }
+
+            inline uint32_t getLoDCount() const {return LoDDistancesSQ.size();}
+
+            //! Culls instances and assigns them LoDs
+            /** \param _instanceData First instance's input data, starting with its matrix4x3, has to stay valid until write() returns.
+            \param _stride Distance between two instances' input data.
+            \param _visibilityOffset Offset of the byte which culls an instance when zero.
+            \param _nodeTransform Transformation of the node, instance transforms are relative to it.
+            \param _frustum World space frustum, nothing gets frustum culled if null.
+            \param _eyePosition Position the LoD distances are measured from. */
+            inline void classify(   const uint8_t* _instanceData, const size_t& _instanceCount, const size_t& _stride, const size_t& _visibilityOffset,
+                                    const core::matrix4x3& _nodeTransform, const SViewFrustum* _frustum, const core::vector3df& _eyePosition)
+            {
+                InstanceData = _instanceData;
+                InstanceCount = _instanceCount;
+                Stride = _stride;
+                VisibilityOffset = _visibilityOffset;
+
+                const size_t paddedCount = (InstanceCount+BatchSize-1u)&~size_t(BatchSize-1u);
+                for (auto& component : WorldBounds)
+                    component.resize(paddedCount);
+                WorldTransforms.resize(paddedCount);
+                InstanceLoDs.resize(paddedCount);
+
+                const uint32_t lodCount = getLoDCount();
+                const size_t chunkCount = (InstanceCount+InstanceGrain-1u)/InstanceGrain;
+                ChunkLoDCounts.resize(chunkCount*lodCount);
+
+                SClassifyParams params;
+                for (uint32_t i=0u; i<3u; i++)
+                for (uint32_t j=0u; j<4u; j++)
+                    params.NodeTransform[j*3u+i] = _mm_set1_ps(_nodeTransform(i,j));
+                const core::vector3df center = LoDInvariantBox.getCenter();
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    params.LocalMin[j] = _mm_set1_ps((&LoDInvariantBox.MinEdge.X)[j]);
+                    params.LocalMax[j] = _mm_set1_ps((&LoDInvariantBox.MaxEdge.X)[j]);
+                    params.LocalCenter[j] = _mm_set1_ps((&center.X)[j]);
+                    params.Eye[j] = _mm_set1_ps((&_eyePosition.X)[j]);
+                }
+                for (uint32_t i=0u; i<SViewFrustum::VF_PLANE_COUNT; i++)
+                {
+                    // planes which can't cull anything when there's no frustum
+                    const float* plane = _frustum ? reinterpret_cast<const float*>(_frustum->planes+i):nullptr;
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        params.Normal[i][j] = _mm_set1_ps(plane ? plane[j]:0.f);
+                        params.PositiveComponent[i][j] = plane&&plane[j]<=0.f ? EWB_MIN_X+j:EWB_MAX_X+j;
+                    }
+                    params.Distance[i] = _mm_set1_ps(plane ? plane[3]:0.f);
+                }
+
+                core::parallel_for_range<size_t>(0u,chunkCount,[&](size_t rangeBegin, size_t rangeEnd)
+                    {
+                        for (size_t chunk=rangeBegin; chunk<rangeEnd; chunk++)
+                            classifyChunk(params,chunk);
+                    },1u
+                );
+
+                // every chunk's survivors of a LoD go right after the previous chunk's
+                std::fill(LoDCounts.begin(),LoDCounts.end(),0u);
+                for (size_t chunk=0u; chunk<chunkCount; chunk++)
+                for (uint32_t lod=0u; lod<lodCount; lod++)
+                {
+                    uint32_t& count = ChunkLoDCounts[chunk*lodCount+lod];
+                    const uint32_t chunkOffset = LoDCounts[lod];
+                    LoDCounts[lod] += count;
+                    count = chunkOffset;
+                }
+                VisibleCount = 0u;
+                for (uint32_t lod=0u; lod<lodCount; lod++)
+                {
+                    LoDFirstInstances[lod] = VisibleCount;
+                    VisibleCount += LoDCounts[lod];
+                }
+            }
+
+            //! Writes out the survivors of the last classify(), LoD by LoD
+            /** \param _output Where LoD 0's first instance goes, needs room for getVisibleInstanceCount() instances.
+            \param _outputStride Bytes per output instance.
+            \param _outputFunc Called as f(void* output, const core::matrix4x3& worldTransform, const uint8_t* instanceData, uint32_t lod)
+            for every survivor, from many threads at once. */
+            template<typename F>
+            inline void write(uint8_t* _output, const size_t& _outputStride, F&& _outputFunc) const
+            {
+                const uint32_t lodCount = getLoDCount();
+                const size_t chunkCount = (InstanceCount+InstanceGrain-1u)/InstanceGrain;
+                core::parallel_for_range<size_t>(0u,chunkCount,[&](size_t rangeBegin, size_t rangeEnd)
+                    {
+                        uint32_t next[CulledLoD];
+                        for (size_t chunk=rangeBegin; chunk<rangeEnd; chunk++)
+                        {
+                            for (uint32_t lod=0u; lod<lodCount; lod++)
+                                next[lod] = LoDFirstInstances[lod]+ChunkLoDCounts[chunk*lodCount+lod];
+
+                            const size_t end = core::min_<size_t>((chunk+1u)*InstanceGrain,InstanceCount);
+                            for (size_t i=chunk*InstanceGrain; i<end; i++)
+                            {
+                                const uint32_t lod = InstanceLoDs[i];
+                                if (lod==CulledLoD)
+                                    continue;
+                                _outputFunc(_output+(next[lod]++)*_outputStride,WorldTransforms[i],InstanceData+i*Stride,lod);
+                            }
+                        }
+                    },1u
+                );
+            }
+
+            //! How many instances of a LoD survived the last classify()
+            inline uint32_t getLoDInstanceCount(const uint32_t& _lod) const {return LoDCounts[_lod];}
+
+            //! Index of the first instance of a LoD in the output of write()
+            inline uint32_t getLoDFirstInstance(const uint32_t& _lod) const {return LoDFirstInstances[_lod];}
+
+            inline uint32_t getVisibleInstanceCount() const {return VisibleCount;}
+
+            //! LoD an instance got by the last classify(), or CulledLoD
+            inline uint8_t getInstanceLoD(const size_t& _index) const {return InstanceLoDs[_index];}
+
+            //! Node transform followed by the instance's, as computed by the last classify() (only for instances which weren't culled)
+            inline const core::matrix4x3& getWorldTransform(const size_t& _index) const {return WorldTransforms[_index];}
+
+            //! World space bounds of an instance, as computed by the last classify()
+            inline core::aabbox3df getWorldBox(const size_t& _index) const
+            {
+                return core::aabbox3df( WorldBounds[EWB_MIN_X][_index],WorldBounds[EWB_MIN_Y][_index],WorldBounds[EWB_MIN_Z][_index],
+                                        WorldBounds[EWB_MAX_X][_index],WorldBounds[EWB_MAX_Y][_index],WorldBounds[EWB_MAX_Z][_index]);
+            }
+
+        private:
+            enum E_WORLD_BOUND
+            {
+                EWB_MIN_X = 0,
+                EWB_MIN_Y,
+                EWB_MIN_Z,
+                EWB_MAX_X,
+                EWB_MAX_Y,
+                EWB_MAX_Z,
+                EWB_COUNT
+            };
+
+            //! everything splatted across all lanes
+            struct SClassifyParams
+            {
+                __m128 NodeTransform[12];
+                __m128 LocalMin[3];
+                __m128 LocalMax[3];
+                __m128 LocalCenter[3];
+                __m128 Eye[3];
+                __m128 Normal[SViewFrustum::VF_PLANE_COUNT][3];
+                __m128 Distance[SViewFrustum::VF_PLANE_COUNT];
+                uint32_t PositiveComponent[SViewFrustum::VF_PLANE_COUNT][3];
+            };
+
+            inline void classifyChunk(const SClassifyParams& _params, const size_t& _chunk)
+            {
+                const uint32_t lodCount = getLoDCount();
+                uint32_t* counts = ChunkLoDCounts.data()+_chunk*lodCount;
+                std::fill(counts,counts+lodCount,0u);
+
+                const size_t end = core::min_<size_t>((_chunk+1u)*InstanceGrain,InstanceCount);
+                for (size_t first=_chunk*InstanceGrain; first<end; first+=BatchSize)
+                {
+                    // gather 4 instance transforms and transpose them into one register per element, padding lanes repeat the first instance
+                    __m128 instance[12];
+                    uint32_t hidden = 0u;
+                    {
+                        const uint8_t* instances[BatchSize];
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                        {
+                            const bool valid = first+lane<end;
+                            instances[lane] = InstanceData+(valid ? first+lane:first)*Stride;
+                            hidden |= (valid&&instances[lane][VisibilityOffset] ? 0u:1u)<<lane;
+                        }
+                        // matrix4x3 is 4 columns of 3 floats
+                        for (uint32_t k=0u; k<12u; k+=4u)
+                        {
+                            for (uint32_t lane=0u; lane<BatchSize; lane++)
+                                instance[k+lane] = _mm_loadu_ps(reinterpret_cast<const float*>(instances[lane])+k);
+                            _MM_TRANSPOSE4_PS(instance[k],instance[k+1u],instance[k+2u],instance[k+3u]);
+                        }
+                    }
+
+                    // node transform followed by the instance's, element (i,j) lives in [j*3+i]
+                    __m128 world[12];
+                    for (uint32_t j=0u; j<4u; j++)
+                    for (uint32_t i=0u; i<3u; i++)
+                    {
+                        __m128 sum = _mm_mul_ps(_params.NodeTransform[i],instance[j*3u]);
+                        sum = _mm_add_ps(sum,_mm_mul_ps(_params.NodeTransform[3u+i],instance[j*3u+1u]));
+                        sum = _mm_add_ps(sum,_mm_mul_ps(_params.NodeTransform[6u+i],instance[j*3u+2u]));
+                        world[j*3u+i] = j<3u ? sum:_mm_add_ps(sum,_params.NodeTransform[9u+i]);
+                    }
+
+                    // same sums in the same order as matrix4x3::transformBoxEx
+                    __m128 bounds[EWB_COUNT];
+                    __m128 distanceSQ = _mm_setzero_ps();
+                    for (uint32_t i=0u; i<3u; i++)
+                    {
+                        __m128 minSum, maxSum, centerSum;
+                        for (uint32_t j=0u; j<3u; j++)
+                        {
+                            const __m128 element = world[j*3u+i];
+                            const __m128 negative = _mm_cmplt_ps(element,_mm_setzero_ps());
+                            const __m128 minTerm = _mm_mul_ps(element,_mm_blendv_ps(_params.LocalMin[j],_params.LocalMax[j],negative));
+                            const __m128 maxTerm = _mm_mul_ps(element,_mm_blendv_ps(_params.LocalMax[j],_params.LocalMin[j],negative));
+                            const __m128 centerTerm = _mm_mul_ps(element,_params.LocalCenter[j]);
+                            minSum = j ? _mm_add_ps(minSum,minTerm):minTerm;
+                            maxSum = j ? _mm_add_ps(maxSum,maxTerm):maxTerm;
+                            centerSum = j ? _mm_add_ps(centerSum,centerTerm):centerTerm;
+                        }
+                        bounds[EWB_MIN_X+i] = _mm_add_ps(minSum,world[9u+i]);
+                        bounds[EWB_MAX_X+i] = _mm_add_ps(maxSum,world[9u+i]);
+                        const __m128 eyeToInstance = _mm_sub_ps(_mm_add_ps(centerSum,world[9u+i]),_params.Eye[i]);
+                        distanceSQ = _mm_add_ps(distanceSQ,_mm_mul_ps(eyeToInstance,eyeToInstance));
+                    }
+                    for (uint32_t j=0u; j<EWB_COUNT; j++)
+                        _mm_storeu_ps(WorldBounds[j].data()+first,bounds[j]);
+
+                    // the corner furthest along each plane's normal has to be on the inside
+                    __m128 outside = _mm_setzero_ps();
+                    for (uint32_t i=0u; i<SViewFrustum::VF_PLANE_COUNT; i++)
+                    {
+                        __m128 distance = _params.Distance[i];
+                        for (uint32_t j=0u; j<3u; j++)
+                            distance = _mm_add_ps(distance,_mm_mul_ps(_params.Normal[i][j],bounds[_params.PositiveComponent[i][j]]));
+                        outside = _mm_or_ps(outside,_mm_cmplt_ps(distance,_mm_setzero_ps()));
+                    }
+
+                    // LoD is the number of LoD distances the instance is at or past
+                    __m128i lod = _mm_setzero_si128();
+                    for (uint32_t i=0u; i<lodCount; i++)
+                        lod = _mm_sub_epi32(lod,_mm_castps_si128(_mm_cmpge_ps(distanceSQ,_mm_set1_ps(LoDDistancesSQ[i]))));
+                    const __m128i tooFar = _mm_cmpeq_epi32(lod,_mm_set1_epi32(lodCount));
+
+                    const uint32_t culled = hidden|uint32_t(_mm_movemask_ps(_mm_or_ps(outside,_mm_castsi128_ps(tooFar))));
+                    // only write() reads the world transforms, don't bother when the whole batch is culled
+                    if (culled!=(0x1u<<BatchSize)-1u)
+                    for (uint32_t k=0u; k<12u; k+=4u)
+                    {
+                        _MM_TRANSPOSE4_PS(world[k],world[k+1u],world[k+2u],world[k+3u]);
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                            _mm_storeu_ps(WorldTransforms[first+lane].pointer()+k,world[k+lane]);
+                    }
+                    alignas(16) uint32_t lods[BatchSize];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lods),lod);
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                    {
+                        if ((culled>>lane)&0x1u)
+                            InstanceLoDs[first+lane] = CulledLoD;
+                        else
+                        {
+                            InstanceLoDs[first+lane] = lods[lane];
+                            counts[lods[lane]]++;
+                        }
+                    }
+                }
+            }
+
+            core::aabbox3df LoDInvariantBox;
+            core::vector<float> LoDDistancesSQ;
+
+            const uint8_t* InstanceData = nullptr;
+            size_t InstanceCount = 0u;
+            size_t Stride = 0u;
+            size_t VisibilityOffset = 0u;
+
+            core::vector<float> WorldBounds[EWB_COUNT];
+            core::vector<core::matrix4x3> WorldTransforms;
+            core::vector<uint8_t> InstanceLoDs;
+
+            //! per chunk and LoD, survivor counts while classifying, then offsets within the LoD
+            core::vector<uint32_t> ChunkLoDCounts;
+            core::vector<uint32_t> LoDCounts;
+            core::vector<uint32_t> LoDFirstInstances;
+            uint32_t VisibleCount = 0u;
+    };
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -115,6 +115,14 @@ const io::path& CLimitReadFile::getFileName() const
 }
 
 
+const void* CLimitReadFile::getMappedRange(const size_t& offset, const size_t& size) const
+{
+	if (!File || offset > AreaEnd-AreaStart || size > AreaEnd-AreaStart-offset)
+		return nullptr;
+	return File->getMappedRange(AreaStart+offset, size);
+}
+
+
 } // end namespace io
 } // end namespace irr
 
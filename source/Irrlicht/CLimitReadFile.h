@@ -45,6 +45,9 @@ namespace io
             //! returns name of file
             virtual const io::path& getFileName() const;
 
+            //! forwards to the underlying file
+            virtual const void* getMappedRange(const size_t& offset, const size_t& size) const;
+
         private:
 
             io::path Filename;
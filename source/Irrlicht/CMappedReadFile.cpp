@@ -0,0 +1,142 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "CMappedReadFile.h"
+
+#if defined(_IRR_WINDOWS_API_)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace irr
+{
+namespace io
+{
+
+
+CMappedReadFile::CMappedReadFile(const io::path& fileName)
+: Mapping(nullptr), FileSize(0), Pos(0), Filename(fileName)
+#ifdef _IRR_WINDOWS_API_
+, FileHandle(INVALID_HANDLE_VALUE), MappingHandle(nullptr)
+#endif
+{
+	#ifdef _IRR_DEBUG
+	setDebugName("CMappedReadFile");
+	#endif
+
+	openFile();
+}
+
+
+CMappedReadFile::~CMappedReadFile()
+{
+#if defined(_IRR_WINDOWS_API_)
+	if (Mapping)
+		UnmapViewOfFile(Mapping);
+	if (MappingHandle)
+		CloseHandle(MappingHandle);
+	if (FileHandle!=INVALID_HANDLE_VALUE)
+		CloseHandle(FileHandle);
+#else
+	if (Mapping)
+		munmap(const_cast<uint8_t*>(Mapping), FileSize);
+#endif
+}
+
+
+//! returns how much was read
+int32_t CMappedReadFile::read(void* buffer, uint32_t sizeToRead)
+{
+	if (!isOpen() || Pos >= FileSize)
+		return 0;
+
+	const size_t amount = core::min_<size_t>(sizeToRead, FileSize-Pos);
+	memcpy(buffer, Mapping+Pos, amount);
+	Pos += amount;
+	return (int32_t)amount;
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CMappedReadFile::seek(const size_t& finalPos, bool relativeMovement)
+{
+	if (!isOpen())
+		return false;
+
+	const size_t newPos = relativeMovement ? (Pos+finalPos):finalPos;
+	if (newPos > FileSize)
+		return false;
+
+	Pos = newPos;
+	return true;
+}
+
+
+const void* CMappedReadFile::getMappedRange(const size_t& offset, const size_t& size) const
+{
+	if (!isOpen() || offset > FileSize || size > FileSize-offset)
+		return nullptr;
+	return Mapping+offset;
+}
+
+
+//! opens the file
+void CMappedReadFile::openFile()
+{
+	if (Filename.size() == 0)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+	#if defined ( _IRR_WCHAR_FILESYSTEM )
+	FileHandle = CreateFileW(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	#else
+	FileHandle = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	#endif
+	if (FileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(FileHandle, &size) || size.QuadPart == 0)
+		return;
+
+	MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!MappingHandle)
+		return;
+
+	Mapping = reinterpret_cast<const uint8_t*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (Mapping)
+		FileSize = size.QuadPart;
+#else
+	const int fd = open(Filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED)
+		{
+			// loaders mostly go front to back, let the kernel read ahead aggressively
+			madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+			Mapping = reinterpret_cast<const uint8_t*>(mapping);
+			FileSize = info.st_size;
+		}
+	}
+	// the mapping keeps its own reference to the file
+	close(fd);
+#endif
+}
+
+
+} // end namespace io
+} // end namespace irr
+
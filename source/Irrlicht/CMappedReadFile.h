@@ -0,0 +1,73 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_MAPPED_READ_FILE_H_INCLUDED__
+#define __C_MAPPED_READ_FILE_H_INCLUDED__
+
+#include "IReadFile.h"
+
+#include "irr/core/core.h"
+
+namespace irr
+{
+
+namespace io
+{
+
+	/*!
+		Class for reading a real file from disk through a read-only memory mapping,
+		loaders can parse the contents in place with getMappedRange() instead of reading into their own buffers.
+	*/
+	class CMappedReadFile : public IReadFile
+	{
+        protected:
+            virtual ~CMappedReadFile();
+
+        public:
+            CMappedReadFile(const io::path& fileName);
+
+            //! returns how much was read
+            virtual int32_t read(void* buffer, uint32_t sizeToRead) override;
+
+            //! changes position in file, returns true if successful
+            virtual bool seek(const size_t& finalPos, bool relativeMovement = false) override;
+
+            //! returns size of file
+            virtual size_t getSize() const override { return FileSize; }
+
+            //! returns if the file is open and mapped, empty files can't be mapped
+            virtual bool isOpen() const
+            {
+                return Mapping != nullptr;
+            }
+
+            //! returns where in the file we are.
+            virtual size_t getPos() const override { return Pos; }
+
+            //! returns name of file
+            virtual const io::path& getFileName() const override { return Filename; }
+
+            //! returns a pointer into the mapping
+            virtual const void* getMappedRange(const size_t& offset, const size_t& size) const override;
+
+        private:
+
+            //! opens and maps the file
+            void openFile();
+
+            const uint8_t* Mapping;
+            size_t FileSize;
+            size_t Pos;
+            io::path Filename;
+#ifdef _IRR_WINDOWS_API_
+            void* FileHandle;
+            void* MappingHandle;
+#endif
+	};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
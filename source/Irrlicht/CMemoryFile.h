@@ -136,6 +136,13 @@ namespace io
 
         virtual const io::path& getFileName() const override { return m_filename; }
 
+        virtual const void* getMappedRange(const size_t& offset, const size_t& size) const override
+        {
+            if (offset > m_length || size > m_length-offset)
+                return nullptr;
+            return reinterpret_cast<const uint8_t*>(m_storage)+offset;
+        }
+
         virtual int32_t read(void* buffer, uint32_t sizeToRead) override
         {
             int64_t amount = static_cast<int64_t>(sizeToRead);
@@ -52,6 +52,9 @@ namespace scene
 		//! Returns type of the scene node
 		virtual ESCENE_NODE_TYPE getType() const override { return ESNT_MESH; }
 
+		//! Neither OnAnimate() nor updateAbsolutePosition() are overridden, so the scene manager may animate it level by level
+		virtual bool supportsLevelOrderedUpdate() const override { return true; }
+
 		//! Sets a new mesh
 		virtual void setMesh(core::smart_refctd_ptr<video::IGPUMesh>&& mesh) override;
 
@@ -26,7 +26,7 @@ CMeshSceneNodeInstanced::CMeshSceneNodeInstanced(IDummyTransformationSceneNode*
         const core::vector3df& position, const core::vector3df& rotation, const core::vector3df& scale)
     : IMeshSceneNodeInstanced(parent, mgr, id, position, rotation, scale),
     instanceBBoxes(nullptr), instanceBBoxesCount(0), flagQueryForRetrieval(false),
-    gpuCulledLodInstanceDataBuffer(), dataPerInstanceOutputSize(0),
+    gpuCulledLodInstanceDataBuffer(), cpuOutputFunc(nullptr), cpuOutputUserData(nullptr), dataPerInstanceOutputSize(0),
     extraDataInstanceSize(0), dataPerInstanceInputSize(0), cachedMaterialCount(0)
 {
     #ifdef _IRR_DEBUG
@@ -196,9 +196,24 @@ bool CMeshSceneNodeInstanced::setLoDMeshes(const core::vector<MeshLoD>& levelsOf
 
     lodCullingPointMesh->getMaterial() = lodSelectionShader;
 
+    {
+        core::vector<float> lodDistancesSQ(LoD.size());
+        for (size_t i=0; i<LoD.size(); i++)
+            lodDistancesSQ[i] = LoD[i].distanceSQ;
+        cpuCuller.setLoDs(LoDInvariantBox,lodDistancesSQ.data(),lodDistancesSQ.size());
+    }
+
     return true;
 }
 
+void CMeshSceneNodeInstanced::setCPUCulling(CPUInstanceOutputFunc outputFunc, void* userData)
+{
+    cpuOutputFunc = outputFunc;
+    cpuOutputUserData = userData;
+    // don't let a GPU pass still in flight overwrite what the CPU sets
+    flagQueryForRetrieval = false;
+}
+
 uint32_t CMeshSceneNodeInstanced::addInstance(const core::matrix4x3& relativeTransform, const void* extraData)
 {
     uint32_t ix;
@@ -435,9 +450,6 @@ void CMeshSceneNodeInstanced::RecullInstances()
     video::IVideoDriver* driver = SceneManager->getVideoDriver();
 
     {
-        //can swap before or after, but defubuteky before tform feedback shadeur
-        instanceDataAllocator->pushBuffer(driver->getDefaultUpStreamingBuffer());
-
         size_t outputSizePerLoD = dataPerInstanceOutputSize*getCurrentInstanceCapacity();
         if (gpuCulledLodInstanceDataBuffer->getSize()!=xfb.size()*gpuLoDsPerPass*outputSizePerLoD)
         {
@@ -451,6 +463,15 @@ void CMeshSceneNodeInstanced::RecullInstances()
             }
         }
 
+        if (cpuOutputFunc)
+        {
+            RecullInstancesOnCPU();
+            return;
+        }
+
+        //can swap before or after, but defubuteky before tform feedback shadeur
+        instanceDataAllocator->pushBuffer(driver->getDefaultUpStreamingBuffer());
+
         driver->setTransform(video::E4X3TS_WORLD,AbsoluteTransformation);
         for (size_t i=0; i<xfb.size(); i++)
         {
@@ -471,11 +492,64 @@ void CMeshSceneNodeInstanced::RecullInstances()
     }
 }
 
+void CMeshSceneNodeInstanced::RecullInstancesOnCPU()
+{
+    video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+    // instances are kept contiguous by the address allocator, and the back buffer always has the latest data
+    const uint8_t* instanceData = reinterpret_cast<const uint8_t*>(instanceDataAllocator->getBackBufferPointer());
+    ICameraSceneNode* camera = SceneManager->getActiveCamera();
+    if (camera)
+        cpuCuller.classify(instanceData,getInstanceCount(),dataPerInstanceInputSize,48+36+extraDataInstanceSize,AbsoluteTransformation,camera->getViewFrustum(),camera->getAbsolutePosition());
+    else // nothing to measure LoD distances from
+        cpuCuller.classify(instanceData,0u,dataPerInstanceInputSize,48+36+extraDataInstanceSize,AbsoluteTransformation,nullptr,core::vector3df(0.f));
+
+    auto writeOutput = [this](void* output, const core::matrix4x3& worldTransform, const uint8_t* instance, uint32_t lod)
+    {
+        cpuOutputFunc(output,worldTransform,instance,lod,cpuOutputUserData);
+    };
+    uint32_t uploadSize = cpuCuller.getVisibleInstanceCount()*dataPerInstanceOutputSize;
+    auto upStreamingBuffer = driver->getDefaultUpStreamingBuffer();
+    if (uploadSize<=upStreamingBuffer->max_size())
+    {
+        uint32_t offset = video::StreamingTransientDataBufferMT<>::invalid_address;
+        uint32_t alignment = 64u; // smallest mapping alignment capability
+        while (uploadSize&&offset==video::StreamingTransientDataBufferMT<>::invalid_address)
+            upStreamingBuffer->multi_alloc(std::chrono::microseconds(500u),1u,&offset,&uploadSize,&alignment);
+
+        if (uploadSize)
+        {
+            cpuCuller.write(reinterpret_cast<uint8_t*>(upStreamingBuffer->getBufferPointer())+offset,dataPerInstanceOutputSize,writeOutput);
+            // some platforms expose non-coherent host-visible GPU memory, so writes need to be flushed explicitly
+            if (upStreamingBuffer->needsManualFlushOrInvalidate())
+                driver->flushMappedMemoryRanges({{upStreamingBuffer->getBuffer()->getBoundMemory(),offset,uploadSize}});
+            driver->copyBuffer(upStreamingBuffer->getBuffer(),gpuCulledLodInstanceDataBuffer.get(),offset,0u,uploadSize);
+            upStreamingBuffer->multi_free(1u,&offset,&uploadSize,driver->placeFence());
+        }
+    }
+    else
+    {
+        cpuCulledInstanceData.resize(uploadSize);
+        cpuCuller.write(cpuCulledInstanceData.data(),dataPerInstanceOutputSize,writeOutput);
+        driver->updateBufferRangeViaStagingBuffer(gpuCulledLodInstanceDataBuffer.get(),0u,uploadSize,cpuCulledInstanceData.data());
+    }
+
+    // counts are known right away, no queries to wait on in render()
+    for (size_t j=0; j<LoD.size(); j++)
+    for (size_t i=0; i<LoD[j].mesh->getMeshBufferCount(); i++)
+    {
+        LoD[j].mesh->getMeshBuffer(i)->setInstanceCount(cpuCuller.getLoDInstanceCount(j));
+        LoD[j].mesh->getMeshBuffer(i)->setBaseInstance(cpuCuller.getLoDFirstInstance(j));
+    }
+    flagQueryForRetrieval = false;
+}
+
 //! frame
 void CMeshSceneNodeInstanced::OnRegisterSceneNode()
 {
     ISceneNode::OnRegisterSceneNode();
 
+    RecullPending = false;
 	if (IsVisible&&LoD.size()&&instanceDataAllocator&&getInstanceCount()&&canProceedPastFence())
 	{
 		// because this node supports rendering of mixed mode meshes consisting of
@@ -507,19 +581,24 @@ void CMeshSceneNodeInstanced::OnRegisterSceneNode()
                 break;
         }
 
-		// register according to material types counted
-		uint32_t taken = 0;
+		// register according to material types counted, the instances only get reculled if the node passes culling
 		if (solidCount)
-			taken |= SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+			RecullPending |= SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID)!=0u;
 
 		if (transparentCount)
-			taken |= SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
-
-        if (taken)
-            RecullInstances();
+			RecullPending |= SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT)!=0u;
 	}
 }
 
+void CMeshSceneNodeInstanced::OnCullingDone(bool passedCulling)
+{
+    if (passedCulling&&RecullPending)
+    {
+        RecullPending = false;
+        RecullInstances();
+    }
+}
+
 
 //! renders the node.
 void CMeshSceneNodeInstanced::render()
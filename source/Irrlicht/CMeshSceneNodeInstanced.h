@@ -10,6 +10,7 @@
 #include "ITransformFeedback.h"
 #include "IQueryObject.h"
 #include "ISceneManager.h"
+#include "CInstanceLoDCuller.h"
 
 
 namespace irr
@@ -78,6 +79,10 @@ class CMeshSceneNodeInstanced : public IMeshSceneNodeInstanced
 
         virtual const core::aabbox3df& getLoDInvariantBBox() const {return LoDInvariantBox;}
 
+        virtual void setCPUCulling(CPUInstanceOutputFunc outputFunc, void* userData=nullptr) override;
+
+        virtual bool isCPUCullingEnabled() const override {return cpuOutputFunc!=nullptr;}
+
 
         virtual size_t getInstanceCount() const { return core::address_allocator_traits<InstanceDataAddressAllocator>::get_allocated_size(instanceDataAllocator->getAddressAllocator())/dataPerInstanceInputSize; }
 
@@ -102,6 +107,9 @@ class CMeshSceneNodeInstanced : public IMeshSceneNodeInstanced
         //! frame
         virtual void OnRegisterSceneNode();
 
+        //! reculls the instances once the node is known to pass culling in any of the passes it registered for
+        virtual void OnCullingDone(bool passedCulling);
+
         //! renders the node.
         virtual void render();
 
@@ -145,11 +153,15 @@ class CMeshSceneNodeInstanced : public IMeshSceneNodeInstanced
         //! Returns type of the scene node
         virtual ESCENE_NODE_TYPE getType() const { return ESNT_MESH_INSTANCED; }
 
+        //! Neither OnAnimate() nor updateAbsolutePosition() are overridden, so the scene manager may animate it level by level
+        virtual bool supportsLevelOrderedUpdate() const { return true; }
+
         //! Creates a clone of this scene node and its children.
         virtual ISceneNode* clone(IDummyTransformationSceneNode* newParent=0, ISceneManager* newManager=0) { assert(false); return nullptr; }
 
     protected:
         void RecullInstances();
+        void RecullInstancesOnCPU();
         core::aabbox3d<float> Box;
         core::aabbox3d<float> LoDInvariantBox;
         uint32_t cachedMaterialCount;
@@ -172,11 +184,19 @@ class CMeshSceneNodeInstanced : public IMeshSceneNodeInstanced
         core::smart_refctd_ptr<video::IGPUMeshBuffer> lodCullingPointMesh;
         core::smart_refctd_ptr<video::IGPUBuffer> gpuCulledLodInstanceDataBuffer;
 
+        CPUInstanceOutputFunc cpuOutputFunc;
+        void* cpuOutputUserData;
+        CInstanceLoDCuller cpuCuller;
+        //! only used when the culled instances don't fit in the upload buffer in one go
+        core::vector<uint8_t> cpuCulledInstanceData;
+
         size_t dataPerInstanceOutputSize;
         size_t extraDataInstanceSize;
         size_t dataPerInstanceInputSize;
 
         int32_t PassCount;
+        //! registered for rendering this frame, but the instances haven't been reculled yet
+        bool RecullPending = false;
 
         inline size_t getCurrentInstanceCapacity() const
         {
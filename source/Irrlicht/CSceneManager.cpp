@@ -11,6 +11,7 @@
 #include "IWriteFile.h"
 
 #include "os.h"
+#include "irr/core/parallel/parallel_for.h"
 
 // We need this include for the case of skinned mesh support without
 // any such loader
@@ -43,7 +44,7 @@ CSceneManager::CSceneManager(IrrlichtDevice* device, video::IVideoDriver* driver
 		gui::ICursorControl* cursorControl)
 : ISceneNode(0, 0), Driver(driver), Timer(timer), FileSystem(fs), Device(device),
 	CursorControl(cursorControl),
-	ActiveCamera(0), CurrentRendertime(ESNRP_NONE),
+	SpatialIndexEnabled(false), ActiveCamera(0), CurrentRendertime(ESNRP_NONE),
 	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type")
 {
 	#ifdef _IRR_DEBUG
@@ -526,6 +527,49 @@ const core::aabbox3d<float>& CSceneManager::getBoundingBox()
 
 
 //! returns if node is culled
+void CSceneManager::setSpatialIndexEnabled(bool enabled, float smallestCellSize)
+{
+	SpatialIndexEnabled = enabled;
+	// nodes get inserted during the next OnAnimate
+	SpatialIndex.setSmallestCellSize(smallestCellSize);
+}
+
+bool CSceneManager::getSceneNodesInBox(const core::aabbox3df& box, core::vector<ISceneNode*>& outNodes) const
+{
+	if (!SpatialIndexEnabled)
+		return false;
+
+	SpatialIndex.getNodesInBox(box,outNodes);
+	return true;
+}
+
+bool CSceneManager::getSceneNodesInSphere(const core::vector3df& center, float radius, core::vector<ISceneNode*>& outNodes) const
+{
+	if (!SpatialIndexEnabled)
+		return false;
+
+	SpatialIndex.getNodesInSphere(center,radius,outNodes);
+	return true;
+}
+
+bool CSceneManager::getSceneNodesInFrustum(const SViewFrustum& frustum, core::vector<ISceneNode*>& outNodes) const
+{
+	if (!SpatialIndexEnabled)
+		return false;
+
+	SpatialIndex.getNodesInFrustum(frustum,outNodes);
+	return true;
+}
+
+bool CSceneManager::getNearestSceneNodes(const core::vector3df& point, uint32_t k, core::vector<ISceneNode*>& outNodes) const
+{
+	if (!SpatialIndexEnabled)
+		return false;
+
+	SpatialIndex.getNearestNodes(point,k,outNodes);
+	return true;
+}
+
 bool CSceneManager::isCulled(ISceneNode* node) const
 {
 	const ICameraSceneNode* cam = getActiveCamera();
@@ -584,54 +628,14 @@ uint32_t CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_
 		SkyBoxList.push_back(node);
 		taken = 1;
 		break;
+	// culled all at once in drawAll, so for these taken only means queued
 	case ESNRP_SOLID:
-		if (!isCulled(node))
-		{
-			SolidNodeList.push_back(node);
-			taken = 1;
-		}
-		break;
 	case ESNRP_TRANSPARENT:
-		if (!isCulled(node))
-		{
-			TransparentNodeList.push_back(TransparentNodeEntry(node, ActiveCamera->getAbsolutePosition()));
-			taken = 1;
-		}
-		break;
 	case ESNRP_TRANSPARENT_EFFECT:
-		if (!isCulled(node))
-		{
-			TransparentEffectNodeList.push_back(TransparentNodeEntry(node, ActiveCamera->getAbsolutePosition()));
-			taken = 1;
-		}
-		break;
 	case ESNRP_AUTOMATIC:
-		if (!isCulled(node))
-		{
-			const uint32_t count = node->getMaterialCount();
-
-			taken = 0;
-			for (uint32_t i=0; i<count; ++i)
-			{
-				video::IMaterialRenderer* rnd =
-					Driver->getMaterialRenderer(node->getMaterial(i).MaterialType);
-				if (rnd && rnd->isTransparent())
-				{
-					// register as transparent node
-					TransparentNodeEntry e(node, ActiveCamera->getAbsolutePosition());
-					TransparentNodeList.push_back(e);
-					taken = 1;
-					break;
-				}
-			}
-
-			// not transparent, register as solid
-			if (!taken)
-			{
-				SolidNodeList.push_back(node);
-				taken = 1;
-			}
-		}
+		Culler.addBox(node->getBoundingBox(),&node->getAbsoluteTransformation(),node->getAutomaticCulling());
+		CullableNodeList.push_back({node,pass});
+		taken = 1;
 		break;
 
 	default: // ignore this one
@@ -641,34 +645,212 @@ uint32_t CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_
 #ifdef _IRR_SCENEMANAGER_DEBUG
 	int32_t index = Parameters.findAttribute ( "calls" );
 	Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+#endif
+
+	return taken;
+}
+
+//!
+core::vector3df CSceneManager::getCameraPositionForSorting() const
+{
+	return ActiveCamera ? ActiveCamera->getAbsolutePosition():core::vector3df(0.f);
+}
+
+//!
+void CSceneManager::cullRegisteredNodes()
+{
+	Culler.cull(ActiveCamera ? ActiveCamera->getViewFrustum():nullptr);
 
-	if (!taken)
+	const core::vector3df cameraPosition = getCameraPositionForSorting();
+	for (size_t i=0; i<CullableNodeList.size(); i++)
 	{
-		index = Parameters.findAttribute ( "culled" );
-		Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
-	}
+		ISceneNode* node = CullableNodeList[i].Node;
+		const bool visible = Culler.isVisible(i);
+		// in registration order, like the verdicts registerNodeForRendering used to return right away
+		node->OnCullingDone(visible);
+		if (!visible)
+		{
+#ifdef _IRR_SCENEMANAGER_DEBUG
+			int32_t index = Parameters.findAttribute ( "culled" );
+			Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
 #endif
+			continue;
+		}
 
-	return taken;
+		switch (CullableNodeList[i].Pass)
+		{
+		case ESNRP_SOLID:
+			SolidNodeList.push_back(node);
+			break;
+		case ESNRP_TRANSPARENT:
+			TransparentNodeList.push_back(TransparentNodeEntry(node, cameraPosition));
+			break;
+		case ESNRP_TRANSPARENT_EFFECT:
+			TransparentEffectNodeList.push_back(TransparentNodeEntry(node, cameraPosition));
+			break;
+		default:
+			{
+				bool transparent = false;
+				const uint32_t count = node->getMaterialCount();
+				for (uint32_t j=0; j<count; ++j)
+				{
+					video::IMaterialRenderer* rnd =
+						Driver->getMaterialRenderer(node->getMaterial(j).MaterialType);
+					if (rnd && rnd->isTransparent())
+					{
+						transparent = true;
+						break;
+					}
+				}
+
+				if (transparent)
+					TransparentNodeList.push_back(TransparentNodeEntry(node, cameraPosition));
+				else
+					SolidNodeList.push_back(node);
+			}
+			break;
+		}
+	}
+
+	CullableNodeList.clear();
+	Culler.clear();
 }
 
 //!
+uint8_t CSceneManager::getAnimationLevelFlags(IDummyTransformationSceneNode* node)
+{
+    if (node->isISceneNode() && !static_cast<ISceneNode*>(node)->isVisible())
+        return EALF_SKIP;
+    if (!node->supportsLevelOrderedUpdate())
+        return EALF_RECURSIVE;
+    return node->getAnimators().size() ? EALF_ANIMATORS:0u;
+}
+
+//! The level pass never reaches below a recursively animated node, so its descendants would fall out of the index at endGeneration()
+void CSceneManager::updateSpatialIndexSubtree(IDummyTransformationSceneNode* node)
+{
+    if (node->isISceneNode())
+    {
+        ISceneNode* sceneNode = static_cast<ISceneNode*>(node);
+        // invisible subtrees get dropped, same as in the level pass
+        if (!sceneNode->isVisible())
+            return;
+        SpatialIndex.update(sceneNode);
+    }
+    for (IDummyTransformationSceneNode* child : node->getChildren())
+        updateSpatialIndexSubtree(child);
+}
+
+//! Animates the scene graph one depth level at a time, instead of recursing depth first.
+/** Animators are free to change the scene graph, so they run on this thread before anything else looks at their level,
+then the absolute transformations of the whole level get recomputed in parallel (only for nodes whose relative
+transformation or parent changed) and the children of the level get gathered into the next one.
+Every node is grabbed while it is in a level, so animators removing nodes (even ones of their own level) can't leave dangling pointers,
+nodes which got detached from the scene graph are skipped along with their subtrees. */
 void CSceneManager::OnAnimate(uint32_t timeMs)
 {
-    size_t prevSize = Children.size();
-    for (size_t i=0; i<prevSize;)
+    if (SpatialIndexEnabled)
+        SpatialIndex.beginGeneration();
+
+    AnimationLevel.resize(Children.size());
+    AnimationLevelFlags.resize(Children.size());
+    for (size_t i=0; i<Children.size(); i++)
     {
-        IDummyTransformationSceneNode* tmpChild = Children[i];
-        if (tmpChild->isISceneNode())
-            static_cast<ISceneNode*>(tmpChild)->OnAnimate(timeMs);
-        else
-            OnAnimate_static(tmpChild,timeMs);
-
-        if (Children[i]>tmpChild)
-            prevSize = Children.size();
-        else
-            i++;
+        AnimationLevel[i] = Children[i];
+        AnimationLevel[i]->grab();
+        AnimationLevelFlags[i] = getAnimationLevelFlags(Children[i]);
     }
+
+    while (AnimationLevel.size())
+    {
+        const size_t levelSize = AnimationLevel.size();
+        for (size_t i=0; i<levelSize; i++)
+        {
+            IDummyTransformationSceneNode* node = AnimationLevel[i];
+            if (AnimationLevelFlags[i]&EALF_RECURSIVE)
+            {
+                if (node->isISceneNode())
+                    static_cast<ISceneNode*>(node)->OnAnimate(timeMs);
+                else
+                    OnAnimate_static(node,timeMs);
+            }
+            else if (AnimationLevelFlags[i]&EALF_ANIMATORS)
+                animateNode_static(node,timeMs);
+        }
+
+        AnimationChildOffsets.resize(levelSize+1u);
+        core::parallel_for_range<size_t>(0u,levelSize,[this](size_t rangeBegin, size_t rangeEnd)
+            {
+                for (size_t i=rangeBegin; i<rangeEnd; i++)
+                {
+                    // removed by an animator
+                    if (!AnimationLevel[i]->getParent())
+                        AnimationLevelFlags[i] = EALF_SKIP;
+                    if (AnimationLevelFlags[i]&(EALF_SKIP|EALF_RECURSIVE))
+                    {
+                        AnimationChildOffsets[i] = 0u;
+                        continue;
+                    }
+                    const bool moved = AnimationLevel[i]->recomputeAbsoluteTransformation();
+                    if (SpatialIndexEnabled&&AnimationLevel[i]->isISceneNode())
+                    {
+                        if (!SpatialIndex.touch(static_cast<ISceneNode*>(AnimationLevel[i]))||moved)
+                            AnimationLevelFlags[i] |= EALF_REINDEX;
+                    }
+                    AnimationChildOffsets[i] = AnimationLevel[i]->getChildren().size();
+                }
+            },AnimationLevelGrain
+        );
+
+        if (SpatialIndexEnabled)
+        for (size_t i=0; i<levelSize; i++)
+        {
+            // recursively animated nodes might have animated their bounding boxes and anything below them as well
+            if (AnimationLevelFlags[i]&EALF_RECURSIVE)
+                updateSpatialIndexSubtree(AnimationLevel[i]);
+            else if (AnimationLevelFlags[i]&EALF_REINDEX)
+                SpatialIndex.update(static_cast<ISceneNode*>(AnimationLevel[i]));
+        }
+
+        uint32_t nextLevelSize = 0u;
+        for (size_t i=0; i<levelSize; i++)
+        {
+            const uint32_t childCount = AnimationChildOffsets[i];
+            AnimationChildOffsets[i] = nextLevelSize;
+            nextLevelSize += childCount;
+        }
+        AnimationChildOffsets[levelSize] = nextLevelSize;
+
+        NextAnimationLevel.resize(nextLevelSize);
+        NextAnimationLevelFlags.resize(nextLevelSize);
+        core::parallel_for_range<size_t>(0u,levelSize,[this](size_t rangeBegin, size_t rangeEnd)
+            {
+                for (size_t i=rangeBegin; i<rangeEnd; i++)
+                {
+                    uint32_t outIx = AnimationChildOffsets[i];
+                    if (outIx==AnimationChildOffsets[i+1u])
+                        continue;
+
+                    for (IDummyTransformationSceneNode* child : AnimationLevel[i]->getChildren())
+                    {
+                        NextAnimationLevel[outIx] = child;
+                        child->grab();
+                        NextAnimationLevelFlags[outIx++] = getAnimationLevelFlags(child);
+                    }
+                }
+            },AnimationLevelGrain
+        );
+
+        // the last reference to a removed node might go here, destructors touch their children, so not in parallel
+        for (size_t i=0; i<levelSize; i++)
+            AnimationLevel[i]->drop();
+        AnimationLevel.swap(NextAnimationLevel);
+        AnimationLevelFlags.swap(NextAnimationLevelFlags);
+    }
+
+    // whatever the pass didn't reach left the scene graph or became invisible
+    if (SpatialIndexEnabled)
+        SpatialIndex.endGeneration();
 }
 
 //! This method is called just before the rendering process of the whole scene.
@@ -707,8 +889,9 @@ void CSceneManager::drawAll()
 		ActiveCamera->render();
 	}
 
-	// let all nodes register themselves
+	// let all nodes register themselves, then cull them all at once before anything gets sorted or rendered
 	OnRegisterSceneNode();
+	cullRegisteredNodes();
 
 	//render camera scenes
 	{
@@ -735,7 +918,9 @@ void CSceneManager::drawAll()
 	{
 		CurrentRendertime = ESNRP_SOLID;
 
-		std::sort(SolidNodeList.begin(),SolidNodeList.end()); // sort by textures
+		// sort by textures
+		SolidNodeScratch.resize(SolidNodeList.size());
+		core::radix_sort(SolidNodeList.data(),SolidNodeList.data()+SolidNodeList.size(),SolidNodeScratch.data(),[](const DefaultNodeEntry& e) {return e.getSortKey();});
 
         for (i=0; i<SolidNodeList.size(); ++i)
             SolidNodeList[i].Node->render();
@@ -750,7 +935,9 @@ void CSceneManager::drawAll()
 	{
 		CurrentRendertime = ESNRP_TRANSPARENT;
 
-		std::sort(TransparentNodeList.begin(),TransparentNodeList.end()); // sort by distance from camera
+		// sort by distance from camera
+		TransparentNodeScratch.resize(TransparentNodeList.size());
+		core::radix_sort(TransparentNodeList.data(),TransparentNodeList.data()+TransparentNodeList.size(),TransparentNodeScratch.data(),[](const TransparentNodeEntry& e) {return e.getSortKey();});
         for (i=0; i<TransparentNodeList.size(); ++i)
             TransparentNodeList[i].Node->render();
 
@@ -764,7 +951,9 @@ void CSceneManager::drawAll()
 	{
 		CurrentRendertime = ESNRP_TRANSPARENT_EFFECT;
 
-		std::sort(TransparentEffectNodeList.begin(),TransparentEffectNodeList.end()); // sort by distance from camera
+		// sort by distance from camera
+		TransparentNodeScratch.resize(TransparentEffectNodeList.size());
+		core::radix_sort(TransparentEffectNodeList.data(),TransparentEffectNodeList.data()+TransparentEffectNodeList.size(),TransparentNodeScratch.data(),[](const TransparentNodeEntry& e) {return e.getSortKey();});
         for (i=0; i<TransparentEffectNodeList.size(); ++i)
             TransparentEffectNodeList[i].Node->render();
 #ifdef _IRR_SCENEMANAGER_DEBUG
@@ -970,6 +1159,8 @@ bool CSceneManager::receiveIfEventReceiverDidNotAbsorb(const SEvent& event)
 //! Removes all children of this scene node
 void CSceneManager::removeAll()
 {
+	// the index holds references, which would keep the removed nodes alive
+	SpatialIndex.clear();
 	ISceneNode::removeAll();
 	setActiveCamera(0);
 	// Make sure the driver is reset, might need a more complex method at some point
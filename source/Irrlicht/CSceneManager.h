@@ -9,6 +9,9 @@
 #include "ISceneNode.h"
 #include "ICursorControl.h"
 #include "ISkinningStateManager.h"
+#include "CFrustumCuller.h"
+#include "CSceneNodeSpatialIndex.h"
+#include "irr/core/algorithm/radix_sort.h"
 
 #include <map>
 #include <string>
@@ -30,6 +33,9 @@ namespace scene
 	*/
 	class CSceneManager : public ISceneManager, public ISceneNode
 	{
+        //! depth levels with fewer nodes than this get animated on the calling thread
+        _IRR_STATIC_INLINE_CONSTEXPR size_t AnimationLevelGrain = 512u;
+
     protected:
 		//! destructor
 		virtual ~CSceneManager();
@@ -254,13 +260,48 @@ namespace scene
 		//! returns if node is culled
 		virtual bool isCulled(ISceneNode* node) const;
 
+		virtual void setSpatialIndexEnabled(bool enabled, float smallestCellSize=1.f) override;
+
+		virtual bool isSpatialIndexEnabled() const override {return SpatialIndexEnabled;}
+
+		virtual bool getSceneNodesInBox(const core::aabbox3df& box, core::vector<ISceneNode*>& outNodes) const override;
+
+		virtual bool getSceneNodesInSphere(const core::vector3df& center, float radius, core::vector<ISceneNode*>& outNodes) const override;
+
+		virtual bool getSceneNodesInFrustum(const SViewFrustum& frustum, core::vector<ISceneNode*>& outNodes) const override;
+
+		virtual bool getNearestSceneNodes(const core::vector3df& point, uint32_t k, core::vector<ISceneNode*>& outNodes) const override;
+
 	protected:
 
 		//! clears the deletion list
 		void clearDeletionList();
 
+		//! where transparent nodes get sorted back to front from, the origin without an active camera
+		core::vector3df getCameraPositionForSorting() const;
+
+		//! culls everything registered for the solid and transparent passes at once, and sorts the survivors into their render lists
+		void cullRegisteredNodes();
+
+		enum E_ANIMATION_LEVEL_FLAGS : uint8_t
+		{
+			//! invisible, neither the node nor its subtree get animated
+			EALF_SKIP = 0x1u,
+			//! has animators, which get run on the calling thread
+			EALF_ANIMATORS = 0x2u,
+			//! does not support level ordered updates, the whole subtree gets animated depth first
+			EALF_RECURSIVE = 0x4u,
+			//! moved or not in the spatial index yet, gets (re)inserted after its level
+			EALF_REINDEX = 0x8u
+		};
+		//! classifies a node for the depth level it is about to be animated in
+		static uint8_t getAnimationLevelFlags(IDummyTransformationSceneNode* node);
+		//! reindexes the visible scene nodes of a subtree animated depth first, nothing below it gets touched by the level pass
+		void updateSpatialIndexSubtree(IDummyTransformationSceneNode* node);
+
 		struct DefaultNodeEntry
 		{
+				DefaultNodeEntry() {}
 				DefaultNodeEntry(ISceneNode* n) :
 					Node(n), renderPriority(0x80000000u), Material(video::EMT_SOLID)
 				{
@@ -271,9 +312,13 @@ namespace scene
 
 				bool operator < (const DefaultNodeEntry& other) const
 				{
-					return (renderPriority < other.renderPriority)||(renderPriority==other.renderPriority && Material<other.Material);
+					return getSortKey()<other.getSortKey();
 				}
 
+				//! same order as operator<, for radix sorting
+				/** The material type is signed (user material types may be negative), so its sign bit gets flipped to keep its order as an unsigned key. */
+				inline uint64_t getSortKey() const {return (uint64_t(renderPriority)<<32ull)|(uint32_t(int32_t(Material))^0x80000000u);}
+
 				ISceneNode* Node;
 			private:
 				uint32_t renderPriority;
@@ -283,6 +328,7 @@ namespace scene
 		//! sort on distance (center) to camera
 		struct TransparentNodeEntry
 		{
+			TransparentNodeEntry() {}
 			TransparentNodeEntry(ISceneNode* n, const core::vector3df& camera)
 				: Node(n)
 			{
@@ -294,6 +340,9 @@ namespace scene
 				return Distance > other.Distance;
 			}
 
+			//! same order as operator< (back to front), for radix sorting
+			inline uint32_t getSortKey() const {return ~core::float_to_sortable_uint(float(Distance));}
+
 			ISceneNode* Node;
 			private:
 				double Distance;
@@ -350,6 +399,28 @@ namespace scene
 
 		core::vector<IDummyTransformationSceneNode*> DeletionList;
 
+		//! nodes registered for the solid and transparent passes, waiting to be culled in drawAll
+		struct CullableNodeEntry
+		{
+			ISceneNode* Node;
+			E_SCENE_NODE_RENDER_PASS Pass;
+		};
+		core::vector<CullableNodeEntry> CullableNodeList;
+		CFrustumCuller Culler;
+		//! radix sort scratch memory
+		core::vector<DefaultNodeEntry> SolidNodeScratch;
+		core::vector<TransparentNodeEntry> TransparentNodeScratch;
+
+		//! the scene graph flattened into the current and next depth level during OnAnimate, kept to not reallocate every frame
+		core::vector<IDummyTransformationSceneNode*> AnimationLevel, NextAnimationLevel;
+		core::vector<uint8_t> AnimationLevelFlags, NextAnimationLevelFlags;
+		//! where the children of each node of the current level start in the next
+		core::vector<uint32_t> AnimationChildOffsets;
+
+		//! updated at the end of OnAnimate, when enabled
+		CSceneNodeSpatialIndex SpatialIndex;
+		bool SpatialIndexEnabled;
+
 		//! current active camera
 		ICameraSceneNode* ActiveCamera;
 
@@ -0,0 +1,502 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_SCENE_NODE_SPATIAL_INDEX_H_INCLUDED__
+#define __C_SCENE_NODE_SPATIAL_INDEX_H_INCLUDED__
+
+#include <queue>
+
+#include "ISceneNode.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+
+    //! Spatial index over the world space bounding boxes of scene nodes, a loose octree stored as a hash grid per level
+    /**
+        Level L is an unbounded grid of cubic cells with sides of getSmallestCellSize()*2^L, hashed by their integer coordinates,
+        cell c of level L is the parent of cells 2c and 2c+1 (on every axis) of level L-1. A node lives in one cell of the finest level
+        whose cells are at least as large as its box, the cell containing its box's center, so every cell is loose, it only has to be
+        grown by half its size on every side to contain all of its nodes, and its loose bounds contain the loose bounds of its children.
+        Only cells with nodes in their subtree are stored, each with a mask of its stored children. Queries descend from the cells of
+        the root level (a level coarse enough to have nodes and only a handful of cells), reject whole subtrees by their loose bounds
+        and only then test the nodes' own boxes, nearest queries visit the cells closest first.
+
+        Nodes get grabbed while indexed. Moving a node only touches the two cells involved and their ancestors below the first one they
+        share, so the scene manager keeps the index up to
+        date from its animation pass: every frame is a generation, nodes the pass reaches get touch()ed (or update()d when their absolute
+        transformation changed), endGeneration() removes all nodes which weren't, because they left the scene graph or became invisible.
+
+        The queries are const and may run on many threads at once, as long as nothing updates the index meanwhile.
+    */
+    class CSceneNodeSpatialIndex
+    {
+        public:
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t LevelCount = 32u;
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t InvalidEntry = 0xffffffffu;
+
+            CSceneNodeSpatialIndex(const float& _smallestCellSize=1.f) : SmallestCellSize(_smallestCellSize), Generation(0u), RootLevel(0u), NodeCount(0u) {}
+            ~CSceneNodeSpatialIndex() {clear();}
+
+            //! Removes and drops all nodes
+            inline void clear()
+            {
+                for (auto& entry : Entries)
+                {
+                    if (!entry.Node)
+                        continue;
+                    entry.Node->SpatialIndexEntry = InvalidEntry;
+                    entry.Node->drop();
+                }
+                Entries.clear();
+                FreeEntries.clear();
+                for (auto& level : Levels)
+                    level.clear();
+                RootLevel = 0u;
+                NodeCount = 0u;
+            }
+
+            //! Side of the cells of the finest level, changing it clears the index
+            inline void setSmallestCellSize(const float& _smallestCellSize)
+            {
+                clear();
+                SmallestCellSize = _smallestCellSize;
+            }
+            inline const float& getSmallestCellSize() const {return SmallestCellSize;}
+
+            inline size_t getNodeCount() const {return NodeCount;}
+
+            inline bool contains(const ISceneNode* _node) const
+            {
+                const uint32_t entry = _node->SpatialIndexEntry;
+                return entry<Entries.size()&&Entries[entry].Node==_node;
+            }
+
+            //! Starts a new generation, nodes neither touched nor updated until endGeneration() get removed by it
+            inline void beginGeneration() {Generation++;}
+
+            //! Marks an indexed node as still being there, safe to call for different nodes from many threads at once
+            /** \return False if the node is not in the index yet. */
+            inline bool touch(ISceneNode* _node)
+            {
+                if (!contains(_node))
+                    return false;
+                Entries[_node->SpatialIndexEntry].Generation = Generation;
+                return true;
+            }
+
+            //! Inserts a node or refreshes its bounds from getTransformedBoundingBox(), moving it to another cell if needed
+            inline void update(ISceneNode* _node)
+            {
+                const core::aabbox3df box = _node->getTransformedBoundingBox();
+                uint32_t level;
+                const uint64_t cell = getCell(box,level);
+
+                uint32_t index = _node->SpatialIndexEntry;
+                if (!contains(_node))
+                {
+                    if (FreeEntries.size())
+                    {
+                        index = FreeEntries.back();
+                        FreeEntries.pop_back();
+                    }
+                    else
+                    {
+                        index = Entries.size();
+                        Entries.emplace_back();
+                    }
+                    _node->grab();
+                    _node->SpatialIndexEntry = index;
+                    Entries[index].Node = _node;
+                    insertIntoCell(index,level,cell);
+                    NodeCount++;
+                }
+                else if (Entries[index].Level!=level||Entries[index].Cell!=cell)
+                {
+                    // linking the new cell first keeps the ancestors the two cells share
+                    const uint32_t oldLevel = Entries[index].Level;
+                    const uint64_t oldCell = Entries[index].Cell;
+                    unlinkFromCell(index);
+                    insertIntoCell(index,level,cell);
+                    eraseIfEmpty(oldLevel,oldCell);
+                }
+                Entries[index].Box = box;
+                Entries[index].Generation = Generation;
+            }
+
+            //! Removes and drops a node, if it was indexed
+            inline void remove(ISceneNode* _node)
+            {
+                if (contains(_node))
+                    removeEntry(_node->SpatialIndexEntry);
+            }
+
+            //! Removes all nodes which were neither touched nor updated since beginGeneration()
+            inline void endGeneration()
+            {
+                for (uint32_t i=0u; i<Entries.size(); i++)
+                {
+                    if (Entries[i].Node&&Entries[i].Generation!=Generation)
+                        removeEntry(i);
+                }
+            }
+
+            //! Appends every node whose world box overlaps the box
+            inline void getNodesInBox(const core::aabbox3df& _box, core::vector<ISceneNode*>& _outNodes) const
+            {
+                traverse([&](const core::aabbox3df& looseCell) {return looseCell.intersectsWithBox(_box);},[&](const SEntry& entry)
+                    {
+                        if (entry.Box.intersectsWithBox(_box))
+                            _outNodes.push_back(entry.Node);
+                    }
+                );
+            }
+
+            //! Appends every node whose world box is no further than the radius from the center
+            inline void getNodesInSphere(const core::vector3df& _center, const float& _radius, core::vector<ISceneNode*>& _outNodes) const
+            {
+                const float radiusSQ = _radius*_radius;
+                traverse([&](const core::aabbox3df& looseCell) {return getDistanceSQ(looseCell,_center)<=radiusSQ;},[&](const SEntry& entry)
+                    {
+                        if (getDistanceSQ(entry.Box,_center)<=radiusSQ)
+                            _outNodes.push_back(entry.Node);
+                    }
+                );
+            }
+
+            //! Appends every node whose world box overlaps the frustum's bounding box and is not entirely outside one of its planes
+            /** The bounding box test rejects the boxes near the frustum's corners which the plane test alone lets through. */
+            inline void getNodesInFrustum(const SViewFrustum& _frustum, core::vector<ISceneNode*>& _outNodes) const
+            {
+                const core::aabbox3df& bounds = _frustum.getBoundingBox();
+                auto intersects = [&](const core::aabbox3df& box) {return box.intersectsWithBox(bounds)&&_frustum.intersectsAABB(box);};
+                traverse(intersects,[&](const SEntry& entry)
+                    {
+                        if (intersects(entry.Box))
+                            _outNodes.push_back(entry.Node);
+                    }
+                );
+            }
+
+            //! Appends the (at most) k nodes whose world boxes are closest to the point, closest first
+            inline void getNearestNodes(const core::vector3df& _point, const uint32_t& _k, core::vector<ISceneNode*>& _outNodes) const
+            {
+                if (!_k||!NodeCount)
+                    return;
+
+                typedef std::pair<float,const SEntry*> Candidate;
+                auto closer = [](const Candidate& a, const Candidate& b) {return a.first<b.first;};
+                // the k closest nodes so far, furthest on top
+                std::priority_queue<Candidate,core::vector<Candidate>,decltype(closer)> nearest(closer);
+
+                struct SPendingCell
+                {
+                    float DistanceSQ;
+                    uint32_t Level;
+                    uint64_t Key;
+                    const SCell* Cell;
+
+                    inline bool operator<(const SPendingCell& other) const {return DistanceSQ>other.DistanceSQ;}
+                };
+                std::priority_queue<SPendingCell,core::vector<SPendingCell> > cells;
+                for (const auto& root : Levels[RootLevel])
+                {
+                    int32_t coords[3];
+                    getCellCoords(root.first,coords);
+                    cells.push({getDistanceSQ(getLooseCellBox(coords,getCellSize(RootLevel)),_point),RootLevel,root.first,&root.second});
+                }
+                // nothing in a cell's subtree is closer than its loose bounds
+                while (!cells.empty()&&(nearest.size()<_k||cells.top().DistanceSQ<nearest.top().first))
+                {
+                    const SPendingCell pending = cells.top();
+                    cells.pop();
+                    for (uint32_t index : pending.Cell->Entries)
+                    {
+                        const SEntry& entry = Entries[index];
+                        const float distanceSQ = getDistanceSQ(entry.Box,_point);
+                        if (nearest.size()<_k)
+                            nearest.emplace(distanceSQ,&entry);
+                        else if (distanceSQ<nearest.top().first)
+                        {
+                            nearest.pop();
+                            nearest.emplace(distanceSQ,&entry);
+                        }
+                    }
+                    forEachChild(pending.Level,pending.Key,*pending.Cell,[&](const int32_t* coords, const uint64_t& key, const SCell& child)
+                        {
+                            const float distanceSQ = getDistanceSQ(getLooseCellBox(coords,getCellSize(pending.Level-1u)),_point);
+                            if (nearest.size()<_k||distanceSQ<nearest.top().first)
+                                cells.push({distanceSQ,pending.Level-1u,key,&child});
+                        }
+                    );
+                }
+
+                const size_t offset = _outNodes.size();
+                _outNodes.resize(offset+nearest.size());
+                for (size_t i=_outNodes.size(); i>offset; i--)
+                {
+                    _outNodes[i-1u] = nearest.top().second->Node;
+                    nearest.pop();
+                }
+            }
+
+        private:
+            //! cell coordinates have to fit in 21 bits
+            _IRR_STATIC_INLINE_CONSTEXPR int32_t MaxCellCoord = (0x1<<20)-1;
+            //! the root is raised while it has more cells than this
+            _IRR_STATIC_INLINE_CONSTEXPR size_t MaxRootCells = 8u;
+
+            struct SEntry
+            {
+                ISceneNode* Node = nullptr;
+                core::aabbox3df Box;
+                uint64_t Cell = 0u;
+                uint32_t Level = 0u;
+                //! position in the cell's list
+                uint32_t Slot = 0u;
+                uint32_t Generation = 0u;
+            };
+            struct SCell
+            {
+                core::vector<uint32_t> Entries;
+                //! bit (x&1)|((y&1)<<1)|((z&1)<<2) is set when child (x,y,z) is stored
+                uint8_t Children = 0u;
+            };
+            typedef core::unordered_map<uint64_t,SCell> CellMap;
+
+            static inline uint64_t getCellKey(const int32_t* _coords)
+            {
+                uint64_t key = 0u;
+                for (uint32_t i=0u; i<3u; i++)
+                    key |= uint64_t(_coords[i]+MaxCellCoord+1)<<(21ull*i);
+                return key;
+            }
+            static inline void getCellCoords(const uint64_t& _key, int32_t* _outCoords)
+            {
+                for (uint32_t i=0u; i<3u; i++)
+                    _outCoords[i] = int32_t((_key>>(21ull*i))&0x1fffffull)-MaxCellCoord-1;
+            }
+            static inline uint64_t getParentCellKey(const uint64_t& _key)
+            {
+                int32_t coords[3];
+                getCellCoords(_key,coords);
+                for (uint32_t i=0u; i<3u; i++)
+                    coords[i] = coords[i]>=0 ? (coords[i]/2):((coords[i]-1)/2);
+                return getCellKey(coords);
+            }
+            //! the cell's bit in its parent's child mask
+            static inline uint8_t getChildBit(const uint64_t& _key)
+            {
+                int32_t coords[3];
+                getCellCoords(_key,coords);
+                return 0x1u<<((coords[0]&0x1)|((coords[1]&0x1)<<1)|((coords[2]&0x1)<<2));
+            }
+
+            inline float getCellSize(const uint32_t& _level) const {return ldexpf(SmallestCellSize,_level);}
+
+            //! the cell's own bounds grown by half of its size on every side
+            inline core::aabbox3df getLooseCellBox(const int32_t* _coords, const float& _cellSize) const
+            {
+                core::aabbox3df box;
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    (&box.MinEdge.X)[i] = (float(_coords[i])-0.5f)*_cellSize;
+                    (&box.MaxEdge.X)[i] = (float(_coords[i])+1.5f)*_cellSize;
+                }
+                return box;
+            }
+
+            static inline float getDistanceSQ(const core::aabbox3df& _box, const core::vector3df& _point)
+            {
+                float distanceSQ = 0.f;
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    const float d = core::max_((&_box.MinEdge.X)[i]-(&_point.X)[i],0.f,(&_point.X)[i]-(&_box.MaxEdge.X)[i]);
+                    distanceSQ += d*d;
+                }
+                return distanceSQ;
+            }
+
+            //! finest level whose cells are as large as the box and can address its center
+            inline uint64_t getCell(const core::aabbox3df& _box, uint32_t& _outLevel) const
+            {
+                const core::vector3df extent = _box.getExtent();
+                const float maxExtent = core::max_(extent.X,extent.Y,extent.Z);
+                const core::vector3df center = _box.getCenter();
+
+                int32_t coords[3];
+                float cellSize = SmallestCellSize;
+                for (_outLevel=0u; ; _outLevel++,cellSize*=2.f)
+                {
+                    if (cellSize<maxExtent&&_outLevel+1u<LevelCount)
+                        continue;
+
+                    bool fits = true;
+                    for (uint32_t i=0u; i<3u; i++)
+                    {
+                        const float coord = floorf((&center.X)[i]/cellSize);
+                        fits = fits&&coord>=-float(MaxCellCoord)&&coord<=float(MaxCellCoord);
+                        coords[i] = int32_t(core::max_(core::min_(coord,float(MaxCellCoord)),-float(MaxCellCoord)));
+                    }
+                    if (fits||_outLevel+1u==LevelCount)
+                        break;
+                }
+                return getCellKey(coords);
+            }
+
+            inline void insertIntoCell(const uint32_t& _index, const uint32_t& _level, const uint64_t& _cell)
+            {
+                while (RootLevel<_level)
+                    raiseRoot();
+
+                SEntry& entry = Entries[_index];
+                entry.Level = _level;
+                entry.Cell = _cell;
+                auto inserted = Levels[_level].try_emplace(_cell);
+                auto& list = inserted.first->second.Entries;
+                entry.Slot = list.size();
+                list.push_back(_index);
+                if (!inserted.second)
+                    return;
+
+                // link the new cell to its ancestors, up to the first one which was already there
+                uint64_t cell = _cell;
+                for (uint32_t level=_level; level<RootLevel; level++)
+                {
+                    const uint8_t childBit = getChildBit(cell);
+                    cell = getParentCellKey(cell);
+                    auto parent = Levels[level+1u].try_emplace(cell);
+                    parent.first->second.Children |= childBit;
+                    if (!parent.second)
+                        return;
+                }
+                // every query tests all root cells
+                while (Levels[RootLevel].size()>MaxRootCells&&RootLevel+1u<LevelCount)
+                    raiseRoot();
+            }
+
+            //! makes the root cells children of cells one level up
+            inline void raiseRoot()
+            {
+                for (const auto& cell : Levels[RootLevel])
+                    Levels[RootLevel+1u][getParentCellKey(cell.first)].Children |= getChildBit(cell.first);
+                RootLevel++;
+            }
+
+            //! takes the entry out of its cell's list, leaves the cell in place even if it became empty
+            inline void unlinkFromCell(const uint32_t& _index)
+            {
+                const SEntry& entry = Entries[_index];
+                auto& list = Levels[entry.Level].find(entry.Cell)->second.Entries;
+                Entries[list.back()].Slot = entry.Slot;
+                list[entry.Slot] = list.back();
+                list.pop_back();
+            }
+
+            //! erases the cell and then its ancestors, for as long as they have neither entries nor children
+            inline void eraseIfEmpty(uint32_t _level, uint64_t _cell)
+            {
+                for (; ; _level++)
+                {
+                    auto found = Levels[_level].find(_cell);
+                    if (found->second.Entries.size()||found->second.Children)
+                        return;
+                    Levels[_level].erase(found);
+                    if (_level>=RootLevel)
+                        return;
+
+                    const uint8_t childBit = getChildBit(_cell);
+                    _cell = getParentCellKey(_cell);
+                    Levels[_level+1u].find(_cell)->second.Children &= ~childBit;
+                }
+            }
+
+            inline void removeFromCell(const uint32_t& _index)
+            {
+                unlinkFromCell(_index);
+                eraseIfEmpty(Entries[_index].Level,Entries[_index].Cell);
+            }
+
+            inline void removeEntry(const uint32_t& _index)
+            {
+                removeFromCell(_index);
+                ISceneNode* node = Entries[_index].Node;
+                Entries[_index].Node = nullptr;
+                FreeEntries.push_back(_index);
+                NodeCount--;
+                node->SpatialIndexEntry = InvalidEntry;
+                node->drop();
+            }
+
+            //! calls f with the coordinates, key and contents of every stored child of a cell
+            template<typename F>
+            inline void forEachChild(const uint32_t& _level, const uint64_t& _key, const SCell& _cell, F&& _f) const
+            {
+                if (!_cell.Children)
+                    return;
+                const CellMap& children = Levels[_level-1u];
+                int32_t parentCoords[3];
+                getCellCoords(_key,parentCoords);
+                for (uint32_t child=0u; child<8u; child++)
+                {
+                    if (!((_cell.Children>>child)&0x1u))
+                        continue;
+                    int32_t coords[3];
+                    for (uint32_t i=0u; i<3u; i++)
+                        coords[i] = parentCoords[i]*2+int32_t((child>>i)&0x1u);
+                    const uint64_t key = getCellKey(coords);
+                    _f(coords,key,children.find(key)->second);
+                }
+            }
+
+            //! depth first descent from the root cells, calls f for every entry of every cell whose loose bounds and ancestors' pass the cell test
+            template<typename CellTest, typename F>
+            inline void traverse(CellTest&& _cellTest, F&& _f) const
+            {
+                struct SPendingCell
+                {
+                    uint32_t Level;
+                    uint64_t Key;
+                    const SCell* Cell;
+                };
+                // at most 7 siblings wait on every level, plus the root cells
+                core::vector<SPendingCell> stack;
+                stack.reserve(Levels[RootLevel].size()+LevelCount*8u);
+                for (const auto& root : Levels[RootLevel])
+                    stack.push_back({RootLevel,root.first,&root.second});
+                while (!stack.empty())
+                {
+                    const SPendingCell pending = stack.back();
+                    stack.pop_back();
+                    int32_t coords[3];
+                    getCellCoords(pending.Key,coords);
+                    if (!_cellTest(getLooseCellBox(coords,getCellSize(pending.Level))))
+                        continue;
+                    for (uint32_t index : pending.Cell->Entries)
+                        _f(Entries[index]);
+                    forEachChild(pending.Level,pending.Key,*pending.Cell,[&](const int32_t* childCoords, const uint64_t& key, const SCell& child)
+                        {
+                            stack.push_back({pending.Level-1u,key,&child});
+                        }
+                    );
+                }
+            }
+
+            float SmallestCellSize;
+            uint32_t Generation;
+            //! at least the coarsest level with any nodes so far, cells link to their parents up to it
+            uint32_t RootLevel;
+            size_t NodeCount;
+
+            core::vector<SEntry> Entries;
+            core::vector<uint32_t> FreeEntries;
+            CellMap Levels[LevelCount];
+    };
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
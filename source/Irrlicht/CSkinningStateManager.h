@@ -4,6 +4,7 @@
 
 #include "ISkinningStateManager.h"
 #include "ITextureBufferObject.h"
+#include "CSoABoneSolver.h"
 #include "IVideoDriver.h"
 
 ///#define UPDATE_WHOLE_BUFFER
@@ -16,10 +17,38 @@ namespace scene
 
     class CSkinningStateManager : public ISkinningStateManager
     {
+            //! roughly how many bones a worker thread should get in one go when animating instances
+            _IRR_STATIC_INLINE_CONSTEXPR size_t SolverBoneGrain = 2048u;
+
             video::IVideoDriver* Driver;
 #ifdef _IRR_COMPILE_WITH_OPENGL_
             video::ITextureBufferObject* TBO;
 #endif
+            CSoABoneSolver Solver;
+            //! scratch for `performBoning`, kept to not reallocate every frame
+            core::vector<uint32_t> DirtyInstances;
+            core::vector<core::aabbox3df> DirtyInstanceBBoxes;
+            core::vector<CSoABoneSolver::SInstance> SolverInstances;
+            core::vector<CSoABoneSolver::SLayer> SolverLayers;
+
+            //! appends the layers of an instance in the form the solver takes them, returns how many there were
+            inline uint32_t getSolverLayers(core::vector<CSoABoneSolver::SLayer>& out, const uint32_t& instanceID) const
+            {
+                auto found = instanceLayers.find(instanceID);
+                if (found==instanceLayers.end())
+                    return 0u;
+
+                const size_t boneCount = referenceHierarchy->getBoneCount();
+                for (const SAnimationLayer& layer : found->second)
+                {
+                    _IRR_DEBUG_BREAK_IF(layer.boneMask!=kNoBoneMask&&(layer.boneMask+1u)*boneCount>boneMasks.size())
+                    const float* boneWeights = layer.boneMask!=kNoBoneMask&&(layer.boneMask+1u)*boneCount<=boneMasks.size() ? boneMasks.data()+layer.boneMask*boneCount:nullptr;
+                    out.push_back({layer.frame,layer.referenceFrame,layer.weight,boneWeights,layer.interpolate,layer.additive});
+                }
+                return found->second.size();
+            }
+
+            static_assert(sizeof(FinalBoneData)==sizeof(CSoABoneSolver::SBoneOutput), "CSoABoneSolver writes records laid out like FinalBoneData");
         protected:
             virtual ~CSkinningStateManager()
             {
@@ -30,7 +59,7 @@ namespace scene
 
         public:
             CSkinningStateManager(const E_BONE_UPDATE_MODE& boneControl, video::IVideoDriver* driver, const asset::CFinalBoneHierarchy* sourceHierarchy)
-                                    : ISkinningStateManager(boneControl,driver,sourceHierarchy), Driver(driver)
+                                    : ISkinningStateManager(boneControl,driver,sourceHierarchy), Driver(driver), Solver(sourceHierarchy)
             {
 #ifdef _IRR_COMPILE_WITH_OPENGL_
                 TBO = driver->addTextureBufferObject(instanceBoneDataAllocator->getFrontBuffer(),video::ITextureBufferObject::ETBOF_RGBA32F);
@@ -114,7 +143,7 @@ namespace scene
                         for (size_t i=0; i<referenceHierarchy->getBoneCount(); i++)
                         {
                             const asset::CFinalBoneHierarchy::BoneReferenceData& boneData = referenceHierarchy->getBoneData()[i];
-                            core::matrix4x3 localMatrix = asset::CFinalBoneHierarchy::getMatrixFromKey(referenceHierarchy->getNonInterpolatedAnimationData(i)[0]).getAsRetardedIrrlichtMatrix();
+                            core::matrix4x3 localMatrix = referenceHierarchy->getLocalMatrix(i,referenceHierarchy->getKeys()[0],false).getAsRetardedIrrlichtMatrix();
 
                             IBoneSceneNode* tmpBone; //! TODO: change to placement new
                             if (boneData.parentOffsetRelative)
@@ -196,6 +225,23 @@ namespace scene
                     return;
 
                 FinalBoneData* boneDataForInstance = reinterpret_cast<FinalBoneData*>(reinterpret_cast<uint8_t*>(instanceBoneDataAllocator->getBackBufferPointer())+instanceID);
+
+                // blended poses only come out of the solver, which bones the whole instance at once
+                core::vector<CSoABoneSolver::SLayer> layers;
+                if (const uint32_t layerCount = getSolverLayers(layers,instanceID))
+                {
+                    core::aabbox3df bbox;
+                    const CSoABoneSolver::SInstance instance = {currentInstance->frame,currentInstance->interpolateAnimation,getGlobalMatrices(currentInstance),
+                                                                reinterpret_cast<CSoABoneSolver::SBoneOutput*>(boneDataForInstance),&bbox,layers.data(),layerCount};
+                    Solver.solve(&instance,1u);
+                    instanceBoneDataAllocator->markRangeForPush(instanceID,instanceID+instanceFinalBoneDataSize);
+                    // performBoning has nothing left to do for this instance, the bones calling back into here return straight away
+                    currentInstance->lastAnimatedFrame = currentInstance->frame;
+                    updateBoneNodes(currentInstance,true);
+                    if (currentInstance->attachedNode)
+                        currentInstance->attachedNode->setBoundingBox(bbox);
+                    return;
+                }
                 if (boneDataForInstance[boneID].lastAnimatedFrame != currentInstance->frame)
                     return;
 
@@ -216,24 +262,10 @@ namespace scene
                 boneStackSize++;
 
 
-                float interpolationFactor;
-                size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,currentInstance->frame);
-                float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
-                core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
-
                 while (boneStackSize--)
                 {
                     size_t j = boneStack[boneStackSize];
-					asset::CFinalBoneHierarchy::AnimationKeyData upperFrame = (currentInstance->interpolateAnimation ? referenceHierarchy->getInterpolatedAnimationData(j):referenceHierarchy->getNonInterpolatedAnimationData(j))[foundKeyIx];
-
-                    core::matrix3x4SIMD interpolatedLocalTform;
-                    if (currentInstance->interpolateAnimation&&interpolationFactor<1.f)
-                    {
-						asset::CFinalBoneHierarchy::AnimationKeyData lowerFrame = (currentInstance->interpolateAnimation ? referenceHierarchy->getInterpolatedAnimationData(j):referenceHierarchy->getNonInterpolatedAnimationData(j))[foundKeyIx-1];
-                        interpolatedLocalTform = referenceHierarchy->getMatrixFromKeys(lowerFrame,upperFrame,interpolationFactor,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
-                    }
-                    else
-                        interpolatedLocalTform = referenceHierarchy->getMatrixFromKey(upperFrame);
+                    const core::matrix3x4SIMD interpolatedLocalTform = referenceHierarchy->getLocalMatrix(j,currentInstance->frame,currentInstance->interpolateAnimation);
 
                     if (j < referenceHierarchy->getBoneLevelRangeEnd(0))
                         getGlobalMatrices(currentInstance)[j] = interpolatedLocalTform.getAsRetardedIrrlichtMatrix();
@@ -279,6 +311,43 @@ namespace scene
                 }
             }
 
+            //! puts the freshly boned transforms of an instance into its bone scene nodes
+            /** `blended` instances have no single frame to take the local transforms from, they get recovered from the global matrices */
+            inline void updateBoneNodes(BoneHierarchyInstanceData* currentInstance, const bool& blended)
+            {
+                core::matrix3x4SIMD attachedNodeTform;
+                if (currentInstance->attachedNode)
+                    attachedNodeTform.set(currentInstance->attachedNode->getAbsoluteTransformation());
+
+                for (size_t j=0; j<referenceHierarchy->getBoneCount(); j++)
+                {
+                    IBoneSceneNode* bone = getBones(currentInstance)[j];
+                    if (!bone)
+                        continue;
+
+                    if (bone->getSkinningSpace()!=IBoneSceneNode::EBSS_LOCAL)
+                    {
+                        bone->setRelativeTransformationMatrix(core::matrix3x4SIMD::concatenateBFollowedByA(attachedNodeTform, core::matrix3x4SIMD().set(getGlobalMatrices(currentInstance)[j])).getAsRetardedIrrlichtMatrix());
+                        continue;
+                    }
+
+                    core::matrix3x4SIMD interpolatedLocalTform;
+                    if (!blended)
+                        interpolatedLocalTform = referenceHierarchy->getLocalMatrix(j,currentInstance->frame,currentInstance->interpolateAnimation);
+                    else if (j<referenceHierarchy->getBoneLevelRangeEnd(0))
+                        interpolatedLocalTform.set(getGlobalMatrices(currentInstance)[j]);
+                    else
+                    {
+                        core::matrix3x4SIMD parentInverse;
+                        core::matrix3x4SIMD().set(getGlobalMatrices(currentInstance)[referenceHierarchy->getBoneData()[j].parentOffsetFromTop]).getInverse(parentInverse);
+                        interpolatedLocalTform = core::matrix3x4SIMD::concatenateBFollowedByA(parentInverse,core::matrix3x4SIMD().set(getGlobalMatrices(currentInstance)[j]));
+                    }
+
+                    bone->setRelativeTransformationMatrix(interpolatedLocalTform.getAsRetardedIrrlichtMatrix());
+                    bone->updateAbsolutePosition();
+                }
+            }
+
             inline void TrySwapBoneBuffer()
             {
                 instanceBoneDataAllocator->pushBuffer(Driver->getDefaultUpStreamingBuffer());
@@ -307,138 +376,75 @@ namespace scene
                         case EBUM_READ:
                             {
                                 uint8_t* boneData = reinterpret_cast<uint8_t*>(instanceBoneDataAllocator->getBackBufferPointer());
-                                bool notModified = true;
-                                uint32_t localFirstDirtyInstance,localLastDirtyInstance;
+
+                                DirtyInstances.clear();
+                                DirtyInstanceBBoxes.clear();
                                 for (size_t i=instanceBoneDataAllocator->getAddressAllocator().get_align_offset(); i<instanceBoneDataAllocator->getAddressAllocator().get_total_size(); i+=instanceFinalBoneDataSize)
                                 {
                                     BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(i);
                                     if (!currentInstance->refCount || currentInstance->frame==currentInstance->lastAnimatedFrame) //in other modes, check if also has no bones!!!
                                         continue;
+                                    DirtyInstances.push_back(i);
+                                }
+                                if (DirtyInstances.empty())
+                                {
+                                    TrySwapBoneBuffer();
+                                    break;
+                                }
 
-                                    core::matrix4x3 attachedNodeTform;
-                                    if (currentInstance->attachedNode)
-                                        attachedNodeTform = currentInstance->attachedNode->getAbsoluteTransformation();
-
-
-                                    float interpolationFactor;
-                                    size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,currentInstance->frame);
-                                    float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
-                                    core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
-
-
-                                    FinalBoneData* boneDataForInstance = reinterpret_cast<FinalBoneData*>(boneData+i);
-                                    for (size_t j=0; j<referenceHierarchy->getBoneCount(); j++)
+                                // instances are independent, bones implicitly animated already get recomputed to the same values
+                                DirtyInstanceBBoxes.resize(DirtyInstances.size());
+                                SolverInstances.resize(DirtyInstances.size());
+                                SolverLayers.clear();
+                                for (size_t k=0u; k<DirtyInstances.size(); k++)
+                                {
+                                    BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(DirtyInstances[k]);
+                                    SolverInstances[k].frame = currentInstance->frame;
+                                    SolverInstances[k].interpolate = currentInstance->interpolateAnimation;
+                                    SolverInstances[k].globalMatrices = getGlobalMatrices(currentInstance);
+                                    SolverInstances[k].bones = reinterpret_cast<CSoABoneSolver::SBoneOutput*>(boneData+DirtyInstances[k]);
+                                    SolverInstances[k].bbox = DirtyInstanceBBoxes.data()+k;
+                                    SolverInstances[k].layerCount = getSolverLayers(SolverLayers,DirtyInstances[k]);
+                                }
+                                // only now that SolverLayers is done growing
+                                for (size_t k=0u, firstLayer=0u; k<DirtyInstances.size(); firstLayer+=SolverInstances[k++].layerCount)
+                                    SolverInstances[k].layers = SolverInstances[k].layerCount ? SolverLayers.data()+firstLayer:nullptr;
+                                const size_t grain = core::roundUp<size_t>(core::max_<size_t>(SolverBoneGrain/referenceHierarchy->getBoneCount(),1u),CSoABoneSolver::BatchSize);
+                                core::parallel_for_range<size_t>(0u,SolverInstances.size(),[this](size_t rangeBegin, size_t rangeEnd)
                                     {
-                                        if (boneDataForInstance[j].lastAnimatedFrame==currentInstance->frame)
-                                            continue;
-                                        if (notModified)
-                                        {
-                                            localFirstDirtyInstance = i;
-                                            notModified = false;
-                                        }
-                                        localLastDirtyInstance = i;
-                                        boneDataForInstance[j].lastAnimatedFrame = currentInstance->frame;
-
-                                        asset::CFinalBoneHierarchy::AnimationKeyData upperFrame = (currentInstance->interpolateAnimation ? referenceHierarchy->getInterpolatedAnimationData(j):referenceHierarchy->getNonInterpolatedAnimationData(j))[foundKeyIx];
-
-                                        core::matrix3x4SIMD interpolatedLocalTform;
-                                        if (currentInstance->interpolateAnimation&&interpolationFactor<1.f)
-                                        {
-											asset::CFinalBoneHierarchy::AnimationKeyData lowerFrame =  (currentInstance->interpolateAnimation ? referenceHierarchy->getInterpolatedAnimationData(j):referenceHierarchy->getNonInterpolatedAnimationData(j))[foundKeyIx-1];
-                                            interpolatedLocalTform = referenceHierarchy->getMatrixFromKeys(lowerFrame,upperFrame,interpolationFactor,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
-                                        }
-                                        else
-                                            interpolatedLocalTform = referenceHierarchy->getMatrixFromKey(upperFrame);
-
-                                        if (j < referenceHierarchy->getBoneLevelRangeEnd(0))
-                                            getGlobalMatrices(currentInstance)[j] = interpolatedLocalTform.getAsRetardedIrrlichtMatrix();
-                                        else
-                                        {
-                                            const core::matrix4x3& parentTform = getGlobalMatrices(currentInstance)[referenceHierarchy->getBoneData()[j].parentOffsetFromTop];
-                                            getGlobalMatrices(currentInstance)[j] = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(parentTform), interpolatedLocalTform).getAsRetardedIrrlichtMatrix();
-                                        }
-                                        boneDataForInstance[j].SkinningTransform = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(getGlobalMatrices(currentInstance)[j]), core::matrix3x4SIMD().set(referenceHierarchy->getBoneData()[j].PoseBindMatrix)).getAsRetardedIrrlichtMatrix();
-
+                                        Solver.solve(SolverInstances.data()+rangeBegin,rangeEnd-rangeBegin);
+                                    },grain
+                                );
 
-                                        core::aabbox3df bbox;
-                                        bbox.MinEdge.X = referenceHierarchy->getBoneData()[j].MinBBoxEdge[0];
-                                        bbox.MinEdge.Y = referenceHierarchy->getBoneData()[j].MinBBoxEdge[1];
-                                        bbox.MinEdge.Z = referenceHierarchy->getBoneData()[j].MinBBoxEdge[2];
-                                        bbox.MaxEdge.X = referenceHierarchy->getBoneData()[j].MaxBBoxEdge[0];
-                                        bbox.MaxEdge.Y = referenceHierarchy->getBoneData()[j].MaxBBoxEdge[1];
-                                        bbox.MaxEdge.Z = referenceHierarchy->getBoneData()[j].MaxBBoxEdge[2];
-                                        //boneDataForInstance[j].SkinningTransform.transformBoxEx(bbox);
-										bbox = core::transformBoxEx(bbox, core::matrix3x4SIMD().set(boneDataForInstance[j].SkinningTransform));
-                                        //
-                                        if (boneControlMode==EBUM_READ)
-                                        {
-                                            IBoneSceneNode* bone = getBones(currentInstance)[j];
-                                            if (bone)
-                                            {
-												if (bone->getSkinningSpace() != IBoneSceneNode::EBSS_LOCAL)
-													bone->setRelativeTransformationMatrix(core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(attachedNodeTform), core::matrix3x4SIMD().set(getGlobalMatrices(currentInstance)[j])).getAsRetardedIrrlichtMatrix()/*concatenateBFollowedByA(attachedNodeTform,getGlobalMatrices(currentInstance)[j])*/);
-                                                else
-                                                {
-                                                    bone->setRelativeTransformationMatrix(interpolatedLocalTform.getAsRetardedIrrlichtMatrix());
-                                                    bone->updateAbsolutePosition();
-                                                }
-                                            }
-                                        }
-
-                                        boneDataForInstance[j].MinBBoxEdge[0] = bbox.MinEdge.X;
-                                        boneDataForInstance[j].MinBBoxEdge[1] = bbox.MinEdge.Y;
-                                        boneDataForInstance[j].MinBBoxEdge[2] = bbox.MinEdge.Z;
-                                        boneDataForInstance[j].MaxBBoxEdge[0] = bbox.MaxEdge.X;
-                                        boneDataForInstance[j].MaxBBoxEdge[1] = bbox.MaxEdge.Y;
-                                        boneDataForInstance[j].MaxBBoxEdge[2] = bbox.MaxEdge.Z;
-                                        boneDataForInstance[j].SkinningTransform.getSub3x3InverseTranspose(boneDataForInstance[j].SkinningNormalMatrix);
-                                    }
+                                // scene nodes are not thread safe
+                                if (boneControlMode==EBUM_READ)
+                                for (size_t k=0u; k<DirtyInstances.size(); k++)
+                                {
+                                    BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(DirtyInstances[k]);
+                                    updateBoneNodes(currentInstance,SolverInstances[k].layerCount!=0u);
                                 }
 
-                                if (!notModified)
-                                    instanceBoneDataAllocator->markRangeForPush(localFirstDirtyInstance,localLastDirtyInstance+instanceFinalBoneDataSize);
+                                instanceBoneDataAllocator->markRangeForPush(DirtyInstances.front(),DirtyInstances.back()+instanceFinalBoneDataSize);
 
                                 TrySwapBoneBuffer();
 
-                                if (!notModified)
+                                for (size_t k=0u; k<DirtyInstances.size(); k++)
                                 {
-                                    for (size_t i=localFirstDirtyInstance; i<=localLastDirtyInstance; i+=instanceFinalBoneDataSize)
-                                    {
-                                        BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(i);
-                                        if (!currentInstance->refCount || currentInstance->frame==currentInstance->lastAnimatedFrame) //in other modes, check if also has no bones!!!
-                                            continue;
-                                        currentInstance->lastAnimatedFrame = currentInstance->frame;
+                                    BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(DirtyInstances[k]);
+                                    currentInstance->lastAnimatedFrame = currentInstance->frame;
 
-                                        core::aabbox3df nodeBBox;
-                                        FinalBoneData* boneDataForInstance = reinterpret_cast<FinalBoneData*>(boneData+i);
+                                    if (boneControlMode==EBUM_READ)
+                                    {
                                         for (size_t j=0; j<referenceHierarchy->getBoneCount(); j++)
                                         {
-                                            if (boneControlMode==EBUM_READ)
-                                            {
-                                                IBoneSceneNode* bone = getBones(currentInstance)[j];
-                                                if (bone)
-                                                    bone->updateAbsolutePosition();
-                                            }
-
-                                            if (!currentInstance->attachedNode)
-                                                continue;
-
-                                            core::aabbox3df bbox;
-                                            bbox.MinEdge.X = boneDataForInstance[j].MinBBoxEdge[0];
-                                            bbox.MinEdge.Y = boneDataForInstance[j].MinBBoxEdge[1];
-                                            bbox.MinEdge.Z = boneDataForInstance[j].MinBBoxEdge[2];
-                                            bbox.MaxEdge.X = boneDataForInstance[j].MaxBBoxEdge[0];
-                                            bbox.MaxEdge.Y = boneDataForInstance[j].MaxBBoxEdge[1];
-                                            bbox.MaxEdge.Z = boneDataForInstance[j].MaxBBoxEdge[2];
-                                            if (j)
-                                                nodeBBox.addInternalBox(bbox);
-                                            else
-                                                nodeBBox = bbox;
+                                            IBoneSceneNode* bone = getBones(currentInstance)[j];
+                                            if (bone)
+                                                bone->updateAbsolutePosition();
                                         }
-
-                                        if (currentInstance->attachedNode)
-                                            currentInstance->attachedNode->setBoundingBox(nodeBBox);
                                     }
+
+                                    if (currentInstance->attachedNode)
+                                        currentInstance->attachedNode->setBoundingBox(DirtyInstanceBBoxes[k]);
                                 }
                             }
                             break;
@@ -38,6 +38,9 @@ class CSkyDomeSceneNode : public ISceneNode
 		virtual uint32_t getMaterialCount() const;
 		virtual ESCENE_NODE_TYPE getType() const { return ESNT_SKY_DOME; }
 
+		//! Neither OnAnimate() nor updateAbsolutePosition() are overridden, so the scene manager may animate it level by level
+		virtual bool supportsLevelOrderedUpdate() const { return true; }
+
 		virtual ISceneNode* clone(IDummyTransformationSceneNode* newParent=0, ISceneManager* newManager=0) { assert(false); return nullptr; }
 
 	private:
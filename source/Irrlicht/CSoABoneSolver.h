@@ -0,0 +1,866 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_SOA_BONE_SOLVER_H_INCLUDED__
+#define __C_SOA_BONE_SOLVER_H_INCLUDED__
+
+#include "CFinalBoneHierarchy.h"
+
+namespace irr
+{
+namespace scene
+{
+
+    //! Evaluates the animation of a CFinalBoneHierarchy for many instances, four bones at a time
+    /**
+        Everything is kept in structure-of-arrays form, one SSE lane per bone and one register per matrix element, from the keyframe gather
+        all the way to the final store. Interpolation, the local matrix, the concatenation with the parent and the pose-bind matrix,
+        the bounding box and the normal matrix never go through matrix4x3 or matrix3x4SIMD, records only get transposed back
+        to the instance's array of structures on the way out.
+
+        The lanes can be filled in two ways:
+        - EB_BONES puts up to 4 bones of the same hierarchy level in the lanes (they only depend on the levels above), one instance at a time
+        - EB_INSTANCES puts the same bone of 4 instances in the lanes and walks the hierarchy bone by bone,
+        which keeps every lane busy on narrow hierarchies (long chains, levels of 1-2 bones) where EB_BONES would leave most lanes empty
+
+        Hierarchies with compressed animations get every instance's bone poses decoded with CCompressedBoneAnimation::sample first,
+        the lanes then load the decoded keys instead of gathering and blending two keyframes.
+
+        An instance can also be a stack of layers (clips at their own frames with weights, per bone weights and additive layers),
+        the layers get blended in the same registers right before the local matrix is built, so the bones are still only walked once.
+
+        The solver only reads the hierarchy, so a single one can be used by any amount of threads at once.
+    */
+    class CSoABoneSolver
+    {
+        public:
+            _IRR_STATIC_INLINE_CONSTEXPR uint32_t BatchSize = 4u;
+
+            enum E_BATCHING
+            {
+                //! picks EB_INSTANCES if EB_BONES would leave more than a sixth of the lanes empty
+                EB_AUTO = 0,
+                EB_BONES,
+                EB_INSTANCES
+            };
+
+            //! What gets written per bone, same layout as ISkinningStateManager::FinalBoneData
+            #include "irr/irrpack.h"
+            struct SBoneOutput
+            {
+                float SkinningTransform[12];
+                float SkinningNormalMatrix[9];
+                float MinBBoxEdge[3];
+                float MaxBBoxEdge[3];
+                float lastAnimatedFrame;
+            } PACK_STRUCT;
+            #include "irr/irrunpack.h"
+
+            //! One clip of an instance's layer stack, see ISkinningStateManager::SAnimationLayer for how they blend
+            struct SLayer
+            {
+                float frame;
+                //! frame of the pose an additive layer is relative to
+                float referenceFrame;
+                float weight;
+                //! multiplies `weight` per bone, nullptr for a weight of 1 everywhere
+                const float* boneWeights;
+                bool interpolate;
+                bool additive;
+            };
+
+            //! One instance to animate, `globalMatrices` and `bones` need room for every bone of the hierarchy
+            struct SInstance
+            {
+                //! also what `lastAnimatedFrame` of the bones gets set to when the instance has layers
+                float frame;
+                bool interpolate;
+                core::matrix4x3* globalMatrices;
+                SBoneOutput* bones;
+                //! receives the union of the bone bboxes
+                core::aabbox3df* bbox;
+                //! if `layerCount` is not 0 the pose is blended from these instead of `frame` and `interpolate`
+                const SLayer* layers;
+                uint32_t layerCount;
+            };
+
+            CSoABoneSolver(const asset::CFinalBoneHierarchy* _hierarchy, E_BATCHING _batching=EB_AUTO) : Hierarchy(_hierarchy)
+            {
+                Hierarchy->grab();
+
+                for (size_t level=0u; level<Hierarchy->getHierarchyLevels(); level++)
+                {
+                    const size_t levelEnd = Hierarchy->getBoneLevelRangeEnd(level);
+                    for (size_t first=Hierarchy->getBoneLevelRangeStart(level); first<levelEnd; first+=BatchSize)
+                    {
+                        SBatch batch;
+                        batch.Count = core::min_<size_t>(BatchSize,levelEnd-first);
+                        batch.Root = level==0u;
+
+                        // unused lanes repeat the last bone, so they load valid data and do not change the instance bbox
+                        const float* poseBind[BatchSize];
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                        {
+                            const uint32_t bone = first+core::min_(lane,batch.Count-1u);
+                            const asset::CFinalBoneHierarchy::BoneReferenceData& boneData = Hierarchy->getBoneData()[bone];
+                            batch.Bone[lane] = bone;
+                            batch.Parent[lane] = boneData.parentOffsetFromTop;
+                            poseBind[lane] = boneData.PoseBindMatrix.pointer();
+                            for (uint32_t i=0u; i<3u; i++)
+                            {
+                                batch.MinBBoxEdge[i][lane] = boneData.MinBBoxEdge[i];
+                                batch.MaxBBoxEdge[i][lane] = boneData.MaxBBoxEdge[i];
+                            }
+                        }
+
+                        __m128 matrix[12];
+                        loadMatrices(matrix,poseBind);
+                        for (uint32_t i=0u; i<12u; i++)
+                            _mm_storeu_ps(batch.PoseBind[i],matrix[i]);
+
+                        Batches.push_back(batch);
+                    }
+                }
+
+                if (_batching==EB_AUTO)
+                    _batching = Hierarchy->getBoneCount()*6u<Batches.size()*BatchSize*5u ? EB_INSTANCES:EB_BONES;
+                Batching = _batching;
+            }
+            CSoABoneSolver(const CSoABoneSolver&) = delete;
+            CSoABoneSolver& operator=(const CSoABoneSolver&) = delete;
+
+            ~CSoABoneSolver()
+            {
+                Hierarchy->drop();
+            }
+
+            inline const asset::CFinalBoneHierarchy* getHierarchy() const {return Hierarchy;}
+
+            inline E_BATCHING getBatching() const {return Batching;}
+
+            //! Computes the global matrices, the bone records and the bboxes of `_count` instances
+            /** Gives the same results as evaluating every bone with CFinalBoneHierarchy::getMatrixFromKeys and the matrix3x4SIMD functions,
+            except that a bone with a singular skinning transform gets a zero normal matrix instead of keeping its old one. */
+            inline void solve(const SInstance* _instances, size_t _count) const
+            {
+                // room for the decoded poses and the layers of a batch of instances
+                const size_t lanes = Batching==EB_INSTANCES ? BatchSize:1u;
+                SScratch scratch = {nullptr,1u,nullptr,0u};
+                for (size_t i=0u; i<_count; i++)
+                {
+                    scratch.PosesPerLane = core::max_(scratch.PosesPerLane,getPoseCount(_instances[i]));
+                    scratch.LayersPerLane = core::max_(scratch.LayersPerLane,_instances[i].layerCount);
+                }
+                core::vector<asset::CFinalBoneHierarchy::AnimationKeyData> decoded;
+                if (Hierarchy->hasCompressedAnimations())
+                {
+                    decoded.resize(Hierarchy->getBoneCount()*lanes*scratch.PosesPerLane);
+                    scratch.Decoded = decoded.data();
+                }
+                core::vector<SLayerSource> layers(lanes*scratch.LayersPerLane);
+                scratch.Layers = layers.data();
+
+                if (Batching==EB_INSTANCES)
+                {
+                    for (size_t i=0u; i<_count; i+=BatchSize)
+                        solveInstanceBatch(_instances+i,core::min_<size_t>(BatchSize,_count-i),scratch);
+                }
+                else
+                {
+                    for (size_t i=0u; i<_count; i++)
+                        solveBoneBatches(_instances[i],scratch);
+                }
+            }
+
+            //! Single instance version of `solve`, returns the union of the bone bboxes
+            inline core::aabbox3df solve(float _frame, bool _interpolate, core::matrix4x3* _globalMatrices, SBoneOutput* _outBones) const
+            {
+                core::aabbox3df retval;
+                const SInstance instance = {_frame,_interpolate,_globalMatrices,_outBones,&retval,nullptr,0u};
+                solve(&instance,1u);
+                return retval;
+            }
+
+        private:
+            struct SBatch
+            {
+                //! element [row*4+column] of the 3x4 matrix for every lane
+                float PoseBind[12][BatchSize];
+                float MinBBoxEdge[3][BatchSize];
+                float MaxBBoxEdge[3][BatchSize];
+                uint32_t Bone[BatchSize];
+                uint32_t Parent[BatchSize];
+                uint32_t Count;
+                bool Root;
+            };
+
+            struct SKeys
+            {
+                __m128 Rotation[4];
+                __m128 Position[3];
+                __m128 Scale[3];
+            };
+
+            //! what the animation of a bone depends on, per lane
+            struct SInterpolation
+            {
+                __m128 Interpolant;
+                __m128 Term2;
+                __m128 Term3;
+            };
+
+            //! where the keys of a pose are, bone `b` gets blended from `Lower[b*stride]` and `Upper[b*stride]` (see `getKeyStride`)
+            struct SPoseSource
+            {
+                const asset::CFinalBoneHierarchy::AnimationKeyData* Lower;
+                const asset::CFinalBoneHierarchy::AnimationKeyData* Upper;
+                float Interpolant;
+                float Term2;
+                float Term3;
+            };
+
+            //! an SLayer with its poses looked up
+            struct SLayerSource
+            {
+                SPoseSource Pose;
+                //! only used by additive layers
+                SPoseSource Reference;
+                float Weight;
+                const float* BoneWeights;
+                bool Additive;
+            };
+
+            //! per thread memory of `solve`, every lane gets `PosesPerLane` decoded poses and `LayersPerLane` layers
+            struct SScratch
+            {
+                asset::CFinalBoneHierarchy::AnimationKeyData* Decoded;
+                uint32_t PosesPerLane;
+                SLayerSource* Layers;
+                uint32_t LayersPerLane;
+            };
+
+            //! number of poses an instance samples, only matters for compressed animations which need somewhere to decode them to
+            static inline uint32_t getPoseCount(const SInstance& _instance)
+            {
+                uint32_t retval = _instance.layerCount ? 0u:1u;
+                for (uint32_t i=0u; i<_instance.layerCount; i++)
+                    retval += _instance.layers[i].additive&&i ? 2u:1u;
+                return retval;
+            }
+
+            inline size_t getKeyStride() const {return Hierarchy->hasCompressedAnimations() ? 1u:Hierarchy->getKeyFrameCount();}
+
+            //! finds the keys around `_frame`, compressed animations get decoded to `_decoded` which then moves past the pose
+            inline SPoseSource getPoseSource(float _frame, bool _interpolate, asset::CFinalBoneHierarchy::AnimationKeyData*& _decoded) const
+            {
+                SPoseSource retval;
+                float interpolationFactor;
+                const size_t foundKeyIx = Hierarchy->getLowerBoundBoneKeyframes(interpolationFactor,_frame);
+                if (_decoded)
+                {
+                    // one already blended key per bone
+                    Hierarchy->getCompressedAnimations()->sample(_decoded,0u,Hierarchy->getBoneCount(),Hierarchy->getKeys(),foundKeyIx,_frame,_interpolate);
+                    retval.Upper = _decoded;
+                    _decoded += Hierarchy->getBoneCount();
+                    interpolationFactor = 1.f;
+                }
+                else
+                    retval.Upper = (_interpolate ? Hierarchy->getInterpolatedAnimationData():Hierarchy->getNonInterpolatedAnimationData())+foundKeyIx;
+
+                // blending a key with itself at the end gives back the key, same as CFinalBoneHierarchy::getMatrixFromKey
+                if (_interpolate&&interpolationFactor<1.f)
+                {
+                    retval.Lower = retval.Upper-1;
+                    retval.Interpolant = interpolationFactor;
+                    core::quaternion::flerp_interpolant_terms(retval.Term2,retval.Term3,interpolationFactor);
+                }
+                else
+                {
+                    retval.Lower = retval.Upper;
+                    retval.Interpolant = 1.f;
+                    retval.Term2 = 0.25f;
+                    retval.Term3 = 0.f;
+                }
+                return retval;
+            }
+
+            //! fills `_layerCount` layers, an instance without layers becomes a single one and missing layers are padded with ones of no weight
+            inline void getLayerSources(SLayerSource* _out, uint32_t _layerCount, const SInstance& _instance, asset::CFinalBoneHierarchy::AnimationKeyData* _decoded) const
+            {
+                uint32_t i = 0u;
+                if (!_instance.layerCount)
+                {
+                    _out[0].Pose = _out[0].Reference = getPoseSource(_instance.frame,_instance.interpolate,_decoded);
+                    i++;
+                }
+                for (; i<_instance.layerCount; i++)
+                {
+                    const SLayer& layer = _instance.layers[i];
+                    _out[i].Pose = _out[i].Reference = getPoseSource(layer.frame,layer.interpolate,_decoded);
+                    _out[i].Weight = layer.weight;
+                    _out[i].BoneWeights = layer.boneWeights;
+                    // the first layer is the base pose
+                    _out[i].Additive = layer.additive&&i;
+                    if (_out[i].Additive)
+                        _out[i].Reference = getPoseSource(layer.referenceFrame,layer.interpolate,_decoded);
+                }
+                for (; i<_layerCount; i++)
+                {
+                    _out[i] = _out[0];
+                    _out[i].Weight = 0.f;
+                    _out[i].Additive = false;
+                }
+            }
+
+            //! lanes are bones of a level, the interpolation is the same for all of them
+            inline void solveBoneBatches(const SInstance& _instance, const SScratch& _scratch) const
+            {
+                asset::CFinalBoneHierarchy::AnimationKeyData* decoded = _scratch.Decoded;
+                const size_t keyStride = getKeyStride();
+                const SLayerSource* layers[BatchSize];
+                SPoseSource source = {nullptr,nullptr,1.f,0.25f,0.f};
+                if (_instance.layerCount)
+                {
+                    getLayerSources(_scratch.Layers,_instance.layerCount,_instance,decoded);
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                        layers[lane] = _scratch.Layers;
+                }
+                else
+                    source = getPoseSource(_instance.frame,_instance.interpolate,decoded);
+                const bool blend = source.Lower!=source.Upper;
+                const SInterpolation interpolation = {_mm_set1_ps(source.Interpolant),_mm_set1_ps(source.Term2),_mm_set1_ps(source.Term3)};
+                const __m128 frame = _mm_set1_ps(_instance.frame);
+
+                __m128 instanceMin[3],instanceMax[3];
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    instanceMin[i] = _mm_set1_ps(FLT_MAX);
+                    instanceMax[i] = _mm_set1_ps(-FLT_MAX);
+                }
+
+                for (const SBatch& batch : Batches)
+                {
+                    SKeys upper;
+                    if (_instance.layerCount)
+                        blendLayers(upper,layers,_instance.layerCount,batch.Bone,keyStride);
+                    else
+                    {
+                        const asset::CFinalBoneHierarchy::AnimationKeyData* keys[BatchSize];
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                            keys[lane] = source.Upper+keyStride*batch.Bone[lane];
+                        loadKeys(upper,keys,0);
+                        if (blend)
+                        {
+                            SKeys lower;
+                            for (uint32_t lane=0u; lane<BatchSize; lane++)
+                                keys[lane] = source.Lower+keyStride*batch.Bone[lane];
+                            loadKeys(lower,keys,0);
+                            interpolate(upper,lower,interpolation);
+                        }
+                    }
+
+                    __m128 global[12];
+                    computeLocal(global,upper);
+                    if (!batch.Root)
+                    {
+                        const float* parents[BatchSize];
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                            parents[lane] = _instance.globalMatrices[batch.Parent[lane]].pointer();
+                        __m128 parent[12],local[12];
+                        loadMatrices(parent,parents);
+                        for (uint32_t i=0u; i<12u; i++)
+                            local[i] = global[i];
+                        concatenate(global,parent,local);
+                    }
+                    float* globals[BatchSize];
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                        globals[lane] = _instance.globalMatrices[batch.Bone[lane]].pointer();
+                    storeMatrices(globals,global,batch.Count);
+
+                    __m128 poseBind[12],inMin[3],inMax[3];
+                    for (uint32_t i=0u; i<12u; i++)
+                        poseBind[i] = _mm_loadu_ps(batch.PoseBind[i]);
+                    for (uint32_t i=0u; i<3u; i++)
+                    {
+                        inMin[i] = _mm_loadu_ps(batch.MinBBoxEdge[i]);
+                        inMax[i] = _mm_loadu_ps(batch.MaxBBoxEdge[i]);
+                    }
+                    __m128 record[7][4];
+                    finishBones(record,instanceMin,instanceMax,global,poseBind,inMin,inMax,frame);
+                    for (uint32_t lane=0u; lane<batch.Count; lane++)
+                    {
+                        float* out = reinterpret_cast<float*>(_instance.bones+batch.Bone[lane]);
+                        for (uint32_t i=0u; i<7u; i++)
+                            _mm_storeu_ps(out+i*4u,record[i][lane]);
+                    }
+                }
+
+                float* outMin = &_instance.bbox->MinEdge.X;
+                float* outMax = &_instance.bbox->MaxEdge.X;
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    __m128 tmp = _mm_min_ps(instanceMin[i],_mm_movehl_ps(instanceMin[i],instanceMin[i]));
+                    outMin[i] = _mm_cvtss_f32(_mm_min_ss(tmp,_mm_shuffle_ps(tmp,tmp,_MM_SHUFFLE(1,1,1,1))));
+                    tmp = _mm_max_ps(instanceMax[i],_mm_movehl_ps(instanceMax[i],instanceMax[i]));
+                    outMax[i] = _mm_cvtss_f32(_mm_max_ss(tmp,_mm_shuffle_ps(tmp,tmp,_MM_SHUFFLE(1,1,1,1))));
+                }
+            }
+
+            //! lanes are instances, unused ones repeat the last instance and are not stored
+            inline void solveInstanceBatch(const SInstance* _instances, size_t _count, const SScratch& _scratch) const
+            {
+                const SInstance* instances[BatchSize];
+                uint32_t layerCount = 0u;
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                {
+                    instances[lane] = _instances+core::min_<size_t>(lane,_count-1u);
+                    layerCount = core::max_(layerCount,instances[lane]->layerCount);
+                }
+
+                // with any layers in the batch every lane goes through the layer blending
+                SPoseSource poses[BatchSize];
+                const SPoseSource* sources[BatchSize];
+                const SLayerSource* layers[BatchSize];
+                alignas(16) float frame[BatchSize];
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                {
+                    asset::CFinalBoneHierarchy::AnimationKeyData* decoded = _scratch.Decoded ? _scratch.Decoded+Hierarchy->getBoneCount()*_scratch.PosesPerLane*lane:nullptr;
+                    if (layerCount)
+                    {
+                        SLayerSource* laneLayers = _scratch.Layers+_scratch.LayersPerLane*lane;
+                        getLayerSources(laneLayers,layerCount,*instances[lane],decoded);
+                        layers[lane] = laneLayers;
+                    }
+                    else
+                    {
+                        poses[lane] = getPoseSource(instances[lane]->frame,instances[lane]->interpolate,decoded);
+                        sources[lane] = poses+lane;
+                    }
+                    frame[lane] = instances[lane]->frame;
+                }
+                const __m128 frames = _mm_load_ps(frame);
+                const size_t keyStride = getKeyStride();
+
+                __m128 instanceMin[3],instanceMax[3];
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    instanceMin[i] = _mm_set1_ps(FLT_MAX);
+                    instanceMax[i] = _mm_set1_ps(-FLT_MAX);
+                }
+
+                const size_t rootEnd = Hierarchy->getBoneLevelRangeEnd(0u);
+                for (size_t bone=0u; bone<Hierarchy->getBoneCount(); bone++)
+                {
+                    const asset::CFinalBoneHierarchy::BoneReferenceData& boneData = Hierarchy->getBoneData()[bone];
+
+                    const uint32_t bones[BatchSize] = {uint32_t(bone),uint32_t(bone),uint32_t(bone),uint32_t(bone)};
+                    SKeys upper;
+                    if (layerCount)
+                        blendLayers(upper,layers,layerCount,bones,keyStride);
+                    else
+                        loadPose(upper,sources,bones,keyStride);
+
+                    __m128 global[12];
+                    computeLocal(global,upper);
+                    if (bone>=rootEnd)
+                    {
+                        const float* parents[BatchSize];
+                        for (uint32_t lane=0u; lane<BatchSize; lane++)
+                            parents[lane] = instances[lane]->globalMatrices[boneData.parentOffsetFromTop].pointer();
+                        __m128 parent[12],local[12];
+                        loadMatrices(parent,parents);
+                        for (uint32_t i=0u; i<12u; i++)
+                            local[i] = global[i];
+                        concatenate(global,parent,local);
+                    }
+                    float* globals[BatchSize];
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                        globals[lane] = instances[lane]->globalMatrices[bone].pointer();
+                    storeMatrices(globals,global,_count);
+
+                    // the bone constants are the same in every lane
+                    const float* poseBindPtr = boneData.PoseBindMatrix.pointer();
+                    __m128 poseBind[12],inMin[3],inMax[3];
+                    for (uint32_t row=0u; row<3u; row++)
+                    for (uint32_t col=0u; col<4u; col++)
+                        poseBind[row*4u+col] = _mm_set1_ps(poseBindPtr[col*3u+row]);
+                    for (uint32_t i=0u; i<3u; i++)
+                    {
+                        inMin[i] = _mm_set1_ps(boneData.MinBBoxEdge[i]);
+                        inMax[i] = _mm_set1_ps(boneData.MaxBBoxEdge[i]);
+                    }
+                    __m128 record[7][4];
+                    finishBones(record,instanceMin,instanceMax,global,poseBind,inMin,inMax,frames);
+                    for (uint32_t lane=0u; lane<_count; lane++)
+                    {
+                        float* out = reinterpret_cast<float*>(instances[lane]->bones+bone);
+                        for (uint32_t i=0u; i<7u; i++)
+                            _mm_storeu_ps(out+i*4u,record[i][lane]);
+                    }
+                }
+
+                // lanes already are the instances, so the transpose hands out one bbox each
+                __m128 boxes[2][4] = {
+                    {instanceMin[0],instanceMin[1],instanceMin[2],_mm_setzero_ps()},
+                    {instanceMax[0],instanceMax[1],instanceMax[2],_mm_setzero_ps()}
+                };
+                _MM_TRANSPOSE4_PS(boxes[0][0],boxes[0][1],boxes[0][2],boxes[0][3]);
+                _MM_TRANSPOSE4_PS(boxes[1][0],boxes[1][1],boxes[1][2],boxes[1][3]);
+                for (uint32_t lane=0u; lane<_count; lane++)
+                {
+                    alignas(16) float tmp[2][4];
+                    _mm_store_ps(tmp[0],boxes[0][lane]);
+                    _mm_store_ps(tmp[1],boxes[1][lane]);
+                    instances[lane]->bbox->MinEdge.set(tmp[0][0],tmp[0][1],tmp[0][2]);
+                    instances[lane]->bbox->MaxEdge.set(tmp[1][0],tmp[1][1],tmp[1][2]);
+                }
+            }
+
+            //! matrix4x3 is 12 floats stored column by column, 3 transposes turn 4 of them into the [row*4+column] registers
+            static inline void loadMatrices(__m128 _out[12], const float* const _in[BatchSize])
+            {
+                __m128 tmp[3][4];
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                for (uint32_t i=0u; i<3u; i++)
+                    tmp[i][lane] = _mm_loadu_ps(_in[lane]+i*4u);
+                for (uint32_t i=0u; i<3u; i++)
+                    _MM_TRANSPOSE4_PS(tmp[i][0],tmp[i][1],tmp[i][2],tmp[i][3]);
+
+                _out[0] = tmp[0][0]; _out[4] = tmp[0][1]; _out[8] = tmp[0][2]; _out[1] = tmp[0][3];
+                _out[5] = tmp[1][0]; _out[9] = tmp[1][1]; _out[2] = tmp[1][2]; _out[6] = tmp[1][3];
+                _out[10] = tmp[2][0]; _out[3] = tmp[2][1]; _out[7] = tmp[2][2]; _out[11] = tmp[2][3];
+            }
+            static inline void storeMatrices(float* const _out[BatchSize], const __m128 _in[12], size_t _count)
+            {
+                __m128 tmp[3][4] = {
+                    {_in[0],_in[4],_in[8],_in[1]},
+                    {_in[5],_in[9],_in[2],_in[6]},
+                    {_in[10],_in[3],_in[7],_in[11]}
+                };
+                for (uint32_t i=0u; i<3u; i++)
+                    _MM_TRANSPOSE4_PS(tmp[i][0],tmp[i][1],tmp[i][2],tmp[i][3]);
+                for (uint32_t lane=0u; lane<_count; lane++)
+                for (uint32_t i=0u; i<3u; i++)
+                    _mm_storeu_ps(_out[lane]+i*4u,tmp[i][lane]);
+            }
+
+            //! AnimationKeyData is Rotation[4], Position[3], Scale[3], Padding[2]
+            static inline void loadKeys(SKeys& _out, const asset::CFinalBoneHierarchy::AnimationKeyData* const _keys[BatchSize], ptrdiff_t _offset)
+            {
+                __m128 pos[4],scale[4];
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                {
+                    const asset::CFinalBoneHierarchy::AnimationKeyData& key = _keys[lane][_offset];
+                    _out.Rotation[lane] = _mm_loadu_ps(key.Rotation);
+                    pos[lane] = _mm_loadu_ps(key.Position);
+                    scale[lane] = _mm_loadu_ps(key.Scale);
+                }
+                _MM_TRANSPOSE4_PS(_out.Rotation[0],_out.Rotation[1],_out.Rotation[2],_out.Rotation[3]);
+                _MM_TRANSPOSE4_PS(pos[0],pos[1],pos[2],pos[3]);
+                _MM_TRANSPOSE4_PS(scale[0],scale[1],scale[2],scale[3]);
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    _out.Position[i] = pos[i];
+                    _out.Scale[i] = scale[i];
+                }
+            }
+
+            static inline __m128 dot4(const __m128 _a[4], const __m128 _b[4])
+            {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_a[0],_b[0]),_mm_mul_ps(_a[1],_b[1])),_mm_add_ps(_mm_mul_ps(_a[2],_b[2]),_mm_mul_ps(_a[3],_b[3])));
+            }
+
+            //! `_upper` becomes the blend of `_lower` and `_upper`, quaternions as in CFinalBoneHierarchy::getMatrixFromKeys without the normalization
+            static inline void interpolate(SKeys& _upper, const SKeys& _lower, const SInterpolation& _interpolation)
+            {
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    _upper.Position[i] = _mm_add_ps(_lower.Position[i],_mm_mul_ps(_mm_sub_ps(_upper.Position[i],_lower.Position[i]),_interpolation.Interpolant));
+                    _upper.Scale[i] = _mm_add_ps(_lower.Scale[i],_mm_mul_ps(_mm_sub_ps(_upper.Scale[i],_lower.Scale[i]),_interpolation.Interpolant));
+                }
+
+                // quaternion::flerp_adjustedinterpolant and the short way round lerp
+                const __m128 signBit = _mm_set1_ps(-0.f);
+                const __m128 angle = dot4(_lower.Rotation,_upper.Rotation);
+                const __m128 wrongDoubleCover = _mm_and_ps(angle,signBit);
+                const __m128 absAngle = _mm_andnot_ps(signBit,angle);
+                __m128 A = _mm_add_ps(_mm_set1_ps(3.55645f),_mm_mul_ps(absAngle,_mm_set1_ps(-1.43519f)));
+                A = _mm_add_ps(_mm_set1_ps(-3.2452f),_mm_mul_ps(absAngle,A));
+                A = _mm_add_ps(_mm_set1_ps(1.0904f),_mm_mul_ps(absAngle,A));
+                __m128 B = _mm_add_ps(_mm_set1_ps(-1.06021f),_mm_mul_ps(absAngle,_mm_set1_ps(0.215638f)));
+                B = _mm_add_ps(_mm_set1_ps(0.848013f),_mm_mul_ps(absAngle,B));
+                const __m128 k = _mm_add_ps(_mm_mul_ps(A,_interpolation.Term2),B);
+                const __m128 adjustedInterpolant = _mm_add_ps(_interpolation.Interpolant,_mm_mul_ps(_interpolation.Term3,k));
+                for (uint32_t i=0u; i<4u; i++)
+                    _upper.Rotation[i] = _mm_add_ps(_lower.Rotation[i],_mm_mul_ps(_mm_sub_ps(_mm_xor_ps(_upper.Rotation[i],wrongDoubleCover),_lower.Rotation[i]),adjustedInterpolant));
+            }
+
+            //! keys of bone `_bones[lane]` from `_sources[lane]` in every lane, interpolated as in `interpolate`
+            static inline void loadPose(SKeys& _out, const SPoseSource* const _sources[BatchSize], const uint32_t _bones[BatchSize], size_t _keyStride)
+            {
+                const asset::CFinalBoneHierarchy::AnimationKeyData* keys[BatchSize];
+                bool blend = false;
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                {
+                    keys[lane] = _sources[lane]->Upper+_keyStride*_bones[lane];
+                    blend = blend||_sources[lane]->Lower!=_sources[lane]->Upper;
+                }
+                loadKeys(_out,keys,0);
+                if (!blend)
+                    return;
+
+                SKeys lower;
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                    keys[lane] = _sources[lane]->Lower+_keyStride*_bones[lane];
+                loadKeys(lower,keys,0);
+                const SInterpolation interpolation = {
+                    _mm_setr_ps(_sources[0]->Interpolant,_sources[1]->Interpolant,_sources[2]->Interpolant,_sources[3]->Interpolant),
+                    _mm_setr_ps(_sources[0]->Term2,_sources[1]->Term2,_sources[2]->Term2,_sources[3]->Term2),
+                    _mm_setr_ps(_sources[0]->Term3,_sources[1]->Term3,_sources[2]->Term3,_sources[3]->Term3)
+                };
+                interpolate(_out,lower,interpolation);
+            }
+
+            static inline void normalizeRotation(__m128 _rotation[4])
+            {
+                const __m128 dot = dot4(_rotation,_rotation);
+#ifdef __IRR_FAST_MATH
+                const __m128 rcpLen = _mm_rsqrt_ps(dot);
+#else
+                const __m128 rcpLen = _mm_div_ps(_mm_set1_ps(1.f),_mm_sqrt_ps(dot));
+#endif
+                for (uint32_t i=0u; i<4u; i++)
+                    _rotation[i] = _mm_mul_ps(_rotation[i],rcpLen);
+            }
+
+            //! Hamilton product, the rotation of `_out` is that of `_b` followed by `_a`
+            static inline void multiplyRotations(__m128 _out[4], const __m128 _a[4], const __m128 _b[4])
+            {
+                const __m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_a[3],_b[0]),_mm_mul_ps(_a[0],_b[3])),_mm_mul_ps(_a[1],_b[2])),_mm_mul_ps(_a[2],_b[1]));
+                const __m128 y = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_a[3],_b[1]),_mm_mul_ps(_a[0],_b[2])),_mm_add_ps(_mm_mul_ps(_a[1],_b[3]),_mm_mul_ps(_a[2],_b[0])));
+                const __m128 z = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(_a[3],_b[2]),_mm_mul_ps(_a[0],_b[1])),_mm_mul_ps(_a[1],_b[0])),_mm_mul_ps(_a[2],_b[3]));
+                const __m128 w = _mm_sub_ps(_mm_mul_ps(_a[3],_b[3]),_mm_add_ps(_mm_add_ps(_mm_mul_ps(_a[0],_b[0]),_mm_mul_ps(_a[1],_b[1])),_mm_mul_ps(_a[2],_b[2])));
+                _out[0] = x;
+                _out[1] = y;
+                _out[2] = z;
+                _out[3] = w;
+            }
+
+            //! moves `_base` towards `_pose` by `_weight`, the rotation the short way round, both have to be normalized
+            static inline void blendOverride(SKeys& _out, const SKeys& _base, const SKeys& _pose, const __m128& _weight)
+            {
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    _out.Position[i] = _mm_add_ps(_base.Position[i],_mm_mul_ps(_mm_sub_ps(_pose.Position[i],_base.Position[i]),_weight));
+                    _out.Scale[i] = _mm_add_ps(_base.Scale[i],_mm_mul_ps(_mm_sub_ps(_pose.Scale[i],_base.Scale[i]),_weight));
+                }
+                const __m128 wrongDoubleCover = _mm_and_ps(dot4(_base.Rotation,_pose.Rotation),_mm_set1_ps(-0.f));
+                for (uint32_t i=0u; i<4u; i++)
+                    _out.Rotation[i] = _mm_add_ps(_base.Rotation[i],_mm_mul_ps(_mm_sub_ps(_mm_xor_ps(_pose.Rotation[i],wrongDoubleCover),_base.Rotation[i]),_weight));
+                normalizeRotation(_out.Rotation);
+            }
+
+            //! applies the difference between `_reference` and `_pose` to `_base` in the bone's local space, scaled by `_weight`, `_pose` has to be normalized
+            static inline void blendAdditive(SKeys& _out, const SKeys& _base, const SKeys& _pose, SKeys& _reference, const __m128& _weight)
+            {
+                const __m128 one = _mm_set1_ps(1.f);
+                for (uint32_t i=0u; i<3u; i++)
+                {
+                    _out.Position[i] = _mm_add_ps(_base.Position[i],_mm_mul_ps(_mm_sub_ps(_pose.Position[i],_reference.Position[i]),_weight));
+                    const __m128 scaleDelta = _mm_sub_ps(_mm_div_ps(_pose.Scale[i],_reference.Scale[i]),one);
+                    _out.Scale[i] = _mm_mul_ps(_base.Scale[i],_mm_add_ps(one,_mm_mul_ps(scaleDelta,_weight)));
+                }
+
+                // delta = conjugate(reference)*pose, lerped from identity by the weight on the short way round
+                normalizeRotation(_reference.Rotation);
+                const __m128 signBit = _mm_set1_ps(-0.f);
+                const __m128 conjugate[4] = {_mm_xor_ps(_reference.Rotation[0],signBit),_mm_xor_ps(_reference.Rotation[1],signBit),_mm_xor_ps(_reference.Rotation[2],signBit),_reference.Rotation[3]};
+                __m128 delta[4];
+                multiplyRotations(delta,conjugate,_pose.Rotation);
+                const __m128 wrongDoubleCover = _mm_and_ps(delta[3],signBit);
+                for (uint32_t i=0u; i<3u; i++)
+                    delta[i] = _mm_mul_ps(_mm_xor_ps(delta[i],wrongDoubleCover),_weight);
+                delta[3] = _mm_add_ps(one,_mm_mul_ps(_mm_sub_ps(_mm_xor_ps(delta[3],wrongDoubleCover),one),_weight));
+                normalizeRotation(delta);
+                multiplyRotations(_out.Rotation,_base.Rotation,delta);
+            }
+
+            //! the first layer of every lane is the base pose, the others get blended over it in order
+            static inline void blendLayers(SKeys& _out, const SLayerSource* const _layers[BatchSize], uint32_t _layerCount, const uint32_t _bones[BatchSize], size_t _keyStride)
+            {
+                const SPoseSource* sources[BatchSize];
+                for (uint32_t lane=0u; lane<BatchSize; lane++)
+                    sources[lane] = &_layers[lane][0].Pose;
+                loadPose(_out,sources,_bones,_keyStride);
+                normalizeRotation(_out.Rotation);
+
+                for (uint32_t i=1u; i<_layerCount; i++)
+                {
+                    alignas(16) float weights[BatchSize];
+                    uint32_t additiveLanes = 0u;
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                    {
+                        const SLayerSource& layer = _layers[lane][i];
+                        sources[lane] = &layer.Pose;
+                        weights[lane] = layer.BoneWeights ? layer.Weight*layer.BoneWeights[_bones[lane]]:layer.Weight;
+                        additiveLanes |= uint32_t(layer.Additive)<<lane;
+                    }
+                    const __m128 weight = _mm_load_ps(weights);
+                    // masked out everywhere, typically an upper body layer in a batch of leg bones
+                    if (_mm_movemask_ps(_mm_cmpneq_ps(weight,_mm_setzero_ps()))==0)
+                        continue;
+
+                    // interpolated keys are not unit length, which would skew the weights
+                    SKeys pose;
+                    loadPose(pose,sources,_bones,_keyStride);
+                    normalizeRotation(pose.Rotation);
+                    if (!additiveLanes)
+                    {
+                        blendOverride(_out,_out,pose,weight);
+                        continue;
+                    }
+
+                    SKeys reference,additive;
+                    for (uint32_t lane=0u; lane<BatchSize; lane++)
+                        sources[lane] = &_layers[lane][i].Reference;
+                    loadPose(reference,sources,_bones,_keyStride);
+                    if (additiveLanes==(1u<<BatchSize)-1u)
+                    {
+                        blendAdditive(_out,_out,pose,reference,weight);
+                        continue;
+                    }
+
+                    // lanes of different instances can disagree
+                    SKeys overridden;
+                    blendOverride(overridden,_out,pose,weight);
+                    blendAdditive(additive,_out,pose,reference,weight);
+                    const __m128 select = _mm_castsi128_ps(_mm_setr_epi32(-int32_t(additiveLanes&0x1u),-int32_t((additiveLanes>>1u)&0x1u),-int32_t((additiveLanes>>2u)&0x1u),-int32_t(additiveLanes>>3u)));
+                    for (uint32_t j=0u; j<4u; j++)
+                        _out.Rotation[j] = _mm_blendv_ps(overridden.Rotation[j],additive.Rotation[j],select);
+                    for (uint32_t j=0u; j<3u; j++)
+                    {
+                        _out.Position[j] = _mm_blendv_ps(overridden.Position[j],additive.Position[j],select);
+                        _out.Scale[j] = _mm_blendv_ps(overridden.Scale[j],additive.Scale[j],select);
+                    }
+                }
+            }
+
+            //! normalizes the rotation and builds the matrix like matrix3x4SIMD::setScaleRotationAndTranslation
+            static inline void computeLocal(__m128 _out[12], const SKeys& _keys)
+            {
+                const __m128 dot = dot4(_keys.Rotation,_keys.Rotation);
+#ifdef __IRR_FAST_MATH
+                const __m128 rcpLen = _mm_rsqrt_ps(dot);
+#else
+                const __m128 rcpLen = _mm_div_ps(_mm_set1_ps(1.f),_mm_sqrt_ps(dot));
+#endif
+                const __m128 x = _mm_mul_ps(_keys.Rotation[0],rcpLen);
+                const __m128 y = _mm_mul_ps(_keys.Rotation[1],rcpLen);
+                const __m128 z = _mm_mul_ps(_keys.Rotation[2],rcpLen);
+                const __m128 w = _mm_mul_ps(_keys.Rotation[3],rcpLen);
+
+                const __m128 xx = _mm_mul_ps(x,x), yy = _mm_mul_ps(y,y), zz = _mm_mul_ps(z,z);
+                const __m128 xy = _mm_mul_ps(x,y), xz = _mm_mul_ps(x,z), yz = _mm_mul_ps(y,z);
+                const __m128 xw = _mm_mul_ps(x,w), yw = _mm_mul_ps(y,w), zw = _mm_mul_ps(z,w);
+                const __m128 two = _mm_set1_ps(2.f);
+                const __m128 sx2 = _mm_mul_ps(_keys.Scale[0],two), sy2 = _mm_mul_ps(_keys.Scale[1],two), sz2 = _mm_mul_ps(_keys.Scale[2],two);
+
+                _out[0] = _mm_sub_ps(_keys.Scale[0],_mm_mul_ps(sx2,_mm_add_ps(yy,zz)));
+                _out[1] = _mm_mul_ps(sy2,_mm_sub_ps(xy,zw));
+                _out[2] = _mm_mul_ps(sz2,_mm_add_ps(xz,yw));
+                _out[3] = _keys.Position[0];
+                _out[4] = _mm_mul_ps(sx2,_mm_add_ps(xy,zw));
+                _out[5] = _mm_sub_ps(_keys.Scale[1],_mm_mul_ps(sy2,_mm_add_ps(xx,zz)));
+                _out[6] = _mm_mul_ps(sz2,_mm_sub_ps(yz,xw));
+                _out[7] = _keys.Position[1];
+                _out[8] = _mm_mul_ps(sx2,_mm_sub_ps(xz,yw));
+                _out[9] = _mm_mul_ps(sy2,_mm_add_ps(yz,xw));
+                _out[10] = _mm_sub_ps(_keys.Scale[2],_mm_mul_ps(sz2,_mm_add_ps(xx,yy)));
+                _out[11] = _keys.Position[2];
+            }
+
+            //! `_out` = `_a`*`_b`, so `_b` gets applied first like in matrix3x4SIMD::concatenateBFollowedByA
+            static inline void concatenate(__m128 _out[12], const __m128 _a[12], const __m128 _b[12])
+            {
+                for (uint32_t row=0u; row<3u; row++)
+                {
+                    const __m128* a = _a+row*4u;
+                    for (uint32_t col=0u; col<4u; col++)
+                    {
+                        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0],_b[col]),_mm_mul_ps(a[1],_b[4u+col])),_mm_mul_ps(a[2],_b[8u+col]));
+                        if (col==3u)
+                            sum = _mm_add_ps(sum,a[3]);
+                        _out[row*4u+col] = sum;
+                    }
+                }
+            }
+
+            //! skinning matrix, bbox and normal matrix from the global matrix, transposed to one 28 float record (7 registers) per lane
+            static inline void finishBones(__m128 _record[7][4], __m128 _instanceMin[3], __m128 _instanceMax[3],
+                                            const __m128 _global[12], const __m128 _poseBind[12], const __m128 _inMin[3], const __m128 _inMax[3], const __m128& _frame)
+            {
+                __m128 s[12];
+                concatenate(s,_global,_poseBind);
+
+                // bbox, same as core::transformBoxEx
+                __m128 boneMin[3],boneMax[3];
+                const __m128 zero = _mm_setzero_ps();
+                for (uint32_t row=0u; row<3u; row++)
+                {
+                    boneMin[row] = boneMax[row] = s[row*4u+3u];
+                    for (uint32_t col=0u; col<3u; col++)
+                    {
+                        const __m128 m = s[row*4u+col];
+                        const __m128 negative = _mm_cmplt_ps(m,zero);
+                        boneMin[row] = _mm_add_ps(boneMin[row],_mm_mul_ps(m,_mm_or_ps(_mm_and_ps(negative,_inMax[col]),_mm_andnot_ps(negative,_inMin[col]))));
+                        boneMax[row] = _mm_add_ps(boneMax[row],_mm_mul_ps(m,_mm_or_ps(_mm_and_ps(negative,_inMin[col]),_mm_andnot_ps(negative,_inMax[col]))));
+                    }
+                    _instanceMin[row] = _mm_min_ps(_instanceMin[row],boneMin[row]);
+                    _instanceMax[row] = _mm_max_ps(_instanceMax[row],boneMax[row]);
+                }
+
+                // normal matrix, same as matrix4x3::getSub3x3InverseTranspose
+                __m128 normal[9];
+                normal[0] = _mm_sub_ps(_mm_mul_ps(s[5],s[10]),_mm_mul_ps(s[9],s[6]));
+                normal[1] = _mm_sub_ps(_mm_mul_ps(s[9],s[2]),_mm_mul_ps(s[1],s[10]));
+                normal[2] = _mm_sub_ps(_mm_mul_ps(s[1],s[6]),_mm_mul_ps(s[5],s[2]));
+                normal[3] = _mm_sub_ps(_mm_mul_ps(s[6],s[8]),_mm_mul_ps(s[10],s[4]));
+                normal[4] = _mm_sub_ps(_mm_mul_ps(s[10],s[0]),_mm_mul_ps(s[2],s[8]));
+                normal[5] = _mm_sub_ps(_mm_mul_ps(s[2],s[4]),_mm_mul_ps(s[6],s[0]));
+                normal[6] = _mm_sub_ps(_mm_mul_ps(s[4],s[9]),_mm_mul_ps(s[8],s[5]));
+                normal[7] = _mm_sub_ps(_mm_mul_ps(s[8],s[1]),_mm_mul_ps(s[0],s[9]));
+                normal[8] = _mm_sub_ps(_mm_mul_ps(s[0],s[5]),_mm_mul_ps(s[4],s[1]));
+                const __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s[0],normal[0]),_mm_mul_ps(s[4],normal[1])),_mm_mul_ps(s[8],normal[2]));
+                const __m128 singular = _mm_cmple_ps(_mm_andnot_ps(_mm_set1_ps(-0.f),determinant),_mm_set1_ps(FLT_MIN));
+                const __m128 rcpDeterminant = _mm_div_ps(_mm_set1_ps(1.f),determinant);
+                for (uint32_t i=0u; i<9u; i++)
+                    normal[i] = _mm_andnot_ps(singular,_mm_mul_ps(normal[i],rcpDeterminant));
+
+                // SkinningTransform, SkinningNormalMatrix, MinBBoxEdge, MaxBBoxEdge, lastAnimatedFrame
+                const __m128 fields[7][4] = {
+                    {s[0],s[4],s[8],s[1]},
+                    {s[5],s[9],s[2],s[6]},
+                    {s[10],s[3],s[7],s[11]},
+                    {normal[0],normal[1],normal[2],normal[3]},
+                    {normal[4],normal[5],normal[6],normal[7]},
+                    {normal[8],boneMin[0],boneMin[1],boneMin[2]},
+                    {boneMax[0],boneMax[1],boneMax[2],_frame}
+                };
+                for (uint32_t i=0u; i<7u; i++)
+                {
+                    for (uint32_t j=0u; j<4u; j++)
+                        _record[i][j] = fields[i][j];
+                    _MM_TRANSPOSE4_PS(_record[i][0],_record[i][1],_record[i][2],_record[i][3]);
+                }
+            }
+
+            const asset::CFinalBoneHierarchy* Hierarchy;
+            core::vector<SBatch> Batches;
+            E_BATCHING Batching;
+    };
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
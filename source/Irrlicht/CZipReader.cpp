@@ -22,27 +22,13 @@ extern "C" void bz_internal_error(int errorCode)
 #include "CFileList.h"
 #include "CReadFile.h"
 
+#include "CZipStreamReadFile.h"
+
 #include "IrrCompileConfig.h"
 #ifdef _IRR_COMPILE_WITH_ZLIB_
-	#ifndef _IRR_USE_NON_SYSTEM_ZLIB_
-	#include <zlib.h> // use system lib
-	#else
-	#include "zlib/zlib.h"
-	#endif
-
 	#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
 	#include "aesGladman/fileenc.h"
 	#endif
-	#ifdef _IRR_COMPILE_WITH_BZIP2_
-	#ifndef _IRR_USE_NON_SYSTEM_BZLIB_
-	#include <bzlib.h>
-	#else
-	#include "bzip2/bzlib.h"
-	#endif
-	#endif
-	#ifdef _IRR_COMPILE_WITH_LZMA_
-	#include "lzma/LzmaDec.h"
-	#endif
 #endif
 
 namespace irr
@@ -50,6 +36,8 @@ namespace irr
 namespace io
 {
 
+//! entries up to this size are decompressed into memory when opened, bigger ones are streamed
+static const uint32_t InMemoryDecompressionLimit = 1u<<20;
 
 // -----------------------------------------------------------------------------
 // zip loader
@@ -599,232 +587,41 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
                 return new CLimitReadFile(File, e.Offset, decryptedSize, found->FullName);
 		}
 	case 8:
-		{
-  			#ifdef _IRR_COMPILE_WITH_ZLIB_
-
-			const uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
-			char* pBuf = new char[ uncompressedSize ];
-			if (!pBuf)
-			{
-				swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-                delete[] decryptedBuf;
-				if (decrypted)
-					decrypted->drop();
-				return 0;
-			}
-
-			uint8_t *pcData = decryptedBuf;
-			if (!pcData)
-			{
-				pcData = new uint8_t[decryptedSize];
-				if (!pcData)
-				{
-					swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-					os::Printer::log( buf, ELL_ERROR);
-                    delete[] decryptedBuf;
-					delete [] pBuf;
-					return 0;
-				}
-
-				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
-			}
-
-			// Setup the inflate stream.
-			z_stream stream;
-			int32_t err;
-
-			stream.next_in = (Bytef*)pcData;
-			stream.avail_in = (uInt)decryptedSize;
-			stream.next_out = (Bytef*)pBuf;
-			stream.avail_out = uncompressedSize;
-			stream.zalloc = (alloc_func)0;
-			stream.zfree = (free_func)0;
-
-			// Perform inflation. wbits < 0 indicates no zlib header inside the data.
-			err = inflateInit2(&stream, -MAX_WBITS);
-			if (err == Z_OK)
-			{
-				err = inflate(&stream, Z_FINISH);
-				inflateEnd(&stream);
-				if (err == Z_STREAM_END)
-					err = Z_OK;
-				err = Z_OK;
-				inflateEnd(&stream);
-			}
-
-			if (decrypted)
-				decrypted->drop();
-			else
-				delete[] pcData;
-
-            delete[] decryptedBuf;
-			if (err != Z_OK)
-			{
-				swprintf ( buf, 64, L"Error decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-				delete [] pBuf;
-				return 0;
-			}
-            else
-            {
-                auto ret = new io::CMemoryReadFile(pBuf, uncompressedSize, found->FullName);
-                delete[] pBuf;
-                return ret;
-            }
-
-			#else
-			return 0; // zlib not compiled, we cannot decompress the data.
-			#endif
-		}
 	case 12:
+	case 14:
 		{
-  			#ifdef _IRR_COMPILE_WITH_BZIP2_
-
+			CZipStreamReadFile::E_METHOD method = CZipStreamReadFile::EM_DEFLATE;
+			if (actualCompressionMethod==12)
+				method = CZipStreamReadFile::EM_BZIP2;
+			else if (actualCompressionMethod==14)
+				method = CZipStreamReadFile::EM_LZMA;
+
+			// decompression happens on demand while the entry is read, nothing is inflated up front
+			IReadFile* compressed = decrypted ? decrypted:new CLimitReadFile(File, e.Offset, decryptedSize, found->FullName);
+			delete[] decryptedBuf;
 			const uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
-			char* pBuf = new char[ uncompressedSize ];
-			if (!pBuf)
-			{
-				swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-                delete[] decryptedBuf;
-				if (decrypted)
-					decrypted->drop();
-				return 0;
-			}
-
-			uint8_t *pcData = decryptedBuf;
-			if (!pcData)
+			CZipStreamReadFile* stream = new CZipStreamReadFile(compressed, method, uncompressedSize, found->FullName);
+			compressed->drop();
+			if (!stream->isOpen())
 			{
-				pcData = new uint8_t[decryptedSize];
-				if (!pcData)
-				{
-					swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-					os::Printer::log( buf, ELL_ERROR);
-					delete [] pBuf;
-                    delete[] decryptedBuf;
-					return 0;
-				}
-
-				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
-			}
-
-			bz_stream bz_ctx={0};
-			/* use BZIP2's default memory allocation
-			bz_ctx->bzalloc = NULL;
-			bz_ctx->bzfree  = NULL;
-			bz_ctx->opaque  = NULL;
-			*/
-			int err = BZ2_bzDecompressInit(&bz_ctx, 0, 0); /* decompression */
-			if(err != BZ_OK)
-			{
-				os::Printer::log("bzip2 decompression failed. File cannot be read.", ELL_ERROR);
-                delete[] decryptedBuf;
+				stream->drop();
 				return 0;
 			}
-			bz_ctx.next_in = (char*)pcData;
-			bz_ctx.avail_in = decryptedSize;
-			/* pass all input to decompressor */
-			bz_ctx.next_out = pBuf;
-			bz_ctx.avail_out = uncompressedSize;
-			err = BZ2_bzDecompress(&bz_ctx);
-			err = BZ2_bzDecompressEnd(&bz_ctx);
 
-			if (decrypted)
-				decrypted->drop();
-			else
-				delete[] pcData;
+			if (uncompressedSize>InMemoryDecompressionLimit)
+				return stream;
 
-			if (err != BZ_OK)
+			// small entries are decompressed right away so loaders can parse them in place with getMappedRange
+			core::vector<uint8_t> contents(uncompressedSize);
+			const int32_t readSize = stream->read(contents.data(), uncompressedSize);
+			stream->drop();
+			if (readSize!=int32_t(uncompressedSize))
 			{
 				swprintf ( buf, 64, L"Error decompressing %s", found->FullName.c_str() );
 				os::Printer::log( buf, ELL_ERROR);
-				delete [] pBuf;
-                delete[] decryptedBuf;
-				return 0;
-			}
-            else
-            {
-                auto ret = new io::CMemoryReadFile(pBuf, uncompressedSize, found->FullName);
-                delete[] pBuf;
-                return ret;
-            }
-
-			#else
-            delete[] decryptedBuf;
-			os::Printer::log("bzip2 decompression not supported. File cannot be read.", ELL_ERROR);
-			return 0;
-			#endif
-		}
-	case 14:
-		{
-  			#ifdef _IRR_COMPILE_WITH_LZMA_
-
-			uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
-			char* pBuf = new char[ uncompressedSize ];
-			if (!pBuf)
-			{
-				swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-                delete[] decryptedBuf;
-				if (decrypted)
-					decrypted->drop();
-				return 0;
-			}
-
-			uint8_t *pcData = decryptedBuf;
-			if (!pcData)
-			{
-				pcData = new uint8_t[decryptedSize];
-				if (!pcData)
-				{
-					swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-					os::Printer::log( buf, ELL_ERROR);
-					delete [] pBuf;
-					return 0;
-				}
-
-				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
-			}
-
-			ELzmaStatus status;
-			SizeT tmpDstSize = uncompressedSize;
-			SizeT tmpSrcSize = decryptedSize;
-
-			unsigned int propSize = (pcData[3]<<8)+pcData[2];
-			int err = LzmaDecode((Byte*)pBuf, &tmpDstSize,
-					pcData+4+propSize, &tmpSrcSize,
-					pcData+4, propSize,
-					e.header.GeneralBitFlag&0x1?LZMA_FINISH_END:LZMA_FINISH_ANY, &status,
-					&lzmaAlloc);
-			uncompressedSize = tmpDstSize; // may be different to expected value
-
-			if (decrypted)
-				decrypted->drop();
-			else
-				delete[] pcData;
-
-            delete[] decryptedBuf;
-			if (err != SZ_OK)
-			{
-				os::Printer::log( "Error decompressing", found->FullName, ELL_ERROR);
-				delete [] pBuf;
 				return 0;
 			}
-			else
-				return io::createMemoryReadFile(pBuf, uncompressedSize, found->FullName, true);
-
-			#else
-            delete[] decryptedBuf;
-			os::Printer::log("lzma decompression not supported. File cannot be read.", ELL_ERROR);
-			return 0;
-			#endif
+			return new io::CMemoryReadFile(contents.data(), uncompressedSize, found->FullName);
 		}
 	case 99:
 		// If we come here with an encrypted file, decryption support is missing
@@ -839,16 +636,6 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 	};
 }
 
-#ifdef _IRR_COMPILE_WITH_LZMA_
-//! Used for LZMA decompression. The lib has no default memory management
-namespace
-{
-	void *SzAlloc(void *p, size_t size) { p = p; return _IRR_ALIGNED_MALLOC(size,_IRR_SIMD_ALIGNMENT); }
-	void SzFree(void *p, void *address) { p = p; _IRR_ALIGNED_FREE(address); }
-	ISzAlloc lzmaAlloc = { SzAlloc, SzFree };
-}
-#endif
-
 } // end namespace io
 } // end namespace irr
 
@@ -0,0 +1,405 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "CZipStreamReadFile.h"
+
+#ifdef __IRR_COMPILE_WITH_ZIP_ARCHIVE_LOADER_
+
+#include "os.h"
+
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+	#ifndef _IRR_USE_NON_SYSTEM_ZLIB_
+	#include <zlib.h> // use system lib
+	#else
+	#include "zlib/zlib.h"
+	#endif
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+	#ifndef _IRR_USE_NON_SYSTEM_BZLIB_
+	#include <bzlib.h>
+	#else
+	#include "bzip2/bzlib.h"
+	#endif
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+	#include "lzma/C/LzmaDec.h"
+#endif
+
+namespace irr
+{
+namespace io
+{
+
+namespace
+{
+	//! size of the ring of decoded bytes, must be a power of two multiple of DecodeChunkSize
+	constexpr size_t WindowSize = 1u<<18;
+	constexpr size_t DecodeChunkSize = 1u<<16;
+	constexpr size_t InputBufferSize = 1u<<16;
+	//! deflate restart points are at least this far apart, each one costs up to 32kB of history
+	constexpr size_t MinRestartSpacing = 1u<<20;
+	constexpr size_t MaxRestartPoints = 128u;
+
+#ifdef _IRR_COMPILE_WITH_LZMA_
+	struct LzmaMemMngmnt
+	{
+		static void *alloc(ISzAllocPtr, size_t _size) { return _IRR_ALIGNED_MALLOC(_size,_IRR_SIMD_ALIGNMENT); }
+		static void release(ISzAllocPtr, void* _addr) { _IRR_ALIGNED_FREE(_addr); }
+	};
+	ISzAlloc lzmaAlloc = { &LzmaMemMngmnt::alloc, &LzmaMemMngmnt::release };
+#endif
+}
+
+struct CZipStreamReadFile::SDecoder
+{
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+	z_stream Inflate;
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+	bz_stream Bzip2;
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+	CLzmaDec Lzma;
+	//! the zip LZMA header (version, properties size and properties) comes before the stream
+	size_t LzmaDataOffset;
+#endif
+	//! next unconsumed byte of the input buffer
+	size_t InputOffset;
+};
+
+
+CZipStreamReadFile::CZipStreamReadFile(IReadFile* _compressed, E_METHOD _method, size_t _uncompressedSize, const io::path& _fileName)
+	: Compressed(_compressed), Method(_method), UncompressedSize(_uncompressedSize), Filename(_fileName), Pos(0u),
+	Window(WindowSize), ValidBegin(0u), DecodedEnd(0u), Input(InputBufferSize), InputPos(0u), InputFill(0u),
+	Decoder(new SDecoder()), Failed(false), RestartSpacing(core::max_(MinRestartSpacing,_uncompressedSize/MaxRestartPoints))
+{
+	#ifdef _IRR_DEBUG
+	setDebugName("CZipStreamReadFile");
+	#endif
+
+	Compressed->grab();
+
+	bool initialized = false;
+	switch (Method)
+	{
+		case EM_DEFLATE:
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+			// wbits < 0 indicates no zlib header inside the data.
+			initialized = inflateInit2(&Decoder->Inflate, -MAX_WBITS)==Z_OK;
+#else
+			os::Printer::log("zlib not compiled, deflated file cannot be read.", ELL_ERROR);
+#endif
+			break;
+		case EM_BZIP2:
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+			initialized = BZ2_bzDecompressInit(&Decoder->Bzip2, 0, 0)==BZ_OK;
+#else
+			os::Printer::log("bzip2 decompression not supported. File cannot be read.", ELL_ERROR);
+#endif
+			break;
+		case EM_LZMA:
+#ifdef _IRR_COMPILE_WITH_LZMA_
+		{
+			uint8_t header[4+LZMA_PROPS_SIZE];
+			Compressed->seek(0u);
+			if (Compressed->read(header, 4)!=4)
+				break;
+			const uint32_t propSize = (header[3]<<8)+header[2];
+			if (propSize!=LZMA_PROPS_SIZE || Compressed->read(header+4, propSize)!=int32_t(propSize))
+				break;
+
+			Decoder->LzmaDataOffset = 4u+propSize;
+			LzmaDec_Construct(&Decoder->Lzma);
+			initialized = LzmaDec_Allocate(&Decoder->Lzma, header+4, propSize, &lzmaAlloc)==SZ_OK;
+		}
+#else
+			os::Printer::log("lzma decompression not supported. File cannot be read.", ELL_ERROR);
+#endif
+			break;
+	}
+
+	if (initialized)
+		initialized = restart(0u);
+	if (!initialized)
+	{
+		os::Printer::log("Could not set up decompression of", Filename.c_str(), ELL_ERROR);
+		delete Decoder;
+		Decoder = nullptr;
+	}
+}
+
+
+CZipStreamReadFile::~CZipStreamReadFile()
+{
+	if (Decoder)
+	{
+		switch (Method)
+		{
+			case EM_DEFLATE:
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+				inflateEnd(&Decoder->Inflate);
+#endif
+				break;
+			case EM_BZIP2:
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+				BZ2_bzDecompressEnd(&Decoder->Bzip2);
+#endif
+				break;
+			case EM_LZMA:
+#ifdef _IRR_COMPILE_WITH_LZMA_
+				LzmaDec_Free(&Decoder->Lzma, &lzmaAlloc);
+#endif
+				break;
+		}
+		delete Decoder;
+	}
+	Compressed->drop();
+}
+
+
+//! returns how much was read
+int32_t CZipStreamReadFile::read(void* buffer, uint32_t sizeToRead)
+{
+	if (!Decoder || Pos>=UncompressedSize)
+		return 0;
+
+	uint8_t* out = reinterpret_cast<uint8_t*>(buffer);
+	const size_t toRead = core::min_<size_t>(sizeToRead, UncompressedSize-Pos);
+	size_t done = 0u;
+	while (done<toRead)
+	{
+		if (Pos<ValidBegin)
+		{
+			if (!restart(Pos))
+				break;
+		}
+		else if (Pos>=DecodedEnd)
+		{
+			if (Failed || !decodeChunk())
+				break;
+		}
+		else
+		{
+			const size_t ringOffset = Pos&(WindowSize-1u);
+			const size_t len = core::min_(core::min_(toRead-done, DecodedEnd-Pos), WindowSize-ringOffset);
+			memcpy(out+done, Window.data()+ringOffset, len);
+			Pos += len;
+			done += len;
+		}
+	}
+
+	return static_cast<int32_t>(done);
+}
+
+
+//! changes position in file, returns true if successful
+bool CZipStreamReadFile::seek(const size_t& finalPos, bool relativeMovement)
+{
+	const size_t newPos = relativeMovement ? Pos+finalPos:finalPos;
+	if (newPos>UncompressedSize)
+		return false;
+
+	// decoding happens lazily on the next read
+	Pos = newPos;
+	return true;
+}
+
+
+bool CZipStreamReadFile::restart(size_t _pos)
+{
+	const SRestartPoint* point = nullptr;
+	for (const auto& p : RestartPoints)
+	{
+		if (p.OutPos>_pos)
+			break;
+		point = &p;
+	}
+
+	bool success = false;
+	InputPos = 0u;
+	InputFill = 0u;
+	Decoder->InputOffset = 0u;
+	switch (Method)
+	{
+		case EM_DEFLATE:
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+			success = inflateReset(&Decoder->Inflate)==Z_OK;
+			if (success && point)
+			{
+				InputPos = point->InPos;
+				if (point->Bits)
+					success = inflatePrime(&Decoder->Inflate, point->Bits, point->PrevByte>>(8u-point->Bits))==Z_OK;
+				success = success && inflateSetDictionary(&Decoder->Inflate, point->Dictionary.data(), point->Dictionary.size())==Z_OK;
+			}
+#endif
+			break;
+		case EM_BZIP2:
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+			// bzip2 has no way to reset, the state has to be torn down
+			BZ2_bzDecompressEnd(&Decoder->Bzip2);
+			memset(&Decoder->Bzip2, 0, sizeof(bz_stream));
+			success = BZ2_bzDecompressInit(&Decoder->Bzip2, 0, 0)==BZ_OK;
+#endif
+			break;
+		case EM_LZMA:
+#ifdef _IRR_COMPILE_WITH_LZMA_
+			LzmaDec_Init(&Decoder->Lzma);
+			InputPos = Decoder->LzmaDataOffset;
+			success = true;
+#endif
+			break;
+	}
+
+	DecodedEnd = ValidBegin = point ? point->OutPos:0u;
+	Failed = !success;
+	return success;
+}
+
+
+bool CZipStreamReadFile::refillInput()
+{
+	if (Decoder->InputOffset<InputFill)
+		return true;
+
+	InputPos += InputFill;
+	Decoder->InputOffset = 0u;
+	if (!Compressed->seek(InputPos))
+		InputFill = 0u;
+	else
+		InputFill = core::max_(Compressed->read(Input.data(), Input.size()), 0);
+	return InputFill!=0u;
+}
+
+
+void CZipStreamReadFile::recordRestartPoint()
+{
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+	if (DecodedEnd<(RestartPoints.empty() ? 0u:RestartPoints.back().OutPos)+RestartSpacing)
+		return;
+
+	z_stream& strm = Decoder->Inflate;
+	SRestartPoint point;
+	point.OutPos = DecodedEnd;
+	point.InPos = InputPos+Decoder->InputOffset;
+	point.Bits = strm.data_type&7;
+	if (point.Bits)
+	{
+		// the partially consumed byte must still be in the buffer
+		if (Decoder->InputOffset==0u)
+			return;
+		point.PrevByte = Input[Decoder->InputOffset-1u];
+	}
+	else
+		point.PrevByte = 0u;
+
+	point.Dictionary.resize(1u<<MAX_WBITS);
+	uInt dictLength = point.Dictionary.size();
+	if (inflateGetDictionary(&strm, point.Dictionary.data(), &dictLength)!=Z_OK)
+		return;
+	point.Dictionary.resize(dictLength);
+
+	RestartPoints.push_back(std::move(point));
+#endif
+}
+
+
+bool CZipStreamReadFile::decodeChunk()
+{
+	const size_t ringOffset = DecodedEnd&(WindowSize-1u);
+	const size_t chunkSize = core::min_(core::min_(DecodeChunkSize, WindowSize-ringOffset), UncompressedSize-DecodedEnd);
+	if (chunkSize==0u)
+		return false;
+
+	uint8_t* const out = Window.data()+ringOffset;
+	const size_t chunkBegin = DecodedEnd;
+	size_t produced = 0u;
+	bool streamEnd = false;
+	while (produced<chunkSize && !streamEnd && !Failed)
+	{
+		if (!refillInput())
+		{
+			Failed = true;
+			break;
+		}
+
+		switch (Method)
+		{
+			case EM_DEFLATE:
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+			{
+				z_stream& strm = Decoder->Inflate;
+				strm.next_in = reinterpret_cast<Bytef*>(Input.data()+Decoder->InputOffset);
+				strm.avail_in = InputFill-Decoder->InputOffset;
+				strm.next_out = reinterpret_cast<Bytef*>(out+produced);
+				strm.avail_out = chunkSize-produced;
+				// stop at every block boundary so restart points can be taken
+				const int err = inflate(&strm, Z_BLOCK);
+				Decoder->InputOffset = InputFill-strm.avail_in;
+				produced = chunkSize-strm.avail_out;
+				DecodedEnd = chunkBegin+produced;
+
+				if (err==Z_STREAM_END)
+					streamEnd = true;
+				else if (err!=Z_OK)
+					Failed = true;
+				else if ((strm.data_type&128) && !(strm.data_type&64))
+					recordRestartPoint();
+			}
+#endif
+				break;
+			case EM_BZIP2:
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+			{
+				bz_stream& strm = Decoder->Bzip2;
+				strm.next_in = reinterpret_cast<char*>(Input.data()+Decoder->InputOffset);
+				strm.avail_in = InputFill-Decoder->InputOffset;
+				strm.next_out = reinterpret_cast<char*>(out+produced);
+				strm.avail_out = chunkSize-produced;
+				const int err = BZ2_bzDecompress(&strm);
+				Decoder->InputOffset = InputFill-strm.avail_in;
+				produced = chunkSize-strm.avail_out;
+
+				if (err==BZ_STREAM_END)
+					streamEnd = true;
+				else if (err!=BZ_OK)
+					Failed = true;
+			}
+#endif
+				break;
+			case EM_LZMA:
+#ifdef _IRR_COMPILE_WITH_LZMA_
+			{
+				SizeT destLen = chunkSize-produced;
+				SizeT srcLen = InputFill-Decoder->InputOffset;
+				ELzmaStatus status;
+				const SRes err = LzmaDec_DecodeToBuf(&Decoder->Lzma, out+produced, &destLen, Input.data()+Decoder->InputOffset, &srcLen, LZMA_FINISH_ANY, &status);
+				Decoder->InputOffset += srcLen;
+				produced += destLen;
+
+				if (status==LZMA_STATUS_FINISHED_WITH_MARK)
+					streamEnd = true;
+				else if (err!=SZ_OK || (destLen==0u && srcLen==0u))
+					Failed = true;
+			}
+#endif
+				break;
+		}
+	}
+
+	DecodedEnd = chunkBegin+produced;
+	if (DecodedEnd>WindowSize)
+		ValidBegin = core::max_(ValidBegin, DecodedEnd-WindowSize);
+
+	if (Failed || (streamEnd && DecodedEnd<UncompressedSize))
+	{
+		Failed = true;
+		os::Printer::log("Error decompressing", Filename.c_str(), ELL_ERROR);
+	}
+	return produced!=0u;
+}
+
+} // end namespace io
+} // end namespace irr
+
+#endif // __IRR_COMPILE_WITH_ZIP_ARCHIVE_LOADER_
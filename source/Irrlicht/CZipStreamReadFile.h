@@ -0,0 +1,118 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_ZIP_STREAM_READ_FILE_H_INCLUDED__
+#define __C_ZIP_STREAM_READ_FILE_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+
+#ifdef __IRR_COMPILE_WITH_ZIP_ARCHIVE_LOADER_
+
+#include "IReadFile.h"
+
+#include "irr/core/core.h"
+
+namespace irr
+{
+
+namespace io
+{
+
+	/*!
+		Class for reading a compressed zip entry without decompressing it up front,
+		the entry is decoded on demand into a ring window of the most recently decoded bytes.
+		Seeking backwards past the window restarts the decoder, deflate streams remember restart points
+		(bit offset into the compressed data plus the 32kB history) every so often while decoding so the restart
+		happens close to the target, bzip2 and LZMA streams have to be decoded again from the beginning.
+		Memory use is bounded by the window, the input buffer and the restart points, not by the entry size.
+	*/
+	class CZipStreamReadFile : public IReadFile
+	{
+        protected:
+            virtual ~CZipStreamReadFile();
+
+        public:
+            enum E_METHOD
+            {
+                EM_DEFLATE = 0,
+                EM_BZIP2,
+                EM_LZMA
+            };
+
+            //! `_compressed` needs to hold exactly the compressed data of the entry, it gets grabbed
+            CZipStreamReadFile(IReadFile* _compressed, E_METHOD _method, size_t _uncompressedSize, const io::path& _fileName);
+
+            //! returns whether the decoder could be set up
+            virtual bool isOpen() const { return Decoder != nullptr; }
+
+            //! returns how much was read
+            virtual int32_t read(void* buffer, uint32_t sizeToRead) override;
+
+            //! changes position in file, returns true if successful
+            virtual bool seek(const size_t& finalPos, bool relativeMovement = false) override;
+
+            //! returns size of file
+            virtual size_t getSize() const override { return UncompressedSize; }
+
+            //! returns where in the file we are.
+            virtual size_t getPos() const override { return Pos; }
+
+            //! returns name of file
+            virtual const io::path& getFileName() const override { return Filename; }
+
+        private:
+            //! decoder library state, only known to the translation unit
+            struct SDecoder;
+
+            //! state needed to resume inflating at a deflate block boundary
+            struct SRestartPoint
+            {
+                size_t OutPos;
+                size_t InPos;
+                uint32_t Bits;
+                uint8_t PrevByte;
+                core::vector<uint8_t> Dictionary;
+            };
+
+            //! puts the decoder at the latest restart point not after `_pos`, or at the beginning
+            bool restart(size_t _pos);
+
+            //! decodes the next chunk into the ring window, returns false on error or end of stream
+            bool decodeChunk();
+
+            //! refills the input buffer if it was used up, returns false if there is no compressed data left
+            bool refillInput();
+
+            void recordRestartPoint();
+
+            IReadFile* Compressed;
+            E_METHOD Method;
+            size_t UncompressedSize;
+            io::path Filename;
+
+            size_t Pos;
+
+            //! ring of decoded bytes, holds [ValidBegin,DecodedEnd) of the uncompressed data
+            core::vector<uint8_t> Window;
+            size_t ValidBegin;
+            size_t DecodedEnd;
+
+            //! compressed data buffer, InputPos is the offset in `Compressed` the buffer was last filled from
+            core::vector<uint8_t> Input;
+            size_t InputPos;
+            size_t InputFill;
+
+            SDecoder* Decoder;
+            bool Failed;
+
+            core::vector<SRestartPoint> RestartPoints;
+            size_t RestartSpacing;
+	};
+
+} // end namespace io
+} // end namespace irr
+
+#endif // __IRR_COMPILE_WITH_ZIP_ARCHIVE_LOADER_
+
+#endif
@@ -6,6 +6,7 @@
 #include "CBAWMeshFileLoader.h"
 
 #include <stack>
+#include <functional>
 
 #include "os.h"
 #include "CMemoryFile.h"
@@ -105,82 +106,205 @@ asset::SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const as
         ctx.inner.params,
         _override
     };
-	core::stack<SBlobData*> toLoad, toFinalize;
-	toLoad.push(&meshBlobDataIter->second);
-    toLoad.top()->hierarchyLvl = 0u;
-	while (!toLoad.empty())
+	// blobs get loaded a hierarchy level at a time, file reads and the override's callbacks stay on this thread,
+	// while all blobs of the level get validated, decrypted, decompressed and instantiated in parallel
+	struct SLoadingBlob
 	{
-		SBlobData* data = toLoad.top();
-		toLoad.pop();
-
-		const uint64_t handle = data->header->handle;
-        const uint32_t size = data->header->blobSizeDecompr;
-        const uint32_t blobType = data->header->blobType;
-        const std::string thisCacheKey = genSubAssetCacheKey(rootCacheKey, handle);
-        const uint32_t hierLvl = data->hierarchyLvl;
-
-        uint8_t decrKey[16];
-        size_t decrKeyLen = 16u;
-        uint32_t attempt = 0u;
-        const void* blob = nullptr;
-        // todo: supposedFilename arg is missing (empty string) - what is it?
-        while (_override->getDecryptionKey(decrKey, decrKeyLen, attempt, ctx.inner.mainFile, "", thisCacheKey, ctx.inner, hierLvl))
-        {
-            if (!((data->header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u))
-                blob = data->heapBlob = tryReadBlobOnStack(*data, ctx, decrKey);
-            if (blob)
-                break;
-            ++attempt;
-        }
-
-		if (!blob)
+		SBlobData* data = nullptr;
+		void* read = nullptr;
+		uint8_t decrKey[16] = {};
+		//! first decryption key attempt left for loading the blob one by one, if it failed
+		uint32_t nextAttempt = 0u;
+		core::unordered_set<uint64_t> deps = {};
+		void* obj = nullptr;
+		bool cached = false;
+	};
+	core::vector<SLoadingBlob> level, toFinalize;
+	auto freeHeapBlob = [](SBlobData* _data) {
+		if (_data->heapBlob)
+			_IRR_ALIGNED_FREE(_data->heapBlob);
+		_data->heapBlob = nullptr;
+		_data->mappedBlob = nullptr;
+	};
+	// single cleanup path for every early return, frees the blobs read for the current level and those decoded but not finalized yet
+	auto freeBlobsRoutine = [&] {
+		for (auto& loading : level)
 		{
-            return {};
+			if (loading.read)
+				_IRR_ALIGNED_FREE(loading.read);
+			loading.read = nullptr;
+		}
+		for (auto* pending : {&level, &toFinalize})
+		for (auto& loading : *pending)
+			freeHeapBlob(loading.data);
+	};
+	auto blobsExiter = core::makeRAIIExiter(freeBlobsRoutine);
+	core::unordered_set<uint64_t> discovered;
+	level.push_back({&meshBlobDataIter->second});
+	level.back().data->hierarchyLvl = 0u;
+	discovered.insert(meshBlobDataIter->first);
+	for (uint32_t hierLvl = 0u; !level.empty(); ++hierLvl)
+	{
+		for (auto& loading : level)
+		{
+			loading.read = nullptr;
+			loading.nextAttempt = 0u;
+		}
+		for (auto& loading : level)
+		{
+			SBlobData* data = loading.data;
+			// uncompressed and unencrypted blobs get used in place if the file is memory-mapped
+			if ((data->mappedBlob = tryGetMappedBlob(*data, ctx)))
+				continue;
+
+			size_t decrKeyLen = 16u;
+			// todo: supposedFilename arg is missing (empty string) - what is it?
+			if (!_override->getDecryptionKey(loading.decrKey, decrKeyLen, 0u, ctx.inner.mainFile, "", genSubAssetCacheKey(rootCacheKey, data->header->handle), ctx.inner, hierLvl))
+				return {};
+			loading.nextAttempt = 1u;
+			if ((data->header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u)
+				continue;
+
+			loading.read = _IRR_ALIGNED_MALLOC(data->header->effectiveSize(), _IRR_SIMD_ALIGNMENT);
+			ctx.inner.mainFile->seek(data->absOffset);
+			ctx.inner.mainFile->read(loading.read, data->header->effectiveSize());
 		}
 
-		core::unordered_set<uint64_t> deps = ctx.loadingMgr.getNeededDeps(blobType, blob);
-        for (auto it = deps.begin(); it != deps.end(); ++it)
-        {
-            if (ctx.createdObjs.find(*it) == ctx.createdObjs.end())
-            {
-                toLoad.push(&ctx.blobs[*it]);
-                toLoad.top()->hierarchyLvl = hierLvl+1u;
-            }
-        }
-
-        auto foundBundle = _override->findCachedAsset(thisCacheKey, nullptr, ctx.inner, hierLvl).getContents();
-        if (foundBundle.first!=foundBundle.second)
-        {
-            ctx.createdObjs[handle] = toAddrUsedByBlobsLoadingMgr(foundBundle.first->get(), blobType);
-            continue;
-        }
+		core::parallel_for<size_t>(0u, level.size(), [&](size_t i)
+			{
+				SBlobData* data = level[i].data;
+				if (data->mappedBlob)
+				{
+					if (!data->header->validate(data->mappedBlob))
+						data->mappedBlob = nullptr;
+				}
+				else if (level[i].read)
+				{
+					// takes ownership of the read blob, whether decoding succeeds or not
+					data->heapBlob = tryDecodeBlob(*data, level[i].read, level[i].decrKey, ctx.iv);
+					level[i].read = nullptr;
+				}
+			}, 1u);
+
+		core::vector<SLoadingBlob> nextLevel;
+		for (auto& loading : level)
+		{
+			SBlobData* data = loading.data;
+			const uint64_t handle = data->header->handle;
+			const std::string thisCacheKey = genSubAssetCacheKey(rootCacheKey, handle);
+
+			const void* blob = data->heapBlob ? data->heapBlob:data->mappedBlob;
+			// the first key or the mapped blob didn't work, try the remaining keys the way the blobs would be loaded one by one
+			uint8_t decrKey[16];
+			size_t decrKeyLen = 16u;
+			for (uint32_t attempt = loading.nextAttempt; !blob && _override->getDecryptionKey(decrKey, decrKeyLen, attempt, ctx.inner.mainFile, "", thisCacheKey, ctx.inner, hierLvl); ++attempt)
+			{
+				if (!((data->header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u))
+					blob = data->heapBlob = tryReadBlobOnStack(*data, ctx, decrKey);
+			}
+
+			if (!blob)
+			{
+				return {};
+			}
+
+			loading.deps = ctx.loadingMgr.getNeededDeps(data->header->blobType, blob);
+			for (auto it = loading.deps.begin(); it != loading.deps.end(); ++it)
+			{
+				if (discovered.insert(*it).second)
+				{
+					nextLevel.push_back({&ctx.blobs[*it]});
+					nextLevel.back().data->hierarchyLvl = hierLvl+1u;
+				}
+			}
+
+			auto foundBundle = _override->findCachedAsset(thisCacheKey, nullptr, ctx.inner, hierLvl).getContents();
+			loading.cached = foundBundle.first!=foundBundle.second;
+			loading.obj = loading.cached ? toAddrUsedByBlobsLoadingMgr(foundBundle.first->get(), data->header->blobType):nullptr;
+		}
 
-		bool fail = !(ctx.createdObjs[handle] = ctx.loadingMgr.instantiateEmpty(blobType, blob, size, params));
+		// textures get loaded through the asset manager, so they stay on this thread
+		auto instantiate = [&](SLoadingBlob& loading)
+		{
+			const SBlobData* data = loading.data;
+			loading.obj = ctx.loadingMgr.instantiateEmpty(data->header->blobType, data->heapBlob ? data->heapBlob:data->mappedBlob, data->header->blobSizeDecompr, params);
+		};
+		core::parallel_for<size_t>(0u, level.size(), [&](size_t i)
+			{
+				if (!level[i].cached && level[i].data->header->blobType != asset::Blob::EBT_TEXTURE_PATH)
+					instantiate(level[i]);
+			}, 1u);
+		for (auto& loading : level)
+		{
+			if (!loading.cached && loading.data->header->blobType == asset::Blob::EBT_TEXTURE_PATH)
+				instantiate(loading);
+		}
 
+		// register everything first, so a failure releases all of the level's objects
+		bool fail = false;
+		for (auto& loading : level)
+		{
+			if (loading.obj)
+				ctx.createdObjs[loading.data->header->handle] = loading.obj;
+			else
+				fail = true;
+		}
 		if (fail)
 		{
-            return {};
+			return {};
 		}
 
-		if (!deps.size())
+		for (auto& loading : level)
 		{
-            void* obj = ctx.createdObjs[handle];
-			ctx.loadingMgr.finalize(blobType, obj, blob, size, ctx.createdObjs, params);
-            _IRR_ALIGNED_FREE(data->heapBlob);
-			blob = data->heapBlob = nullptr;
-            insertAssetIntoCache(ctx, _override, obj, blobType, hierLvl, thisCacheKey);
+			SBlobData* data = loading.data;
+			if (loading.cached)
+			{
+				freeHeapBlob(data);
+				continue;
+			}
+
+			if (!loading.deps.size())
+			{
+				ctx.loadingMgr.finalize(data->header->blobType, loading.obj, data->heapBlob ? data->heapBlob:data->mappedBlob, data->header->blobSizeDecompr, ctx.createdObjs, params);
+				freeHeapBlob(data);
+				insertAssetIntoCache(ctx, _override, loading.obj, data->header->blobType, hierLvl, genSubAssetCacheKey(rootCacheKey, data->header->handle));
+			}
+			else
+				toFinalize.push_back(std::move(loading));
 		}
-		else
-			toFinalize.push(data);
+		level = std::move(nextLevel);
 	}
 
+	// a blob can depend on one discovered on the same or an earlier level, so finalize in order of the height of their dependency trees
+	core::unordered_map<uint64_t, const SLoadingBlob*> unfinalized;
+	for (const auto& loading : toFinalize)
+		unfinalized[loading.data->header->handle] = &loading;
+	core::unordered_map<uint64_t, uint32_t> heights;
+	std::function<uint32_t(uint64_t)> getHeight = [&](uint64_t _handle) -> uint32_t
+	{
+		auto found = heights.find(_handle);
+		if (found != heights.end())
+			return found->second;
+
+		uint32_t height = 0u;
+		auto loading = unfinalized.find(_handle);
+		if (loading != unfinalized.end())
+		{
+			for (uint64_t dep : loading->second->deps)
+				height = std::max(height, getHeight(dep)+1u);
+		}
+		return heights[_handle] = height;
+	};
+	for (const auto& loading : toFinalize)
+		getHeight(loading.data->header->handle);
+	std::stable_sort(toFinalize.begin(), toFinalize.end(), [&](const SLoadingBlob& _a, const SLoadingBlob& _b) { return heights[_a.data->header->handle] < heights[_b.data->header->handle]; });
+
 	void* retval = nullptr;
-	while (!toFinalize.empty())
+	for (size_t i = 0u; i < toFinalize.size(); ++i)
 	{
-		SBlobData* data = toFinalize.top();
-		toFinalize.pop();
+		SBlobData* data = toFinalize[i].data;
 
-		const void* blob = data->heapBlob;
+		const void* blob = data->heapBlob ? data->heapBlob:data->mappedBlob;
 		const uint64_t handle = data->header->handle;
 		const uint32_t size = data->header->blobSizeDecompr;
 		const uint32_t blobType = data->header->blobType;
@@ -188,7 +312,8 @@ asset::SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const as
         const std::string thisCacheKey = genSubAssetCacheKey(rootCacheKey, handle);
 
 		retval = ctx.loadingMgr.finalize(blobType, ctx.createdObjs[handle], blob, size, ctx.createdObjs, params); // last one will always be mesh
-        if (!toFinalize.empty()) // don't cache root-asset (mesh) as sub-asset because it'll be cached by asset manager directly (and there's only one IAsset::cacheKey)
+		freeHeapBlob(data);
+        if (i+1u != toFinalize.size()) // don't cache root-asset (mesh) as sub-asset because it'll be cached by asset manager directly (and there's only one IAsset::cacheKey)
             insertAssetIntoCache(ctx, _override, retval, blobType, hierLvl, thisCacheKey);
 	}
 
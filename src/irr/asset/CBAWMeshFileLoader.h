@@ -13,6 +13,7 @@
 #include "irr/asset/bawformat/legacy/CBAWLegacy.h"
 #include "irr/asset/bawformat/CBlobsLoadingManager.h"
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
 
 #include "os.h"
 
@@ -35,6 +36,8 @@ private:
 		HeaderT* header;
 		size_t absOffset; // absolute
 		void* heapBlob = nullptr;
+		//! raw blob used in place from a memory-mapped file, alternative to `heapBlob`
+		const void* mappedBlob = nullptr;
 		mutable bool validated = false;
         uint32_t hierarchyLvl = 0u;
 
@@ -42,6 +45,7 @@ private:
         SBlobData_t(const SBlobData_t<HeaderT>&) = delete;
         SBlobData_t(SBlobData_t<HeaderT>&& _other) {
             std::swap(heapBlob, _other.heapBlob);
+            mappedBlob = _other.mappedBlob;
             header = _other.header;
             absOffset = _other.absOffset;
             validated = _other.validated;
@@ -160,6 +164,15 @@ private:
 	/** @returns `_stackPtr` if blob was read to it or pointer to malloc'd memory otherwise.*/
     template<typename HeaderT>
 	void* tryReadBlobOnStack(const SBlobData_t<HeaderT>& _data, SContext& _ctx, const unsigned char pwd[16], void* _stackPtr=NULL, size_t _stackSize=0) const;
+	//! Returns a pointer to the blob inside the file if it is raw and the file is memory-mapped, no copy is made
+	/** The blob is not validated yet, so it can be done in parallel with other blobs. */
+	template<typename HeaderT>
+	const void* tryGetMappedBlob(const SBlobData_t<HeaderT>& _data, SContext& _ctx) const;
+	//! Validates, decrypts and decompresses a blob read from the file, safe to call for different blobs from many threads at once
+	/** Takes ownership of `_read` (`effectiveSize()` bytes allocated with _IRR_ALIGNED_MALLOC).
+	@returns the decoded blob (possibly `_read` itself) allocated with _IRR_ALIGNED_MALLOC, or nullptr on failure.*/
+	template<typename HeaderT>
+	void* tryDecodeBlob(const SBlobData_t<HeaderT>& _data, void* _read, const unsigned char _pwd[16], const unsigned char _iv[16]) const;
 
 	bool decompressLzma(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const;
 	bool decompressLz4(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const;
@@ -181,6 +194,9 @@ private:
         case asset::Blob::EBT_SKINNED_MESH_BUFFER:
             assert(_assetAddr->getAssetType()==asset::IAsset::ET_SUB_MESH);
             return static_cast<asset::ICPUSkinnedMeshBuffer*>(_assetAddr);
+        case asset::Blob::EBT_MESHLET_MESH_BUFFER:
+            assert(_assetAddr->getAssetType()==asset::IAsset::ET_SUB_MESH);
+            return static_cast<asset::ICPUMeshletMeshBuffer*>(_assetAddr);
         case asset::Blob::EBT_RAW_DATA_BUFFER:
             assert(_assetAddr->getAssetType()==asset::IAsset::ET_BUFFER);
             return static_cast<asset::ICPUBuffer*>(_assetAddr);
@@ -206,6 +222,9 @@ private:
         case asset::Blob::EBT_SKINNED_MESH_BUFFER:
             asset = reinterpret_cast<asset::ICPUSkinnedMeshBuffer*>(_asset);
             break;
+        case asset::Blob::EBT_MESHLET_MESH_BUFFER:
+            asset = reinterpret_cast<asset::ICPUMeshletMeshBuffer*>(_asset);
+            break;
         case asset::Blob::EBT_RAW_DATA_BUFFER:
             asset = reinterpret_cast<asset::ICPUBuffer*>(_asset);
             break;
@@ -483,6 +502,78 @@ void* CBAWMeshFileLoader::tryReadBlobOnStack(const SBlobData_t<HeaderT> & _data,
     return dst;
 }
 
+template<typename HeaderT>
+const void* CBAWMeshFileLoader::tryGetMappedBlob(const SBlobData_t<HeaderT>& _data, SContext& _ctx) const
+{
+    if (_data.header->compressionType != asset::Blob::EBCT_RAW)
+        return nullptr;
+
+    const void* blob = _ctx.inner.mainFile->getMappedRange(_data.absOffset, _data.header->effectiveSize());
+    // blobs get reinterpreted as structs with SIMD members, so keep the alignment a heap copy would have
+    if (!blob || (reinterpret_cast<size_t>(blob)%_IRR_SIMD_ALIGNMENT) != 0u)
+        return nullptr;
+    return blob;
+}
+
+template<typename HeaderT>
+void* CBAWMeshFileLoader::tryDecodeBlob(const SBlobData_t<HeaderT>& _data, void* _read, const unsigned char _pwd[16], const unsigned char _iv[16]) const
+{
+    const bool encrypted = (_data.header->compressionType & asset::Blob::EBCT_AES128_GCM);
+    const bool compressed = (_data.header->compressionType & asset::Blob::EBCT_LZ4) || (_data.header->compressionType & asset::Blob::EBCT_LZMA);
+
+    if (!_data.header->validate(_read))
+    {
+#ifdef _IRR_DEBUG
+        os::Printer::log("Blob validation failed!", ELL_ERROR);
+#endif
+        _IRR_ALIGNED_FREE(_read);
+        return nullptr;
+    }
+
+    void* src = _read;
+    if (encrypted)
+    {
+#ifdef _IRR_COMPILE_WITH_OPENSSL_
+        const size_t size = _data.header->effectiveSize();
+        void* out = _IRR_ALIGNED_MALLOC(size, _IRR_SIMD_ALIGNMENT);
+        const bool ok = asset::decAes128gcm(src, size, out, size, _pwd, _iv, _data.header->gcmTag);
+        _IRR_ALIGNED_FREE(src);
+        if (!ok)
+        {
+            _IRR_ALIGNED_FREE(out);
+#ifdef _IRR_DEBUG
+            os::Printer::log("Blob decryption failed!", ELL_ERROR);
+#endif
+            return nullptr;
+        }
+        src = out;
+#else
+        _IRR_ALIGNED_FREE(src);
+        return nullptr;
+#endif
+    }
+
+    if (!compressed)
+        return src;
+
+    void* dst = _IRR_ALIGNED_MALLOC(asset::BlobHeaderVn<_IRR_BAW_FORMAT_VERSION>::calcEncSize(_data.header->blobSizeDecompr), _IRR_SIMD_ALIGNMENT);
+    bool res = false;
+    if (_data.header->compressionType & asset::Blob::EBCT_LZ4)
+        res = decompressLz4(dst, _data.header->blobSizeDecompr, src, _data.header->blobSize);
+    else if (_data.header->compressionType & asset::Blob::EBCT_LZMA)
+        res = decompressLzma(dst, _data.header->blobSizeDecompr, src, _data.header->blobSize);
+    _IRR_ALIGNED_FREE(src);
+    if (!res)
+    {
+        _IRR_ALIGNED_FREE(dst);
+#ifdef _IRR_DEBUG
+        os::Printer::log("Blob decompression failed!", ELL_ERROR);
+#endif
+        return nullptr;
+    }
+    return dst;
+}
+
 }} // irr::scene
 
 #endif
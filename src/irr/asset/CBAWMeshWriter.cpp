@@ -14,7 +14,9 @@
 #include "irr/asset/ICPUTexture.h"
 #include "irr/asset/ICPUSkinnedMesh.h"
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
 #include "CFinalBoneHierarchy.h"
+#include "CImageWriterDDS.h"
 
 
 #include "lz4/lib/lz4.h"
@@ -96,13 +98,59 @@ struct LzmaMemMngmnt
 		tryWrite(&data, _file, _ctx, sizeof(data), _headerIdx, flags, encrPwd, comprLvl);
 	}
 	template<>
+	void CBAWMeshWriter::exportAsBlob<ICPUMeshletMeshBuffer>(ICPUMeshletMeshBuffer* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
+	{
+		uint8_t stackData[1u<<14];
+        MeshletMeshBufferBlobV1* data = MeshletMeshBufferBlobV1::createAndTryOnStack(_obj, stackData, sizeof(stackData));
+
+        const E_WRITER_FLAGS flags = _ctx.writerOverride->getAssetWritingFlags(_ctx.inner, _obj, 1u);
+        const uint8_t* encrPwd = nullptr;
+        _ctx.writerOverride->getEncryptionKey(encrPwd, _ctx.inner, _obj, 1u);
+        const float comprLvl = _ctx.writerOverride->getAssetCompressionLevel(_ctx.inner, _obj, 1u);
+		tryWrite(data, _file, _ctx, MeshletMeshBufferBlobV1::calcBlobSizeForObj(_obj), _headerIdx, flags, encrPwd, comprLvl);
+
+		if ((uint8_t*)data != stackData)
+			_IRR_ALIGNED_FREE(data);
+	}
+	template<>
 	void CBAWMeshWriter::exportAsBlob<ICPUTexture>(ICPUTexture* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
         ICPUTexture* tex = _obj;
 
         const WriteProperties* props = reinterpret_cast<const WriteProperties*>(_ctx.inner.params.userData);
 		const io::path fileDir = props->relPath.size() ? props->relPath : io::IFileSystem::getFileDir(m_fileSystem->getAbsolutePath(_file->getFileName())); // get relative-file's directory
-		io::path path = m_fileSystem->getRelativeFilename(tex->getSourceFilename().c_str(), fileDir); // get texture-file path relative to the file's directory
+		io::path texturePath = tex->getSourceFilename().c_str();
+#ifdef _IRR_COMPILE_WITH_DDS_WRITER_
+		if (props->bakedTextureFormat != asset::EF_UNKNOWN)
+		{
+			// bake the block compressed texture next to the output file and reference that instead
+			const io::path outputDir = io::IFileSystem::getFileDir(m_fileSystem->getAbsolutePath(_file->getFileName()));
+			const io::path bakedPath = outputDir + "/" + io::IFileSystem::getFileBasename(texturePath, false) + ".dds";
+			if (bakedPath != m_fileSystem->getAbsolutePath(texturePath))
+			{
+				CImageWriterDDS::SWriteProperties ddsProps;
+				ddsProps.format = props->bakedTextureFormat;
+				ddsProps.quality = props->bakedTextureQuality;
+				ddsProps.overrideQuality = true;
+				ddsProps.generateMipMaps = props->bakedTextureMipMaps;
+
+				bool baked = false;
+				io::IWriteFile* ddsFile = m_fileSystem->createAndWriteFile(bakedPath);
+				if (ddsFile)
+				{
+					auto ddsWriter = core::make_smart_refctd_ptr<CImageWriterDDS>();
+					baked = ddsWriter->writeAsset(ddsFile, SAssetWriteParams(tex, EWF_BINARY, 0.f, 0u, nullptr, &ddsProps));
+					ddsFile->drop();
+				}
+
+				if (baked)
+					texturePath = bakedPath;
+				else
+					os::Printer::log("Could not bake texture, referencing the original file instead", texturePath.c_str(), ELL_WARNING);
+			}
+		}
+#endif // _IRR_COMPILE_WITH_DDS_WRITER_
+		io::path path = m_fileSystem->getRelativeFilename(texturePath, fileDir); // get texture-file path relative to the file's directory
 		const uint32_t len = strlen(path.c_str()) + 1;
 
         const E_WRITER_FLAGS flags = _ctx.writerOverride->getAssetWritingFlags(_ctx.inner, _obj, 2u);
@@ -197,6 +245,9 @@ struct LzmaMemMngmnt
 			case Blob::EBT_SKINNED_MESH_BUFFER:
 				exportAsBlob(reinterpret_cast<ICPUSkinnedMeshBuffer*>(ctx.headers[i].handle), i, _file, ctx);
 				break;
+			case Blob::EBT_MESHLET_MESH_BUFFER:
+				exportAsBlob(reinterpret_cast<ICPUMeshletMeshBuffer*>(ctx.headers[i].handle), i, _file, ctx);
+				break;
 			case Blob::EBT_RAW_DATA_BUFFER:
 				exportAsBlob(reinterpret_cast<ICPUBuffer*>(ctx.headers[i].handle), i, _file, ctx);
 				break;
@@ -272,7 +323,10 @@ struct LzmaMemMngmnt
                 BlobHeaderV1 bh;
 				bh.handle = reinterpret_cast<uint64_t>(meshBuffer);
 				bh.compressionType = Blob::EBCT_RAW;
-				bh.blobType = isMeshAnimated ? Blob::EBT_SKINNED_MESH_BUFFER : Blob::EBT_MESH_BUFFER;
+				if (isMeshAnimated)
+					bh.blobType = Blob::EBT_SKINNED_MESH_BUFFER;
+				else // ICPUMeshletMeshBuffer is a direct non-virtual inheritor
+					bh.blobType = dynamic_cast<const ICPUMeshletMeshBuffer*>(meshBuffer) ? Blob::EBT_MESHLET_MESH_BUFFER : Blob::EBT_MESH_BUFFER;
 				_ctx.headers.push_back(bh);
 				countedObjects.insert(meshBuffer);
 
@@ -9,6 +9,7 @@
 #include "irr/asset/ICPUBuffer.h"
 #include "irr/asset/IAssetWriter.h"
 #include "irr/asset/ICPUMesh.h"
+#include "irr/asset/CBlockCompressor.h"
 #include "irr/asset/bawformat/CBAWFile.h"
 
 namespace irr {
@@ -45,6 +46,12 @@ namespace asset
 			unsigned char initializationVector[16];
 			//! Directory to which texture paths will be relative in output mesh file
 			io::path relPath;
+			//! Block compressed format textures get baked to as .dds files next to the output, EF_UNKNOWN keeps the original texture files
+			asset::E_FORMAT bakedTextureFormat = asset::EF_UNKNOWN;
+			//! Encoding quality of the baked textures
+			CBlockCompressor::E_QUALITY bakedTextureQuality = CBlockCompressor::EQ_NORMAL;
+			//! Whether textures without mip maps get a full chain generated before baking
+			bool bakedTextureMipMaps = true;
 		};
 
 	private:
@@ -0,0 +1,872 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "irr/asset/CBlockCompressor.h"
+#include "irr/asset/format/convertColor.h"
+
+#include <cfloat>
+#include <utility>
+
+namespace irr
+{
+namespace asset
+{
+
+namespace impl
+{
+    //! 4x4 block in SoA layout, `weight` is 0 for texels which don't take part in the fit (transparent BC1 texels)
+    struct SBlock
+    {
+        alignas(16) float ch[4][16];
+        alignas(16) float weight[16];
+
+        SBlock(const uint8_t* _texels)
+        {
+            for (uint32_t i=0u; i<16u; i++)
+            {
+                for (uint32_t c=0u; c<4u; c++)
+                    ch[c][i] = _texels[4u*i+c];
+                weight[i] = 1.f;
+            }
+        }
+    };
+
+    //! Picks the closest palette entry for every texel and returns the weighted squared error of the block
+    /** Four texels are tested against a palette entry at once, so evaluating a candidate pair of endpoints
+    costs `paletteSize` iterations of a handful of SSE instructions. */
+    static float selectIndices(const SBlock& _block, const float (*_palette)[4], uint32_t _paletteSize, const float* _channelWeights, uint8_t* _outIndices)
+    {
+        float error = 0.f;
+#ifdef __IRR_COMPILE_WITH_X86_SIMD_
+        const __m128 chWeight[4] = {_mm_set1_ps(_channelWeights[0]),_mm_set1_ps(_channelWeights[1]),_mm_set1_ps(_channelWeights[2]),_mm_set1_ps(_channelWeights[3])};
+        for (uint32_t g=0u; g<16u; g+=4u)
+        {
+            __m128 texel[4];
+            for (uint32_t c=0u; c<4u; c++)
+                texel[c] = _mm_load_ps(_block.ch[c]+g);
+
+            __m128 best = _mm_set1_ps(FLT_MAX);
+            __m128i bestIx = _mm_setzero_si128();
+            for (uint32_t k=0u; k<_paletteSize; k++)
+            {
+                __m128 dist = _mm_setzero_ps();
+                for (uint32_t c=0u; c<4u; c++)
+                {
+                    const __m128 diff = _mm_sub_ps(texel[c],_mm_set1_ps(_palette[k][c]));
+                    dist = _mm_add_ps(dist,_mm_mul_ps(_mm_mul_ps(diff,diff),chWeight[c]));
+                }
+                const __m128 closer = _mm_cmplt_ps(dist,best);
+                best = _mm_min_ps(dist,best);
+                bestIx = _mm_blendv_epi8(bestIx,_mm_set1_epi32(k),_mm_castps_si128(closer));
+            }
+
+            alignas(16) float texelError[4];
+            alignas(16) uint32_t texelIx[4];
+            _mm_store_ps(texelError,_mm_mul_ps(best,_mm_load_ps(_block.weight+g)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(texelIx),bestIx);
+            for (uint32_t i=0u; i<4u; i++)
+            {
+                error += texelError[i];
+                _outIndices[g+i] = texelIx[i];
+            }
+        }
+#else
+        for (uint32_t i=0u; i<16u; i++)
+        {
+            float best = FLT_MAX;
+            for (uint32_t k=0u; k<_paletteSize; k++)
+            {
+                float dist = 0.f;
+                for (uint32_t c=0u; c<4u; c++)
+                {
+                    const float diff = _block.ch[c][i]-_palette[k][c];
+                    dist += diff*diff*_channelWeights[c];
+                }
+                if (dist<best)
+                {
+                    best = dist;
+                    _outIndices[i] = k;
+                }
+            }
+            error += best*_block.weight[i];
+        }
+#endif
+        return error;
+    }
+
+    //! Endpoints along the principal axis of the weighted texels, only the first `_channels` channels are considered
+    static void principalAxisEndpoints(const SBlock& _block, uint32_t _channels, float* _e0, float* _e1)
+    {
+        float mean[4] = {0.f,0.f,0.f,0.f};
+        float totalWeight = 0.f;
+        for (uint32_t i=0u; i<16u; i++)
+        {
+            for (uint32_t c=0u; c<_channels; c++)
+                mean[c] += _block.ch[c][i]*_block.weight[i];
+            totalWeight += _block.weight[i];
+        }
+        if (totalWeight==0.f)
+            totalWeight = 1.f;
+        for (uint32_t c=0u; c<_channels; c++)
+            mean[c] /= totalWeight;
+
+        float cov[4][4] = {};
+        for (uint32_t i=0u; i<16u; i++)
+        for (uint32_t a=0u; a<_channels; a++)
+        for (uint32_t b=a; b<_channels; b++)
+            cov[a][b] += (_block.ch[a][i]-mean[a])*(_block.ch[b][i]-mean[b])*_block.weight[i];
+        for (uint32_t a=0u; a<_channels; a++)
+        for (uint32_t b=0u; b<a; b++)
+            cov[a][b] = cov[b][a];
+
+        // power iteration, starting from the covariance row of the channel with the largest variance
+        uint32_t widest = 0u;
+        for (uint32_t c=1u; c<_channels; c++)
+        if (cov[c][c]>cov[widest][widest])
+            widest = c;
+        float axis[4] = {0.f,0.f,0.f,0.f};
+        for (uint32_t c=0u; c<_channels; c++)
+            axis[c] = cov[widest][c];
+        for (uint32_t iter=0u; iter<8u; iter++)
+        {
+            float next[4] = {0.f,0.f,0.f,0.f};
+            float maxComponent = 0.f;
+            for (uint32_t a=0u; a<_channels; a++)
+            {
+                for (uint32_t b=0u; b<_channels; b++)
+                    next[a] += cov[a][b]*axis[b];
+                maxComponent = core::max_(maxComponent,std::abs(next[a]));
+            }
+            if (maxComponent==0.f)
+                break;
+            for (uint32_t c=0u; c<_channels; c++)
+                axis[c] = next[c]/maxComponent;
+        }
+
+        float lengthSq = 0.f;
+        for (uint32_t c=0u; c<_channels; c++)
+            lengthSq += axis[c]*axis[c];
+        if (lengthSq==0.f)
+        {
+            for (uint32_t c=0u; c<_channels; c++)
+                _e0[c] = _e1[c] = mean[c];
+            return;
+        }
+
+        float tMin = FLT_MAX, tMax = -FLT_MAX;
+        for (uint32_t i=0u; i<16u; i++)
+        {
+            if (_block.weight[i]==0.f)
+                continue;
+            float t = 0.f;
+            for (uint32_t c=0u; c<_channels; c++)
+                t += (_block.ch[c][i]-mean[c])*axis[c];
+            tMin = core::min_(tMin,t);
+            tMax = core::max_(tMax,t);
+        }
+        for (uint32_t c=0u; c<_channels; c++)
+        {
+            _e0[c] = core::min_(core::max_(mean[c]+axis[c]*tMin/lengthSq,0.f),255.f);
+            _e1[c] = core::min_(core::max_(mean[c]+axis[c]*tMax/lengthSq,0.f),255.f);
+        }
+    }
+
+    //! Bounding box of the weighted texels, inset by 1/16th of the range on each side to account for the interpolated entries
+    static void boundingBoxEndpoints(const SBlock& _block, uint32_t _channels, float* _e0, float* _e1)
+    {
+        for (uint32_t c=0u; c<_channels; c++)
+        {
+            float lo = 255.f, hi = 0.f;
+            for (uint32_t i=0u; i<16u; i++)
+            {
+                if (_block.weight[i]==0.f)
+                    continue;
+                lo = core::min_(lo,_block.ch[c][i]);
+                hi = core::max_(hi,_block.ch[c][i]);
+            }
+            if (lo>hi)
+                lo = hi = 0.f;
+            const float inset = (hi-lo)/16.f;
+            _e0[c] = lo+inset;
+            _e1[c] = hi-inset;
+        }
+    }
+
+    //! Least squares endpoints for fixed indices, `_fractions[ix]` is how far along e0->e1 palette entry `ix` lies
+    /** Returns false if the system is degenerate (all texels use the same fraction). */
+    static bool leastSquaresEndpoints(const SBlock& _block, uint32_t _channels, const uint8_t* _indices, const float* _fractions, float* _e0, float* _e1)
+    {
+        float A = 0.f, B = 0.f, C = 0.f;
+        float X0[4] = {0.f,0.f,0.f,0.f}, X1[4] = {0.f,0.f,0.f,0.f};
+        for (uint32_t i=0u; i<16u; i++)
+        {
+            const float w = _block.weight[i];
+            if (w==0.f)
+                continue;
+            const float f = _fractions[_indices[i]];
+            const float g = 1.f-f;
+            A += g*g*w;
+            B += g*f*w;
+            C += f*f*w;
+            for (uint32_t c=0u; c<_channels; c++)
+            {
+                X0[c] += g*_block.ch[c][i]*w;
+                X1[c] += f*_block.ch[c][i]*w;
+            }
+        }
+
+        const float det = A*C-B*B;
+        if (std::abs(det)<1e-6f)
+            return false;
+        for (uint32_t c=0u; c<_channels; c++)
+        {
+            _e0[c] = core::min_(core::max_((C*X0[c]-B*X1[c])/det,0.f),255.f);
+            _e1[c] = core::min_(core::max_((A*X1[c]-B*X0[c])/det,0.f),255.f);
+        }
+        return true;
+    }
+
+    //! Little endian bit writer for 128bit blocks
+    struct SBitWriter
+    {
+        uint8_t* out;
+        uint32_t pos = 0u;
+
+        SBitWriter(void* _out) : out(reinterpret_cast<uint8_t*>(_out)) { memset(out,0,16u); }
+
+        inline void write(uint32_t _value, uint32_t _bits)
+        {
+            for (uint32_t b=0u; b<_bits; b++, pos++)
+                out[pos>>3u] |= ((_value>>b)&0x1u)<<(pos&0x7u);
+        }
+    };
+
+
+    //! BC1 colour endpoints
+    struct SBC1Endpoints
+    {
+        uint16_t c0, c1;
+    };
+
+    static inline uint16_t quantize565(const float* _rgb)
+    {
+        const uint32_t r = uint32_t(_rgb[0]*31.f/255.f+0.5f);
+        const uint32_t g = uint32_t(_rgb[1]*63.f/255.f+0.5f);
+        const uint32_t b = uint32_t(_rgb[2]*31.f/255.f+0.5f);
+        return (r<<11u)|(g<<5u)|b;
+    }
+
+    static inline void expand565(uint16_t _c, float* _rgb)
+    {
+        const uint32_t r = (_c>>11u)&0x1fu, g = (_c>>5u)&0x3fu, b = _c&0x1fu;
+        _rgb[0] = float((r<<3u)|(r>>2u));
+        _rgb[1] = float((g<<2u)|(g>>4u));
+        _rgb[2] = float((b<<3u)|(b>>2u));
+        _rgb[3] = 0.f;
+    }
+
+    //! Palette as decoded by hardware, `_fourColor` is implied by the order of c0 and c1 except for BC2/BC3 colour blocks
+    static inline void bc1Palette(const SBC1Endpoints& _e, bool _fourColor, float (*_palette)[4])
+    {
+        expand565(_e.c0,_palette[0]);
+        expand565(_e.c1,_palette[1]);
+        for (uint32_t c=0u; c<4u; c++)
+        {
+            if (_fourColor)
+            {
+                _palette[2][c] = (2.f*_palette[0][c]+_palette[1][c])/3.f;
+                _palette[3][c] = (_palette[0][c]+2.f*_palette[1][c])/3.f;
+            }
+            else
+            {
+                _palette[2][c] = (_palette[0][c]+_palette[1][c])*0.5f;
+                _palette[3][c] = 0.f;
+            }
+        }
+    }
+
+    //! RGB weights roughly following luminance, so that the error is spent where it is least visible
+    _IRR_STATIC_INLINE_CONSTEXPR float BC1ChannelWeights[4] = {0.299f*3.f,0.587f*3.f,0.114f*3.f,0.f};
+
+    //! Encodes the colour half of a BC1/BC2/BC3 block with endpoints `_e0` and `_e1`, returns the error
+    /** `_forceFourColor` is for BC2/BC3 which always decode four colours, `_threeColor` picks the BC1 mode with a transparent entry. */
+    static float encodeBC1Colors(const SBlock& _block, const float* _e0, const float* _e1, bool _threeColor, bool _forceFourColor, bool _hasTransparent, SBC1Endpoints& _outEndpoints, uint32_t& _outIndices)
+    {
+        SBC1Endpoints ep = {quantize565(_e0),quantize565(_e1)};
+        // the mode is given by the endpoint order
+        if (_threeColor ? (ep.c0>ep.c1):(ep.c0<ep.c1))
+            std::swap(ep.c0,ep.c1);
+
+        const bool fourColor = _forceFourColor || ep.c0>ep.c1;
+        float palette[4][4];
+        bc1Palette(ep,fourColor,palette);
+
+        uint8_t indices[16];
+        // in the three colour mode the last entry is transparent (or black), opaque texels may never pick it
+        const float error = selectIndices(_block,palette,fourColor ? 4u:3u,BC1ChannelWeights,indices);
+
+        uint32_t packed = 0u;
+        for (uint32_t i=0u; i<16u; i++)
+        {
+            const uint32_t ix = (_hasTransparent && _block.weight[i]==0.f) ? 3u:indices[i];
+            packed |= ix<<(2u*i);
+        }
+        _outEndpoints = ep;
+        _outIndices = packed;
+        return error;
+    }
+
+    static void compressBC1Colors(const SBlock& _block, uint8_t* _out, CBlockCompressor::E_QUALITY _quality, bool _hasTransparent, bool _forceFourColor)
+    {
+        SBC1Endpoints bestEndpoints;
+        uint32_t bestIndices;
+
+        bool anyOpaque = false;
+        for (uint32_t i=0u; i<16u; i++)
+            anyOpaque |= _block.weight[i]!=0.f;
+        if (!anyOpaque)
+        {
+            // fully transparent, three colour mode with every texel on the transparent entry
+            bestEndpoints = {0u,0u};
+            bestIndices = 0xffffffffu;
+        }
+        else
+        {
+            float e0[4], e1[4];
+            if (_quality==CBlockCompressor::EQ_FAST)
+                boundingBoxEndpoints(_block,3u,e0,e1);
+            else
+                principalAxisEndpoints(_block,3u,e0,e1);
+
+            const bool threeColor = _hasTransparent && !_forceFourColor;
+            float bestError = encodeBC1Colors(_block,e0,e1,threeColor,_forceFourColor,_hasTransparent,bestEndpoints,bestIndices);
+
+            auto tryEndpoints = [&](const float* _a, const float* _b, bool _threeColorMode) -> bool
+            {
+                SBC1Endpoints endpoints;
+                uint32_t indices;
+                const float error = encodeBC1Colors(_block,_a,_b,_threeColorMode,_forceFourColor,_hasTransparent,endpoints,indices);
+                if (error<bestError)
+                {
+                    bestError = error;
+                    bestEndpoints = endpoints;
+                    bestIndices = indices;
+                    return true;
+                }
+                return false;
+            };
+
+            if (_quality!=CBlockCompressor::EQ_FAST)
+            {
+                const uint32_t refinements = _quality==CBlockCompressor::EQ_HIGH ? 4u:1u;
+                const bool fourColor = _forceFourColor || bestEndpoints.c0>bestEndpoints.c1;
+                // fractions along c0->c1 of the palette entries
+                const float fourColorFractions[4] = {0.f,1.f,1.f/3.f,2.f/3.f};
+                const float threeColorFractions[4] = {0.f,1.f,0.5f,0.f};
+                for (uint32_t r=0u; r<refinements; r++)
+                {
+                    uint8_t indices[16];
+                    for (uint32_t i=0u; i<16u; i++)
+                        indices[i] = (bestIndices>>(2u*i))&0x3u;
+
+                    float a[4], b[4];
+                    if (!leastSquaresEndpoints(_block,3u,indices,fourColor ? fourColorFractions:threeColorFractions,a,b))
+                        break;
+                    if (!tryEndpoints(a,b,!fourColor))
+                        break;
+                }
+
+                // the three colour mode can represent a texel halfway between the endpoints exactly
+                if (_quality==CBlockCompressor::EQ_HIGH && !threeColor && !_forceFourColor)
+                    tryEndpoints(e0,e1,true);
+            }
+
+            if (_quality==CBlockCompressor::EQ_HIGH)
+            {
+                // nudge single 565 components while that improves the block
+                for (uint32_t pass=0u; pass<2u; pass++)
+                {
+                    bool improved = false;
+                    const bool threeColorMode = !_forceFourColor && bestEndpoints.c0<=bestEndpoints.c1;
+                    for (uint32_t e=0u; e<2u; e++)
+                    for (uint32_t c=0u; c<3u; c++)
+                    for (int32_t delta=-1; delta<=1; delta+=2)
+                    {
+                        const uint32_t shift = c==0u ? 11u:(c==1u ? 5u:0u);
+                        const uint32_t mask = c==1u ? 0x3fu:0x1fu;
+                        SBC1Endpoints candidate = bestEndpoints;
+                        uint16_t& target = e ? candidate.c1:candidate.c0;
+                        const int32_t value = int32_t((target>>shift)&mask)+delta;
+                        if (value<0 || value>int32_t(mask))
+                            continue;
+                        target = (target&~(mask<<shift))|(uint32_t(value)<<shift);
+
+                        float a[4], b[4];
+                        expand565(candidate.c0,a);
+                        expand565(candidate.c1,b);
+                        improved |= tryEndpoints(a,b,threeColorMode);
+                    }
+                    if (!improved)
+                        break;
+                }
+            }
+        }
+
+        memcpy(_out,&bestEndpoints.c0,2u);
+        memcpy(_out+2u,&bestEndpoints.c1,2u);
+        memcpy(_out+4u,&bestIndices,4u);
+    }
+
+
+    static inline void bc4Palette(uint8_t _r0, uint8_t _r1, float (*_palette)[4])
+    {
+        memset(_palette,0,sizeof(float)*4u*8u);
+        _palette[0][0] = _r0;
+        _palette[1][0] = _r1;
+        if (_r0>_r1)
+        {
+            for (uint32_t i=2u; i<8u; i++)
+                _palette[i][0] = float((8u-i)*_r0+(i-1u)*_r1)/7.f;
+        }
+        else
+        {
+            for (uint32_t i=2u; i<6u; i++)
+                _palette[i][0] = float((6u-i)*_r0+(i-1u)*_r1)/5.f;
+            _palette[6][0] = 0.f;
+            _palette[7][0] = 255.f;
+        }
+    }
+
+    //! Encodes a BC4 block with the given endpoint bytes, the mode follows from their order
+    static float encodeBC4(const SBlock& _block, uint8_t _r0, uint8_t _r1, uint8_t* _out)
+    {
+        float palette[8][4];
+        bc4Palette(_r0,_r1,palette);
+
+        const float channelWeights[4] = {1.f,0.f,0.f,0.f};
+        uint8_t indices[16];
+        const float error = selectIndices(_block,palette,8u,channelWeights,indices);
+
+        uint64_t packed = 0u;
+        for (uint32_t i=0u; i<16u; i++)
+            packed |= uint64_t(indices[i])<<(3u*i);
+        _out[0] = _r0;
+        _out[1] = _r1;
+        for (uint32_t i=0u; i<6u; i++)
+            _out[2u+i] = (packed>>(8u*i))&0xffu;
+        return error;
+    }
+
+    //! `_block` holds the channel to encode in channel 0
+    static void compressBC4Channel(const SBlock& _block, uint8_t* _out, CBlockCompressor::E_QUALITY _quality)
+    {
+        float lo = 255.f, hi = 0.f;
+        for (uint32_t i=0u; i<16u; i++)
+        {
+            lo = core::min_(lo,_block.ch[0][i]);
+            hi = core::max_(hi,_block.ch[0][i]);
+        }
+
+        // eight value mode wants r0>r1
+        uint8_t best[8];
+        float bestError = encodeBC4(_block,uint8_t(hi),uint8_t(lo),best);
+        if (_quality!=CBlockCompressor::EQ_FAST && bestError>0.f)
+        {
+            auto tryEndpoints = [&](float _a, float _b) -> bool
+            {
+                const uint8_t r0 = uint8_t(core::min_(core::max_(_a,0.f),255.f)+0.5f);
+                const uint8_t r1 = uint8_t(core::min_(core::max_(_b,0.f),255.f)+0.5f);
+                uint8_t candidate[8];
+                const float error = encodeBC4(_block,r0,r1,candidate);
+                if (error<bestError)
+                {
+                    bestError = error;
+                    memcpy(best,candidate,8u);
+                    return true;
+                }
+                return false;
+            };
+
+            const uint32_t refinements = _quality==CBlockCompressor::EQ_HIGH ? 4u:1u;
+            auto refine = [&]()
+            {
+                for (uint32_t r=0u; r<refinements; r++)
+                {
+                    const bool eightValue = best[0]>best[1];
+                    float fractions[8] = {0.f,1.f};
+                    for (uint32_t i=2u; i<8u; i++)
+                        fractions[i] = eightValue ? float(i-1u)/7.f:(i<6u ? float(i-1u)/5.f:0.f);
+
+                    uint8_t indices[16];
+                    uint64_t packed = 0u;
+                    for (uint32_t i=0u; i<6u; i++)
+                        packed |= uint64_t(best[2u+i])<<(8u*i);
+                    SBlock fitted = _block;
+                    for (uint32_t i=0u; i<16u; i++)
+                    {
+                        indices[i] = (packed>>(3u*i))&0x7u;
+                        // texels snapped to the 0 and 255 entries don't depend on the endpoints
+                        if (!eightValue && indices[i]>=6u)
+                            fitted.weight[i] = 0.f;
+                    }
+
+                    float a[4], b[4];
+                    if (!leastSquaresEndpoints(fitted,1u,indices,fractions,a,b))
+                        break;
+                    if (!tryEndpoints(eightValue ? core::max_(a[0],b[0]):core::min_(a[0],b[0]),eightValue ? core::min_(a[0],b[0]):core::max_(a[0],b[0])))
+                        break;
+                }
+            };
+            refine();
+
+            if (_quality==CBlockCompressor::EQ_HIGH)
+            {
+                // six value mode with explicit 0 and 255, fit the endpoints to the texels in between
+                float innerLo = 255.f, innerHi = 0.f;
+                for (uint32_t i=0u; i<16u; i++)
+                {
+                    const float v = _block.ch[0][i];
+                    if (v==0.f || v==255.f)
+                        continue;
+                    innerLo = core::min_(innerLo,v);
+                    innerHi = core::max_(innerHi,v);
+                }
+                if (innerLo<=innerHi && tryEndpoints(innerLo,innerHi))
+                    refine();
+            }
+        }
+        memcpy(_out,best,8u);
+    }
+
+
+    //! BC7 4bit index interpolation weights out of 64
+    _IRR_STATIC_INLINE_CONSTEXPR uint32_t BC7Weights4[16] = {0u,4u,9u,13u,17u,21u,26u,30u,34u,38u,43u,47u,51u,55u,60u,64u};
+
+    struct SBC7Mode6Endpoints
+    {
+        uint8_t c[2][4]; // 7bit
+        uint8_t p[2];
+    };
+
+    static inline void bc7Mode6Palette(const SBC7Mode6Endpoints& _e, float (*_palette)[4])
+    {
+        for (uint32_t c=0u; c<4u; c++)
+        {
+            const uint32_t a = (uint32_t(_e.c[0][c])<<1u)|_e.p[0];
+            const uint32_t b = (uint32_t(_e.c[1][c])<<1u)|_e.p[1];
+            for (uint32_t k=0u; k<16u; k++)
+                _palette[k][c] = float(((64u-BC7Weights4[k])*a+BC7Weights4[k]*b+32u)>>6u);
+        }
+    }
+
+    //! Quantizes an RGBA endpoint to 7 bits per channel with the given p-bit
+    static inline void quantizeBC7Mode6(const float* _e, uint8_t _p, uint8_t* _out)
+    {
+        for (uint32_t c=0u; c<4u; c++)
+            _out[c] = uint8_t(core::min_(core::max_((_e[c]-float(_p))*0.5f+0.5f,0.f),127.f));
+    }
+
+    static float encodeBC7Mode6(const SBlock& _block, const float* _e0, const float* _e1, const uint8_t* _p, SBC7Mode6Endpoints& _outEndpoints, uint8_t* _outIndices)
+    {
+        SBC7Mode6Endpoints ep;
+        ep.p[0] = _p[0];
+        ep.p[1] = _p[1];
+        quantizeBC7Mode6(_e0,_p[0],ep.c[0]);
+        quantizeBC7Mode6(_e1,_p[1],ep.c[1]);
+
+        float palette[16][4];
+        bc7Mode6Palette(ep,palette);
+        const float channelWeights[4] = {1.f,1.f,1.f,1.f};
+        const float error = selectIndices(_block,palette,16u,channelWeights,_outIndices);
+        _outEndpoints = ep;
+        return error;
+    }
+
+    static void compressBC7Mode6(const SBlock& _block, uint8_t* _out, CBlockCompressor::E_QUALITY _quality)
+    {
+        float e0[4], e1[4];
+        if (_quality==CBlockCompressor::EQ_FAST)
+            boundingBoxEndpoints(_block,4u,e0,e1);
+        else
+            principalAxisEndpoints(_block,4u,e0,e1);
+
+        SBC7Mode6Endpoints bestEndpoints;
+        uint8_t bestIndices[16];
+        float bestError = FLT_MAX;
+        auto tryEndpoints = [&](const float* _a, const float* _b) -> bool
+        {
+            // high quality tries every p-bit combination, the others take the p-bit with the smaller quantization error per endpoint
+            uint8_t pbits[4][2] = {{0u,0u},{1u,1u},{0u,1u},{1u,0u}};
+            uint32_t combos = 4u;
+            if (_quality!=CBlockCompressor::EQ_HIGH)
+            {
+                for (uint32_t e=0u; e<2u; e++)
+                {
+                    const float* end = e ? _b:_a;
+                    float error[2] = {0.f,0.f};
+                    for (uint8_t p=0u; p<2u; p++)
+                    {
+                        uint8_t quantized[4];
+                        quantizeBC7Mode6(end,p,quantized);
+                        for (uint32_t c=0u; c<4u; c++)
+                        {
+                            const float diff = float((uint32_t(quantized[c])<<1u)|p)-end[c];
+                            error[p] += diff*diff;
+                        }
+                    }
+                    pbits[0][e] = error[1]<error[0] ? 1u:0u;
+                }
+                combos = 1u;
+            }
+
+            bool improved = false;
+            for (uint32_t i=0u; i<combos; i++)
+            {
+                SBC7Mode6Endpoints endpoints;
+                uint8_t indices[16];
+                const float error = encodeBC7Mode6(_block,_a,_b,pbits[i],endpoints,indices);
+                if (error<bestError)
+                {
+                    bestError = error;
+                    bestEndpoints = endpoints;
+                    memcpy(bestIndices,indices,16u);
+                    improved = true;
+                }
+            }
+            return improved;
+        };
+        tryEndpoints(e0,e1);
+
+        if (_quality!=CBlockCompressor::EQ_FAST)
+        {
+            float fractions[16];
+            for (uint32_t k=0u; k<16u; k++)
+                fractions[k] = float(BC7Weights4[k])/64.f;
+
+            const uint32_t refinements = _quality==CBlockCompressor::EQ_HIGH ? 4u:1u;
+            for (uint32_t r=0u; r<refinements && bestError>0.f; r++)
+            {
+                float a[4], b[4];
+                if (!leastSquaresEndpoints(_block,4u,bestIndices,fractions,a,b))
+                    break;
+                if (!tryEndpoints(a,b))
+                    break;
+            }
+        }
+
+        // the anchor texel has an implicit 0 as the index MSB
+        if (bestIndices[0]&0x8u)
+        {
+            std::swap(bestEndpoints.c[0],bestEndpoints.c[1]);
+            std::swap(bestEndpoints.p[0],bestEndpoints.p[1]);
+            for (uint32_t i=0u; i<16u; i++)
+                bestIndices[i] = 15u-bestIndices[i];
+        }
+
+        SBitWriter writer(_out);
+        writer.write(0x1u<<6u,7u); // mode 6
+        for (uint32_t c=0u; c<4u; c++)
+        {
+            writer.write(bestEndpoints.c[0][c],7u);
+            writer.write(bestEndpoints.c[1][c],7u);
+        }
+        writer.write(bestEndpoints.p[0],1u);
+        writer.write(bestEndpoints.p[1],1u);
+        writer.write(bestIndices[0],3u);
+        for (uint32_t i=1u; i<16u; i++)
+            writer.write(bestIndices[i],4u);
+    }
+
+    //! Gathers the 4x4 block at (_x,_y), replicating the last row and column for partial blocks at the edges
+    static inline void gatherBlock(const uint8_t* _slice, uint32_t _width, uint32_t _height, uint32_t _x, uint32_t _y, uint8_t* _out)
+    {
+        for (uint32_t y=0u; y<4u; y++)
+        {
+            const uint8_t* row = _slice+size_t(core::min_(_y+y,_height-1u))*_width*4u;
+            for (uint32_t x=0u; x<4u; x++)
+                memcpy(_out+(4u*y+x)*4u,row+size_t(core::min_(_x+x,_width-1u))*4u,4u);
+        }
+    }
+}
+
+
+bool CBlockCompressor::isSupportedFormat(E_FORMAT _fmt)
+{
+    switch (_fmt)
+    {
+        case EF_BC1_RGB_UNORM_BLOCK:
+        case EF_BC1_RGB_SRGB_BLOCK:
+        case EF_BC1_RGBA_UNORM_BLOCK:
+        case EF_BC1_RGBA_SRGB_BLOCK:
+        case EF_BC3_UNORM_BLOCK:
+        case EF_BC3_SRGB_BLOCK:
+        case EF_BC4_UNORM_BLOCK:
+        case EF_BC5_UNORM_BLOCK:
+        case EF_BC7_UNORM_BLOCK:
+        case EF_BC7_SRGB_BLOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void CBlockCompressor::compressBC1Block(const uint8_t* _texels, void* _out, E_QUALITY _quality, bool _punchThroughAlpha)
+{
+    impl::SBlock block(_texels);
+    bool hasTransparent = false;
+    if (_punchThroughAlpha)
+    for (uint32_t i=0u; i<16u; i++)
+    if (_texels[4u*i+3u]<128u)
+    {
+        block.weight[i] = 0.f;
+        hasTransparent = true;
+    }
+    impl::compressBC1Colors(block,reinterpret_cast<uint8_t*>(_out),_quality,hasTransparent,false);
+}
+
+void CBlockCompressor::compressBC3Block(const uint8_t* _texels, void* _out, E_QUALITY _quality)
+{
+    uint8_t* out = reinterpret_cast<uint8_t*>(_out);
+    compressBC4Block(_texels,out,_quality,3u);
+    impl::compressBC1Colors(impl::SBlock(_texels),out+8u,_quality,false,true);
+}
+
+void CBlockCompressor::compressBC4Block(const uint8_t* _texels, void* _out, E_QUALITY _quality, uint32_t _channel)
+{
+    impl::SBlock block(_texels);
+    for (uint32_t i=0u; i<16u; i++)
+    {
+        block.ch[0][i] = _texels[4u*i+_channel];
+        block.ch[1][i] = block.ch[2][i] = block.ch[3][i] = 0.f;
+    }
+    impl::compressBC4Channel(block,reinterpret_cast<uint8_t*>(_out),_quality);
+}
+
+void CBlockCompressor::compressBC5Block(const uint8_t* _texels, void* _out, E_QUALITY _quality)
+{
+    compressBC4Block(_texels,_out,_quality,0u);
+    compressBC4Block(_texels,reinterpret_cast<uint8_t*>(_out)+8u,_quality,1u);
+}
+
+void CBlockCompressor::compressBC7Block(const uint8_t* _texels, void* _out, E_QUALITY _quality)
+{
+    impl::compressBC7Mode6(impl::SBlock(_texels),reinterpret_cast<uint8_t*>(_out),_quality);
+}
+
+CImageData* CBlockCompressor::compress(const CImageData* _image, E_FORMAT _dstFmt, E_QUALITY _quality, core::CTaskScheduler* _scheduler)
+{
+    const E_FORMAT srcFmt = _image->getColorFormat();
+    if (!isSupportedFormat(_dstFmt) || isBlockCompressionFormat(srcFmt) || isPlanarFormat(srcFmt) || srcFmt==EF_UNKNOWN)
+        return nullptr;
+
+    const core::vector3d<uint32_t> size = _image->getSize();
+    if (size.X==0u || size.Y==0u || size.Z==0u)
+        return nullptr;
+
+    // the block formats store values in the encoding of the destination, so convert into that first
+    const E_FORMAT stagingFmt = isSRGBFormat(_dstFmt) ? EF_R8G8B8A8_SRGB:EF_R8G8B8A8_UNORM;
+    const uint32_t srcChannels = getFormatChannelCount(srcFmt);
+    const size_t stagingRowSize = size_t(size.X)*4u;
+    core::vector<uint8_t> staging(stagingRowSize*size.Y*size.Z);
+    {
+        const uint8_t* const srcData = reinterpret_cast<const uint8_t*>(_image->getData());
+        const size_t srcPitch = _image->getPitchIncludingAlignment();
+        core::parallel_for<uint32_t>(0u,size.Y*size.Z,[&](uint32_t _row)
+            {
+                const void* srcPix[4] = {srcData+_row*srcPitch,nullptr,nullptr,nullptr};
+                uint8_t* const dstRow = staging.data()+_row*stagingRowSize;
+                core::vector3d<uint32_t> rowSize(size.X,1u,1u);
+                video::convertColor(srcFmt,stagingFmt,srcPix,dstRow,size.X,rowSize);
+
+                // channels missing from the source are undefined after conversion
+                if (srcChannels<4u)
+                for (uint32_t x=0u; x<size.X; x++)
+                {
+                    uint8_t* texel = dstRow+4u*x;
+                    for (uint32_t c=srcChannels; c<3u; c++)
+                        texel[c] = 0u;
+                    texel[3] = 255u;
+                }
+            },
+            0u,_scheduler
+        );
+    }
+
+    uint32_t minCoord[3], maxCoord[3];
+    memcpy(minCoord,_image->getSliceMin(),sizeof(minCoord));
+    memcpy(maxCoord,_image->getSliceMax(),sizeof(maxCoord));
+    CImageData* retval = new CImageData(nullptr,minCoord,maxCoord,_image->getSupposedMipLevel(),_dstFmt,1u);
+
+    const uint32_t blocksX = (size.X+3u)/4u;
+    const uint32_t blocksY = (size.Y+3u)/4u;
+    const uint32_t blockSize = getTexelOrBlockBytesize(_dstFmt);
+    uint8_t* const outData = reinterpret_cast<uint8_t*>(retval->getData());
+    // every block row is an independent task
+    core::parallel_for<uint32_t>(0u,blocksY*size.Z,[&](uint32_t _blockRow)
+        {
+            const uint32_t z = _blockRow/blocksY;
+            const uint32_t by = _blockRow%blocksY;
+            const uint8_t* const slice = staging.data()+size_t(z)*stagingRowSize*size.Y;
+            uint8_t* out = outData+size_t(_blockRow)*blocksX*blockSize;
+
+            uint8_t texels[64];
+            for (uint32_t bx=0u; bx<blocksX; bx++, out+=blockSize)
+            {
+                impl::gatherBlock(slice,size.X,size.Y,bx*4u,by*4u,texels);
+                switch (_dstFmt)
+                {
+                    case EF_BC1_RGB_UNORM_BLOCK:
+                    case EF_BC1_RGB_SRGB_BLOCK:
+                        compressBC1Block(texels,out,_quality,false);
+                        break;
+                    case EF_BC1_RGBA_UNORM_BLOCK:
+                    case EF_BC1_RGBA_SRGB_BLOCK:
+                        compressBC1Block(texels,out,_quality,true);
+                        break;
+                    case EF_BC3_UNORM_BLOCK:
+                    case EF_BC3_SRGB_BLOCK:
+                        compressBC3Block(texels,out,_quality);
+                        break;
+                    case EF_BC4_UNORM_BLOCK:
+                        compressBC4Block(texels,out,_quality);
+                        break;
+                    case EF_BC5_UNORM_BLOCK:
+                        compressBC5Block(texels,out,_quality);
+                        break;
+                    default:
+                        compressBC7Block(texels,out,_quality);
+                        break;
+                }
+            }
+        },
+        1u,_scheduler
+    );
+
+    return retval;
+}
+
+ICPUTexture* CBlockCompressor::compress(const ICPUTexture* _texture, E_FORMAT _dstFmt, E_QUALITY _quality, core::CTaskScheduler* _scheduler)
+{
+    core::vector<CImageData*> ranges;
+    ranges.reserve(_texture->getRanges().size());
+    for (const CImageData* range : _texture->getRanges())
+    {
+        CImageData* compressed = compress(range,_dstFmt,_quality,_scheduler);
+        if (!compressed)
+        {
+            for (auto& r : ranges)
+                r->drop();
+            return nullptr;
+        }
+        ranges.push_back(compressed);
+    }
+
+    ICPUTexture* retval = ICPUTexture::create(ranges,_texture->getSourceFilename(),_texture->getType());
+    for (auto& r : ranges)
+        r->drop();
+    return retval;
+}
+
+} // end namespace asset
+} // end namespace irr
@@ -0,0 +1,269 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include <algorithm>
+#include <cstring>
+
+#include "irr/static_if.h"
+#include "irr/asset/CBoundedAssetCache.h"
+
+using namespace irr;
+using namespace asset;
+
+
+uint64_t CBoundedAssetCache::hashKey(const std::string& _key)
+{
+    // 64bit FNV-1a, keys are short paths so a 256bit hash of which only a quarter gets used is a waste
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : _key)
+    {
+        hash ^= uint8_t(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t CBoundedAssetCache::estimateSize(const SAssetBundle& _bundle)
+{
+    size_t retval = 0u;
+    auto contents = _bundle.getContents();
+    for (auto it=contents.first; it!=contents.second; it++)
+    if (*it && !(*it)->isADummyObjectForCache())
+        retval += (*it)->conservativeSizeEstimate();
+    return retval;
+}
+
+
+void CBoundedAssetCache::setByteBudget(size_t _bytes, E_EVICTION_POLICY _policy)
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    m_byteBudget = _bytes;
+    m_policy = _policy;
+    evictOverBudget(nullptr);
+}
+
+bool CBoundedAssetCache::insert(const std::string& _key, const SAssetBundle& _val)
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    SEntry& entry = link(_key,_val);
+    if (m_greetingFunc)
+        m_greetingFunc(entry.bundle);
+    evictOverBudget(&entry);
+    return true;
+}
+
+bool CBoundedAssetCache::contains(const SAssetBundle& _object) const
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    for (const auto& entry : m_index)
+    if (entry.second->bundle==_object)
+        return true;
+    return false;
+}
+
+void CBoundedAssetCache::clear()
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    if (m_disposalFunc)
+    {
+        for (auto& entry : m_lru)
+            m_disposalFunc(entry.bundle);
+        for (auto& entry : m_dummies)
+            m_disposalFunc(entry.bundle);
+    }
+    m_index.clear();
+    m_lru.clear();
+    m_dummies.clear();
+    m_byteSize = 0u;
+}
+
+bool CBoundedAssetCache::swapObjectValue(const std::string& _key, const SAssetBundle& _obj, const SAssetBundle& _val)
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    auto found = find(_key,_obj);
+    const bool inserting = found==m_index.end();
+    // re-link so the size estimate and the dummy state get recomputed for the new value
+    if (!inserting)
+        unlink(found,true);
+    SEntry& entry = link(_key,_val);
+    if (m_greetingFunc)
+        m_greetingFunc(entry.bundle);
+    evictOverBudget(&entry);
+    return inserting;
+}
+
+bool CBoundedAssetCache::removeObject(const SAssetBundle& _obj, const std::string& _key)
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    auto found = find(_key,_obj);
+    if (found==m_index.end())
+        return false;
+
+    unlink(found,true);
+    return true;
+}
+
+bool CBoundedAssetCache::findAndStoreRange(const std::string& _key, size_t& _inOutStorageSize, MutablePairType* _out) const
+{
+    return findAndStoreRange_impl(_key,_inOutStorageSize,_out);
+}
+
+bool CBoundedAssetCache::findAndStoreRange(const std::string& _key, size_t& _inOutStorageSize, SAssetBundle* _out) const
+{
+    return findAndStoreRange_impl(_key,_inOutStorageSize,_out);
+}
+
+template<typename StorageT>
+bool CBoundedAssetCache::findAndStoreRange_impl(const std::string& _key, size_t& _inOutStorageSize, StorageT* _out) const
+{
+    const uint64_t keyHash = hashKey(_key);
+
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    const auto rng = m_index.equal_range(keyHash);
+    size_t reqSize = 0u;
+    for (auto it=rng.first; it!=rng.second; it++)
+    if (it->second->key==_key)
+        reqSize++;
+
+    if (!_out)
+    {
+        _inOutStorageSize = reqSize;
+        return false;
+    }
+
+    size_t i = 0u;
+    for (auto it=rng.first; it!=rng.second && i<_inOutStorageSize; it++)
+    {
+        const entry_iterator_t entry = it->second;
+        if (entry->key!=_key)
+            continue;
+
+        IRR_PSEUDO_IF_CONSTEXPR_BEGIN(std::is_same<StorageT,MutablePairType>::value)
+        {
+            _out[i++] = MutablePairType(entry->key,entry->bundle);
+        }
+        IRR_PSEUDO_ELSE_CONSTEXPR
+        {
+            _out[i++] = entry->bundle;
+        }
+        IRR_PSEUDO_IF_CONSTEXPR_END
+        // mark as most recently used, splicing within the same list keeps all iterators valid
+        if (!entry->isDummy)
+            m_lru.splice(m_lru.begin(),m_lru,entry);
+    }
+    const bool res = _inOutStorageSize<=reqSize;
+    _inOutStorageSize = i;
+    return res;
+}
+
+bool CBoundedAssetCache::outputAll(size_t& _inOutStorageSize, MutablePairType* _out) const
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    const size_t reqSize = m_index.size();
+    if (!_out)
+    {
+        _inOutStorageSize = reqSize;
+        return false;
+    }
+
+    size_t i = 0u;
+    const entry_list_t* lists[] = {&m_lru,&m_dummies};
+    for (const entry_list_t* list : lists)
+    for (auto it=list->begin(); it!=list->end() && i<_inOutStorageSize; it++)
+        _out[i++] = MutablePairType(it->key,it->bundle);
+    const bool res = _inOutStorageSize<=reqSize;
+    _inOutStorageSize = i;
+    return res;
+}
+
+bool CBoundedAssetCache::changeObjectKey(const SAssetBundle& _obj, const std::string& _key, const std::string& _newKey)
+{
+    const uint64_t newKeyHash = hashKey(_newKey);
+
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    auto found = find(_key,_obj);
+    if (found==m_index.end())
+        return false;
+
+    const entry_iterator_t entry = found->second;
+    m_index.erase(found);
+    entry->key = _newKey;
+    entry->keyHash = newKeyHash;
+    m_index.emplace(newKeyHash,entry);
+    return true;
+}
+
+
+CBoundedAssetCache::index_t::iterator CBoundedAssetCache::find(const std::string& _key, const SAssetBundle& _obj)
+{
+    auto rng = m_index.equal_range(hashKey(_key));
+    for (auto it=rng.first; it!=rng.second; it++)
+    if (it->second->key==_key && it->second->bundle==_obj)
+        return it;
+    return m_index.end();
+}
+
+CBoundedAssetCache::SEntry& CBoundedAssetCache::link(const std::string& _key, const SAssetBundle& _val)
+{
+    const size_t byteSize = estimateSize(_val);
+    // bundles which are already dummies never get evicted, so there's no point putting them on the LRU list
+    bool isDummy = false;
+    auto contents = _val.getContents();
+    for (auto it=contents.first; it!=contents.second; it++)
+    {
+        if (!*it) // like in estimateSize, null entries hold no memory and don't decide anything
+            continue;
+        if (!(*it)->isADummyObjectForCache())
+        {
+            isDummy = false;
+            break;
+        }
+        isDummy = true;
+    }
+
+    entry_list_t& list = isDummy ? m_dummies:m_lru;
+    list.push_front(SEntry{_key,_val,hashKey(_key),isDummy ? 0u:byteSize,isDummy});
+    m_index.emplace(list.front().keyHash,list.begin());
+    m_byteSize += list.front().byteSize;
+    return list.front();
+}
+
+void CBoundedAssetCache::unlink(index_t::iterator _indexIt, bool _dispose)
+{
+    const entry_iterator_t entry = _indexIt->second;
+    m_index.erase(_indexIt);
+
+    if (_dispose && m_disposalFunc)
+        m_disposalFunc(entry->bundle);
+    m_byteSize -= entry->byteSize;
+    if (entry->isDummy)
+        m_dummies.erase(entry);
+    else
+        m_lru.erase(entry);
+}
+
+void CBoundedAssetCache::evictOverBudget(const SEntry* _keep)
+{
+    while (m_byteSize>m_byteBudget && !m_lru.empty())
+    {
+        const entry_iterator_t victim = std::prev(m_lru.end());
+        if (&(*victim)==_keep)
+            break;
+
+        if (m_policy==EEP_CONVERT_TO_DUMMY && m_dummyConversionFunc)
+        {
+            m_dummyConversionFunc(victim->bundle);
+            m_byteSize -= victim->byteSize;
+            victim->byteSize = 0u;
+            victim->isDummy = true;
+            m_dummies.splice(m_dummies.begin(),m_lru,victim);
+            continue;
+        }
+
+        auto rng = m_index.equal_range(victim->keyHash);
+        auto indexIt = std::find_if(rng.first,rng.second,[victim](const index_t::value_type& _e) {return _e.second==victim;});
+        _IRR_DEBUG_BREAK_IF(indexIt==rng.second);
+        unlink(indexIt,true);
+    }
+}
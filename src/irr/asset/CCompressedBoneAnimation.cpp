@@ -0,0 +1,447 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "irr/asset/CCompressedBoneAnimation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irr
+{
+namespace asset
+{
+
+namespace impl
+{
+    //! the three smallest components of a unit quaternion lie in [-sqrt(1/2),sqrt(1/2)]
+    _IRR_STATIC_INLINE_CONSTEXPR float SmallestThreeRange = 0.707106781f;
+    _IRR_STATIC_INLINE_CONSTEXPR float SmallestThreeMax = 32767.f;
+    _IRR_STATIC_INLINE_CONSTEXPR float RangedMax = 65535.f;
+    //! longest run of keys a single interpolated segment may replace, bounds the cost of the reduction
+    _IRR_STATIC_INLINE_CONSTEXPR size_t MaxSegmentLength = 256u;
+
+    //! 15 bits per component, bit 15 of the first two words holds the index of the dropped largest component
+    static void encodeRotation(const float* _unnormalized, uint16_t* _out)
+    {
+        // the decoder rebuilds the dropped component of a unit quaternion, keys normalized with an approximate rsqrt would tilt it
+        float _rotation[4];
+        const float invLength = 1.f/std::sqrt(_unnormalized[0]*_unnormalized[0]+_unnormalized[1]*_unnormalized[1]+_unnormalized[2]*_unnormalized[2]+_unnormalized[3]*_unnormalized[3]);
+        for (uint32_t i=0u; i<4u; i++)
+            _rotation[i] = _unnormalized[i]*invLength;
+
+        uint32_t largest = 0u;
+        for (uint32_t i=1u; i<4u; i++)
+        if (std::abs(_rotation[i])>std::abs(_rotation[largest]))
+            largest = i;
+        // q and -q are the same rotation, the dropped component is always positive
+        const float sign = _rotation[largest]<0.f ? -1.f:1.f;
+
+        for (uint32_t i=0u, j=0u; i<4u; i++)
+        {
+            if (i==largest)
+                continue;
+            const float normalized = (_rotation[i]*sign+SmallestThreeRange)*(0.5f/SmallestThreeRange);
+            _out[j++] = uint16_t(core::clamp<float>(std::round(normalized*SmallestThreeMax),0.f,SmallestThreeMax));
+        }
+        _out[0] |= uint16_t((largest&1u)<<15u);
+        _out[1] |= uint16_t((largest>>1u)<<15u);
+    }
+
+    //! reads 4 words, the last one belongs to the next key (or the padding) and gets ignored
+    static inline __m128 decodeRotation(const uint16_t* _in)
+    {
+        const __m128i raw = _mm_and_si128(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(_in))),_mm_setr_epi32(0x7fff,0x7fff,0x7fff,0));
+        const __m128 xyz = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(raw),_mm_set1_ps(2.f*SmallestThreeRange/SmallestThreeMax)),_mm_setr_ps(SmallestThreeRange,SmallestThreeRange,SmallestThreeRange,0.f));
+        const __m128 w = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.f),_mm_dp_ps(xyz,xyz,0x7f)),_mm_setzero_ps()));
+        switch ((_in[0]>>15u)|((_in[1]>>15u)<<1u))
+        {
+            case 0u:
+                return _mm_blend_ps(_mm_shuffle_ps(xyz,xyz,_MM_SHUFFLE(2,1,0,0)),w,0x1);
+            case 1u:
+                return _mm_blend_ps(_mm_shuffle_ps(xyz,xyz,_MM_SHUFFLE(2,1,0,0)),w,0x2);
+            case 2u:
+                return _mm_blend_ps(_mm_shuffle_ps(xyz,xyz,_MM_SHUFFLE(2,1,1,0)),w,0x4);
+            default:
+                return _mm_blend_ps(xyz,w,0x8);
+        }
+    }
+
+    static inline __m128 decodeRanged(const uint16_t* _in, const float* _base, const float* _step)
+    {
+        const __m128 raw = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(_in))));
+        return _mm_add_ps(_mm_loadu_ps(_base),_mm_mul_ps(raw,_mm_setr_ps(_step[0],_step[1],_step[2],0.f)));
+    }
+
+    //! same approximate slerp as CFinalBoneHierarchy::getMatrixFromKeys
+    static inline __m128 interpolateRotation(__m128 _a, __m128 _b, float _interpolant)
+    {
+        const __m128 dot = _mm_dp_ps(_a,_b,0xff);
+        const float angle = _mm_cvtss_f32(dot);
+        float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
+        core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,_interpolant);
+        const float adjusted = core::quaternion::flerp_adjustedinterpolant(std::abs(angle),_interpolant,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+
+        // flip the sign bit of `_b` if the keys are on opposite sides of the double cover
+        _b = _mm_xor_ps(_b,_mm_and_ps(_mm_cmplt_ps(dot,_mm_setzero_ps()),_mm_set1_ps(-0.f)));
+        const __m128 mixed = _mm_add_ps(_a,_mm_mul_ps(_mm_sub_ps(_b,_a),_mm_set1_ps(adjusted)));
+        return _mm_div_ps(mixed,_mm_sqrt_ps(_mm_dp_ps(mixed,mixed,0xff)));
+    }
+
+    static inline __m128 interpolateRanged(__m128 _a, __m128 _b, float _interpolant)
+    {
+        return _mm_add_ps(_a,_mm_mul_ps(_mm_sub_ps(_b,_a),_mm_set1_ps(_interpolant)));
+    }
+
+    //! Decoded values and tolerances of one channel while compressing
+    struct SChannelCompressor
+    {
+        uint32_t channel;
+        float tolerance;
+        //! `tolerance` turned into the quantity `withinTolerance` compares
+        float threshold;
+
+        SChannelCompressor(uint32_t _channel, const CCompressedBoneAnimation::SCompressionParams& _params) : channel(_channel)
+        {
+            switch (channel)
+            {
+                case 0u:
+                    // the angle between rotations is twice the angle between the quaternions, compared as the squared chord
+                    // between them because the cosine of a tolerance this small is indistinguishable from 1 in float
+                    tolerance = _params.rotationTolerance;
+                    threshold = 4.f*std::sin(tolerance*0.25f)*std::sin(tolerance*0.25f);
+                    break;
+                case 1u:
+                    tolerance = _params.positionTolerance;
+                    threshold = tolerance*tolerance;
+                    break;
+                default:
+                    tolerance = _params.scaleTolerance;
+                    threshold = tolerance;
+                    break;
+            }
+        }
+
+        inline __m128 load(const SBoneAnimationKey& _key) const
+        {
+            switch (channel)
+            {
+                case 0u:
+                    return _mm_loadu_ps(_key.Rotation);
+                case 1u:
+                    return _mm_setr_ps(_key.Position[0],_key.Position[1],_key.Position[2],0.f);
+                default:
+                    return _mm_setr_ps(_key.Scale[0],_key.Scale[1],_key.Scale[2],0.f);
+            }
+        }
+
+        inline bool withinTolerance(__m128 _decoded, __m128 _original) const
+        {
+            switch (channel)
+            {
+                case 0u:
+                {
+                    // q and -q are the same rotation
+                    const __m128 flip = _mm_and_ps(_mm_cmplt_ps(_mm_dp_ps(_decoded,_original,0xff),_mm_setzero_ps()),_mm_set1_ps(-0.f));
+                    const __m128 diff = _mm_sub_ps(_mm_xor_ps(_decoded,flip),_original);
+                    return _mm_cvtss_f32(_mm_dp_ps(diff,diff,0xff))<=threshold;
+                }
+                case 1u:
+                {
+                    const __m128 diff = _mm_sub_ps(_decoded,_original);
+                    return _mm_cvtss_f32(_mm_dp_ps(diff,diff,0x7f))<=threshold;
+                }
+                default:
+                {
+                    const __m128 diff = _mm_andnot_ps(_mm_set1_ps(-0.f),_mm_sub_ps(_decoded,_original));
+                    return (_mm_movemask_ps(_mm_cmpgt_ps(diff,_mm_set1_ps(threshold)))&0x7)==0;
+                }
+            }
+        }
+
+        inline __m128 interpolate(__m128 _a, __m128 _b, float _interpolant) const
+        {
+            return channel ? interpolateRanged(_a,_b,_interpolant):interpolateRotation(_a,_b,_interpolant);
+        }
+    };
+
+    //! Compressed tracks of a single bone, stitched together with the other bones afterwards
+    struct SBoneTracks
+    {
+        //! track descriptors with `firstKey` relative to this bone
+        float base[2][3][4];
+        float step[2][3][3];
+        uint32_t firstKey[2][3];
+        uint32_t keyCount[2][3];
+        core::vector<uint32_t> keyIndices;
+        core::vector<uint16_t> keyData;
+    };
+
+    static void compressTrack(SBoneTracks& _out, uint32_t _flavour, const SChannelCompressor& _channel, const SBoneAnimationKey* _keys, size_t _keyframeCount, const float* _keyframes)
+    {
+        const uint32_t c = _channel.channel;
+        _out.firstKey[_flavour][c] = _out.keyIndices.size();
+        _out.keyCount[_flavour][c] = 0u;
+        for (uint32_t i=0u; i<4u; i++)
+            _out.base[_flavour][c][i] = 0.f;
+        for (uint32_t i=0u; i<3u; i++)
+            _out.step[_flavour][c][i] = 0.f;
+
+        core::vector<core::vectorSIMDf> original(_keyframeCount);
+        for (size_t i=0u; i<_keyframeCount; i++)
+            original[i] = _channel.load(_keys[i]);
+
+        bool constant = true;
+        for (size_t i=1u; constant&&i<_keyframeCount; i++)
+            constant = _channel.withinTolerance(original[0].getAsRegister(),original[i].getAsRegister());
+        if (constant)
+        {
+            _mm_storeu_ps(_out.base[_flavour][c],original[0].getAsRegister());
+            return;
+        }
+
+        // quantize every key, the reduction measures the error of the dequantized keys
+        core::vector<uint16_t> quantized(_keyframeCount*3u+1u,0u);
+        core::vector<core::vectorSIMDf> decoded(_keyframeCount);
+        if (c==0u)
+        {
+            for (size_t i=0u; i<_keyframeCount; i++)
+            {
+                alignas(16) float rotation[4];
+                _mm_store_ps(rotation,original[i].getAsRegister());
+                encodeRotation(rotation,quantized.data()+i*3u);
+                decoded[i] = decodeRotation(quantized.data()+i*3u);
+            }
+        }
+        else
+        {
+            __m128 minimum = original[0].getAsRegister(), maximum = original[0].getAsRegister();
+            for (size_t i=1u; i<_keyframeCount; i++)
+            {
+                minimum = _mm_min_ps(minimum,original[i].getAsRegister());
+                maximum = _mm_max_ps(maximum,original[i].getAsRegister());
+            }
+            alignas(16) float rangeMin[4],rangeMax[4];
+            _mm_store_ps(rangeMin,minimum);
+            _mm_store_ps(rangeMax,maximum);
+            float* base = _out.base[_flavour][c];
+            float* step = _out.step[_flavour][c];
+            for (uint32_t j=0u; j<3u; j++)
+            {
+                base[j] = rangeMin[j];
+                step[j] = (rangeMax[j]-rangeMin[j])/RangedMax;
+            }
+            for (size_t i=0u; i<_keyframeCount; i++)
+            {
+                alignas(16) float value[4];
+                _mm_store_ps(value,original[i].getAsRegister());
+                for (uint32_t j=0u; j<3u; j++)
+                    quantized[i*3u+j] = step[j]>0.f ? uint16_t(core::clamp<float>(std::round((value[j]-base[j])/step[j]),0.f,RangedMax)):0u;
+                decoded[i] = decodeRanged(quantized.data()+i*3u,base,step);
+            }
+        }
+
+        auto keep = [&](size_t _key) -> void
+        {
+            _out.keyIndices.push_back(_key);
+            for (uint32_t j=0u; j<3u; j++)
+                _out.keyData.push_back(quantized[_key*3u+j]);
+        };
+        keep(0u);
+        if (_flavour==0u)
+        {
+            // extend every segment for as long as it reproduces the keys it skips
+            for (size_t segmentBegin=0u; segmentBegin+1u<_keyframeCount; )
+            {
+                size_t segmentEnd = segmentBegin+1u;
+                for (size_t candidate=segmentEnd+1u; candidate<_keyframeCount&&candidate-segmentBegin<=MaxSegmentLength; candidate++)
+                {
+                    const float startTime = _keyframes[segmentBegin];
+                    const float invDuration = 1.f/(_keyframes[candidate]-startTime);
+                    bool reproduces = true;
+                    for (size_t i=segmentBegin+1u; reproduces&&i<candidate; i++)
+                        reproduces = _channel.withinTolerance(_channel.interpolate(decoded[segmentBegin].getAsRegister(),decoded[candidate].getAsRegister(),(_keyframes[i]-startTime)*invDuration),original[i].getAsRegister());
+                    if (!reproduces)
+                        break;
+                    segmentEnd = candidate;
+                }
+                keep(segmentEnd);
+                segmentBegin = segmentEnd;
+            }
+        }
+        else
+        {
+            // the key is held until the next kept one
+            size_t held = 0u;
+            for (size_t i=1u; i<_keyframeCount; i++)
+            if (!_channel.withinTolerance(decoded[held].getAsRegister(),original[i].getAsRegister()))
+            {
+                keep(i);
+                held = i;
+            }
+        }
+        _out.keyCount[_flavour][c] = _out.keyIndices.size()-_out.firstKey[_flavour][c];
+    }
+
+    static bool sameChannel(uint32_t _channel, const SBoneAnimationKey* _a, const SBoneAnimationKey* _b, size_t _keyframeCount)
+    {
+        for (size_t i=0u; i<_keyframeCount; i++)
+        {
+            const void* a = _channel==0u ? (const void*)_a[i].Rotation:(_channel==1u ? (const void*)_a[i].Position:(const void*)_a[i].Scale);
+            const void* b = _channel==0u ? (const void*)_b[i].Rotation:(_channel==1u ? (const void*)_b[i].Position:(const void*)_b[i].Scale);
+            if (memcmp(a,b,_channel==0u ? sizeof(float)*4u:sizeof(float)*3u))
+                return false;
+        }
+        return true;
+    }
+}
+
+
+CCompressedBoneAnimation::CCompressedBoneAnimation(size_t _boneCount, size_t _keyframeCount, const float* _keyframes,
+                                                   const SBoneAnimationKey* _interpolated, const SBoneAnimationKey* _nonInterpolated,
+                                                   const SCompressionParams& _params, core::CTaskScheduler* _scheduler)
+{
+    core::vector<impl::SBoneTracks> bones(_boneCount);
+    core::parallel_for<size_t>(0u,_boneCount,[&](size_t _bone)
+        {
+            impl::SBoneTracks& tracks = bones[_bone];
+            const SBoneAnimationKey* flavours[2] = {_interpolated+_bone*_keyframeCount,_nonInterpolated+_bone*_keyframeCount};
+            for (uint32_t c=0u; c<EC_COUNT; c++)
+            {
+                const impl::SChannelCompressor channel(c,_params);
+                impl::compressTrack(tracks,0u,channel,flavours[0],_keyframeCount,_keyframes);
+                if (impl::sameChannel(c,flavours[0],flavours[1],_keyframeCount))
+                {
+                    // the other flavour needs a different reduction, so only tracks which do not get reduced can be shared
+                    if (tracks.keyCount[0][c]==0u||tracks.keyCount[0][c]==_keyframeCount)
+                    {
+                        memcpy(tracks.base[1][c],tracks.base[0][c],sizeof(tracks.base[0][c]));
+                        memcpy(tracks.step[1][c],tracks.step[0][c],sizeof(tracks.step[0][c]));
+                        tracks.firstKey[1][c] = tracks.firstKey[0][c];
+                        tracks.keyCount[1][c] = tracks.keyCount[0][c];
+                        continue;
+                    }
+                }
+                impl::compressTrack(tracks,1u,channel,flavours[1],_keyframeCount,_keyframes);
+            }
+        },1u,_scheduler
+    );
+
+    size_t keyCount = 0u;
+    for (const impl::SBoneTracks& tracks : bones)
+        keyCount += tracks.keyIndices.size();
+
+    Data.resize(calcSize(_boneCount,keyCount),0u);
+    SHeader* header = reinterpret_cast<SHeader*>(Data.data());
+    header->boneCount = _boneCount;
+    header->keyCount = keyCount;
+
+    STrack* outTracks = reinterpret_cast<STrack*>(Data.data()+calcTracksOffset());
+    uint32_t* outIndices = reinterpret_cast<uint32_t*>(Data.data()+calcKeyIndicesOffset(_boneCount));
+    uint16_t* outData = reinterpret_cast<uint16_t*>(Data.data()+calcKeyDataOffset(_boneCount,keyCount));
+    size_t firstKey = 0u;
+    for (size_t bone=0u; bone<_boneCount; bone++)
+    {
+        const impl::SBoneTracks& tracks = bones[bone];
+        for (uint32_t flavour=0u; flavour<2u; flavour++)
+        for (uint32_t c=0u; c<EC_COUNT; c++)
+        {
+            STrack& track = outTracks[(flavour*_boneCount+bone)*EC_COUNT+c];
+            track.firstKey = firstKey+tracks.firstKey[flavour][c];
+            track.keyCount = tracks.keyCount[flavour][c];
+            memcpy(track.base,tracks.base[flavour][c],sizeof(track.base));
+            memcpy(track.step,tracks.step[flavour][c],sizeof(track.step));
+        }
+        memcpy(outIndices+firstKey,tracks.keyIndices.data(),sizeof(uint32_t)*tracks.keyIndices.size());
+        memcpy(outData+firstKey*3u,tracks.keyData.data(),sizeof(uint16_t)*tracks.keyData.size());
+        firstKey += tracks.keyIndices.size();
+    }
+}
+
+CCompressedBoneAnimation::CCompressedBoneAnimation(const void* _data, size_t _size)
+    : Data(reinterpret_cast<const uint8_t*>(_data),reinterpret_cast<const uint8_t*>(_data)+_size)
+{
+}
+
+size_t CCompressedBoneAnimation::getSerializedSize(const void* _data)
+{
+    const SHeader* header = reinterpret_cast<const SHeader*>(_data);
+    return calcSize(header->boneCount,header->keyCount);
+}
+
+bool CCompressedBoneAnimation::validate(const void* _data, size_t _size, size_t _boneCount, size_t _keyframeCount)
+{
+    if (_size<sizeof(SHeader))
+        return false;
+    const SHeader* header = reinterpret_cast<const SHeader*>(_data);
+    if (header->boneCount!=_boneCount || _size<calcSize(header->boneCount,header->keyCount))
+        return false;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(_data);
+    const STrack* tracks = reinterpret_cast<const STrack*>(data+calcTracksOffset());
+    const uint32_t* keyIndices = reinterpret_cast<const uint32_t*>(data+calcKeyIndicesOffset(header->boneCount));
+    for (size_t i=0u; i<2u*header->boneCount*EC_COUNT; i++)
+    {
+        if (tracks[i].firstKey>header->keyCount || tracks[i].keyCount>header->keyCount-tracks[i].firstKey)
+            return false;
+        // the samplers binary search the key indices
+        for (uint32_t k=0u; k<tracks[i].keyCount; k++)
+        if (keyIndices[tracks[i].firstKey+k]>=_keyframeCount || (k && keyIndices[tracks[i].firstKey+k]<=keyIndices[tracks[i].firstKey+k-1u]))
+            return false;
+    }
+    return true;
+}
+
+void CCompressedBoneAnimation::sample(SBoneAnimationKey* _out, size_t _boneBegin, size_t _boneEnd, const float* _keyframes, size_t _foundKeyIx, float _frame, bool _interpolate) const
+{
+    const STrack* tracks = getTracks(_interpolate);
+    const uint32_t* keyIndices = getKeyIndices();
+    const uint16_t* keyData = getKeyData();
+
+    for (size_t bone=_boneBegin; bone<_boneEnd; bone++)
+    {
+        __m128 channels[EC_COUNT];
+        for (uint32_t c=0u; c<EC_COUNT; c++)
+        {
+            const STrack& track = tracks[bone*EC_COUNT+c];
+            if (!track.keyCount)
+            {
+                channels[c] = _mm_loadu_ps(track.base);
+                continue;
+            }
+
+            auto decode = [&](const uint32_t* _key) -> __m128
+            {
+                const uint16_t* data = keyData+size_t(_key-keyIndices)*3u;
+                return c==EC_ROTATION ? impl::decodeRotation(data):impl::decodeRanged(data,track.base,track.step);
+            };
+            const uint32_t* first = keyIndices+track.firstKey;
+            const uint32_t* last = first+track.keyCount;
+            if (_interpolate)
+            {
+                const uint32_t* upper = std::lower_bound(first,last,uint32_t(_foundKeyIx));
+                if (upper==first || upper==last)
+                    channels[c] = decode(upper==first ? first:last-1);
+                else
+                {
+                    const uint32_t* lower = upper-1;
+                    const float startTime = _keyframes[*lower];
+                    const float interpolant = core::clamp<float>((_frame-startTime)/(_keyframes[*upper]-startTime),0.f,1.f);
+                    const __m128 a = decode(lower), b = decode(upper);
+                    channels[c] = c==EC_ROTATION ? impl::interpolateRotation(a,b,interpolant):impl::interpolateRanged(a,b,interpolant);
+                }
+            }
+            else
+                channels[c] = decode(std::upper_bound(first,last,uint32_t(_foundKeyIx))-1);
+        }
+
+        // Rotation, Position and Scale are contiguous, so the 48 bytes of a key are three stores
+        float* out = reinterpret_cast<float*>(_out+(bone-_boneBegin));
+        _mm_storeu_ps(out,channels[EC_ROTATION]);
+        _mm_storeu_ps(out+4,_mm_shuffle_ps(channels[EC_POSITION],_mm_shuffle_ps(channels[EC_POSITION],channels[EC_SCALE],_MM_SHUFFLE(0,0,2,2)),_MM_SHUFFLE(2,0,1,0)));
+        _mm_storeu_ps(out+8,_mm_and_ps(_mm_shuffle_ps(channels[EC_SCALE],channels[EC_SCALE],_MM_SHUFFLE(3,3,2,1)),_mm_castsi128_ps(_mm_setr_epi32(-1,-1,0,0))));
+    }
+}
+
+}
+}
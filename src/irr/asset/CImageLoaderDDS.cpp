@@ -96,6 +96,8 @@ static bool DDSGetInfo(CImageLoaderDDS::ddsBuffer *dds, int32_t *width, int32_t
 		*pf = CImageLoaderDDS::DDS_PF_DXT4;
 	else if( fourCC == *((uint32_t*) "DXT5") )
 		*pf = CImageLoaderDDS::DDS_PF_DXT5;
+	else if( fourCC == *((uint32_t*) "DX10") )
+		*pf = CImageLoaderDDS::DDS_PF_DX10;
 	else
 		return false;
 	
@@ -133,6 +135,19 @@ asset::SAssetBundle CImageLoaderDDS::loadAsset(io::IReadFile* _file, const asset
 
 	if (DDSGetInfo(&header, &width, &height, &depth, &pixelFormat))
 	{
+        asset::E_FORMAT dx10Format = asset::EF_UNKNOWN;
+        if (pixelFormat==DDS_PF_DX10)
+        {
+            ddsHeaderDXT10 dx10Header;
+            _file->read(&dx10Header, sizeof(dx10Header));
+            dx10Format = getFormatFromDXGI(dx10Header.dxgiFormat);
+            if (dx10Format==asset::EF_UNKNOWN || dx10Header.arraySize>1u)
+            {
+                os::Printer::log("Unsupported DX10 DDS texture, only single block compressed 2D textures can be loaded.", ELL_ERROR);
+                return {};
+            }
+        }
+
 	    if (header.flags & 0x20000)//DDSD_MIPMAPCOUNT)
             mipmapCnt = header.mipMapCount;
 	    else
@@ -151,6 +166,7 @@ asset::SAssetBundle CImageLoaderDDS::loadAsset(io::IReadFile* _file, const asset
                 case DDS_PF_DXT3:
                 case DDS_PF_DXT4:
                 case DDS_PF_DXT5:
+                case DDS_PF_DX10:
                     tmpWidth = width;
                     break;
                 default:
@@ -243,6 +259,15 @@ asset::SAssetBundle CImageLoaderDDS::loadAsset(io::IReadFile* _file, const asset
                     }
                     break;
 
+                case DDS_PF_DX10:
+                    {
+                        colorFormat = dx10Format;
+                        asset::CImageData* data = new asset::CImageData(NULL,zeroDummy,mipSize,i,colorFormat,1);
+                        _file->read(data->getData(),data->getImageDataSizeInBytes());
+                        images.push_back(data);
+                    }
+                    break;
+
                 default:
 					{
 						os::Printer::log("Unsupported DDS texture format, 16bit uncompressed is not an option here.", ELL_ERROR);
@@ -7,7 +7,7 @@
 
 #include "IrrCompileConfig.h"
 
-#if defined(_IRR_COMPILE_WITH_DDS_LOADER_)
+#if defined(_IRR_COMPILE_WITH_DDS_LOADER_) || defined(_IRR_COMPILE_WITH_DDS_WRITER_)
 
 #include "irr/asset/IAssetLoader.h"
 
@@ -38,6 +38,8 @@ public:
         DDS_PF_DXT3,
         DDS_PF_DXT4,
         DDS_PF_DXT5,
+        //! format is given by the DXGI_FORMAT in the ddsHeaderDXT10 following the header
+        DDS_PF_DX10,
         DDS_PF_UNKNOWN
     };
 
@@ -160,6 +162,16 @@ public:
         uint8_t		data[4];
     } PACK_STRUCT;
 
+    //! Extended header present when the pixel format fourCC is "DX10"
+    struct ddsHeaderDXT10
+    {
+        uint32_t		dxgiFormat;
+        uint32_t		resourceDimension;
+        uint32_t		miscFlag;
+        uint32_t		arraySize;
+        uint32_t		miscFlags2;
+    } PACK_STRUCT;
+
 
 #include "irr/irrunpack.h"
 
@@ -171,6 +183,66 @@ public:
     } floatSwapUnion;
 	
 public:
+    //! DXGI_FORMAT values of the block compressed formats, the rest is not supported in DX10 headers
+    enum E_DXGI_FORMAT : uint32_t
+    {
+        EDF_BC1_UNORM = 71u,
+        EDF_BC1_UNORM_SRGB = 72u,
+        EDF_BC2_UNORM = 74u,
+        EDF_BC2_UNORM_SRGB = 75u,
+        EDF_BC3_UNORM = 77u,
+        EDF_BC3_UNORM_SRGB = 78u,
+        EDF_BC4_UNORM = 80u,
+        EDF_BC4_SNORM = 81u,
+        EDF_BC5_UNORM = 83u,
+        EDF_BC5_SNORM = 84u,
+        EDF_BC7_UNORM = 98u,
+        EDF_BC7_UNORM_SRGB = 99u,
+        EDF_UNKNOWN = 0u
+    };
+
+    static inline asset::E_FORMAT getFormatFromDXGI(uint32_t _dxgiFormat)
+    {
+        switch (_dxgiFormat)
+        {
+            case EDF_BC1_UNORM: return asset::EF_BC1_RGBA_UNORM_BLOCK;
+            case EDF_BC1_UNORM_SRGB: return asset::EF_BC1_RGBA_SRGB_BLOCK;
+            case EDF_BC2_UNORM: return asset::EF_BC2_UNORM_BLOCK;
+            case EDF_BC2_UNORM_SRGB: return asset::EF_BC2_SRGB_BLOCK;
+            case EDF_BC3_UNORM: return asset::EF_BC3_UNORM_BLOCK;
+            case EDF_BC3_UNORM_SRGB: return asset::EF_BC3_SRGB_BLOCK;
+            case EDF_BC4_UNORM: return asset::EF_BC4_UNORM_BLOCK;
+            case EDF_BC4_SNORM: return asset::EF_BC4_SNORM_BLOCK;
+            case EDF_BC5_UNORM: return asset::EF_BC5_UNORM_BLOCK;
+            case EDF_BC5_SNORM: return asset::EF_BC5_SNORM_BLOCK;
+            case EDF_BC7_UNORM: return asset::EF_BC7_UNORM_BLOCK;
+            case EDF_BC7_UNORM_SRGB: return asset::EF_BC7_SRGB_BLOCK;
+            default: return asset::EF_UNKNOWN;
+        }
+    }
+
+    static inline E_DXGI_FORMAT getDXGIFromFormat(asset::E_FORMAT _fmt)
+    {
+        switch (_fmt)
+        {
+            case asset::EF_BC1_RGB_UNORM_BLOCK:
+            case asset::EF_BC1_RGBA_UNORM_BLOCK: return EDF_BC1_UNORM;
+            case asset::EF_BC1_RGB_SRGB_BLOCK:
+            case asset::EF_BC1_RGBA_SRGB_BLOCK: return EDF_BC1_UNORM_SRGB;
+            case asset::EF_BC2_UNORM_BLOCK: return EDF_BC2_UNORM;
+            case asset::EF_BC2_SRGB_BLOCK: return EDF_BC2_UNORM_SRGB;
+            case asset::EF_BC3_UNORM_BLOCK: return EDF_BC3_UNORM;
+            case asset::EF_BC3_SRGB_BLOCK: return EDF_BC3_UNORM_SRGB;
+            case asset::EF_BC4_UNORM_BLOCK: return EDF_BC4_UNORM;
+            case asset::EF_BC4_SNORM_BLOCK: return EDF_BC4_SNORM;
+            case asset::EF_BC5_UNORM_BLOCK: return EDF_BC5_UNORM;
+            case asset::EF_BC5_SNORM_BLOCK: return EDF_BC5_SNORM;
+            case asset::EF_BC7_UNORM_BLOCK: return EDF_BC7_UNORM;
+            case asset::EF_BC7_SRGB_BLOCK: return EDF_BC7_UNORM_SRGB;
+            default: return EDF_UNKNOWN;
+        }
+    }
+
     virtual bool isALoadableFileFormat(io::IReadFile* _file) const override;
 
     virtual const char** getAssociatedFileExtensions() const override
@@ -188,6 +260,6 @@ public:
 } // end namespace video
 } // end namespace irr
 
-#endif // _IRR_COMPILE_WITH_DDS_LOADER_
+#endif // _IRR_COMPILE_WITH_DDS_LOADER_ || _IRR_COMPILE_WITH_DDS_WRITER_
 #endif
 
@@ -0,0 +1,162 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "CImageWriterDDS.h"
+
+#ifdef _IRR_COMPILE_WITH_DDS_WRITER_
+
+#include "CImageLoaderDDS.h"
+#include "IWriteFile.h"
+#include "irr/asset/ICPUTexture.h"
+
+#include "os.h"
+
+namespace irr
+{
+namespace asset
+{
+
+CImageWriterDDS::CImageWriterDDS()
+{
+#ifdef _IRR_DEBUG
+	setDebugName("CImageWriterDDS");
+#endif
+}
+
+asset::E_FORMAT CImageWriterDDS::pickDefaultFormat(asset::E_FORMAT _fmt)
+{
+    const bool srgb = isSRGBFormat(_fmt);
+    switch (getFormatChannelCount(_fmt))
+    {
+        case 1u:
+            return EF_BC4_UNORM_BLOCK;
+        case 2u:
+            return EF_BC5_UNORM_BLOCK;
+        case 3u:
+            return srgb ? EF_BC1_RGB_SRGB_BLOCK:EF_BC1_RGB_UNORM_BLOCK;
+        default:
+            return srgb ? EF_BC3_SRGB_BLOCK:EF_BC3_UNORM_BLOCK;
+    }
+}
+
+bool CImageWriterDDS::writeAsset(io::IWriteFile* _file, const SAssetWriteParams& _params, IAssetWriterOverride* _override)
+{
+    IAssetWriterOverride defaultOverride;
+    if (!_override)
+        _override = &defaultOverride;
+
+    SAssetWriteContext ctx{_params, _file};
+
+    // gather a complete mip chain made of whole levels
+    core::vector<const CImageData*> levels;
+    if (_params.rootAsset->getAssetType()==IAsset::ET_IMAGE)
+    {
+        const ICPUTexture* texture = static_cast<const ICPUTexture*>(_params.rootAsset);
+        if (texture->getType()!=video::ITexture::ETT_2D)
+        {
+            os::Printer::log("DDS writer only supports 2D textures.", ELL_ERROR);
+            return false;
+        }
+        for (uint32_t mip=0u; mip<=texture->getHighestMip(); mip++)
+        {
+            const auto range = texture->getMipMap(mip);
+            if (range.first==range.second || std::next(range.first)!=range.second || (*range.first)->getSupposedMipLevel()!=mip)
+                break;
+            levels.push_back(*range.first);
+        }
+    }
+    else
+        levels.push_back(static_cast<const CImageData*>(_params.rootAsset));
+
+    if (levels.empty() || levels.front()->getSliceMin()[0]!=0u || levels.front()->getSliceMin()[1]!=0u)
+    {
+        os::Printer::log("DDS writer needs a base level starting at the origin.", ELL_ERROR);
+        return false;
+    }
+
+    const SWriteProperties* props = reinterpret_cast<const SWriteProperties*>(_params.userData);
+    const E_FORMAT srcFmt = levels.front()->getColorFormat();
+
+    core::vector<core::smart_refctd_ptr<CImageData> > generated;
+    if (props && props->generateMipMaps && levels.size()==1u && CMipMapGenerator::isSupportedFormat(srcFmt))
+    {
+        for (CImageData* level : CMipMapGenerator::generateMipChain(levels.front(),props->mipMapKernel))
+        {
+            generated.push_back(core::smart_refctd_ptr<CImageData>(level,core::dont_grab));
+            levels.push_back(level);
+        }
+    }
+    E_FORMAT format = props ? props->format:EF_UNKNOWN;
+    if (format==EF_UNKNOWN)
+        format = CImageLoaderDDS::getDXGIFromFormat(srcFmt)!=CImageLoaderDDS::EDF_UNKNOWN ? srcFmt:pickDefaultFormat(srcFmt);
+
+    const CImageLoaderDDS::E_DXGI_FORMAT dxgiFormat = CImageLoaderDDS::getDXGIFromFormat(format);
+    if (dxgiFormat==CImageLoaderDDS::EDF_UNKNOWN)
+    {
+        os::Printer::log("DDS writer can only write block compressed formats.", ELL_ERROR);
+        return false;
+    }
+
+    const CBlockCompressor::E_QUALITY quality = props&&props->overrideQuality ? props->quality:
+        CBlockCompressor::qualityFromCompressionLevel(_override->getAssetCompressionLevel(ctx, _params.rootAsset, 0u));
+
+    core::vector<core::smart_refctd_ptr<CImageData> > compressed;
+    for (auto& level : levels)
+    {
+        if (level->getColorFormat()==format)
+            continue;
+
+        CImageData* image = CBlockCompressor::compress(level, format, quality);
+        if (!image)
+        {
+            os::Printer::log("DDS writer could not block compress the image, it is either block compressed in another format already or planar.", ELL_ERROR);
+            return false;
+        }
+        compressed.push_back(core::smart_refctd_ptr<CImageData>(image, core::dont_grab));
+        level = image;
+    }
+
+    const core::vector3d<uint32_t> size = levels.front()->getSize();
+
+    CImageLoaderDDS::ddsBuffer header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "DDS ", 4u);
+    header.size = 124u;
+    header.flags = 0x1u|0x2u|0x4u|0x1000u|0x80000u; // DDSD_CAPS|DDSD_HEIGHT|DDSD_WIDTH|DDSD_PIXELFORMAT|DDSD_LINEARSIZE
+    if (levels.size()>1u)
+        header.flags |= 0x20000u; // DDSD_MIPMAPCOUNT
+    header.height = size.Y;
+    header.width = size.X;
+    header.linearSize = levels.front()->getImageDataSizeInBytes();
+    header.mipMapCount = levels.size();
+    header.pixelFormat.size = 32u;
+    header.pixelFormat.flags = 0x4u; // DDPF_FOURCC
+    memcpy(&header.pixelFormat.fourCC, "DX10", 4u);
+    header.caps.caps1 = 0x1000u; // DDSCAPS_TEXTURE
+    if (levels.size()>1u)
+        header.caps.caps1 |= 0x400008u; // DDSCAPS_MIPMAP|DDSCAPS_COMPLEX
+
+    CImageLoaderDDS::ddsHeaderDXT10 dx10Header;
+    dx10Header.dxgiFormat = dxgiFormat;
+    dx10Header.resourceDimension = 3u; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    dx10Header.miscFlag = 0u;
+    dx10Header.arraySize = 1u;
+    dx10Header.miscFlags2 = 0u;
+
+    io::IWriteFile* file = _override->getOutputFile(_file, ctx, {_params.rootAsset, 0u});
+    bool success = file->write(&header, sizeof(header)-4u)==int32_t(sizeof(header)-4u);
+    success = success && file->write(&dx10Header, sizeof(dx10Header))==int32_t(sizeof(dx10Header));
+    for (const CImageData* level : levels)
+    {
+        const size_t levelSize = level->getImageDataSizeInBytes();
+        success = success && file->write(level->getData(), levelSize)==int32_t(levelSize);
+    }
+
+    return success;
+}
+
+} // namespace asset
+} // namespace irr
+
+#endif // _IRR_COMPILE_WITH_DDS_WRITER_
@@ -0,0 +1,65 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __C_IMAGE_WRITER_DDS_H_INCLUDED__
+#define __C_IMAGE_WRITER_DDS_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_DDS_WRITER_
+
+#include "irr/asset/IAssetWriter.h"
+#include "irr/asset/CBlockCompressor.h"
+#include "irr/asset/CMipMapGenerator.h"
+
+namespace irr
+{
+namespace asset
+{
+
+//! Writes images and textures as block compressed DDS files with a DX10 header
+/** Images which are not block compressed yet are compressed with CBlockCompressor on the way out,
+this is the way to bake compressed textures offline. */
+class CImageWriterDDS : public asset::IAssetWriter
+{
+public:
+    //! Pass as SAssetWriteParams::userData to pick the output format and quality
+    struct SWriteProperties
+    {
+        //! EF_UNKNOWN keeps block compressed sources as they are and picks a format with pickDefaultFormat otherwise
+        asset::E_FORMAT format = asset::EF_UNKNOWN;
+        //! Used instead of the writer's compression level if set
+        CBlockCompressor::E_QUALITY quality = CBlockCompressor::EQ_NORMAL;
+        bool overrideQuality = false;
+        //! Builds the rest of the mip chain if the source only has a single level
+        bool generateMipMaps = false;
+        CMipMapGenerator::E_KERNEL mipMapKernel = CMipMapGenerator::EK_KAISER;
+    };
+
+	//! constructor
+	CImageWriterDDS();
+
+    virtual const char** getAssociatedFileExtensions() const override
+    {
+        static const char* ext[]{ "dds", nullptr };
+        return ext;
+    }
+
+    virtual uint64_t getSupportedAssetTypesBitfield() const override { return asset::IAsset::ET_SUB_IMAGE|asset::IAsset::ET_IMAGE; }
+
+    virtual uint32_t getSupportedFlags() override { return 0u; }
+
+    virtual uint32_t getForcedFlags() override { return asset::EWF_BINARY|asset::EWF_COMPRESSED; }
+
+    virtual bool writeAsset(io::IWriteFile* _file, const SAssetWriteParams& _params, IAssetWriterOverride* _override = nullptr) override;
+
+    //! Block compressed format a source of format `_fmt` gets written as when SWriteProperties::format is EF_UNKNOWN
+    static asset::E_FORMAT pickDefaultFormat(asset::E_FORMAT _fmt);
+};
+
+} // namespace asset
+} // namespace irr
+
+#endif // _IRR_COMPILE_WITH_DDS_WRITER_
+#endif
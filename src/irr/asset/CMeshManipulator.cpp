@@ -17,6 +17,8 @@
 #include "irr/asset/CSmoothNormalGenerator.h"
 #include "irr/asset/CForsythVertexCacheOptimizer.h"
 #include "irr/asset/COverdrawMeshOptimizer.h"
+#include "irr/asset/CQuadricMeshSimplifier.h"
+#include "irr/asset/CMeshletBuilder.h"
 
 namespace irr
 {
@@ -893,6 +895,260 @@ core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferDuplica
 	return dst;
 }
 
+// Used by prepareForSimplification only, like cmpVertices but skips the position and per instance attributes
+static bool cmpVertexAttributes(const ICPUMeshBuffer* _inbuf, size_t _a, size_t _b, const IMeshManipulator::SErrorMetric* _errMetrics)
+{
+    auto desc = _inbuf->getMeshDataAndFormat();
+    for (size_t i = 0u; i < EVAI_COUNT; ++i)
+    {
+        const E_VERTEX_ATTRIBUTE_ID attrId = (E_VERTEX_ATTRIBUTE_ID)i;
+        if (attrId == _inbuf->getPositionAttributeIx() || !desc->getMappedBuffer(attrId) || desc->getAttribDivisor(attrId))
+            continue;
+
+        const auto atype = desc->getAttribFormat(attrId);
+        const auto cpa = getFormatChannelCount(atype);
+
+        if (isIntegerFormat(atype) || isScaledFormat(atype))
+        {
+            uint32_t attr[8];
+            _inbuf->getAttribute(attr, attrId, _a);
+            _inbuf->getAttribute(attr+4, attrId, _b);
+            if (memcmp(attr, attr+4, cpa*4))
+                return false;
+        }
+        else
+        {
+            core::vectorSIMDf attr[2];
+            _inbuf->getAttribute(attr[0], attrId, _a);
+            _inbuf->getAttribute(attr[1], attrId, _b);
+            if (!IMeshManipulator::compareFloatingPointAttribute(attr[0], attr[1], cpa, _errMetrics[i]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool CMeshManipulator::prepareForSimplification(SSimplifierInput& _out, const ICPUMeshBuffer* _inbuffer, const SErrorMetric* _errMetrics)
+{
+    if (!_inbuffer || !_inbuffer->getMeshDataAndFormat() || _inbuffer->getPrimitiveType() != EPT_TRIANGLES)
+        return false;
+    const E_VERTEX_ATTRIBUTE_ID posAttrId = _inbuffer->getPositionAttributeIx();
+    if (!_inbuffer->getMeshDataAndFormat()->getMappedBuffer(posAttrId))
+        return false;
+
+    const size_t indexCount = _inbuffer->getIndexCount()/3u*3u;
+    _out.indices.resize(indexCount);
+    const void* indices = _inbuffer->getIndices();
+    switch (indices ? _inbuffer->getIndexType():EIT_UNKNOWN)
+    {
+        case EIT_16BIT:
+            std::copy(reinterpret_cast<const uint16_t*>(indices), reinterpret_cast<const uint16_t*>(indices)+indexCount, _out.indices.begin());
+            break;
+        case EIT_32BIT:
+            std::copy(reinterpret_cast<const uint32_t*>(indices), reinterpret_cast<const uint32_t*>(indices)+indexCount, _out.indices.begin());
+            break;
+        default:
+            std::iota(_out.indices.begin(), _out.indices.end(), 0u);
+            break;
+    }
+
+    const size_t vertexCount = indexCount ? (*std::max_element(_out.indices.begin(), _out.indices.end())+1u):0u;
+    _out.positions.resize(vertexCount);
+    core::vectorSIMDf minPos(FLT_MAX), maxPos(-FLT_MAX);
+    for (size_t i = 0u; i < vertexCount; ++i)
+    {
+        core::vectorSIMDf& pos = _out.positions[i];
+        pos = core::vectorSIMDf(0.f);
+        if (!_inbuffer->getAttribute(pos, posAttrId, i))
+            return false;
+        pos.w = 0.f;
+        minPos = core::min_(minPos, pos);
+        maxPos = core::max_(maxPos, pos);
+    }
+    const core::vectorSIMDf extent = maxPos-minPos;
+    const float scale = core::max_(core::max_(extent.x, extent.y), extent.z);
+    if (scale > 0.f)
+    {
+        for (auto& pos : _out.positions)
+            pos = (pos-minPos)/scale;
+    }
+
+    // vertices which only differ in position are attribute seams for the simplifier, so weld exact duplicates first
+    SErrorMetric defaultMetrics[EVAI_COUNT];
+    if (!_errMetrics)
+        _errMetrics = defaultMetrics;
+
+    auto samePosition = [&_out](uint32_t _a, uint32_t _b) {
+        const auto& a = _out.positions[_a];
+        const auto& b = _out.positions[_b];
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    };
+    core::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&_out](uint32_t _a, uint32_t _b) {
+        const auto& a = _out.positions[_a];
+        const auto& b = _out.positions[_b];
+        if (a.x != b.x)
+            return a.x < b.x;
+        if (a.y != b.y)
+            return a.y < b.y;
+        if (a.z != b.z)
+            return a.z < b.z;
+        return _a < _b;
+    });
+
+    core::vector<uint32_t> redirects(vertexCount);
+    for (size_t begin = 0u; begin < vertexCount; )
+    {
+        size_t end = begin+1u;
+        while (end < vertexCount && samePosition(order[begin], order[end]))
+            ++end;
+        // runs are sorted by index, so the lowest vertex of every distinct set of attributes is what the others get welded to
+        for (size_t i = begin; i < end; ++i)
+        {
+            const uint32_t v = order[i];
+            redirects[v] = v;
+            for (size_t j = begin; j < i; ++j)
+            {
+                const uint32_t other = order[j];
+                if (redirects[other] == other && cmpVertexAttributes(_inbuffer, v, other, _errMetrics))
+                {
+                    redirects[v] = other;
+                    break;
+                }
+            }
+        }
+        begin = end;
+    }
+    for (auto& ix : _out.indices)
+        ix = redirects[ix];
+
+    return true;
+}
+
+core::smart_refctd_ptr<ICPUMeshBuffer> CMeshManipulator::createMeshBufferSharingVertices(const ICPUMeshBuffer* _src, const uint32_t* _indices, size_t _indexCount, core::smart_refctd_ptr<ICPUMeshBuffer>&& _dst)
+{
+	core::smart_refctd_ptr<ICPUMeshBuffer> dst = std::move(_dst);
+    if (dst)
+		copyMeshBufferMemberVars(dst.get(), _src);
+    else if (_src->getMeshBufferType() == asset::EMT_ANIMATED_SKINNED)
+    {
+        dst = core::make_smart_refctd_ptr<ICPUSkinnedMeshBuffer>();
+		copyMeshBufferMemberVars(static_cast<ICPUSkinnedMeshBuffer*>(dst.get()), static_cast<const ICPUSkinnedMeshBuffer*>(_src));
+    }
+    else
+    {
+        dst = core::make_smart_refctd_ptr<ICPUMeshBuffer>();
+		copyMeshBufferMemberVars(dst.get(), _src);
+    }
+
+	const uint32_t maxIndex = _indexCount ? *std::max_element(_indices, _indices+_indexCount):0u;
+	const E_INDEX_TYPE indexType = maxIndex >= 0x10000u ? EIT_32BIT:EIT_16BIT;
+	auto idxBuffer = core::make_smart_refctd_ptr<ICPUBuffer>((indexType == EIT_16BIT ? sizeof(uint16_t):sizeof(uint32_t))*_indexCount);
+	if (indexType == EIT_16BIT)
+		std::copy(_indices, _indices+_indexCount, reinterpret_cast<uint16_t*>(idxBuffer->getPointer()));
+	else
+		memcpy(idxBuffer->getPointer(), _indices, idxBuffer->getSize());
+
+    auto newDesc = core::make_smart_refctd_ptr<ICPUMeshDataFormatDesc>();
+	const IMeshDataFormatDesc<ICPUBuffer>* oldDesc = _src->getMeshDataAndFormat();
+	for (size_t i = 0; i < EVAI_COUNT; ++i)
+	{
+		const ICPUBuffer* oldBuf = oldDesc->getMappedBuffer((E_VERTEX_ATTRIBUTE_ID)i);
+		if (!oldBuf)
+			continue;
+
+		newDesc->setVertexAttrBuffer(core::smart_refctd_ptr<ICPUBuffer>(const_cast<ICPUBuffer*>(oldBuf)), (E_VERTEX_ATTRIBUTE_ID)i, oldDesc->getAttribFormat((E_VERTEX_ATTRIBUTE_ID)i),
+			oldDesc->getMappedBufferStride((E_VERTEX_ATTRIBUTE_ID)i), oldDesc->getMappedBufferOffset((E_VERTEX_ATTRIBUTE_ID)i), oldDesc->getAttribDivisor((E_VERTEX_ATTRIBUTE_ID)i));
+	}
+	newDesc->setIndexBuffer(std::move(idxBuffer));
+	dst->setMeshDataAndFormat(std::move(newDesc));
+
+	dst->setIndexBufferOffset(0);
+	dst->setIndexCount(_indexCount);
+	dst->setIndexType(indexType);
+
+	return dst;
+}
+
+core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferSimplified(const ICPUMeshBuffer* _inbuffer, const SSimplificationTarget& _target, const SErrorMetric* _errMetrics, float* _outError)
+{
+	auto levels = createLoDChain(_inbuffer, &_target, 1u, _errMetrics, _outError);
+	if (levels.empty())
+		return nullptr;
+	return std::move(levels.front());
+}
+
+core::vector<core::smart_refctd_ptr<ICPUMeshBuffer> > IMeshManipulator::createLoDChain(const ICPUMeshBuffer* _inbuffer, const SSimplificationTarget* _levels, uint32_t _levelCount, const SErrorMetric* _errMetrics, float* _outErrors)
+{
+	core::vector<core::smart_refctd_ptr<ICPUMeshBuffer> > lods;
+	CMeshManipulator::SSimplifierInput input;
+	if (!_levels || !CMeshManipulator::prepareForSimplification(input, _inbuffer, _errMetrics))
+		return lods;
+
+	const size_t originalTriangleCount = input.indices.size()/3u;
+	size_t indexCount = input.indices.size();
+	float error = 0.f;
+	for (uint32_t i = 0u; i < _levelCount; ++i)
+	{
+		const size_t targetIndexCount = size_t(double(originalTriangleCount)*core::max_(_levels[i].triangleRatio, 0.f))*3u;
+		// each level continues from the previous one, so it only gets what's left of its error budget
+		float levelError = 0.f;
+		if (indexCount > targetIndexCount && _levels[i].maxError > error)
+			indexCount = CQuadricMeshSimplifier::simplify(input.indices.data(), indexCount, input.positions.data(), input.positions.size(), targetIndexCount, _levels[i].maxError-error, &levelError);
+		error += levelError;
+		if (_outErrors)
+			_outErrors[i] = error;
+
+		lods.push_back(CMeshManipulator::createMeshBufferSharingVertices(_inbuffer, input.indices.data(), indexCount));
+	}
+
+	return lods;
+}
+
+core::smart_refctd_ptr<ICPUMeshletMeshBuffer> IMeshManipulator::createMeshletizedMeshBuffer(const ICPUMeshBuffer* _inbuffer, uint32_t _maxVertices, uint32_t _maxTriangles)
+{
+	if (!_inbuffer || !_inbuffer->getMeshDataAndFormat() || _inbuffer->getPrimitiveType() != EPT_TRIANGLES || _inbuffer->getMeshBufferType() != EMBT_NOT_ANIMATED)
+		return nullptr;
+	const E_VERTEX_ATTRIBUTE_ID posAttrId = _inbuffer->getPositionAttributeIx();
+	if (!_inbuffer->getMeshDataAndFormat()->getMappedBuffer(posAttrId))
+		return nullptr;
+
+	const size_t indexCount = _inbuffer->getIndexCount()/3u*3u;
+	core::vector<uint32_t> indices(indexCount);
+	const void* srcIndices = _inbuffer->getIndices();
+	switch (srcIndices ? _inbuffer->getIndexType():EIT_UNKNOWN)
+	{
+		case EIT_16BIT:
+			std::copy(reinterpret_cast<const uint16_t*>(srcIndices), reinterpret_cast<const uint16_t*>(srcIndices)+indexCount, indices.begin());
+			break;
+		case EIT_32BIT:
+			std::copy(reinterpret_cast<const uint32_t*>(srcIndices), reinterpret_cast<const uint32_t*>(srcIndices)+indexCount, indices.begin());
+			break;
+		default:
+			std::iota(indices.begin(), indices.end(), 0u);
+			break;
+	}
+
+	const size_t vertexCount = indexCount ? (*std::max_element(indices.begin(), indices.end())+1u):0u;
+	core::vector<core::vectorSIMDf> positions(vertexCount);
+	for (size_t i = 0u; i < vertexCount; ++i)
+	{
+		positions[i] = core::vectorSIMDf(0.f);
+		if (!_inbuffer->getAttribute(positions[i], posAttrId, i))
+			return nullptr;
+		positions[i].w = 0.f;
+	}
+
+	auto meshlets = CMeshletBuilder::build(indices.data(), indices.size(), positions.data(), positions.size(), core::max_(_maxVertices, 3u), core::max_(_maxTriangles, 1u));
+
+	auto dst = core::make_smart_refctd_ptr<ICPUMeshletMeshBuffer>();
+	CMeshManipulator::createMeshBufferSharingVertices(_inbuffer, indices.data(), indices.size(), core::smart_refctd_ptr<ICPUMeshBuffer>(dst));
+	dst->setMeshlets(std::move(meshlets));
+	return dst;
+}
+
 void IMeshManipulator::filterInvalidTriangles(ICPUMeshBuffer* _input)
 {
     if (!_input || !_input->getMeshDataAndFormat() || !_input->getIndices())
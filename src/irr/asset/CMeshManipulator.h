@@ -49,6 +49,20 @@ class CMeshManipulator : public IMeshManipulator
 		template<typename IdxT>
 		static void _filterInvalidTriangles(ICPUMeshBuffer* _input);
 
+		//! What createMeshBufferSimplified() and createLoDChain() hand over to CQuadricMeshSimplifier
+		struct SSimplifierInput
+		{
+			//! 32bit triangle list, vertices differing only in attributes within `_errMetrics` already welded
+			core::vector<uint32_t> indices;
+			//! Mapped to the unit cube, so errors are relative to the longest side of the bounding box
+			core::vector<core::vectorSIMDf> positions;
+		};
+		static bool prepareForSimplification(SSimplifierInput& _out, const ICPUMeshBuffer* _inbuffer, const SErrorMetric* _errMetrics);
+
+		//! New meshbuffer with the same member variables and vertex buffers as `_src`, but its own index buffer made from `_indices`
+		/** If `_dst` is given it gets filled instead of a new meshbuffer of the same type as `_src`. */
+		static core::smart_refctd_ptr<ICPUMeshBuffer> createMeshBufferSharingVertices(const ICPUMeshBuffer* _src, const uint32_t* _indices, size_t _indexCount, core::smart_refctd_ptr<ICPUMeshBuffer>&& _dst = nullptr);
+
 		//! Meant to create 32bit index buffer from subrange of index buffer containing 16bit indices. Remember to set to index buffer offset to 0 after mapping buffer resulting from this function.
 		static inline core::smart_refctd_ptr<ICPUBuffer> create32BitFrom16BitIdxBufferSubrange(const uint16_t* _in, size_t _idxCount)
 		{
@@ -0,0 +1,234 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include <algorithm>
+
+#include "CMeshletBuilder.h"
+
+namespace irr { namespace asset
+{
+
+namespace
+{
+	//! below this the normals spread close to a half sphere, the cone would hardly ever cull and its apex becomes unstable
+	constexpr float MinConeSpreadCos = 0.1f;
+
+	constexpr uint32_t NoVertex = ~0u;
+	constexpr uint32_t NoTriangle = ~0u;
+}
+
+core::vector<CMeshletBuilder::SMeshlet> CMeshletBuilder::build(uint32_t* _indices, size_t _indexCount, const core::vectorSIMDf* _positions, size_t _vertexCount, uint32_t _maxVertices, uint32_t _maxTriangles)
+{
+	core::vector<SMeshlet> meshlets;
+	const size_t triangleCount = _indexCount/3u;
+	if (!triangleCount || _maxVertices < 3u || !_maxTriangles)
+		return meshlets;
+
+	// triangles around every vertex
+	core::vector<uint32_t> adjacencyOffsets(_vertexCount+1u, 0u);
+	for (size_t i=0u; i<triangleCount*3u; i++)
+		adjacencyOffsets[_indices[i]+1u]++;
+	for (size_t v=0u; v<_vertexCount; v++)
+		adjacencyOffsets[v+1u] += adjacencyOffsets[v];
+	core::vector<uint32_t> adjacency(triangleCount*3u);
+	{
+		core::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end()-1u);
+		for (size_t i=0u; i<triangleCount*3u; i++)
+			adjacency[cursor[_indices[i]]++] = i/3u;
+	}
+
+	// triangles not taken yet around every vertex
+	core::vector<uint32_t> liveTriangles(_vertexCount);
+	for (size_t v=0u; v<_vertexCount; v++)
+		liveTriangles[v] = adjacencyOffsets[v+1u]-adjacencyOffsets[v];
+
+	core::vector<uint8_t> emitted(triangleCount, 0u);
+	core::vector<uint32_t> order;
+	order.reserve(triangleCount);
+	// slot of every vertex within the meshlet being built
+	core::vector<uint32_t> localIndex(_vertexCount, NoVertex);
+	core::vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(_maxVertices);
+	core::vectorSIMDf positionSum(0.f);
+	uint32_t meshletTriangles = 0u;
+
+	auto addTriangle = [&](uint32_t _triangle)
+	{
+		emitted[_triangle] = 1u;
+		order.push_back(_triangle);
+		for (uint32_t k=0u; k<3u; k++)
+		{
+			const uint32_t v = _indices[_triangle*3u+k];
+			liveTriangles[v]--;
+			if (localIndex[v]!=NoVertex)
+				continue;
+			localIndex[v] = meshletVertices.size();
+			meshletVertices.push_back(v);
+			positionSum += _positions[v];
+		}
+		meshletTriangles++;
+	};
+	auto closeMeshlet = [&]()
+	{
+		SMeshlet meshlet = {};
+		meshlet.indexOffset = (order.size()-meshletTriangles)*3u;
+		meshlet.triangleCount = meshletTriangles;
+		meshlet.vertexCount = meshletVertices.size();
+		meshlets.push_back(meshlet);
+
+		for (auto v : meshletVertices)
+			localIndex[v] = NoVertex;
+		meshletVertices.clear();
+		positionSum = core::vectorSIMDf(0.f);
+		meshletTriangles = 0u;
+	};
+
+	size_t seed = 0u;
+	while (order.size()<triangleCount)
+	{
+		if (!meshletTriangles)
+		{
+			while (emitted[seed])
+				seed++;
+			addTriangle(seed);
+		}
+		else
+		{
+			const core::vectorSIMDf centroid = positionSum/float(meshletVertices.size());
+			uint32_t best = NoTriangle;
+			uint32_t bestNewVertices = 4u;
+			bool bestFinishesVertex = false;
+			float bestDistance = FLT_MAX;
+			for (auto v : meshletVertices)
+			for (uint32_t j=adjacencyOffsets[v]; j<adjacencyOffsets[v+1u]; j++)
+			{
+				const uint32_t t = adjacency[j];
+				if (emitted[t])
+					continue;
+
+				const uint32_t* tri = _indices+t*3u;
+				const uint32_t newVertices = uint32_t(localIndex[tri[0]]==NoVertex)+uint32_t(localIndex[tri[1]]==NoVertex)+uint32_t(localIndex[tri[2]]==NoVertex);
+				if (newVertices>bestNewVertices || meshletVertices.size()+newVertices>_maxVertices)
+					continue;
+
+				// taking the last triangle around a vertex avoids leaving holes behind which later end up as tiny meshlets
+				const bool finishesVertex = liveTriangles[tri[0]]==1u || liveTriangles[tri[1]]==1u || liveTriangles[tri[2]]==1u;
+				if (newVertices==bestNewVertices && bestFinishesVertex && !finishesVertex)
+					continue;
+
+				const core::vectorSIMDf offset = (_positions[tri[0]]+_positions[tri[1]]+_positions[tri[2]])/3.f-centroid;
+				const float distance = core::dot(offset, offset).x;
+				if (newVertices<bestNewVertices || finishesVertex!=bestFinishesVertex || distance<bestDistance)
+				{
+					best = t;
+					bestNewVertices = newVertices;
+					bestFinishesVertex = finishesVertex;
+					bestDistance = distance;
+				}
+			}
+
+			if (best==NoTriangle)
+			{
+				closeMeshlet();
+				continue;
+			}
+			addTriangle(best);
+		}
+
+		if (meshletTriangles==_maxTriangles)
+			closeMeshlet();
+	}
+	if (meshletTriangles)
+		closeMeshlet();
+
+	{
+		core::vector<uint32_t> reordered(triangleCount*3u);
+		for (size_t i=0u; i<triangleCount; i++)
+			std::copy(_indices+order[i]*3u, _indices+order[i]*3u+3u, reordered.begin()+i*3u);
+		std::copy(reordered.begin(), reordered.end(), _indices);
+	}
+
+	core::parallel_for<size_t>(0u, meshlets.size(), [&](size_t m)
+		{
+			computeBounds(meshlets[m], _indices+meshlets[m].indexOffset, _positions);
+		}
+	);
+
+	return meshlets;
+}
+
+void CMeshletBuilder::computeBounds(SMeshlet& _meshlet, const uint32_t* _indices, const core::vectorSIMDf* _positions)
+{
+	const uint32_t indexCount = _meshlet.triangleCount*3u;
+
+	core::vectorSIMDf minPos(FLT_MAX), maxPos(-FLT_MAX);
+	for (uint32_t i=0u; i<indexCount; i++)
+	{
+		minPos = core::min_(minPos, _positions[_indices[i]]);
+		maxPos = core::max_(maxPos, _positions[_indices[i]]);
+	}
+	const core::vectorSIMDf center = (minPos+maxPos)*0.5f;
+	float radiusSq = 0.f;
+	for (uint32_t i=0u; i<indexCount; i++)
+	{
+		const core::vectorSIMDf offset = _positions[_indices[i]]-center;
+		radiusSq = core::max_(radiusSq, core::dot(offset, offset).x);
+	}
+	for (uint32_t k=0u; k<3u; k++)
+		_meshlet.center[k] = center.pointer[k];
+	_meshlet.radius = core::squareroot(radiusSq);
+
+	// a zero axis with a cutoff of 1 never culls
+	for (uint32_t k=0u; k<3u; k++)
+	{
+		_meshlet.coneApex[k] = center.pointer[k];
+		_meshlet.coneAxis[k] = 0.f;
+	}
+	_meshlet.coneCutoff = 1.f;
+
+	core::vector<core::vectorSIMDf> normals(_meshlet.triangleCount);
+	core::vectorSIMDf normalSum(0.f);
+	for (uint32_t t=0u; t<_meshlet.triangleCount; t++)
+	{
+		const core::vectorSIMDf& p0 = _positions[_indices[t*3u+0u]];
+		core::vectorSIMDf n = core::cross(_positions[_indices[t*3u+1u]]-p0, _positions[_indices[t*3u+2u]]-p0);
+		n.w = 0.f;
+		const float length = core::length(n).x;
+		// degenerate triangles can face any way, so they don't constrain the cone
+		normals[t] = length>0.f ? n/length:core::vectorSIMDf(0.f);
+		normalSum += normals[t];
+	}
+	const float sumLength = core::length(normalSum).x;
+	if (sumLength<=0.f)
+		return;
+	const core::vectorSIMDf axis = normalSum/sumLength;
+
+	float minDot = 1.f;
+	for (const auto& n : normals)
+	if (n.x!=0.f || n.y!=0.f || n.z!=0.f)
+		minDot = core::min_(minDot, core::dot(n, axis).x);
+	if (minDot<=MinConeSpreadCos)
+		return;
+
+	// move the apex back along the axis until every triangle's plane is in front of it
+	float maxT = 0.f;
+	for (uint32_t t=0u; t<_meshlet.triangleCount; t++)
+	{
+		const core::vectorSIMDf& n = normals[t];
+		if (n.x==0.f && n.y==0.f && n.z==0.f)
+			continue;
+		const float along = core::dot(center-_positions[_indices[t*3u]], n).x/core::dot(axis, n).x;
+		maxT = core::max_(maxT, along);
+	}
+
+	const core::vectorSIMDf apex = center-axis*maxT;
+	for (uint32_t k=0u; k<3u; k++)
+	{
+		_meshlet.coneApex[k] = apex.pointer[k];
+		_meshlet.coneAxis[k] = axis.pointer[k];
+	}
+	_meshlet.coneCutoff = core::squareroot(1.f-minDot*minDot);
+}
+
+}}
@@ -0,0 +1,46 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_MESHLET_BUILDER_H_INCLUDED__
+#define __IRR_C_MESHLET_BUILDER_H_INCLUDED__
+
+#include "irr/core/core.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
+
+// Approach follows zeux's meshoptimizer (https://github.com/zeux/meshoptimizer) cluster builder available under MIT license
+
+namespace irr { namespace asset
+{
+
+//! Greedily partitions triangle lists into meshlets with bounded vertex and triangle counts
+/**
+A meshlet starts from the first triangle not taken yet (in index buffer order) and grows by the adjacent triangle
+which adds the fewest new vertices, ties go to triangles which are the last one left around one of their vertices,
+then to the triangle closest to the meshlet's centroid.
+It is closed once it reaches the triangle limit or no adjacent triangle fits under the vertex limit anymore.
+*/
+class CMeshletBuilder
+{
+	// private, undefined constructor
+	CMeshletBuilder() = delete;
+
+public:
+	using SMeshlet = ICPUMeshletMeshBuffer::SMeshlet;
+
+	//! Reorders the triangles so every meshlet is a contiguous range of `_indices` and computes the meshlets' bounds
+	/**
+	@param _indices Triangle list, gets rewritten in place, a trailing incomplete triangle is left alone.
+	@param _positions Indexed by `_indices`, `w` must be 0.
+	@returns The meshlets in index buffer order, covering all complete triangles.
+	*/
+	static core::vector<SMeshlet> build(uint32_t* _indices, size_t _indexCount, const core::vectorSIMDf* _positions, size_t _vertexCount, uint32_t _maxVertices, uint32_t _maxTriangles);
+
+private:
+	//! Fills in the bounding sphere and normal cone of a meshlet whose triangles start at `_indices`
+	static void computeBounds(SMeshlet& _meshlet, const uint32_t* _indices, const core::vectorSIMDf* _positions);
+};
+
+}}
+
+#endif//__IRR_C_MESHLET_BUILDER_H_INCLUDED__
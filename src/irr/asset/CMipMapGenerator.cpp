@@ -0,0 +1,316 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "irr/asset/CMipMapGenerator.h"
+#include "irr/asset/format/convertColor.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace irr
+{
+namespace asset
+{
+
+namespace impl
+{
+    //! Kernels are evaluated in destination texel units, so the footprint in the source grows with the reduction factor
+    static float kernelRadius(CMipMapGenerator::E_KERNEL _kernel)
+    {
+        return _kernel==CMipMapGenerator::EK_BOX ? 0.5f:3.f;
+    }
+
+    static inline double sinc(double _x)
+    {
+        _x *= core::PI64;
+        if (std::abs(_x)<0.00001)
+            return 1.0;
+        return std::sin(_x)/_x;
+    }
+
+    //! Zeroth order modified Bessel function of the first kind
+    static double besselI0(double _x)
+    {
+        const double quarterSq = _x*_x*0.25;
+        double sum = 1.0;
+        double term = 1.0;
+        for (uint32_t k=1u; term>sum*1e-12; k++)
+        {
+            term *= quarterSq/double(k*k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    static float evaluateKernel(CMipMapGenerator::E_KERNEL _kernel, double _t)
+    {
+        const double radius = kernelRadius(_kernel);
+        if (std::abs(_t)>=radius)
+            return 0.f;
+
+        switch (_kernel)
+        {
+            case CMipMapGenerator::EK_KAISER:
+            {
+                const double alpha = 4.0;
+                const double ratio = _t/radius;
+                return sinc(_t)*besselI0(alpha*std::sqrt(1.0-ratio*ratio))/besselI0(alpha);
+            }
+            case CMipMapGenerator::EK_LANCZOS3:
+                return sinc(_t)*sinc(_t/radius);
+            default:
+                return 1.f;
+        }
+    }
+
+    //! Source texels and normalized weights of every destination texel along one axis
+    /** Every destination texel has `tapCount` taps, unused ones have a weight of 0.
+    Taps falling outside the source are clamped to the edge. */
+    struct SAxisFilter
+    {
+        uint32_t tapCount;
+        core::vector<uint32_t> index;
+        core::vector<float> weight;
+
+        //! Identity
+        explicit SAxisFilter(uint32_t _size) : tapCount(1u), index(_size), weight(_size,1.f)
+        {
+            for (uint32_t i=0u; i<_size; i++)
+                index[i] = i;
+        }
+
+        SAxisFilter(uint32_t _srcSize, uint32_t _dstSize, CMipMapGenerator::E_KERNEL _kernel)
+        {
+            const double scale = double(_srcSize)/double(_dstSize);
+            const double radius = kernelRadius(_kernel)*scale;
+            const uint32_t maxTaps = uint32_t(std::ceil(2.0*radius))+1u;
+
+            // unnormalized weights of all the taps which could touch the footprint
+            core::vector<float> fullWeight(size_t(_dstSize)*maxTaps);
+            core::vector<int32_t> firstTap(_dstSize);
+            core::vector<uint32_t> usedTaps(_dstSize);
+            tapCount = 1u;
+            for (uint32_t x=0u; x<_dstSize; x++)
+            {
+                const double center = (x+0.5)*scale;
+                const int32_t first = int32_t(std::floor(center-radius));
+                float* w = fullWeight.data()+size_t(x)*maxTaps;
+                for (uint32_t t=0u; t<maxTaps; t++)
+                {
+                    const double i = first+int32_t(t);
+                    if (_kernel==CMipMapGenerator::EK_BOX) // coverage of the source texel by the footprint
+                        w[t] = core::max_(core::min_(i+1.0,center+radius)-core::max_(i,center-radius),0.0);
+                    else
+                        w[t] = evaluateKernel(_kernel,(i+0.5-center)/scale);
+                }
+
+                uint32_t begin = 0u, end = maxTaps;
+                while (begin+1u<end && w[begin]==0.f)
+                    begin++;
+                while (end-1u>begin && w[end-1u]==0.f)
+                    end--;
+                firstTap[x] = first+int32_t(begin);
+                usedTaps[x] = end-begin;
+                tapCount = core::max_(tapCount,end-begin);
+                if (begin)
+                    memmove(w,w+begin,(end-begin)*sizeof(float));
+            }
+
+            index.resize(size_t(_dstSize)*tapCount);
+            weight.resize(size_t(_dstSize)*tapCount,0.f);
+            for (uint32_t x=0u; x<_dstSize; x++)
+            {
+                const float* w = fullWeight.data()+size_t(x)*maxTaps;
+                float sum = 0.f;
+                for (uint32_t t=0u; t<usedTaps[x]; t++)
+                    sum += w[t];
+
+                for (uint32_t t=0u; t<tapCount; t++)
+                {
+                    const int32_t i = firstTap[x]+int32_t(core::min_(t,usedTaps[x]-1u));
+                    index[size_t(x)*tapCount+t] = uint32_t(core::max_(core::min_(i,int32_t(_srcSize)-1),0));
+                    if (t<usedTaps[x])
+                        weight[size_t(x)*tapCount+t] = w[t]/sum;
+                }
+            }
+        }
+    };
+
+    //! Filters `_src` down to `_dstSize`, writes the float result to `_dst` and the encoded one to `_dstImage`
+    static void downsampleLevel(const core::vectorSIMDf* _src, const core::vector3d<uint32_t>& _srcSize,
+                                core::vectorSIMDf* _dst, CImageData* _dstImage,
+                                CMipMapGenerator::E_KERNEL _kernel, bool _volume, core::CTaskScheduler* _scheduler)
+    {
+        constexpr uint32_t TileWidth = 256u;
+        constexpr uint32_t TileHeight = 32u;
+
+        const core::vector3d<uint32_t> dstSize = _dstImage->getSize();
+        const SAxisFilter filterX(_srcSize.X,dstSize.X,_kernel);
+        const SAxisFilter filterY(_srcSize.Y,dstSize.Y,_kernel);
+        const SAxisFilter filterZ = _volume ? SAxisFilter(_srcSize.Z,dstSize.Z,_kernel):SAxisFilter(dstSize.Z);
+
+        const E_FORMAT format = _dstImage->getColorFormat();
+        const bool isNormalized = isNormalizedFormat(format);
+        const core::vectorSIMDf low(isSignedFormat(format) ? (isNormalized ? -1.f:-FLT_MAX):0.f);
+        const core::vectorSIMDf high(isNormalized ? 1.f:FLT_MAX);
+
+        uint8_t* const dstData = reinterpret_cast<uint8_t*>(_dstImage->getData());
+        const size_t dstPitch = _dstImage->getPitchIncludingAlignment();
+        const uint32_t texelSize = getTexelOrBlockBytesize(format);
+
+        const uint32_t tilesX = (dstSize.X+TileWidth-1u)/TileWidth;
+        const uint32_t tilesY = (dstSize.Y+TileHeight-1u)/TileHeight;
+        core::parallel_for<uint32_t>(0u,tilesX*tilesY*dstSize.Z,[&](uint32_t _tile)
+            {
+                const uint32_t z = _tile/(tilesX*tilesY);
+                const uint32_t x0 = (_tile%tilesX)*TileWidth;
+                const uint32_t y0 = (_tile/tilesX%tilesY)*TileHeight;
+                const uint32_t x1 = core::min_(x0+TileWidth,dstSize.X);
+                const uint32_t y1 = core::min_(y0+TileHeight,dstSize.Y);
+                const uint32_t width = x1-x0;
+
+                // range of source rows the tile reads
+                uint32_t rowMin = ~0u, rowMax = 0u;
+                for (size_t i=size_t(y0)*filterY.tapCount; i<size_t(y1)*filterY.tapCount; i++)
+                {
+                    rowMin = core::min_(rowMin,filterY.index[i]);
+                    rowMax = core::max_(rowMax,filterY.index[i]);
+                }
+
+                core::vector<core::vectorSIMDf> horizontal(size_t(rowMax-rowMin+1u)*width);
+                core::vector<core::vectorSIMDf> result(size_t(y1-y0)*width,core::vectorSIMDf(0.f));
+                for (uint32_t zt=0u; zt<filterZ.tapCount; zt++)
+                {
+                    const float wz = filterZ.weight[size_t(z)*filterZ.tapCount+zt];
+                    if (wz==0.f)
+                        continue;
+                    const core::vectorSIMDf* srcSlice = _src+size_t(filterZ.index[size_t(z)*filterZ.tapCount+zt])*_srcSize.X*_srcSize.Y;
+
+                    for (uint32_t row=rowMin; row<=rowMax; row++)
+                    {
+                        const core::vectorSIMDf* srcRow = srcSlice+size_t(row)*_srcSize.X;
+                        core::vectorSIMDf* out = horizontal.data()+size_t(row-rowMin)*width;
+                        for (uint32_t x=x0; x<x1; x++)
+                        {
+                            const uint32_t* ix = filterX.index.data()+size_t(x)*filterX.tapCount;
+                            const float* w = filterX.weight.data()+size_t(x)*filterX.tapCount;
+                            core::vectorSIMDf acc(0.f);
+                            for (uint32_t t=0u; t<filterX.tapCount; t++)
+                                acc += srcRow[ix[t]]*w[t];
+                            out[x-x0] = acc;
+                        }
+                    }
+
+                    for (uint32_t y=y0; y<y1; y++)
+                    {
+                        const uint32_t* ix = filterY.index.data()+size_t(y)*filterY.tapCount;
+                        const float* w = filterY.weight.data()+size_t(y)*filterY.tapCount;
+                        core::vectorSIMDf* out = result.data()+size_t(y-y0)*width;
+                        for (uint32_t t=0u; t<filterY.tapCount; t++)
+                        {
+                            const core::vectorSIMDf* in = horizontal.data()+size_t(ix[t]-rowMin)*width;
+                            const core::vectorSIMDf weight(w[t]*wz);
+                            for (uint32_t x=0u; x<width; x++)
+                                out[x] += in[x]*weight;
+                        }
+                    }
+                }
+
+                for (uint32_t y=y0; y<y1; y++)
+                {
+                    const size_t rowIx = size_t(z)*dstSize.Y+y;
+                    core::vectorSIMDf* floatRow = _dst+rowIx*dstSize.X+x0;
+                    const core::vectorSIMDf* in = result.data()+size_t(y-y0)*width;
+                    for (uint32_t x=0u; x<width; x++)
+                        floatRow[x] = core::clamp(in[x],low,high);
+
+                    const void* srcPix[4] = {floatRow,nullptr,nullptr,nullptr};
+                    core::vector3d<uint32_t> rowSize(width,1u,1u);
+                    video::convertColor(EF_R32G32B32A32_SFLOAT,format,srcPix,dstData+rowIx*dstPitch+size_t(x0)*texelSize,width,rowSize);
+                }
+            },
+            1u,_scheduler
+        );
+    }
+}
+
+
+bool CMipMapGenerator::isSupportedFormat(E_FORMAT _fmt)
+{
+    return _fmt!=EF_UNKNOWN && !isBlockCompressionFormat(_fmt) && !isPlanarFormat(_fmt) && !isIntegerFormat(_fmt);
+}
+
+core::vector<CImageData*> CMipMapGenerator::generateMipChain(const CImageData* _base, E_KERNEL _kernel, bool _volume, uint32_t _maxLevelCount, core::CTaskScheduler* _scheduler)
+{
+    core::vector<CImageData*> levels;
+
+    const E_FORMAT format = _base->getColorFormat();
+    core::vector3d<uint32_t> size = _base->getSize();
+    if (!isSupportedFormat(format) || size.X==0u || size.Y==0u || size.Z==0u)
+        return levels;
+
+    // decode the base once, every further level is filtered from the float copy of the one above
+    core::vector<core::vectorSIMDf> current(size_t(size.X)*size.Y*size.Z,core::vectorSIMDf(0.f));
+    {
+        const uint8_t* const srcData = reinterpret_cast<const uint8_t*>(_base->getData());
+        const size_t srcPitch = _base->getPitchIncludingAlignment();
+        core::parallel_for<uint32_t>(0u,size.Y*size.Z,[&](uint32_t _row)
+            {
+                const void* srcPix[4] = {srcData+size_t(_row)*srcPitch,nullptr,nullptr,nullptr};
+                core::vector3d<uint32_t> rowSize(size.X,1u,1u);
+                video::convertColor(format,EF_R32G32B32A32_SFLOAT,srcPix,current.data()+size_t(_row)*size.X,size.X,rowSize);
+            },
+            0u,_scheduler
+        );
+    }
+
+    const uint32_t baseLevel = _base->getSupposedMipLevel();
+    for (uint32_t level=1u; _maxLevelCount==0u||level<=_maxLevelCount; level++)
+    {
+        if (size.X==1u && size.Y==1u && (!_volume||size.Z==1u))
+            break;
+
+        const core::vector3d<uint32_t> dstSize(core::max_(size.X>>1u,1u),core::max_(size.Y>>1u,1u),_volume ? core::max_(size.Z>>1u,1u):size.Z);
+        uint32_t minCoord[3], maxCoord[3];
+        for (uint32_t i=0u; i<3u; i++)
+            minCoord[i] = i<2u||_volume ? (_base->getSliceMin()[i]>>level):_base->getSliceMin()[i];
+        maxCoord[0] = minCoord[0]+dstSize.X;
+        maxCoord[1] = minCoord[1]+dstSize.Y;
+        maxCoord[2] = minCoord[2]+dstSize.Z;
+        CImageData* image = new CImageData(nullptr,minCoord,maxCoord,baseLevel+level,format,_base->getUnpackAlignment());
+
+        core::vector<core::vectorSIMDf> next(size_t(dstSize.X)*dstSize.Y*dstSize.Z);
+        impl::downsampleLevel(current.data(),size,next.data(),image,_kernel,_volume,_scheduler);
+        levels.push_back(image);
+
+        current.swap(next);
+        size = dstSize;
+    }
+
+    return levels;
+}
+
+ICPUTexture* CMipMapGenerator::createMipMappedTexture(const ICPUTexture* _texture, E_KERNEL _kernel, core::CTaskScheduler* _scheduler)
+{
+    if (!_texture || _texture->getRanges().empty())
+        return nullptr;
+
+    const auto baseRange = _texture->getMipMap(_texture->getRanges().front()->getSupposedMipLevel());
+    if (std::distance(baseRange.first,baseRange.second)!=1)
+        return nullptr;
+
+    CImageData* base = *baseRange.first;
+    if (!isSupportedFormat(base->getColorFormat()))
+        return nullptr;
+    core::vector<CImageData*> ranges = generateMipChain(base,_kernel,_texture->getType()==video::ITexture::ETT_3D,0u,_scheduler);
+
+    ranges.insert(ranges.begin(),base);
+    ICPUTexture* retval = ICPUTexture::create(ranges,_texture->getSourceFilename(),_texture->getType());
+    for (auto it=ranges.begin()+1; it!=ranges.end(); it++)
+        (*it)->drop();
+    return retval;
+}
+
+} // end namespace asset
+} // end namespace irr
@@ -15,29 +15,8 @@
 #include "IReadFile.h"
 #include "os.h"
 #include "irr/asset/IAssetManager.h"
+#include "irr/core/string/fast_atof.h"
 
-/*
-namespace std
-{
-    template <>
-    struct hash<irr::asset::SObjVertex>
-    {
-        std::size_t operator()(const irr::asset::SObjVertex& k) const
-        {
-            using std::size_t;
-            using std::hash;
-
-            return hash(k.normal32bit)^
-                    (reinterpret_cast<const uint32_t&>(k.pos[0])*4996156539000000107ull)^
-                    (reinterpret_cast<const uint32_t&>(k.pos[1])*620612627000000023ull)^
-                    (reinterpret_cast<const uint32_t&>(k.pos[2])*1231379668000000199ull)^
-                    (reinterpret_cast<const uint32_t&>(k.uv[0])*1099543332000000001ull)^
-                    (reinterpret_cast<const uint32_t&>(k.uv[1])*1123461104000000009ull);
-        }
-    };
-
-}
-*/
 
 
 namespace irr
@@ -50,6 +29,8 @@ namespace asset
 //#endif
 
 static const uint32_t WORD_BUFFER_LENGTH = 512;
+// files bigger than this get split at line boundaries and parsed in parallel
+static const size_t PARSE_CHUNK_SIZE = 0x1u<<22u;
 
 
 //! Constructor
@@ -82,10 +63,6 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
 	const uint32_t WORD_BUFFER_LENGTH = 512;
 
-	core::vector<core::vector3df> vertexBuffer;
-	core::vector<core::vector3df> normalsBuffer;
-	core::vector<core::vector2df> textureCoordBuffer;
-
 	SObjMtl * currMtl = new SObjMtl();
 	ctx.Materials.push_back(currMtl);
 	uint32_t smoothingGroup=0;
@@ -93,18 +70,78 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 	const io::path fullName = _file->getFileName();
 	const io::path relPath = io::IFileSystem::getFileDir(fullName)+"/";
 
-	char* buf = new char[filesize];
-	memset(buf, 0, filesize);
-	_file->read((void*)buf, filesize);
+	// parse in place if the file is memory-mapped
+	char* fileCopy = nullptr;
+	const char* buf = reinterpret_cast<const char*>(_file->getMappedRange(0u, filesize));
+	if (!buf)
+	{
+		fileCopy = new char[filesize];
+		memset(fileCopy, 0, filesize);
+		_file->seek(0u);
+		_file->read((void*)fileCopy, filesize);
+		buf = fileCopy;
+	}
 	const char* const bufEnd = buf+filesize;
 
-	// Process obj information
-	const char* bufPtr = buf;
+	// Split at line boundaries, a chunk swallows the rest of a line crossing its nominal end
+	core::vector<SChunk> chunks((filesize+PARSE_CHUNK_SIZE-1)/PARSE_CHUNK_SIZE);
+	{
+		const char* chunkBegin = buf;
+		for (size_t i=0; i<chunks.size(); i++)
+		{
+			const char* chunkEnd = bufEnd;
+			if (i+1<chunks.size() && buf+(i+1)*PARSE_CHUNK_SIZE>chunkBegin)
+			{
+				chunkEnd = reinterpret_cast<const char*>(memchr(buf+(i+1)*PARSE_CHUNK_SIZE, '\n', bufEnd-(buf+(i+1)*PARSE_CHUNK_SIZE)));
+				chunkEnd = chunkEnd ? (chunkEnd+1):bufEnd;
+			}
+			else if (i+1<chunks.size())
+				chunkEnd = chunkBegin;
+			chunks[i].begin = chunkBegin;
+			chunks[i].end = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+	}
+	// Parse vertex attributes and face indices of all chunks in parallel
+	core::parallel_for<size_t>(0u, chunks.size(), [&](size_t i) {parseChunk(chunks[i]);}, 1u);
+
+	// Prefix sum gives every chunk the global index of its first attribute of each kind
+	uint32_t attrTotals[SChunk::EA_COUNT] = {0u,0u,0u};
+	for (auto& chunk : chunks)
+	{
+		const size_t counts[SChunk::EA_COUNT] = {chunk.positions.size(),chunk.uvs.size(),chunk.normals.size()};
+		for (uint32_t a=0u; a<SChunk::EA_COUNT; a++)
+		{
+			chunk.attrOffsets[a] = attrTotals[a];
+			attrTotals[a] += uint32_t(counts[a]);
+		}
+	}
+	core::vector<core::vector3df> vertexBuffer(attrTotals[SChunk::EA_POSITION]);
+	core::vector<core::vector2df> textureCoordBuffer(attrTotals[SChunk::EA_UV]);
+	core::vector<core::vector3df> normalsBuffer(attrTotals[SChunk::EA_NORMAL]);
+	core::parallel_for<size_t>(0u, chunks.size(), [&](size_t i)
+		{
+			auto& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), vertexBuffer.begin()+chunk.attrOffsets[SChunk::EA_POSITION]);
+			std::copy(chunk.uvs.begin(), chunk.uvs.end(), textureCoordBuffer.begin()+chunk.attrOffsets[SChunk::EA_UV]);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normalsBuffer.begin()+chunk.attrOffsets[SChunk::EA_NORMAL]);
+			// not needed anymore
+			chunk.positions = decltype(chunk.positions)();
+			chunk.uvs = decltype(chunk.uvs)();
+			chunk.normals = decltype(chunk.normals)();
+		}, 1u
+	);
+
+	// Replay the remaining statements serially, they depend on the material and group state
 	std::string grpName, mtlName;
 	bool mtlChanged=false;
     bool submeshLoadedFromCache = false;
-	while(bufPtr != bufEnd)
+	core::vector<uint32_t> faceCorners;
+	faceCorners.reserve(32); // should be large enough
+	for (const auto& chunk : chunks)
+	for (const auto& statement : chunk.statements)
 	{
+		const char* bufPtr = statement.line;
 		switch(bufPtr[0])
 		{
 		case 'm':	// mtllib (material)
@@ -121,37 +158,6 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 		}
 			break;
 
-		case 'v':               // v, vn, vt
-            if (submeshLoadedFromCache)
-                break;
-			switch(bufPtr[1])
-			{
-			case ' ':          // vertex
-				{
-					core::vector3df vec;
-					bufPtr = readVec3(bufPtr, vec, bufEnd);
-					vertexBuffer.push_back(vec);
-				}
-				break;
-
-			case 'n':       // normal
-				{
-					core::vector3df vec;
-					bufPtr = readVec3(bufPtr, vec, bufEnd);
-					normalsBuffer.push_back(vec);
-				}
-				break;
-
-			case 't':       // texcoord
-				{
-					core::vector2df vec;
-					bufPtr = readUV(bufPtr, vec, bufEnd);
-					textureCoordBuffer.push_back(vec);
-				}
-				break;
-			}
-			break;
-
 		case 'g': // group name
 			{
 				char grp[WORD_BUFFER_LENGTH];
@@ -228,7 +234,6 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 		{
             if (submeshLoadedFromCache)
                 break;
-			char vertexWord[WORD_BUFFER_LENGTH]; // for retrieving vertex data
 			SObjVertex v;
 			// Assign vertex color from currently active material's diffuse color
 			if (mtlChanged)
@@ -241,28 +246,26 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 				mtlChanged=false;
 			}
 
-			// get all vertices data in this face (current line of obj _file)
-			const core::stringc wordBuffer = copyLine(bufPtr, bufEnd);
-			const char* linePtr = wordBuffer.c_str();
-			const char* const endPtr = linePtr+wordBuffer.size();
-
-			core::vector<uint32_t> faceCorners;
-			faceCorners.reserve(32); // should be large enough
-
-			// read in all vertices
-			linePtr = goNextWord(linePtr, endPtr);
-			while (0 != linePtr[0])
+			const uint32_t attrSizes[SChunk::EA_COUNT] = {uint32_t(vertexBuffer.size()),uint32_t(textureCoordBuffer.size()),uint32_t(normalsBuffer.size())};
+			const int32_t* corner = chunk.corners.data()+statement.firstCorner*SChunk::EA_COUNT;
+			for (uint32_t c=0u; c<statement.cornerCount; c++, corner+=SChunk::EA_COUNT)
 			{
-				// Array to communicate with retrieveVertexIndices()
-				// sends the buffer sizes and gets the actual indices
-				// if index not set returns -1
-				int32_t Idx[3];
-				Idx[1] = Idx[2] = -1;
-
-				// read in next vertex's data
-				uint32_t wlength = copyWord(vertexWord, linePtr, WORD_BUFFER_LENGTH, endPtr);
-				// this function will also convert obj's 1-based index to c++'s 0-based index
-				retrieveVertexIndices(vertexWord, Idx, vertexWord+wlength+1, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
+				// convert obj's 1-based or relative indices to 0-based ones, -1 if the index doesn't exist
+				int64_t Idx[SChunk::EA_COUNT];
+				for (uint32_t a=0u; a<SChunk::EA_COUNT; a++)
+				{
+					if (corner[a]>0)
+						Idx[a] = corner[a]-1;
+					else if (corner[a]<0)
+						Idx[a] = int64_t(chunk.attrOffsets[a])+statement.attrCounts[a]+corner[a];
+					else
+						Idx[a] = -1;
+					if (Idx[a]<0 || Idx[a]>=attrSizes[a])
+						Idx[a] = -1;
+				}
+				if (Idx[SChunk::EA_POSITION]<0)
+					continue;
+
 				v.pos[0] = vertexBuffer[Idx[0]].X;
 				v.pos[1] = vertexBuffer[Idx[0]].Y;
 				v.pos[2] = vertexBuffer[Idx[0]].Z;
@@ -291,7 +294,7 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 				}
 
 				int vertLocation;
-				core::map<SObjVertex, int>::iterator n = currMtl->VertMap.find(v);
+				auto n = currMtl->VertMap.find(v);
 				if (n!=currMtl->VertMap.end())
 				{
 					vertLocation = n->second;
@@ -304,13 +307,10 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 				}
 
 				faceCorners.push_back(vertLocation);
-
-				// go to next vertex
-				linePtr = goNextWord(linePtr, endPtr);
 			}
 
 			// triangulate the face
-			for ( uint32_t i = 1; i < faceCorners.size() - 1; ++i )
+			for ( uint32_t i = 1; i+1 < faceCorners.size(); ++i )
 			{
 				// Add a triangle
 				currMtl->Indices.push_back( faceCorners[i+1] );
@@ -318,19 +318,16 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 				currMtl->Indices.push_back( faceCorners[0] );
 			}
 			faceCorners.resize(0); // fast clear
-			faceCorners.reserve(32);
 		}
 		break;
 
-		case '#': // comment
 		default:
 			break;
 		}	// end switch(bufPtr[0])
-		// eat up rest of line
-		bufPtr = goNextLine(bufPtr, bufEnd);
-	}	// end while(bufPtr && (bufPtr-buf<filesize))
+	}	// end for (statement)
 	// Clean up the allocate obj _file contents
-	delete [] buf;
+	if (fileCopy)
+		delete [] fileCopy;
 
 	asset::CCPUMesh* mesh = new asset::CCPUMesh();
 
@@ -456,7 +453,73 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 }
 
 
-const char* COBJMeshFileLoader::readTextures(const SContext& _ctx, const char* bufPtr, const char* const bufEnd, SObjMtl* currMaterial, const io::path& relPath)
+void COBJMeshFileLoader::parseChunk(SChunk& _chunk)
+{
+	const char* const bufEnd = _chunk.end;
+	const char* bufPtr = goFirstWord(_chunk.begin, bufEnd);
+	while (bufPtr != bufEnd)
+	{
+		switch (bufPtr[0])
+		{
+		case 'v':               // v, vn, vt
+			switch ((bufEnd-bufPtr)>1 ? bufPtr[1]:'\0')
+			{
+			case ' ':          // vertex
+				{
+					core::vector3df vec;
+					bufPtr = readVec3(bufPtr, vec, bufEnd);
+					_chunk.positions.push_back(vec);
+				}
+				break;
+
+			case 'n':       // normal
+				{
+					core::vector3df vec;
+					bufPtr = readVec3(bufPtr, vec, bufEnd);
+					_chunk.normals.push_back(vec);
+				}
+				break;
+
+			case 't':       // texcoord
+				{
+					core::vector2df vec;
+					bufPtr = readUV(bufPtr, vec, bufEnd);
+					_chunk.uvs.push_back(vec);
+				}
+				break;
+			}
+			break;
+
+		case 'f':               // face
+		case 'm':               // mtllib
+		case 'g':               // group
+		case 's':               // smoothing group
+		case 'u':               // usemtl
+			{
+				SChunk::SStatement statement;
+				statement.line = bufPtr;
+				statement.attrCounts[SChunk::EA_POSITION] = _chunk.positions.size();
+				statement.attrCounts[SChunk::EA_UV] = _chunk.uvs.size();
+				statement.attrCounts[SChunk::EA_NORMAL] = _chunk.normals.size();
+				statement.firstCorner = _chunk.corners.size()/SChunk::EA_COUNT;
+				if (bufPtr[0]=='f')
+					bufPtr = readFaceCorners(bufPtr, _chunk.corners, bufEnd);
+				statement.cornerCount = _chunk.corners.size()/SChunk::EA_COUNT-statement.firstCorner;
+				_chunk.statements.push_back(statement);
+			}
+			break;
+
+		case '#': // comment
+		default:
+			break;
+		}
+		// eat up rest of line
+		bufPtr = goNextLine(bufPtr, bufEnd);
+	}
+}
+
+
+const char* COBJMeshFileLoader::readTextures(SContext& _ctx, const char* bufPtr, const char* const bufEnd, SObjMtl* currMaterial, const io::path& relPath)
 {
 	E_TEXTURE_TYPE type = ETT_COLOR_MAP;
 	// TODO: Redo this shit!!!! (Especially for sponza)
@@ -570,21 +633,31 @@ const char* COBJMeshFileLoader::readTextures(const SContext& _ctx, const char* b
 	io::path texname(textureNameBuf);
 	handleBackslashes(&texname);
 
-	core::smart_refctd_ptr<asset::ICPUTexture> texture;
+	// textures of the whole MTL file load concurrently, they get assigned in `applyPendingTextures`
 	if (texname.size())
 	{
-        if (FileSystem->existFile(texname))
-		{
-            auto bundle = interm_getAssetInHierarchy(AssetManager, texname.c_str(), _ctx.inner.params, 2u, _ctx.loaderOverride).getContents();
-            if (bundle.first!=bundle.second) texture = core::smart_refctd_ptr_static_cast<asset::ICPUTexture>(*bundle.first);
-		}
-		else
-		{
-			// try to read in the relative path, the .obj is loaded from
-            auto bundle = interm_getAssetInHierarchy(AssetManager, (relPath + texname).c_str(), _ctx.inner.params, 2u, _ctx.loaderOverride).getContents();
-			if (bundle.first != bundle.second) texture = core::smart_refctd_ptr_static_cast<asset::ICPUTexture>(*bundle.first);
-		}
+		// if not found try to read in the relative path, the .obj is loaded from
+		const io::path texPath = FileSystem->existFile(texname) ? texname:(relPath+texname);
+		_ctx.pendingTextures.push_back({currMaterial,type,interm_getAssetInHierarchyAsync(AssetManager, texPath.c_str(), _ctx.inner.params, 2u, _ctx.loaderOverride)});
 	}
+	return bufPtr;
+}
+
+
+void COBJMeshFileLoader::applyPendingTextures(SContext& _ctx)
+{
+	for (auto& pending : _ctx.pendingTextures)
+	{
+		auto bundle = pending.load->wait().getContents();
+		if (bundle.first!=bundle.second)
+			applyTexture(pending.material, pending.type, core::smart_refctd_ptr_static_cast<asset::ICPUTexture>(*bundle.first));
+	}
+	_ctx.pendingTextures.clear();
+}
+
+
+void COBJMeshFileLoader::applyTexture(SObjMtl* currMaterial, E_TEXTURE_TYPE type, core::smart_refctd_ptr<asset::ICPUTexture>&& texture)
+{
 	if ( texture )
 	{
 		if (type==ETT_COLOR_MAP)
@@ -611,7 +684,6 @@ const char* COBJMeshFileLoader::readTextures(const SContext& _ctx, const char* b
 //						currMaterial->Material.MaterialType=video::EMT_REFLECTION_2_LAYER;
 		}
 	}
-	return bufPtr;
 }
 
 
@@ -796,6 +868,9 @@ void COBJMeshFileLoader::readMTL(SContext& _ctx, const char* fileName, const io:
 	if ( currMaterial )
 		_ctx.Materials.push_back( currMaterial );
 
+	// materials must be complete before `usemtl` statements start copying them
+	applyPendingTextures(_ctx);
+
 	delete [] buf;
 	mtlReader->drop();
 }
@@ -811,13 +886,13 @@ const char* COBJMeshFileLoader::readColor(const char* bufPtr, video::SColor& col
 
 	color.setAlpha(255);
 	bufPtr = goAndCopyNextWord(colStr, bufPtr, COLOR_BUFFER_LENGTH, bufEnd);
-	sscanf(colStr,"%f",&tmp);
+	tmp = core::fast_atof(colStr);
 	color.setRed((int32_t)(tmp * 255.0f));
 	bufPtr = goAndCopyNextWord(colStr,   bufPtr, COLOR_BUFFER_LENGTH, bufEnd);
-	sscanf(colStr,"%f",&tmp);
+	tmp = core::fast_atof(colStr);
 	color.setGreen((int32_t)(tmp * 255.0f));
 	bufPtr = goAndCopyNextWord(colStr,   bufPtr, COLOR_BUFFER_LENGTH, bufEnd);
-	sscanf(colStr,"%f",&tmp);
+	tmp = core::fast_atof(colStr);
 	color.setBlue((int32_t)(tmp * 255.0f));
 	return bufPtr;
 }
@@ -826,15 +901,12 @@ const char* COBJMeshFileLoader::readColor(const char* bufPtr, video::SColor& col
 //! Read 3d vector of floats
 const char* COBJMeshFileLoader::readVec3(const char* bufPtr, core::vector3df& vec, const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.X);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.Y);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.Z);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	bufPtr = core::fast_atof_move(bufPtr, bufEnd, vec.X);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	bufPtr = core::fast_atof_move(bufPtr, bufEnd, vec.Y);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	bufPtr = core::fast_atof_move(bufPtr, bufEnd, vec.Z);
 
 	vec.X = -vec.X; // change handedness
 	return bufPtr;
@@ -844,13 +916,10 @@ const char* COBJMeshFileLoader::readVec3(const char* bufPtr, core::vector3df& ve
 //! Read 2d vector of floats
 const char* COBJMeshFileLoader::readUV(const char* bufPtr, core::vector2df& vec, const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.X);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.Y);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	bufPtr = core::fast_atof_move(bufPtr, bufEnd, vec.X);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	bufPtr = core::fast_atof_move(bufPtr, bufEnd, vec.Y);
 
 	vec.Y = 1-vec.Y; // change handedness
 	return bufPtr;
@@ -954,9 +1023,10 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 	}
 
 	uint32_t i = 0;
-	while(inBuf[i])
+	// the buffer doesn't have to be null-terminated, never look past its end
+	while(&(inBuf[i]) != bufEnd && inBuf[i])
 	{
-		if (core::isspace(inBuf[i]) || &(inBuf[i]) == bufEnd)
+		if (core::isspace(inBuf[i]))
 			break;
 		++i;
 	}
@@ -995,72 +1065,26 @@ const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBu
 }
 
 
-bool COBJMeshFileLoader::retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize)
+const char* COBJMeshFileLoader::readFaceCorners(const char* bufPtr, core::vector<int32_t>& corners, const char* const bufEnd)
 {
-	char word[16] = "";
-	const char* p = goFirstWord(vertexData, bufEnd);
-	uint32_t idxType = 0;	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
-
-	uint32_t i = 0;
-	while ( p != bufEnd )
+	// skip the `f`
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	while (bufPtr != bufEnd && !core::isspace(*bufPtr))
 	{
-		if ( ( core::isdigit(*p)) || (*p == '-') )
-		{
-			// build up the number
-			word[i++] = *p;
-		}
-		else if ( *p == '/' || *p == ' ' || *p == '\0' )
+		int32_t idx[SChunk::EA_COUNT] = {0,0,0};
+		for (uint32_t i=0u; i<SChunk::EA_COUNT; i++)
 		{
-			// number is completed. Convert and store it
-			word[i] = '\0';
-			// if no number was found index will become 0 and later on -1 by decrement
-			sscanf(word,"%u",idx+idxType);
-			if (idx[idxType]<0)
-			{
-				switch (idxType)
-				{
-					case 0:
-						idx[idxType] += vbsize;
-						break;
-					case 1:
-						idx[idxType] += vtsize;
-						break;
-					case 2:
-						idx[idxType] += vnsize;
-						break;
-				}
-			}
-			else
-				idx[idxType]-=1;
-
-			// reset the word
-			word[0] = '\0';
-			i = 0;
-
-			// go to the next kind of index type
-			if (*p == '/')
-			{
-				if ( ++idxType > 2 )
-				{
-					// error checking, shouldn't reach here unless file is wrong
-					idxType = 0;
-				}
-			}
-			else
-			{
-				// set all missing values to disable (=-1)
-				while (++idxType < 3)
-					idx[idxType]=-1;
-				++p;
-				break; // while
-			}
+			// an empty index like in `1//3` leaves the pointer where it is
+			bufPtr = core::fast_atoi_move(bufPtr, bufEnd, idx[i]);
+			if (bufPtr == bufEnd || *bufPtr != '/')
+				break;
+			++bufPtr;
 		}
-
-		// go to the next char
-		++p;
+		corners.insert(corners.end(), idx, idx+SChunk::EA_COUNT);
+		// also skips anything unparseable
+		bufPtr = goNextWord(bufPtr, bufEnd, false);
 	}
-
-	return true;
+	return bufPtr;
 }
 
 std::string COBJMeshFileLoader::genKeyForMeshBuf(const SContext & _ctx, const std::string & _baseKey, const std::string & _mtlName, const std::string & _grpName) const
@@ -8,6 +8,7 @@
 #include "irr/core/core.h"
 #include "irr/asset/ICPUMeshBuffer.h"
 #include "irr/asset/IAssetLoader.h"
+#include "irr/asset/CAssetLoadHandle.h"
 
 namespace irr
 {
@@ -55,7 +56,28 @@ public:
     float uv[2];
     uint32_t normal32bit;
 } PACK_STRUCT;
+#include "irr/irrunpack.h"
 
+//! Hashes the values compared by SObjVertex::operator==
+struct SObjVertexHash
+{
+    inline size_t operator()(const SObjVertex& _v) const
+    {
+        const float values[5] = {_v.pos[0],_v.pos[1],_v.pos[2],_v.uv[0],_v.uv[1]};
+        uint64_t retval = _v.normal32bit;
+        for (size_t i=0; i<5; i++)
+        {
+            // adding zero turns -0.f into 0.f, they compare equal so they must hash equal
+            const float x = values[i]+0.f;
+            uint32_t bits;
+            memcpy(&bits,&x,sizeof(bits));
+            retval = (retval^bits)*0x100000001b3ull;
+        }
+        return size_t(retval^(retval>>32u));
+    }
+};
+
+#include "irr/irrpack.h"
 class SObjVertex16
 {
 public:
@@ -124,6 +146,14 @@ class COBJMeshFileLoader : public asset::IAssetLoader
         core::vector<SObjMtl*> Materials;
         core::unordered_map<SObjMtl*, asset::ICPUMeshBuffer*> preloadedSubmeshes;
 
+        struct SPendingTexture
+        {
+            SObjMtl* material;
+            E_TEXTURE_TYPE type;
+            core::smart_refctd_ptr<CAssetLoadHandle> load;
+        };
+        core::vector<SPendingTexture> pendingTextures;
+
         ~SContext()
         {
             for (auto& m : Materials)
@@ -131,6 +161,41 @@ class COBJMeshFileLoader : public asset::IAssetLoader
         }
     };
 
+    //! Everything parsed out of one line-aligned slice of the file, slices get parsed in parallel by `parseChunk`
+    struct SChunk
+    {
+        enum E_ATTRIBUTE : uint32_t
+        {
+            EA_POSITION,
+            EA_UV,
+            EA_NORMAL,
+            EA_COUNT
+        };
+        //! Any statement other than `v`, `vt` and `vn`, these need to be replayed serially in file order
+        struct SStatement
+        {
+            const char* line;
+            //! range of `corners` belonging to a face statement
+            uint32_t firstCorner;
+            uint32_t cornerCount;
+            //! amount of each attribute parsed in this chunk before the statement, needed to resolve relative (negative) indices
+            uint32_t attrCounts[EA_COUNT];
+        };
+
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        core::vector<core::vector3df> positions;
+        core::vector<core::vector2df> uvs;
+        core::vector<core::vector3df> normals;
+        //! EA_COUNT indices per face corner exactly as in the file, 1-based, negative if relative and 0 if missing
+        core::vector<int32_t> corners;
+        core::vector<SStatement> statements;
+
+        //! global index of the first attribute of each kind parsed in this chunk, computed with a prefix sum over the chunks
+        uint32_t attrOffsets[EA_COUNT] = {0u,0u,0u};
+    };
+
 protected:
 	//! destructor
 	virtual ~COBJMeshFileLoader();
@@ -182,7 +247,7 @@ private:
                 Material = o.Material;
             }
 
-            core::map<SObjVertex, int> VertMap;
+            core::unordered_map<SObjVertex, int, SObjVertexHash> VertMap;
             core::vector<SObjVertex> Vertices;
             core::vector<uint32_t> Indices;
             video::SCPUMaterial Material;
@@ -193,8 +258,14 @@ private:
             bool RecalculateNormals;
 	};
 
-	// helper method for material reading
-	const char* readTextures(const SContext& _ctx, const char* bufPtr, const char* const bufEnd, SObjMtl* currMaterial, const io::path& relPath);
+	// helper method for material reading, starts the texture load
+	const char* readTextures(SContext& _ctx, const char* bufPtr, const char* const bufEnd, SObjMtl* currMaterial, const io::path& relPath);
+	// waits for the texture loads started by readTextures and assigns them to their materials
+	void applyPendingTextures(SContext& _ctx);
+	void applyTexture(SObjMtl* currMaterial, E_TEXTURE_TYPE type, core::smart_refctd_ptr<asset::ICPUTexture>&& texture);
+
+	// parses all vertex attributes and collects all other statements of a chunk, safe to call concurrently for different chunks
+	void parseChunk(SChunk& _chunk);
 
 	// returns a pointer to the first printable character available in the buffer
 	const char* goFirstWord(const char* buf, const char* const bufEnd, bool acrossNewlines=true);
@@ -225,10 +296,8 @@ private:
 	//! Read boolean value represented as 'on' or 'off'
 	const char* readBool(const char* bufPtr, bool& tf, const char* const bufEnd);
 
-	// reads and convert to integer the vertex indices in a line of obj file's face statement
-	// -1 for the index if it doesn't exist
-	// indices are changed to 0-based index instead of 1-based from the obj file
-	bool retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize);
+	// reads the `pos/uv/normal` index triplets of a face statement as they are in the file, missing indices become 0
+	const char* readFaceCorners(const char* bufPtr, core::vector<int32_t>& corners, const char* const bufEnd);
 
     std::string genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const;
 
@@ -211,6 +211,15 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 				if (ctx.IsBinaryFile)
 				{
                     ctx.StartPointer = ctx.LineEndPointer + 1;
+                    // binary data never gets modified while parsing, so it can be read straight out of a memory-mapped file
+                    const size_t dataOffset = ctx.File->getPos()-(ctx.EndPointer-ctx.StartPointer);
+                    const size_t dataSize = ctx.File->getSize()-dataOffset;
+                    if (const void* mapped = ctx.File->getMappedRange(dataOffset, dataSize))
+                    {
+                        ctx.StartPointer = const_cast<char*>(reinterpret_cast<const char*>(mapped));
+                        ctx.EndPointer = ctx.StartPointer+dataSize;
+                        ctx.EndOfFile = true;
+                    }
 				}
 			}
 			else if (strcmp(word, "comment") == 0)
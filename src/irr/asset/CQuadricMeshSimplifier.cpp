@@ -0,0 +1,468 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include <algorithm>
+#include <numeric>
+
+#include "CQuadricMeshSimplifier.h"
+
+namespace irr { namespace asset
+{
+
+namespace
+{
+	//! borders and seams get planes through their edges, weighted this much more than the triangles, so they keep their shape
+	constexpr float EdgeWeight = 10.f;
+	//! how far a collapse may rotate a triangle's normal, the cosine of ~75 degrees
+	constexpr float MinNormalCos = 0.25f;
+	//! a pass stops taking collapses once they get this much worse than the ones it needed to reach its goal
+	constexpr float PassErrorSlack = 1.5f;
+	//! clusters keep at least this fraction of their triangles, past it the locked boundaries force slivers and the final pass does better
+	constexpr size_t ClusterKeptFraction = 8u;
+
+	constexpr uint32_t NoEdge = ~0u;
+	constexpr uint32_t SharedGroup = ~1u;
+}
+
+void CQuadricMeshSimplifier::SQuadric::addPlane(const core::vectorSIMDf& _normal, float _distance, float _weight)
+{
+	const float x = _normal.x, y = _normal.y, z = _normal.z;
+	a00 += _weight*x*x;
+	a11 += _weight*y*y;
+	a22 += _weight*z*z;
+	a10 += _weight*y*x;
+	a20 += _weight*z*x;
+	a21 += _weight*z*y;
+	b0 += _weight*x*_distance;
+	b1 += _weight*y*_distance;
+	b2 += _weight*z*_distance;
+	c += _weight*_distance*_distance;
+	w += _weight;
+}
+
+void CQuadricMeshSimplifier::SQuadric::add(const SQuadric& _other)
+{
+	a00 += _other.a00;
+	a11 += _other.a11;
+	a22 += _other.a22;
+	a10 += _other.a10;
+	a20 += _other.a20;
+	a21 += _other.a21;
+	b0 += _other.b0;
+	b1 += _other.b1;
+	b2 += _other.b2;
+	c += _other.c;
+	w += _other.w;
+}
+
+float CQuadricMeshSimplifier::SQuadric::evaluate(const core::vectorSIMDf& _p) const
+{
+	const float x = _p.x, y = _p.y, z = _p.z;
+	// p^T*A*p + 2*b^T*p + c
+	const float rx = a00*x + a10*y + a20*z + 2.f*b0;
+	const float ry = a10*x + a11*y + a21*z + 2.f*b1;
+	const float rz = a20*x + a21*y + a22*z + 2.f*b2;
+	const float r = rx*x + ry*y + rz*z + c;
+	// the average squared distance to the planes
+	return w>0.f ? core::abs_(r)/w : 0.f;
+}
+
+void CQuadricMeshSimplifier::findPositionGroups(uint32_t* _outGroup, uint32_t* _outNextWedge, const core::vectorSIMDf* _positions, size_t _vertexCount)
+{
+	core::vector<uint32_t> order(_vertexCount);
+	std::iota(order.begin(), order.end(), 0u);
+	auto less = [_positions](uint32_t _a, uint32_t _b)
+	{
+		const core::vectorSIMDf& a = _positions[_a];
+		const core::vectorSIMDf& b = _positions[_b];
+		if (a.x!=b.x)
+			return a.x<b.x;
+		if (a.y!=b.y)
+			return a.y<b.y;
+		if (a.z!=b.z)
+			return a.z<b.z;
+		return _a<_b;
+	};
+	std::sort(order.begin(), order.end(), less);
+
+	for (size_t begin=0u; begin<_vertexCount; )
+	{
+		const core::vectorSIMDf& p = _positions[order[begin]];
+		size_t end = begin+1u;
+		while (end<_vertexCount && _positions[order[end]].x==p.x && _positions[order[end]].y==p.y && _positions[order[end]].z==p.z)
+			end++;
+		// sorted by index within the run, so the first is the lowest
+		for (size_t i=begin; i<end; i++)
+		{
+			_outGroup[order[i]] = order[begin];
+			_outNextWedge[order[i]] = order[i+1u<end ? i+1u:begin];
+		}
+		begin = end;
+	}
+}
+
+size_t CQuadricMeshSimplifier::simplify(uint32_t* _indices, size_t _indexCount, const core::vectorSIMDf* _positions, size_t _vertexCount, size_t _targetIndexCount, float _maxError, float* _outError)
+{
+	_indexCount -= _indexCount%3u;
+	_targetIndexCount -= _targetIndexCount%3u;
+
+	float errorSq = 0.f;
+	const float maxErrorSq = _maxError*_maxError;
+	const size_t triangleCount = _indexCount/3u;
+	if (_indexCount>_targetIndexCount && triangleCount<=ClusterTriangleCount*2u)
+		_indexCount = simplifyCluster(_indices, _indexCount, _positions, _vertexCount, nullptr, _targetIndexCount, maxErrorSq, errorSq);
+	else if (_indexCount>_targetIndexCount)
+	{
+		// split along the longest axis of the triangle centroids until the clusters are small enough
+		core::vector<core::vectorSIMDf> centroids(triangleCount);
+		for (size_t t=0u; t<triangleCount; t++)
+			centroids[t] = _positions[_indices[t*3u+0u]]+_positions[_indices[t*3u+1u]]+_positions[_indices[t*3u+2u]];
+		core::vector<uint32_t> order(triangleCount);
+		std::iota(order.begin(), order.end(), 0u);
+
+		core::vector<std::pair<size_t,size_t> > clusters;
+		core::vector<std::pair<size_t,size_t> > stack = {{0u,triangleCount}};
+		while (!stack.empty())
+		{
+			const auto range = stack.back();
+			stack.pop_back();
+			if (range.second-range.first<=ClusterTriangleCount)
+			{
+				clusters.push_back(range);
+				continue;
+			}
+
+			core::vectorSIMDf minEdge(FLT_MAX), maxEdge(-FLT_MAX);
+			for (size_t i=range.first; i<range.second; i++)
+			{
+				minEdge = core::min_(minEdge, centroids[order[i]]);
+				maxEdge = core::max_(maxEdge, centroids[order[i]]);
+			}
+			const core::vectorSIMDf extent = maxEdge-minEdge;
+			const uint32_t axis = extent.x>=extent.y&&extent.x>=extent.z ? 0u:(extent.y>=extent.z ? 1u:2u);
+			const size_t middle = (range.first+range.second)/2u;
+			std::nth_element(order.begin()+range.first, order.begin()+middle, order.begin()+range.second, [&](uint32_t _a, uint32_t _b) {return centroids[_a].pointer[axis]<centroids[_b].pointer[axis];});
+			stack.push_back({range.first,middle});
+			stack.push_back({middle,range.second});
+		}
+
+		// anything at a position used by more than one cluster stays put, wedges of a seam may end up in different clusters
+		core::vector<uint32_t> group(_vertexCount), nextWedge(_vertexCount);
+		findPositionGroups(group.data(), nextWedge.data(), _positions, _vertexCount);
+		core::vector<uint32_t> owner(_vertexCount, NoEdge);
+		for (size_t c=0u; c<clusters.size(); c++)
+		for (size_t i=clusters[c].first; i<clusters[c].second; i++)
+		for (uint32_t k=0u; k<3u; k++)
+		{
+			uint32_t& o = owner[group[_indices[order[i]*3u+k]]];
+			o = o==NoEdge||o==c ? uint32_t(c):SharedGroup;
+		}
+
+		core::vector<core::vector<uint32_t> > clusterIndices(clusters.size());
+		core::vector<float> clusterErrorSq(clusters.size(), 0.f);
+		core::parallel_for<size_t>(0u, clusters.size(), [&](size_t c)
+			{
+				const auto range = clusters[c];
+				core::vector<uint32_t>& indices = clusterIndices[c];
+				indices.resize((range.second-range.first)*3u);
+				for (size_t i=range.first; i<range.second; i++)
+					std::copy(_indices+order[i]*3u, _indices+order[i]*3u+3u, indices.begin()+(i-range.first)*3u);
+
+				// compact the vertices, so the per vertex state only covers this cluster
+				core::vector<uint32_t> vertices(indices);
+				std::sort(vertices.begin(), vertices.end());
+				vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+				for (auto& index : indices)
+					index = std::lower_bound(vertices.begin(), vertices.end(), index)-vertices.begin();
+				core::vector<core::vectorSIMDf> positions(vertices.size());
+				core::vector<uint8_t> locked(vertices.size());
+				for (size_t v=0u; v<vertices.size(); v++)
+				{
+					positions[v] = _positions[vertices[v]];
+					locked[v] = owner[group[vertices[v]]]==SharedGroup;
+				}
+
+				const size_t proportionalTarget = size_t(double(indices.size()/3u)*double(_targetIndexCount)/double(_indexCount))*3u;
+				const size_t target = core::max_(proportionalTarget, indices.size()/3u/ClusterKeptFraction*3u);
+				indices.resize(simplifyCluster(indices.data(), indices.size(), positions.data(), positions.size(), locked.data(), target, maxErrorSq, clusterErrorSq[c]));
+				for (auto& index : indices)
+					index = vertices[index];
+			}, 1u);
+
+		_indexCount = 0u;
+		for (size_t c=0u; c<clusters.size(); c++)
+		{
+			std::copy(clusterIndices[c].begin(), clusterIndices[c].end(), _indices+_indexCount);
+			_indexCount += clusterIndices[c].size();
+			errorSq = core::max_(errorSq, clusterErrorSq[c]);
+		}
+
+		// the clusters couldn't touch their boundaries
+		if (_indexCount>_targetIndexCount)
+		{
+			float boundaryErrorSq = 0.f;
+			_indexCount = simplifyCluster(_indices, _indexCount, _positions, _vertexCount, nullptr, _targetIndexCount, maxErrorSq, boundaryErrorSq);
+			errorSq = core::max_(errorSq, boundaryErrorSq);
+		}
+	}
+
+	if (_outError)
+		*_outError = core::squareroot(errorSq);
+	return _indexCount;
+}
+
+size_t CQuadricMeshSimplifier::simplifyCluster(uint32_t* _indices, size_t _indexCount, const core::vectorSIMDf* _positions, size_t _vertexCount, const uint8_t* _locked, size_t _targetIndexCount, float _maxErrorSq, float& _outErrorSq)
+{
+	_outErrorSq = 0.f;
+	if (_indexCount<=_targetIndexCount)
+		return _indexCount;
+
+	core::vector<uint32_t> group(_vertexCount), nextWedge(_vertexCount);
+	findPositionGroups(group.data(), nextWedge.data(), _positions, _vertexCount);
+
+	// per position, wedges share theirs
+	core::vector<SQuadric> quadrics(_vertexCount);
+	memset(quadrics.data(), 0, quadrics.size()*sizeof(SQuadric));
+	for (size_t i=0u; i<_indexCount; i+=3u)
+	{
+		const core::vectorSIMDf& p0 = _positions[_indices[i+0u]];
+		core::vectorSIMDf normal = core::cross(_positions[_indices[i+1u]]-p0, _positions[_indices[i+2u]]-p0);
+		const float area = core::length(normal).x;
+		if (area==0.f)
+			continue;
+		normal /= area;
+		const float distance = -core::dot(normal, p0).x;
+		for (uint32_t k=0u; k<3u; k++)
+			quadrics[group[_indices[i+k]]].addPlane(normal, distance, area);
+	}
+
+	// the triangles around every vertex
+	core::vector<uint32_t> adjacencyOffsets(_vertexCount+1u), adjacency;
+	auto buildAdjacency = [&]()
+	{
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+		for (size_t i=0u; i<_indexCount; i++)
+			adjacencyOffsets[_indices[i]+1u]++;
+		std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+		adjacency.resize(_indexCount);
+		core::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end()-1u);
+		for (size_t i=0u; i<_indexCount; i++)
+			adjacency[fill[_indices[i]]++] = i/3u;
+	};
+	auto hasEdge = [&](uint32_t _from, uint32_t _to)
+	{
+		for (uint32_t j=adjacencyOffsets[_from]; j<adjacencyOffsets[_from+1u]; j++)
+		{
+			const uint32_t* triangle = _indices+adjacency[j]*3u;
+			for (uint32_t k=0u; k<3u; k++)
+			if (triangle[k]==_from && triangle[(k+1u)%3u]==_to)
+				return true;
+		}
+		return false;
+	};
+
+	// a vertex with exactly one open edge going out and one coming in is on a border, or on a seam if its only other wedge mirrors it
+	core::vector<uint8_t> cornerOpen(_indexCount);
+	core::vector<uint32_t> openOut(_vertexCount), openIn(_vertexCount);
+	core::vector<uint8_t> kinds(_vertexCount);
+	auto classify = [&]()
+	{
+		std::fill(openOut.begin(), openOut.end(), NoEdge);
+		std::fill(openIn.begin(), openIn.end(), NoEdge);
+		for (size_t i=0u; i<_indexCount; i++)
+		{
+			const uint32_t a = _indices[i];
+			const uint32_t b = _indices[i-i%3u+(i+1u)%3u];
+			cornerOpen[i] = !hasEdge(b, a);
+			if (!cornerOpen[i])
+				continue;
+			// an edge to itself marks more than one
+			openOut[a] = openOut[a]==NoEdge ? b:a;
+			openIn[b] = openIn[b]==NoEdge ? a:b;
+		}
+
+		auto isSingle = [&](uint32_t _v, uint32_t _other) {return _other!=NoEdge && _other!=_v;};
+		for (uint32_t v=0u; v<_vertexCount; v++)
+		{
+			const uint32_t w = nextWedge[v];
+			if (_locked && _locked[v])
+				kinds[v] = EVK_LOCKED;
+			else if (w==v)
+			{
+				if (openOut[v]==NoEdge && openIn[v]==NoEdge)
+					kinds[v] = EVK_MANIFOLD;
+				else
+					kinds[v] = isSingle(v,openOut[v])&&isSingle(v,openIn[v]) ? EVK_BORDER:EVK_LOCKED;
+			}
+			else if (nextWedge[w]==v && isSingle(v,openOut[v]) && isSingle(v,openIn[v]) && isSingle(w,openOut[w]) && isSingle(w,openIn[w]) &&
+					group[openOut[v]]==group[openIn[w]] && group[openIn[v]]==group[openOut[w]])
+				kinds[v] = EVK_SEAM;
+			else
+				kinds[v] = EVK_LOCKED;
+		}
+	};
+
+	// rows are the kind collapsed from, columns the kind collapsed onto
+	static const bool CanCollapse[4][4] = {
+		{true,	true,	true,	true},
+		{false,	true,	false,	false},
+		{false,	false,	true,	false},
+		{false,	false,	false,	false}
+	};
+
+	// moving `_from` onto `_to` mustn't turn any of its triangles (which don't vanish) over
+	auto flips = [&](uint32_t _from, uint32_t _to)
+	{
+		const core::vectorSIMDf& target = _positions[_to];
+		for (uint32_t j=adjacencyOffsets[_from]; j<adjacencyOffsets[_from+1u]; j++)
+		{
+			const uint32_t* triangle = _indices+adjacency[j]*3u;
+			const uint32_t k = triangle[0]==_from ? 0u:(triangle[1]==_from ? 1u:2u);
+			const uint32_t b = triangle[(k+1u)%3u], c = triangle[(k+2u)%3u];
+			if (group[b]==group[_to] || group[c]==group[_to])
+				continue;
+
+			const core::vectorSIMDf& pb = _positions[b];
+			const core::vectorSIMDf& pc = _positions[c];
+			const core::vectorSIMDf before = core::cross(pb-_positions[_from], pc-_positions[_from]);
+			const core::vectorSIMDf after = core::cross(pb-target, pc-target);
+			// nothing to compare to when the triangle was degenerate already, but collapsing it to a line is as bad as turning it over
+			const float lengths = core::length(before).x*core::length(after).x;
+			if (core::length(before).x>0.f && core::dot(before, after).x<=MinNormalCos*lengths)
+				return true;
+		}
+		return false;
+	};
+
+	core::vector<SCollapse> candidates;
+	core::vector<uint32_t> remap(_vertexCount);
+	core::vector<uint8_t> collapseLocked(_vertexCount);
+	for (bool first=true; _indexCount>_targetIndexCount; first=false)
+	{
+		buildAdjacency();
+		classify();
+
+		if (first)
+		for (size_t i=0u; i<_indexCount; i++)
+		{
+			if (!cornerOpen[i])
+				continue;
+			const size_t triangle = i-i%3u;
+			const core::vectorSIMDf& p0 = _positions[_indices[triangle+0u]];
+			const core::vectorSIMDf normal = core::normalize(core::cross(_positions[_indices[triangle+1u]]-p0, _positions[_indices[triangle+2u]]-p0));
+			const uint32_t a = _indices[i];
+			const uint32_t b = _indices[triangle+(i+1u)%3u];
+			const core::vectorSIMDf edge = _positions[b]-_positions[a];
+			const float lengthSq = core::dot(edge, edge).x;
+			if (lengthSq==0.f || normal.x!=normal.x)
+				continue;
+			const core::vectorSIMDf edgeNormal = core::normalize(core::cross(edge, normal));
+			const float distance = -core::dot(edgeNormal, _positions[a]).x;
+			quadrics[group[a]].addPlane(edgeNormal, distance, lengthSq*EdgeWeight);
+			quadrics[group[b]].addPlane(edgeNormal, distance, lengthSq*EdgeWeight);
+		}
+
+		candidates.clear();
+		for (size_t i=0u; i<_indexCount; i++)
+		{
+			const uint32_t a = _indices[i];
+			const uint32_t b = _indices[i-i%3u+(i+1u)%3u];
+			// interior edges show up in two triangles
+			if (!cornerOpen[i] && a>b)
+				continue;
+			if (group[a]==group[b])
+				continue;
+
+			SCollapse best = {NoEdge,NoEdge,FLT_MAX};
+			auto consider = [&](uint32_t _from, uint32_t _to)
+			{
+				if (!CanCollapse[kinds[_from]][kinds[_to]])
+					return;
+				// borders and seams only collapse along themselves
+				if ((kinds[_from]==EVK_BORDER||kinds[_from]==EVK_SEAM) && !(cornerOpen[i] && (openOut[_from]==_to||openIn[_from]==_to)))
+					return;
+				const float error = quadrics[group[_from]].evaluate(_positions[_to]);
+				if (error<best.error)
+					best = {_from,_to,error};
+			};
+			consider(a, b);
+			consider(b, a);
+			if (best.from!=NoEdge)
+				candidates.push_back(best);
+		}
+		if (candidates.empty())
+			break;
+		std::sort(candidates.begin(), candidates.end(), [](const SCollapse& _a, const SCollapse& _b) {return _a.error<_b.error;});
+
+		// most collapses take two triangles with them, borders take one
+		const size_t triangleGoal = (_indexCount-_targetIndexCount)/3u;
+		const size_t edgeGoal = core::max_<size_t>(triangleGoal/2u, 1u);
+		// collapses blocked by flips stay on top of the list, with few triangles left to go they'd limit every pass to a handful of collapses
+		const bool limitPass = triangleGoal>_indexCount/3u/32u;
+		const float passErrorLimit = core::min_(candidates[core::min_(edgeGoal, candidates.size())-1u].error*PassErrorSlack, _maxErrorSq);
+
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(collapseLocked.begin(), collapseLocked.end(), 0u);
+		auto lockRing = [&](uint32_t _v)
+		{
+			for (uint32_t j=adjacencyOffsets[_v]; j<adjacencyOffsets[_v+1u]; j++)
+			for (uint32_t k=0u; k<3u; k++)
+				collapseLocked[group[_indices[adjacency[j]*3u+k]]] = 1u;
+		};
+
+		size_t collapses = 0u, trianglesRemoved = 0u;
+		for (const auto& collapse : candidates)
+		{
+			// many of the cheap collapses get locked out by their neighbours, so the pass limit only applies once some progress was made
+			if (trianglesRemoved>=triangleGoal || collapse.error>_maxErrorSq || (limitPass && collapse.error>passErrorLimit && trianglesRemoved>triangleGoal/10u))
+				break;
+			const uint32_t from = collapse.from, to = collapse.to;
+			if (collapseLocked[group[from]] || collapseLocked[group[to]])
+				continue;
+
+			// the other side of a seam moves along with it
+			uint32_t wedgeFrom = NoEdge, wedgeTo = NoEdge;
+			if (kinds[from]==EVK_SEAM)
+			{
+				wedgeFrom = nextWedge[from];
+				wedgeTo = openOut[from]==to ? openIn[wedgeFrom]:openOut[wedgeFrom];
+			}
+			if (flips(from,to) || (wedgeFrom!=NoEdge && flips(wedgeFrom,wedgeTo)))
+				continue;
+
+			// neighbouring collapses in one pass could flip triangles between them
+			lockRing(from);
+			remap[from] = to;
+			if (wedgeFrom!=NoEdge)
+			{
+				lockRing(wedgeFrom);
+				remap[wedgeFrom] = wedgeTo;
+			}
+			collapseLocked[group[to]] = 1u;
+			quadrics[group[to]].add(quadrics[group[from]]);
+
+			collapses++;
+			trianglesRemoved += kinds[from]==EVK_BORDER ? 1u:2u;
+			_outErrorSq = core::max_(_outErrorSq, collapse.error);
+		}
+		if (!collapses)
+			break;
+
+		size_t kept = 0u;
+		for (size_t i=0u; i<_indexCount; i+=3u)
+		{
+			const uint32_t a = remap[_indices[i+0u]], b = remap[_indices[i+1u]], c = remap[_indices[i+2u]];
+			if (a==b || b==c || c==a)
+				continue;
+			_indices[kept++] = a;
+			_indices[kept++] = b;
+			_indices[kept++] = c;
+		}
+		_indexCount = kept;
+	}
+
+	return _indexCount;
+}
+
+}}
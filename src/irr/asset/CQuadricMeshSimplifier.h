@@ -0,0 +1,81 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#ifndef __IRR_C_QUADRIC_MESH_SIMPLIFIER_H_INCLUDED__
+#define __IRR_C_QUADRIC_MESH_SIMPLIFIER_H_INCLUDED__
+
+#include "irr/core/core.h"
+
+// Approach follows zeux's meshoptimizer (https://github.com/zeux/meshoptimizer) simplifier available under MIT license
+
+namespace irr { namespace asset
+{
+
+//! Edge collapse simplifier for triangle lists driven by quadric error metrics
+/**
+Vertices only ever collapse onto other existing vertices, so only the indices change and the vertex data can be shared by all LoDs.
+Indices should already be welded, vertices with equal positions but different indices are treated as attribute seams,
+seams and mesh borders only collapse along themselves and keep their shape, vertices where more than two seams meet never move.
+
+Meshes above `ClusterTriangleCount*2` triangles get split into spatially coherent clusters which are simplified in parallel,
+with the vertices on the cluster boundaries locked, a final pass over the whole mesh then collapses across the boundaries.
+*/
+class CQuadricMeshSimplifier
+{
+	// private, undefined constructor
+	CQuadricMeshSimplifier() = delete;
+
+public:
+	_IRR_STATIC_INLINE_CONSTEXPR size_t ClusterTriangleCount = 16384u;
+
+	//! Removes triangles until at most `_targetIndexCount` indices are left or the next collapse would exceed `_maxError`
+	/**
+	@param _indices Triangle list, gets rewritten in place.
+	@param _positions Should be normalized to the unit cube, so errors are relative to the mesh's size.
+	@param _maxError Largest distance any surface may move by.
+	@param _outError If not nullptr, receives the largest error any collapse made, never above `_maxError`.
+	@returns The new index count, always a multiple of 3.
+	*/
+	static size_t simplify(uint32_t* _indices, size_t _indexCount, const core::vectorSIMDf* _positions, size_t _vertexCount, size_t _targetIndexCount, float _maxError, float* _outError = nullptr);
+
+private:
+	//! Error of moving a point off the planes it came from, accumulated over collapses
+	struct SQuadric
+	{
+		float a00, a11, a22, a10, a20, a21;
+		float b0, b1, b2;
+		float c;
+		//! sum of the plane weights, errors are averaged by it
+		float w;
+
+		void addPlane(const core::vectorSIMDf& _normal, float _distance, float _weight);
+		void add(const SQuadric& _other);
+		float evaluate(const core::vectorSIMDf& _p) const;
+	};
+
+	enum E_VERTEX_KIND : uint8_t
+	{
+		EVK_MANIFOLD,
+		EVK_BORDER,
+		EVK_SEAM,
+		EVK_LOCKED
+	};
+
+	struct SCollapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float error;
+	};
+
+	//! Simplifies one compact set of vertices, `_locked` vertices are never moved
+	static size_t simplifyCluster(uint32_t* _indices, size_t _indexCount, const core::vectorSIMDf* _positions, size_t _vertexCount, const uint8_t* _locked, size_t _targetIndexCount, float _maxErrorSq, float& _outErrorSq);
+
+	//! `_outGroup[v]` is the lowest vertex with the same position as `v`, `_outNextWedge` links such vertices into rings
+	static void findPositionGroups(uint32_t* _outGroup, uint32_t* _outNextWedge, const core::vectorSIMDf* _positions, size_t _vertexCount);
+};
+
+}}
+
+#endif//__IRR_C_QUADRIC_MESH_SIMPLIFIER_H_INCLUDED__
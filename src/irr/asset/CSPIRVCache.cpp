@@ -0,0 +1,204 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "IrrCompileConfig.h"
+#include "irr/asset/CSPIRVCache.h"
+#include "irr/core/xxHash256.h"
+
+#ifdef _IRR_WINDOWS_API_
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+using namespace irr;
+using namespace asset;
+
+namespace
+{
+    //! precedes the SPIR-V words in every file
+    struct SFileHeader
+    {
+        uint32_t magic;
+        uint32_t formatVersion;
+        uint64_t wordCount;
+        uint64_t checksum[4];
+    };
+    constexpr uint32_t FileMagic = 0x56505343u; // "CSPV"
+
+    uint64_t generateTmpFilePrefix()
+    {
+        std::random_device device;
+        return (uint64_t(device())<<32ull)|uint64_t(device());
+    }
+
+    //! Atomically replaces `_target` with `_source`, even if `_target` already exists
+    bool replaceFile(const std::string& _source, const std::string& _target)
+    {
+#ifdef _IRR_WINDOWS_API_
+        // unlike POSIX, `rename` on Windows refuses to overwrite an existing file
+        return MoveFileExA(_source.c_str(),_target.c_str(),MOVEFILE_REPLACE_EXISTING)!=0;
+#else
+        return rename(_source.c_str(),_target.c_str())==0;
+#endif
+    }
+}
+
+
+CSPIRVCache::CSPIRVCache(const std::string& _directory, size_t _byteBudget) :
+    m_directory(_directory.empty()||_directory.back()=='/'||_directory.back()=='\\' ? _directory:(_directory+"/")),
+    m_tmpFilePrefix(generateTmpFilePrefix()), m_byteSize(0u), m_byteBudget(_byteBudget)
+{
+}
+
+bool CSPIRVCache::find(const SKey& _key, core::vector<uint32_t>& _outSPIRV) const
+{
+    {
+        std::unique_lock<core::fast_mutex> lk(m_lock);
+        auto found = m_index.find(_key);
+        if (found!=m_index.end())
+        {
+            m_lru.splice(m_lru.begin(),m_lru,found->second);
+            _outSPIRV = found->second->spirv;
+            return true;
+        }
+    }
+
+    // the file read happens outside of the lock, two threads missing on the same key just both read it
+    core::vector<uint32_t> spirv;
+    if (!readFile(_key,spirv))
+        return false;
+    _outSPIRV = spirv;
+
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    if (m_index.find(_key)==m_index.end())
+    {
+        link(_key,std::move(spirv));
+        evictOverBudget();
+    }
+    return true;
+}
+
+void CSPIRVCache::insert(const SKey& _key, const uint32_t* _spirv, size_t _wordCount)
+{
+    {
+        std::unique_lock<core::fast_mutex> lk(m_lock);
+        auto found = m_index.find(_key);
+        if (found!=m_index.end())
+        {
+            m_byteSize -= found->second->spirv.size()*sizeof(uint32_t);
+            m_lru.erase(found->second);
+            m_index.erase(found);
+        }
+        link(_key,core::vector<uint32_t>(_spirv,_spirv+_wordCount));
+        evictOverBudget();
+    }
+
+    writeFile(_key,_spirv,_wordCount);
+}
+
+void CSPIRVCache::setByteBudget(size_t _bytes)
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    m_byteBudget = _bytes;
+    evictOverBudget();
+}
+
+void CSPIRVCache::clearMemory()
+{
+    std::unique_lock<core::fast_mutex> lk(m_lock);
+    m_index.clear();
+    m_lru.clear();
+    m_byteSize = 0u;
+}
+
+std::string CSPIRVCache::getFilePath(const SKey& _key) const
+{
+    char name[4u*16u+1u];
+    for (uint32_t i=0u; i<4u; i++)
+        snprintf(name+i*16u,17u,"%016llx",static_cast<unsigned long long>(_key.hash[i]));
+    return m_directory+name+".spv";
+}
+
+bool CSPIRVCache::readFile(const SKey& _key, core::vector<uint32_t>& _outSPIRV) const
+{
+    if (m_directory.empty())
+        return false;
+
+    FILE* file = fopen(getFilePath(_key).c_str(),"rb");
+    if (!file)
+        return false;
+
+    // the word count must match the file size before we trust it enough to allocate for it
+    bool ok = fseek(file,0,SEEK_END)==0;
+    const long fileSize = ok ? ftell(file):-1l;
+    ok = ok && fileSize>=long(sizeof(SFileHeader)) && fseek(file,0,SEEK_SET)==0;
+
+    SFileHeader header;
+    ok = ok && fread(&header,sizeof(header),1u,file)==1u && header.magic==FileMagic && header.formatVersion==FormatVersion;
+    const uint64_t payloadSize = uint64_t(fileSize)-sizeof(SFileHeader);
+    ok = ok && payloadSize%sizeof(uint32_t)==0u && header.wordCount==payloadSize/sizeof(uint32_t);
+    if (ok)
+    {
+        _outSPIRV.resize(header.wordCount);
+        ok = fread(_outSPIRV.data(),sizeof(uint32_t),header.wordCount,file)==header.wordCount;
+    }
+    fclose(file);
+    if (!ok)
+        return false;
+
+    uint64_t checksum[4];
+    core::XXHash_256(_outSPIRV.data(),_outSPIRV.size()*sizeof(uint32_t),checksum);
+    return memcmp(checksum,header.checksum,sizeof(checksum))==0;
+}
+
+void CSPIRVCache::writeFile(const SKey& _key, const uint32_t* _spirv, size_t _wordCount) const
+{
+    if (m_directory.empty())
+        return;
+
+    // only misses get here, so there is either no file or a bad one, replace it either way
+    const std::string path = getFilePath(_key);
+    static std::atomic<uint32_t> tmpFileCounter(0u);
+    const std::string tmpPath = path+"."+std::to_string(m_tmpFilePrefix)+"."+std::to_string(tmpFileCounter++)+".tmp";
+    FILE* file = fopen(tmpPath.c_str(),"wb");
+    if (!file)
+        return;
+
+    SFileHeader header;
+    header.magic = FileMagic;
+    header.formatVersion = FormatVersion;
+    header.wordCount = _wordCount;
+    core::XXHash_256(_spirv,_wordCount*sizeof(uint32_t),header.checksum);
+    bool ok = fwrite(&header,sizeof(header),1u,file)==1u;
+    ok = ok && fwrite(_spirv,sizeof(uint32_t),_wordCount,file)==_wordCount;
+    ok = (fclose(file)==0) && ok;
+
+    // the replacement is atomic, so readers see either the old file or a complete new one, results are content-addressed so racing writers write the same bytes
+    if (!ok || !replaceFile(tmpPath,path))
+        remove(tmpPath.c_str());
+}
+
+void CSPIRVCache::link(const SKey& _key, core::vector<uint32_t>&& _spirv) const
+{
+    m_byteSize += _spirv.size()*sizeof(uint32_t);
+    m_lru.push_front(SEntry{_key,std::move(_spirv)});
+    m_index.emplace(_key,m_lru.begin());
+}
+
+void CSPIRVCache::evictOverBudget() const
+{
+    // never evicts the most recently used entry
+    while (m_byteSize>m_byteBudget && m_lru.size()>1u)
+    {
+        const SEntry& victim = m_lru.back();
+        m_byteSize -= victim.spirv.size()*sizeof(uint32_t);
+        m_index.erase(victim.key);
+        m_lru.pop_back();
+    }
+}
@@ -0,0 +1,201 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "IrrCompileConfig.h"
+#include "irr/asset/CSPIRVOptimizer.h"
+#include "irr/asset/ICPUSpecializedShader.h"
+#include "os.h"
+
+#ifdef _IRR_COMPILE_WITH_SPIRV_TOOLS_
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/optimizer.hpp"
+#endif
+
+namespace irr { namespace asset
+{
+
+#ifdef _IRR_COMPILE_WITH_SPIRV_TOOLS_
+
+namespace
+{
+    spv_target_env toSpvTargetEnv(CSPIRVOptimizer::E_TARGET_ENV _targetEnv)
+    {
+        switch (_targetEnv)
+        {
+            case CSPIRVOptimizer::ETE_UNIVERSAL_1_0:
+                return SPV_ENV_UNIVERSAL_1_0;
+            case CSPIRVOptimizer::ETE_UNIVERSAL_1_1:
+                return SPV_ENV_UNIVERSAL_1_1;
+            case CSPIRVOptimizer::ETE_UNIVERSAL_1_2:
+                return SPV_ENV_UNIVERSAL_1_2;
+            case CSPIRVOptimizer::ETE_OPENGL_4_5:
+                return SPV_ENV_OPENGL_4_5;
+            case CSPIRVOptimizer::ETE_VULKAN_1_0:
+                return SPV_ENV_VULKAN_1_0;
+            case CSPIRVOptimizer::ETE_VULKAN_1_1:
+                return SPV_ENV_VULKAN_1_1;
+            default:
+                return SPV_ENV_UNIVERSAL_1_3;
+        }
+    }
+
+    void logMessage(spv_message_level_t _level, const char*, const spv_position_t& _position, const char* _message)
+    {
+        if (_level>SPV_MSG_WARNING)
+            return;
+        const std::string msg = "SPIR-V word " + std::to_string(_position.index) + ": " + _message;
+        os::Printer::log(msg, _level==SPV_MSG_WARNING ? ELL_WARNING : ELL_ERROR);
+    }
+
+    std::pair<const uint32_t*,size_t> getWords(const ICPUShader* _shader)
+    {
+        const ICPUBuffer* bytecode = _shader->getSPIR_VBytecode();
+        return {reinterpret_cast<const uint32_t*>(bytecode->getPointer()), bytecode->getSize()/sizeof(uint32_t)};
+    }
+
+    //! SpecId decoration of every specialization constant in the module
+    core::vector<uint32_t> getSpecIds(const uint32_t* _spirv, size_t _wordCount)
+    {
+        constexpr uint32_t HeaderWordCount = 5u;
+        constexpr uint32_t OpDecorate = 71u;
+        constexpr uint32_t DecorationSpecId = 1u;
+
+        core::vector<uint32_t> specIds;
+        for (size_t i=HeaderWordCount; i<_wordCount; )
+        {
+            const uint32_t instrWordCount = _spirv[i]>>16u;
+            if (instrWordCount==0u || i+instrWordCount>_wordCount)
+                break;
+            // OpDecorate %target SpecId <id>
+            if ((_spirv[i]&0xffffu)==OpDecorate && instrWordCount==4u && _spirv[i+2u]==DecorationSpecId)
+                specIds.push_back(_spirv[i+3u]);
+            i += instrWordCount;
+        }
+        return specIds;
+    }
+
+    void registerPasses(spvtools::Optimizer& _optimizer, const CSPIRVOptimizer::SOptions& _options)
+    {
+        // first, so the presets don't spend time on names and lines
+        if (_options.stripDebugInfo)
+            _optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+        switch (_options.preset)
+        {
+            case CSPIRVOptimizer::EP_PERFORMANCE:
+                _optimizer.RegisterPerformancePasses();
+                break;
+            case CSPIRVOptimizer::EP_SIZE:
+                _optimizer.RegisterSizePasses();
+                break;
+            default:
+                break;
+        }
+        if (_options.compactIds)
+            _optimizer.RegisterPass(spvtools::CreateCompactIdsPass());
+    }
+
+    ICPUShader* run(const spvtools::Optimizer& _optimizer, spv_target_env _targetEnv, const uint32_t* _spirv, size_t _wordCount)
+    {
+        std::vector<uint32_t> optimized;
+        // Run validates its input
+        if (!_optimizer.Run(_spirv, _wordCount, &optimized))
+            return nullptr;
+
+        spvtools::SpirvTools tools(_targetEnv);
+        tools.SetMessageConsumer(logMessage);
+        if (!tools.Validate(optimized.data(), optimized.size()))
+            return nullptr;
+
+        return new ICPUShader(optimized.data(), optimized.size()*sizeof(uint32_t));
+    }
+}
+
+ICPUShader* CSPIRVOptimizer::optimize(const ICPUShader* _shader, const SOptions& _options) const
+{
+    const spv_target_env targetEnv = toSpvTargetEnv(m_targetEnv);
+    spvtools::Optimizer optimizer(targetEnv);
+    optimizer.SetMessageConsumer(logMessage);
+    registerPasses(optimizer, _options);
+
+    const auto spirv = getWords(_shader);
+    return run(optimizer, targetEnv, spirv.first, spirv.second);
+}
+
+ICPUShader* CSPIRVOptimizer::specializeAndOptimize(const ICPUSpecializedShader* _specialized, const SOptions& _options) const
+{
+    const ISpecializationInfo* specInfo = _specialized->getSpecializationInfo();
+    const auto spirv = getWords(_specialized->getUnspecialized());
+
+    // the pass wants the bit pattern as words, smaller than 32bit types take one
+    std::unordered_map<uint32_t,std::vector<uint32_t>> values;
+    for (uint32_t specId : getSpecIds(spirv.first, spirv.second))
+    {
+        const auto value = specInfo->getSpecializationByteValue(specId);
+        if (!value.first)
+            continue;
+        std::vector<uint32_t> words((value.second+sizeof(uint32_t)-1u)/sizeof(uint32_t), 0u);
+        memcpy(words.data(), value.first, value.second);
+        values.emplace(specId, std::move(words));
+    }
+
+    const spv_target_env targetEnv = toSpvTargetEnv(m_targetEnv);
+    spvtools::Optimizer optimizer(targetEnv);
+    optimizer.SetMessageConsumer(logMessage);
+    optimizer.RegisterPass(spvtools::CreateSetSpecConstantDefaultValuePass(values));
+    // plain constants from here on, then fold everything computed from them
+    optimizer.RegisterPass(spvtools::CreateFreezeSpecConstantValuePass());
+    optimizer.RegisterPass(spvtools::CreateFoldSpecConstantOpAndCompositePass());
+    optimizer.RegisterPass(spvtools::CreateUnifyConstantPass());
+    // the presets do this anyway, but EP_NONE has to get rid of the now unreachable code too
+    if (_options.preset==EP_NONE)
+    {
+        optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+        optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass());
+        optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+        optimizer.RegisterPass(spvtools::CreateEliminateDeadConstantPass());
+    }
+    registerPasses(optimizer, _options);
+
+    return run(optimizer, targetEnv, spirv.first, spirv.second);
+}
+
+bool CSPIRVOptimizer::validate(const ICPUShader* _shader) const
+{
+    spvtools::SpirvTools tools(toSpvTargetEnv(m_targetEnv));
+    tools.SetMessageConsumer(logMessage);
+    const auto spirv = getWords(_shader);
+    return tools.Validate(spirv.first, spirv.second);
+}
+
+#else
+
+namespace
+{
+    void logUnavailable()
+    {
+        os::Printer::log("CSPIRVOptimizer: Irrlicht was built without SPIRV-Tools", ELL_ERROR);
+    }
+}
+
+ICPUShader* CSPIRVOptimizer::optimize(const ICPUShader*, const SOptions&) const
+{
+    logUnavailable();
+    return nullptr;
+}
+
+ICPUShader* CSPIRVOptimizer::specializeAndOptimize(const ICPUSpecializedShader*, const SOptions&) const
+{
+    logUnavailable();
+    return nullptr;
+}
+
+bool CSPIRVOptimizer::validate(const ICPUShader*) const
+{
+    logUnavailable();
+    return false;
+}
+
+#endif
+
+}}
@@ -39,6 +39,9 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
     core::vector<core::vectorSIMDf> positions, normals;
     core::vector<uint32_t> colors;
+    // binary triangles get read straight out of memory-mapped files
+    const uint8_t* mapped = nullptr;
+    const uint8_t* mappedEnd = nullptr;
 	if (binary)
 	{
         if (_file->getSize() < 80)
@@ -50,6 +53,12 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
         positions.reserve(3*vtxCnt);
         normals.reserve(vtxCnt);
         colors.reserve(vtxCnt);
+
+        const size_t STL_TRI_SZ = 50u;
+        const size_t trianglesSize = (size_t(filesize)-_file->getPos())/STL_TRI_SZ*STL_TRI_SZ;
+        mapped = reinterpret_cast<const uint8_t*>(_file->getMappedRange(_file->getPos(), trianglesSize));
+        if (mapped)
+            mappedEnd = mapped+trianglesSize;
 	}
 	else
 		goNextLine(_file); // skip header
@@ -57,7 +66,7 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
 	uint16_t attrib=0u;
 	token.reserve(32);
-	while (_file->getPos() < filesize)
+	while (mapped ? (mapped < mappedEnd):(_file->getPos() < filesize))
 	{
 		if (!binary)
 		{
@@ -75,7 +84,10 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
         {
         core::vectorSIMDf n;
-		getNextVector(_file, n, binary);
+		if (mapped)
+			getNextVector(mapped, n);
+		else
+			getNextVector(_file, n, binary);
         normals.push_back(n);
         }
 
@@ -94,7 +106,10 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 				if (getNextToken(_file, token) != "vertex")
                     return {};
 			}
-			getNextVector(_file, p[i], binary);
+			if (mapped)
+				getNextVector(mapped, p[i]);
+			else
+				getNextVector(_file, p[i], binary);
 		}
         for (uint32_t i = 0u; i < 3u; ++i) // seems like in STL format vertices are ordered in clockwise manner...
             positions.push_back(p[2u-i]);
@@ -105,6 +120,11 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 			if (getNextToken(_file, token) != "endloop" || getNextToken(_file, token) != "endfacet")
                 return {};
 		}
+		else if (mapped)
+		{
+			memcpy(&attrib, mapped, 2);
+			mapped += 2;
+		}
 		else
 		{
 			_file->read(&attrib, 2);
@@ -215,6 +235,16 @@ void CSTLMeshFileLoader::getNextVector(io::IReadFile* file, core::vectorSIMDf& v
 	vec.X=-vec.X;
 }
 
+//! Read 3d vector of floats from a memory-mapped binary file and advance the pointer
+void CSTLMeshFileLoader::getNextVector(const uint8_t*& mapped, core::vectorSIMDf& vec) const
+{
+	memcpy(&vec.X, mapped, 4);
+	memcpy(&vec.Y, mapped+4, 4);
+	memcpy(&vec.Z, mapped+8, 4);
+	mapped += 12;
+	vec.X=-vec.X;
+}
+
 
 //! Read next word
 const core::stringc& CSTLMeshFileLoader::getNextToken(io::IReadFile* file, core::stringc& token) const
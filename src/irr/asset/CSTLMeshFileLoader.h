@@ -41,6 +41,8 @@ private:
 
 	//! Read 3d vector of floats
 	void getNextVector(io::IReadFile* file, core::vectorSIMDf& vec, bool binary) const;
+	//! Read 3d vector of floats from a memory-mapped binary file and advance the pointer
+	void getNextVector(const uint8_t*& mapped, core::vectorSIMDf& vec) const;
 };
 
 } // end namespace scene
@@ -46,3 +46,8 @@ SAssetBundle IAssetLoader::interm_getAssetInHierarchy(IAssetManager* _mgr, const
 {
     return _mgr->getAssetInHierarchy(_filename, _params, _hierarchyLevel);
 }
+
+core::smart_refctd_ptr<CAssetLoadHandle> IAssetLoader::interm_getAssetInHierarchyAsync(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+{
+    return _mgr->getAssetInHierarchyAsync(_filename, _params, _hierarchyLevel, _override);
+}
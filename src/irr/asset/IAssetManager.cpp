@@ -54,6 +54,9 @@
 #ifdef _IRR_COMPILE_WITH_TGA_WRITER_
 #include "irr/asset/CImageWriterTGA.h"
 #endif
+#ifdef _IRR_COMPILE_WITH_DDS_WRITER_
+#include "irr/asset/CImageWriterDDS.h"
+#endif
 
 #ifdef _IRR_COMPILE_WITH_JPG_WRITER_
 #include "irr/asset/CImageWriterJPG.h"
@@ -74,6 +77,10 @@ std::function<void(SAssetBundle&)> irr::asset::makeAssetDisposeFunc(const IAsset
 {
     return [_mgr](SAssetBundle& _asset) { _mgr->setAssetCached(_asset, false); };
 }
+std::function<void(SAssetBundle&)> irr::asset::makeAssetDummyConversionFunc(const IAssetManager* const _mgr)
+{
+    return [_mgr](SAssetBundle& _asset) { _mgr->convertAssetToDummy(_asset); };
+}
 
 void IAssetManager::initializeMeshTools()
 {
@@ -133,6 +140,9 @@ void IAssetManager::addLoadersAndWriters()
 #ifdef _IRR_COMPILE_WITH_TGA_WRITER_
 	addAssetWriter(core::make_smart_refctd_ptr<asset::CImageWriterTGA>());
 #endif
+#ifdef _IRR_COMPILE_WITH_DDS_WRITER_
+	addAssetWriter(core::make_smart_refctd_ptr<asset::CImageWriterDDS>());
+#endif
 #ifdef _IRR_COMPILE_WITH_JPG_WRITER_
 	addAssetWriter(core::make_smart_refctd_ptr<asset::CImageWriterJPG>());
 #endif
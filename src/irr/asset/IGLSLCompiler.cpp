@@ -2,20 +2,93 @@
 
 #include "irr/asset/IGLSLCompiler.h"
 #include "irr/asset/ICPUShader.h"
+#include "irr/core/xxHash256.h"
 #include "irr/asset/shadercUtils.h"
+#include "os.h"
 
 namespace irr { namespace asset
 {
 
+namespace
+{
+    //! shaderc compilers must not be used by many threads at once, and they are expensive to construct
+    shaderc::Compiler& getThreadCompiler()
+    {
+        static thread_local shaderc::Compiler compiler;
+        return compiler;
+    }
+
+    shaderc_shader_kind toShadercKind(E_SHADER_STAGE _stage)
+    {
+        return _stage==ESS_UNKNOWN ? shaderc_glsl_infer_from_source : ESStoShadercEnum(_stage);
+    }
+}
+
 ICPUShader* IGLSLCompiler::createShaderFromGLSL(const char* _glslCode, E_SHADER_STAGE _stage, const char* _entryPoint, bool _debug, const char* _compilationId) const
 {
-    shaderc::Compiler comp;
+    CSPIRVCache::SKey key;
+    const bool cacheable = m_cache && computeCacheKey(key, _glslCode, _stage, _entryPoint, _debug, _compilationId);
+    if (cacheable)
+    {
+        core::vector<uint32_t> spirv;
+        if (m_cache->find(key, spirv))
+            return new ICPUShader(spirv.data(), spirv.size()*sizeof(uint32_t));
+    }
+
     shaderc::CompileOptions options;
     if (_debug)
         options.SetGenerateDebugInfo();
-    const shaderc_shader_kind stage = _stage==ESS_UNKNOWN ? shaderc_glsl_infer_from_source : ESStoShadercEnum(_stage);
-    shaderc::SpvCompilationResult res = comp.CompileGlslToSpv(_glslCode, strlen(_glslCode), stage, _compilationId ? _compilationId : "", _entryPoint, options);
-    return new ICPUShader(res.cbegin(), std::distance(res.cbegin(), res.cend())*sizeof(uint32_t));
+    shaderc::SpvCompilationResult res = getThreadCompiler().CompileGlslToSpv(_glslCode, strlen(_glslCode), toShadercKind(_stage), _compilationId ? _compilationId : "", _entryPoint, options);
+    if (res.GetCompilationStatus() != shaderc_compilation_status_success)
+    {
+        os::Printer::log(res.GetErrorMessage(), ELL_ERROR);
+        return nullptr;
+    }
+
+    const size_t wordCount = std::distance(res.cbegin(), res.cend());
+    if (cacheable)
+        m_cache->insert(key, res.cbegin(), wordCount);
+    return new ICPUShader(res.cbegin(), wordCount*sizeof(uint32_t));
+}
+
+void IGLSLCompiler::createShadersFromGLSL(const SCompileRequest* _begin, const SCompileRequest* _end, ICPUShader** _outShaders) const
+{
+    core::parallel_for<size_t>(0u, _end-_begin, [&](size_t i)
+        {
+            const SCompileRequest& request = _begin[i];
+            _outShaders[i] = createShaderFromGLSL(request.glslCode, request.stage, request.entryPoint, request.debug, request.compilationId);
+        }, 1u);
+}
+
+bool IGLSLCompiler::computeCacheKey(CSPIRVCache::SKey& _outKey, const char* _glslCode, E_SHADER_STAGE _stage, const char* _entryPoint, bool _debug, const char* _compilationId) const
+{
+    // comments, whitespace and inactive #if branches don't change the SPIR-V
+    shaderc::CompileOptions options;
+    shaderc::PreprocessedSourceCompilationResult res = getThreadCompiler().PreprocessGlsl(_glslCode, strlen(_glslCode), toShadercKind(_stage), _compilationId ? _compilationId : "", options);
+    if (res.GetCompilationStatus() != shaderc_compilation_status_success)
+        return false;
+
+    std::string keyData(res.cbegin(), res.cend());
+    auto append = [&keyData](const void* _data, size_t _size) { keyData.append(reinterpret_cast<const char*>(_data), _size); };
+    keyData.push_back('\0');
+    keyData += _entryPoint;
+    keyData.push_back('\0');
+    const uint32_t stage = _stage;
+    append(&stage, sizeof(stage));
+    const uint8_t debug = _debug;
+    append(&debug, sizeof(debug));
+    // debug info names the source
+    if (_debug && _compilationId)
+        keyData += _compilationId;
+    uint32_t spirvVersion = 0u, spirvRevision = 0u;
+    shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+    append(&spirvVersion, sizeof(spirvVersion));
+    append(&spirvRevision, sizeof(spirvRevision));
+    const uint32_t formatVersion = CSPIRVCache::FormatVersion;
+    append(&formatVersion, sizeof(formatVersion));
+
+    core::XXHash_256(keyData.data(), keyData.size(), _outKey.hash);
+    return true;
 }
 
-}}
\ No newline at end of file
+}}
@@ -7,6 +7,7 @@
 
 #include "irr/asset/ICPUSkinnedMesh.h"
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
 #include "irr/asset/bawformat/legacy/CBAWLegacy.h"
 #include "CFinalBoneHierarchy.h"
 
@@ -102,6 +103,34 @@ size_t SizedBlob<FixedSizeBlob, SkinnedMeshBufferBlobV0, asset::ICPUSkinnedMeshB
 	return sizeof(SkinnedMeshBufferBlobV0);
 }
 
+MeshletMeshBufferBlobV0::MeshletMeshBufferBlobV0(const asset::ICPUMeshletMeshBuffer* _mmb)
+{
+	memcpy(&mat, &_mmb->getMaterial(), sizeof(video::SCPUMaterial));
+	_mmb->getMaterial().serializeBitfields(mat.bitfieldsPtr());
+	for (size_t i = 0; i < _IRR_MATERIAL_MAX_TEXTURES_; ++i)
+		_mmb->getMaterial().TextureLayer[i].SamplingParams.serializeBitfields(mat.TextureLayer[i].SamplingParams.bitfieldsPtr());
+
+	memcpy(&box, &_mmb->getBoundingBox(), sizeof(core::aabbox3df));
+	descPtr = reinterpret_cast<uint64_t>(_mmb->getMeshDataAndFormat());
+	indexType = _mmb->getIndexType();
+	baseVertex = _mmb->getBaseVertex();
+	indexCount = _mmb->getIndexCount();
+	indexBufOffset = _mmb->getIndexBufferOffset();
+	instanceCount = _mmb->getInstanceCount();
+	baseInstance = _mmb->getBaseInstance();
+	primitiveType = _mmb->getPrimitiveType();
+	posAttrId = _mmb->getPositionAttributeIx();
+	meshletCount = _mmb->getMeshlets().size();
+	if (meshletCount)
+		memcpy(getMeshletData(), _mmb->getMeshlets().data(), meshletCount*sizeof(asset::ICPUMeshletMeshBuffer::SMeshlet));
+}
+
+template<>
+size_t SizedBlob<VariableSizeBlob, MeshletMeshBufferBlobV0, asset::ICPUMeshletMeshBuffer>::calcBlobSizeForObj(const asset::ICPUMeshletMeshBuffer* _obj)
+{
+	return sizeof(MeshletMeshBufferBlobV0) + _obj->getMeshlets().size()*sizeof(asset::ICPUMeshletMeshBuffer::SMeshlet);
+}
+
 FinalBoneHierarchyBlobV0::FinalBoneHierarchyBlobV0(const CFinalBoneHierarchy* _fbh)
 {
 	boneCount = _fbh->getBoneCount();
@@ -112,8 +141,16 @@ FinalBoneHierarchyBlobV0::FinalBoneHierarchyBlobV0(const CFinalBoneHierarchy* _f
 	memcpy(ptr + calcBonesOffset(_fbh), _fbh->getBoneData(), calcBonesByteSize(_fbh));
 	memcpy(ptr + calcLevelsOffset(_fbh), _fbh->getBoneTreeLevelEnd(), calcLevelsByteSize(_fbh));
 	memcpy(ptr + calcKeyFramesOffset(_fbh), _fbh->getKeys(), calcKeyFramesByteSize(_fbh));
-	memcpy(ptr + calcInterpolatedAnimsOffset(_fbh), _fbh->getInterpolatedAnimationData(), calcInterpolatedAnimsByteSize(_fbh));
-	memcpy(ptr + calcNonInterpolatedAnimsOffset(_fbh), _fbh->getNonInterpolatedAnimationData(), calcNonInterpolatedAnimsByteSize(_fbh));
+	if (_fbh->hasCompressedAnimations())
+	{
+		keyframeCount |= CompressedAnimationsFlag;
+		memcpy(ptr + calcInterpolatedAnimsOffset(_fbh), _fbh->getCompressedAnimations()->getSerializedData(), calcInterpolatedAnimsByteSize(_fbh));
+	}
+	else
+	{
+		memcpy(ptr + calcInterpolatedAnimsOffset(_fbh), _fbh->getInterpolatedAnimationData(), calcInterpolatedAnimsByteSize(_fbh));
+		memcpy(ptr + calcNonInterpolatedAnimsOffset(_fbh), _fbh->getNonInterpolatedAnimationData(), calcNonInterpolatedAnimsByteSize(_fbh));
+	}
 	uint8_t* strPtr = ptr + calcBoneNamesOffset(_fbh);
 	for (size_t i = 0; i < boneCount; ++i)
 	{
@@ -176,11 +213,15 @@ size_t FinalBoneHierarchyBlobV0::calcKeyFramesByteSize(const CFinalBoneHierarchy
 }
 size_t FinalBoneHierarchyBlobV0::calcInterpolatedAnimsByteSize(const CFinalBoneHierarchy * _fbh)
 {
-	return _fbh->getAnimationCount()*sizeof(*_fbh->getInterpolatedAnimationData());
+	if (_fbh->hasCompressedAnimations())
+		return _fbh->getCompressedAnimations()->getSerializedSize();
+	return _fbh->getAnimationCount()*CFinalBoneHierarchy::getSizeOfSingleAnimationData();
 }
 size_t FinalBoneHierarchyBlobV0::calcNonInterpolatedAnimsByteSize(const CFinalBoneHierarchy * _fbh)
 {
-	return _fbh->getAnimationCount()*sizeof(*_fbh->getNonInterpolatedAnimationData());
+	if (_fbh->hasCompressedAnimations())
+		return 0u;
+	return _fbh->getAnimationCount()*CFinalBoneHierarchy::getSizeOfSingleAnimationData();
 }
 size_t FinalBoneHierarchyBlobV0::calcBoneNamesByteSize(const CFinalBoneHierarchy * _fbh)
 {
@@ -222,15 +263,20 @@ size_t FinalBoneHierarchyBlobV0::calcLevelsByteSize() const
 }
 size_t FinalBoneHierarchyBlobV0::calcKeyFramesByteSize() const
 {
-	return keyframeCount * sizeof(float);
+	return getKeyframeCount() * sizeof(float);
 }
 size_t FinalBoneHierarchyBlobV0::calcInterpolatedAnimsByteSize() const
 {
-	return keyframeCount * boneCount * CFinalBoneHierarchy::getSizeOfSingleAnimationData();
+	// the size of compressed animations is in their header, make sure it lies within the blob before calling this
+	if (hasCompressedAnimations())
+		return CCompressedBoneAnimation::getSerializedSize(reinterpret_cast<const uint8_t*>(this) + calcInterpolatedAnimsOffset());
+	return getKeyframeCount() * boneCount * CFinalBoneHierarchy::getSizeOfSingleAnimationData();
 }
 size_t FinalBoneHierarchyBlobV0::calcNonInterpolatedAnimsByteSize() const
 {
-	return keyframeCount * boneCount * CFinalBoneHierarchy::getSizeOfSingleAnimationData();
+	if (hasCompressedAnimations())
+		return 0u;
+	return getKeyframeCount() * boneCount * CFinalBoneHierarchy::getSizeOfSingleAnimationData();
 }
 
 
@@ -14,6 +14,7 @@
 #include "irr/asset/ICPUTexture.h"
 #include "irr/asset/IAssetManager.h"
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
+#include "irr/asset/ICPUMeshletMeshBuffer.h"
 #include "irr/asset/CBAWMeshFileLoader.h"
 
 
@@ -342,6 +343,63 @@ void TypedBlob<SkinnedMeshBufferBlobV0, asset::ICPUSkinnedMeshBuffer>::releaseOb
 		reinterpret_cast<const asset::ICPUSkinnedMeshBuffer*>(_obj)->drop();
 }
 
+template<>
+core::unordered_set<uint64_t> TypedBlob<MeshletMeshBufferBlobV0, asset::ICPUMeshletMeshBuffer>::getNeededDeps(const void* _blob)
+{
+	return TypedBlob<MeshBufferBlobV0, asset::ICPUMeshBuffer>::getNeededDeps(_blob);
+}
+
+template<>
+void* TypedBlob<MeshletMeshBufferBlobV0, asset::ICPUMeshletMeshBuffer>::instantiateEmpty(const void* _blob, size_t _blobSize, const BlobLoadingParams& _params)
+{
+	if (!_blob)
+		return nullptr;
+
+	const MeshletMeshBufferBlobV0* blob = (const MeshletMeshBufferBlobV0*)_blob;
+	if (_blobSize < sizeof(MeshletMeshBufferBlobV0) + size_t(blob->meshletCount)*sizeof(asset::ICPUMeshletMeshBuffer::SMeshlet))
+		return nullptr;
+
+	asset::ICPUMeshletMeshBuffer* buf = new asset::ICPUMeshletMeshBuffer();
+	memcpy(&buf->getMaterial(), &blob->mat, sizeof(video::SCPUMaterial));
+	buf->getMaterial().setBitfields(*(blob)->mat.bitfieldsPtr());
+	for (size_t i = 0; i < _IRR_MATERIAL_MAX_TEXTURES_; ++i)
+	{
+		memset(&buf->getMaterial().TextureLayer[i].Texture, 0, sizeof(const void*));
+		buf->getMaterial().TextureLayer[i].SamplingParams.setBitfields(*(blob)->mat.TextureLayer[i].SamplingParams.bitfieldsPtr());
+	}
+
+	buf->setBoundingBox(blob->box);
+	buf->setIndexType((asset::E_INDEX_TYPE)blob->indexType);
+	buf->setBaseVertex(blob->baseVertex);
+	buf->setIndexCount(blob->indexCount);
+	buf->setIndexBufferOffset(blob->indexBufOffset);
+	buf->setInstanceCount(blob->instanceCount);
+	buf->setBaseInstance(blob->baseInstance);
+	buf->setPrimitiveType((asset::E_PRIMITIVE_TYPE)blob->primitiveType);
+	buf->setPositionAttributeIx((asset::E_VERTEX_ATTRIBUTE_ID)blob->posAttrId);
+
+	core::vector<asset::ICPUMeshletMeshBuffer::SMeshlet> meshlets(blob->meshletCount);
+	if (blob->meshletCount)
+		memcpy(meshlets.data(), blob->getMeshletData(), meshlets.size()*sizeof(asset::ICPUMeshletMeshBuffer::SMeshlet));
+	buf->setMeshlets(std::move(meshlets));
+
+	return buf;
+}
+
+template<>
+void* TypedBlob<MeshletMeshBufferBlobV0, asset::ICPUMeshletMeshBuffer>::finalize(void* _obj, const void* _blob, size_t _blobSize, core::unordered_map<uint64_t, void*>& _deps, const BlobLoadingParams& _params)
+{
+	// the members finalize touches are laid out the same as in MeshBufferBlobV0
+	return TypedBlob<MeshBufferBlobV0, asset::ICPUMeshBuffer>::finalize(_obj, _blob, _blobSize, _deps, _params);
+}
+
+template<>
+void TypedBlob<MeshletMeshBufferBlobV0, asset::ICPUMeshletMeshBuffer>::releaseObj(const void* _obj)
+{
+	if (_obj)
+		reinterpret_cast<const asset::ICPUMeshletMeshBuffer*>(_obj)->drop();
+}
+
 template<>
 core::unordered_set<uint64_t> TypedBlob<FinalBoneHierarchyBlobV0, CFinalBoneHierarchy>::getNeededDeps(const void* _blob)
 {
@@ -366,6 +424,13 @@ void* TypedBlob<FinalBoneHierarchyBlobV0, CFinalBoneHierarchy>::instantiateEmpty
 	const uint8_t* const keyframesBegin = data + blob->calcKeyFramesOffset();
 	const uint8_t* const keyframesEnd = keyframesBegin + blob->calcKeyFramesByteSize();
 
+	if (blob->hasCompressedAnimations())
+	{
+		const size_t compressedOffset = blob->calcInterpolatedAnimsOffset();
+		if (compressedOffset > _blobSize || !CCompressedBoneAnimation::validate(data + compressedOffset, _blobSize - compressedOffset, blob->boneCount, blob->getKeyframeCount()))
+			return nullptr;
+	}
+
 	const uint8_t* const interpolatedAnimsBegin = data + blob->calcInterpolatedAnimsOffset();
 	const uint8_t* const interpolatedAnimsEnd = interpolatedAnimsBegin + blob->calcInterpolatedAnimsByteSize();
 
@@ -391,14 +456,24 @@ void* TypedBlob<FinalBoneHierarchyBlobV0, CFinalBoneHierarchy>::instantiateEmpty
 		strPtr += len;
 	}
 
-	CFinalBoneHierarchy* fbh = new CFinalBoneHierarchy(
-		bonesBegin, bonesEnd,
-		boneNames, boneNames + blob->boneCount,
-		(const size_t*)levelsBegin, (const size_t*)levelsEnd,
-		(const float*)keyframesBegin, (const float*)keyframesEnd,
-		interpolatedAnimsBegin, interpolatedAnimsEnd,
-		nonInterpolatedAnimsBegin, nonInterpolatedAnimsEnd
-	);
+	CFinalBoneHierarchy* fbh;
+	if (blob->hasCompressedAnimations())
+		fbh = new CFinalBoneHierarchy(
+			bonesBegin, bonesEnd,
+			boneNames, boneNames + blob->boneCount,
+			(const size_t*)levelsBegin, (const size_t*)levelsEnd,
+			(const float*)keyframesBegin, (const float*)keyframesEnd,
+			interpolatedAnimsBegin, interpolatedAnimsEnd
+		);
+	else
+		fbh = new CFinalBoneHierarchy(
+			bonesBegin, bonesEnd,
+			boneNames, boneNames + blob->boneCount,
+			(const size_t*)levelsBegin, (const size_t*)levelsEnd,
+			(const float*)keyframesBegin, (const float*)keyframesEnd,
+			interpolatedAnimsBegin, interpolatedAnimsEnd,
+			nonInterpolatedAnimsBegin, nonInterpolatedAnimsEnd
+		);
 
 	if ((uint8_t*)boneNames == stack)
 		for (size_t i = 0; i < blob->boneCount; ++i)
@@ -0,0 +1,141 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBaW".
+// For conditions of distribution and use, see LICENSE.md
+
+#include "irr/core/parallel/CTaskScheduler.h"
+
+using namespace irr;
+using namespace core;
+
+
+namespace
+{
+    //! which scheduler (if any) the calling thread is a worker of, and its index there
+    struct SWorkerIdentity
+    {
+        const CTaskScheduler* scheduler = nullptr;
+        uint32_t index = 0u;
+    };
+    thread_local SWorkerIdentity tl_workerIdentity;
+}
+
+
+CTaskScheduler::CTaskScheduler(uint32_t _workerCount) : m_workerCount(_workerCount), m_queues(nullptr), m_queuedTasks(0u), m_exiting(false)
+{
+    if (m_workerCount==DefaultWorkerCount)
+    {
+        const uint32_t hwThreads = std::thread::hardware_concurrency();
+        m_workerCount = hwThreads>1u ? (hwThreads-1u):0u;
+    }
+    // without workers nothing would run tasks which are polled for rather than waited on
+    if (m_workerCount==0u)
+        m_workerCount = 1u;
+
+    m_queues = _IRR_NEW_ARRAY(SWorkerQueue,m_workerCount+1u);
+
+    m_threads.reserve(m_workerCount);
+    for (uint32_t i=0u; i<m_workerCount; i++)
+        m_threads.emplace_back(&CTaskScheduler::workerLoop,this,i);
+}
+
+CTaskScheduler::~CTaskScheduler()
+{
+    // drain whatever fire-and-forget tasks are left, they may hold references
+    while (tryExecuteOne()) {}
+
+    {
+        std::unique_lock<std::mutex> lk(m_sleepLock);
+        m_exiting = true;
+    }
+    m_sleepCondition.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+
+    _IRR_DELETE_ARRAY(m_queues,m_workerCount+1u);
+}
+
+CTaskScheduler* CTaskScheduler::getDefault()
+{
+    // never destroyed on purpose, tasks may still be in flight during static destruction
+    static CTaskScheduler* defaultScheduler = new CTaskScheduler();
+    return defaultScheduler;
+}
+
+uint32_t CTaskScheduler::getCurrentWorkerIndex() const
+{
+    if (tl_workerIdentity.scheduler==this)
+        return tl_workerIdentity.index;
+    return m_workerCount;
+}
+
+void CTaskScheduler::submit(ITask* _task)
+{
+    // counted before it is published, otherwise a thief could take it and decrement first, wrapping the counter around
+    m_queuedTasks++;
+    m_queues[getCurrentWorkerIndex()].push(_task);
+
+    // taking the lock guarantees a worker cannot miss the wakeup between its check and its wait
+    {
+        std::unique_lock<std::mutex> lk(m_sleepLock);
+    }
+    m_sleepCondition.notify_one();
+}
+
+bool CTaskScheduler::tryExecuteOne()
+{
+    ITask* task = acquireTask(getCurrentWorkerIndex());
+    if (!task)
+        return false;
+
+    execute(task);
+    return true;
+}
+
+ITask* CTaskScheduler::acquireTask(uint32_t _workerIx)
+{
+    if (m_queuedTasks.load()==0u)
+        return nullptr;
+
+    ITask* task = m_queues[_workerIx].pop();
+    // steal round-robin starting at our neighbour, the injection queue is at index `m_workerCount` so it gets visited too
+    const uint32_t queueCount = m_workerCount+1u;
+    for (uint32_t i=1u; !task&&i<queueCount; i++)
+        task = m_queues[(_workerIx+i)%queueCount].steal(false);
+    // non-blocking steals can spuriously come back empty-handed, so retry with blocking ones if there's still work queued
+    for (uint32_t i=1u; !task&&i<queueCount&&m_queuedTasks.load()!=0u; i++)
+        task = m_queues[(_workerIx+i)%queueCount].steal(true);
+
+    if (task)
+        m_queuedTasks--;
+    return task;
+}
+
+void CTaskScheduler::execute(ITask* _task)
+{
+    CTaskGroup* group = _task->m_group;
+    _task->execute();
+    _IRR_DELETE(_task);
+    if (group)
+        group->finishTask();
+}
+
+void CTaskScheduler::workerLoop(uint32_t _workerIx)
+{
+    tl_workerIdentity.scheduler = this;
+    tl_workerIdentity.index = _workerIx;
+
+    while (true)
+    {
+        ITask* task = acquireTask(_workerIx);
+        if (task)
+        {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(m_sleepLock);
+        m_sleepCondition.wait(lk,[this]() {return m_exiting.load()||m_queuedTasks.load()!=0u;});
+        if (m_exiting.load())
+            break;
+    }
+}